@@ -1,8 +1,14 @@
+// reads the board of device 0 for 3 seconds through the engine shared by every consumer:
+// every sample is pushed to a queue and only the samples whose readings changed
+// are delivered to a callback, whose subscription is cancelled before that of the queue
+
 #include <nrg/nrg.hpp>
 #include <nonstd/expected.hpp>
 
+#include <atomic>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace
 {
@@ -74,6 +80,7 @@ int main()
     {
         using namespace nrgprf;
         constexpr uint8_t device = 0;
+        constexpr std::chrono::milliseconds period(100);
 
         auto support = reader_gpu::support(0x1);
         if (!support)
@@ -82,31 +89,71 @@ int main()
 
         reader_gpu reader(*support, 0x1);
 
-        sample first;
-        sample last;
-        if (std::error_code ec; !reader.read(first, ec))
-            throw exception(ec);
+        sample_queue queue;
+        subscription every = poll_engine::shared().subscribe(reader,
+            poll_policy::rate(period), queue);
+        std::atomic<size_t> changes = 0;
+        subscription changed = poll_engine::shared().subscribe(reader,
+            poll_policy::changes(period),
+            [&changes](const result<published_sample>& s)
+            {
+                if (s)
+                    changes++;
+            });
         std::this_thread::sleep_for(std::chrono::seconds(3));
-        if (std::error_code ec; !reader.read(last, ec))
+
+        // no sample is delivered once a subscription is cancelled
+        changed.cancel();
+        size_t changes_at_cancel = changes;
+        std::this_thread::sleep_for(2 * period);
+        every.cancel();
+        if (std::error_code ec = every.error())
             throw exception(ec);
 
+        std::vector<published_sample> samples;
+        for (published_sample s; queue.pop(s);)
+            samples.push_back(s);
+        if (samples.size() < 2)
+        {
+            std::cerr << "Read " << samples.size() << " sample(s) in 3 seconds\n";
+            return 1;
+        }
+        const sample& first = samples.front().value;
+        const sample& last = samples.back().value;
+        std::chrono::duration<double> elapsed =
+            samples.back().timestamp - samples.front().timestamp;
+        std::cout << "Read " << samples.size() << " samples over "
+            << elapsed.count() << " s, " << queue.dropped() << " dropped\n";
+        std::cout << changes_at_cancel << " of them changed\n";
+        // the samples which changed were read with those of the queue, which were also read
+        // during the two periods before it was cancelled
+        if (changes != changes_at_cancel || !changes_at_cancel ||
+            changes_at_cancel > samples.size())
+        {
+            std::cerr << "Unexpected number of changed samples: " << changes << "\n";
+            return 1;
+        }
+
         if (*support & readings_type::energy)
         {
             std::cout << "--- Energy ---\n";
             auto [before, after] =
                 get_readings<energy_query>(reader, first, last, device);
-            std::cout << "Before sleep: " << before.count() << " J\n";
-            std::cout << "After sleep: " << after.count() << " J\n";
+            std::cout << "First sample: " << before.count() << " J\n";
+            std::cout << "Last sample: " << after.count() << " J\n";
             std::cout << "Consumed: " << (after - before).count() << " J\n";
         }
         if (*support & readings_type::power)
         {
             std::cout << "--- Power ---\n";
-            auto [before, after] =
-                get_readings<power_query>(reader, first, last, device);
-            std::cout << "Before sleep: " << before.count() << " W\n";
-            std::cout << "After sleep: " << after.count() << " W\n";
-            std::cout << "Average: " << ((after + before) / 2).count() << " W\n";
+            power_query::unit sum{};
+            for (const auto& s : samples)
+                sum += power_query::value(reader, s.value, device);
+            std::cout << "First sample: " << power_query::value(reader, first, device).count()
+                << " W\n";
+            std::cout << "Last sample: " << power_query::value(reader, last, device).count()
+                << " W\n";
+            std::cout << "Average: " << sum.count() / samples.size() << " W\n";
         }
     }
     catch (const nrgprf::exception& e)
@@ -0,0 +1,103 @@
+// checks the channels the hwmon reader discovers in the fake tree of misc/hwmon
+// and the locations they are mapped to: the energy channels of amd_energy by their
+// Esocket and Ecore labels, the power channels of ina3221 integrated into energy,
+// and the power channel of a location which already has an energy channel ignored
+
+#include <nrg/nrg.hpp>
+#include <nonstd/expected.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    bool success = true;
+
+    void check(bool condition, const char* what)
+    {
+        std::cout << (condition ? "ok     " : "FAILED ") << what << "\n";
+        success &= condition;
+    }
+
+    template<typename Location>
+    bool has_value(const nrgprf::reader_rapl& reader, const nrgprf::sample& s, uint8_t skt,
+        uintmax_t expected)
+    {
+        auto res = reader.value<Location>(s, skt);
+        return res && res->count() == expected;
+    }
+
+    // the energy integrated from a constant power over the time between the samples
+    template<typename Location>
+    bool integrated(const nrgprf::reader_rapl& reader, const nrgprf::sample& first,
+        const nrgprf::sample& last, double seconds, double microwatts)
+    {
+        auto before = reader.value<Location>(first, 0);
+        auto after = reader.value<Location>(last, 0);
+        if (!before || !after)
+            return false;
+        double expected = microwatts * seconds;
+        double energy = static_cast<double>(after->count() - before->count());
+        // the reader takes the time of its reads itself
+        return std::abs(energy - expected) <= 0.05 * expected;
+    }
+}
+
+int main()
+{
+    try
+    {
+        using namespace nrgprf;
+
+        // cores 0 and 1 may be siblings, in which case only core 0 is read,
+        // and the topology of the logical CPUs is that of the machine
+        core_mask cores;
+        cores.set(0);
+        if (std::thread::hardware_concurrency() > 1)
+            cores.set(1);
+        reader_rapl reader(locmask::all, socket_mask(0x3), cores);
+        sample first;
+        sample last;
+        if (std::error_code ec; !reader.read(first, ec))
+            throw exception(ec);
+        auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (std::error_code ec; !reader.read(last, ec))
+            throw exception(ec);
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        check(has_value<loc::pkg>(reader, last, 0, 98312466120),
+            "Esocket0 is the package of socket 0, preferred over the CPU power channel");
+        check(has_value<loc::pkg>(reader, last, 1, 97120874309),
+            "Esocket1 is the package of socket 1");
+        check(has_value<loc::core>(reader, last, 0, 1843120532),
+            "Ecore000 is core 0");
+        if (reader.event_idx<loc::core>(1) >= 0)
+            check(has_value<loc::core>(reader, last, 1, 1790214877),
+                "Ecore001 is core 1");
+        check(!reader.value<loc::core>(last, 2), "there is no core 2");
+        check(integrated<loc::uncore>(reader, first, last, seconds, 2350000),
+            "SoC is the uncore of socket 0, integrated from 2.35 W");
+        check(integrated<loc::sys>(reader, first, last, seconds, 41800000),
+            "Total is the system of socket 0, integrated from 41.8 W");
+        check(integrated<loc::mem>(reader, first, last, seconds, 1120000),
+            "DRAM is the memory of socket 0, integrated from 1.12 W");
+        check(!reader.value<loc::mem>(last, 1) && !reader.value<loc::uncore>(last, 1),
+            "socket 1 has no power channels");
+        check(!reader.value<loc::cores>(last, 0), "VDD_CPU is not a power channel");
+    }
+    catch (const nrgprf::exception& e)
+    {
+        std::cerr << "NRG exception: " << e.what() << '\n';
+        return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return !success;
+}
@@ -0,0 +1,175 @@
+// measures the time to read the devices simulated by the stub of NVML in misc/nvml,
+// with and without support for field values and energy readings, that is, with
+// a single query per device or a query per event, and checks the readings
+// of every device against the power the stub simulates
+
+#include <nrg/nrg.hpp>
+#include <nonstd/expected.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    struct stub_mode
+    {
+        const char* name;
+        const char* fields;
+        const char* energy;
+    };
+
+    constexpr stub_mode modes[] = {
+        { "fields", "1", "1" },
+        { "fields, power only", "1", "0" },
+        { "per event", "0", "1" },
+        { "per event, power only", "0", "0" },
+    };
+
+    // device i draws a constant 50 + 25 * i W
+    double stub_power(uint32_t dev)
+    {
+        return 50 + 25 * dev;
+    }
+
+    bool check_device(const nrgprf::reader_gpu& reader, nrgprf::readings_type::type support,
+        const nrgprf::sample& first, const nrgprf::sample& last, double seconds, uint32_t dev)
+    {
+        using namespace nrgprf;
+        bool success = true;
+        if (support & readings_type::power)
+        {
+            auto power = reader.get_board_power(last, dev);
+            success &= power && watts<double>(*power).count() == stub_power(dev);
+        }
+        if (support & readings_type::energy)
+        {
+            auto before = reader.get_board_energy(first, dev);
+            auto after = reader.get_board_energy(last, dev);
+            double expected = stub_power(dev) * seconds;
+            success &= before && after &&
+                std::abs(joules<double>(*after - *before).count() - expected) <= 0.05 * expected;
+        }
+        if (!success)
+            std::cerr << "wrong readings of device " << dev << "\n";
+        return success;
+    }
+
+    // run in a process of its own, since the stub is configured once per process
+    int run_mode(const char* name, uint32_t devices, size_t reads)
+    {
+        using namespace nrgprf;
+        try
+        {
+            device_mask mask;
+            for (uint32_t dev = 0; dev < devices; dev++)
+                mask.set(dev);
+            auto support = reader_gpu::support(mask);
+            if (!support)
+                throw exception(support.error());
+            std::ostream null_stream(nullptr);
+            reader_gpu reader(*support, mask, null_stream);
+
+            sample first;
+            sample last;
+            auto start = std::chrono::steady_clock::now();
+            if (std::error_code ec; !reader.read(first, ec))
+                throw exception(ec);
+            auto begin_reads = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < reads; i++)
+                if (std::error_code ec; !reader.read(last, ec))
+                    throw exception(ec);
+            double us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - begin_reads).count() / reads;
+            // long enough for the energy to be compared to the power
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if (std::error_code ec; !reader.read(last, ec))
+                throw exception(ec);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+            bool success = true;
+            for (uint32_t dev = 0; dev < devices; dev++)
+                success &= check_device(reader, *support, first, last, seconds, dev);
+            std::cout << std::left << std::setw(24) << name << std::right
+                << std::setw(8) << reader.num_events()
+                << std::fixed << std::setprecision(1) << std::setw(14) << us
+                << std::setw(10) << (success ? "ok" : "FAILED") << std::endl;
+            return !success;
+        }
+        catch (const nrgprf::exception& e)
+        {
+            std::cerr << name << ": NRG exception: " << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    bool parse(const char* arg, size_t& into)
+    {
+        char* end;
+        into = std::strtoull(arg, &end, 10);
+        return !*end && end != arg;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 5 && !std::strcmp(argv[1], "--mode"))
+        return run_mode(argv[2], std::strtoul(argv[3], nullptr, 10),
+            std::strtoull(argv[4], nullptr, 10));
+
+    size_t devices = nrgprf::max_devices;
+    size_t latency = 100;
+    size_t reads = 200;
+    if (argc > 4 ||
+        (argc > 1 && (!parse(argv[1], devices) || !devices || devices > nrgprf::max_devices)) ||
+        (argc > 2 && !parse(argv[2], latency)) ||
+        (argc > 3 && (!parse(argv[3], reads) || !reads)))
+    {
+        std::cerr << "Usage: " << argv[0] << " [devices (1-" << nrgprf::max_devices
+            << ", default: " << nrgprf::max_devices << ")]"
+            << " [latency of a query in us (default: 100)] [reads (default: 200)]\n";
+        return 1;
+    }
+
+    std::cout << "devices: " << devices << ", latency: " << latency << " us"
+        << ", reads: " << reads << "\n"
+        << std::left << std::setw(24) << "mode" << std::right
+        << std::setw(8) << "events"
+        << std::setw(14) << "us/read"
+        << std::setw(10) << "readings" << std::endl;
+    std::string devices_arg = std::to_string(devices);
+    std::string latency_arg = std::to_string(latency);
+    std::string reads_arg = std::to_string(reads);
+    bool success = true;
+    for (const auto& mode : modes)
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cerr << "fork: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        if (!pid)
+        {
+            setenv("NVML_STUB_DEVICES", devices_arg.c_str(), 1);
+            setenv("NVML_STUB_LATENCY", latency_arg.c_str(), 1);
+            setenv("NVML_STUB_FIELDS", mode.fields, 1);
+            setenv("NVML_STUB_ENERGY", mode.energy, 1);
+            execl("/proc/self/exe", argv[0], "--mode", mode.name, devices_arg.c_str(),
+                reads_arg.c_str(), nullptr);
+            _exit(1);
+        }
+        int status;
+        success &= waitpid(pid, &status, 0) == pid && WIFEXITED(status) && !WEXITSTATUS(status);
+    }
+    return !success;
+}
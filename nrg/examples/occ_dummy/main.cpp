@@ -0,0 +1,112 @@
+// measures the time to read the OCC sensors from the dummy file of misc/occ,
+// of all sockets at once and of a single socket, and checks that the readings
+// of every location are those of the file
+
+#include <nrg/nrg.hpp>
+#include <nonstd/expected.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    template<typename Location>
+    bool print_reading(const nrgprf::reader_rapl& reader, const nrgprf::sample& first,
+        const nrgprf::sample& last, const char* name)
+    {
+        auto before = reader.value<Location>(first, 0);
+        auto after = reader.value<Location>(last, 0);
+        if (!before || !after)
+            return true;
+        std::cout << std::setw(8) << name
+            << std::setw(14) << before->power.count()
+            << std::setw(14) << after->power.count() << "\n";
+        // the file does not change, so neither do the readings
+        return before->power == after->power && before->timestamp == after->timestamp;
+    }
+
+    template<typename Func>
+    double us_per_read(size_t reads, Func&& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < reads; i++)
+            func();
+        return std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count() / reads;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        using namespace nrgprf;
+
+        size_t reads = 100000;
+        if (argc > 2)
+        {
+            std::cerr << "Usage: " << argv[0] << " [reads (default: " << reads << ")]\n";
+            return 1;
+        }
+        if (argc == 2)
+        {
+            char* end;
+            reads = std::strtoull(argv[1], &end, 10);
+            if (*end || end == argv[1] || !reads)
+            {
+                std::cerr << "invalid number of reads '" << argv[1] << "'\n";
+                return 1;
+            }
+        }
+
+        reader_rapl reader(locmask::all, 0x1);
+        sample first;
+        sample last;
+        if (std::error_code ec; !reader.read(first, ec))
+            throw exception(ec);
+
+        std::error_code ec;
+        double all = us_per_read(reads, [&]()
+            {
+                if (!reader.read(last, ec))
+                    throw exception(ec);
+            });
+        double single = us_per_read(reads, [&]()
+            {
+                if (!reader.read(last, 0, ec))
+                    throw exception(ec);
+            });
+
+        std::cout << "events: " << reader.num_events() << ", reads: " << reads << "\n"
+            << std::fixed << std::setprecision(3)
+            << "all events: " << all << " us/read\n"
+            << "single event: " << single << " us/read\n"
+            << std::setw(8) << "location"
+            << std::setw(14) << "first (uW)"
+            << std::setw(14) << "last (uW)" << "\n";
+        bool same = true;
+        same &= print_reading<loc::sys>(reader, first, last, "sys");
+        same &= print_reading<loc::pkg>(reader, first, last, "pkg");
+        same &= print_reading<loc::cores>(reader, first, last, "cores");
+        same &= print_reading<loc::uncore>(reader, first, last, "uncore");
+        same &= print_reading<loc::mem>(reader, first, last, "mem");
+        same &= print_reading<loc::gpu>(reader, first, last, "gpu");
+        if (!same)
+        {
+            std::cerr << "the readings of the first and last samples differ\n";
+            return 1;
+        }
+    }
+    catch (const nrgprf::exception& e)
+    {
+        std::cerr << "NRG exception: " << e.what() << '\n';
+        return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,110 @@
+// stress test of the tracking of wraparounds of the RAPL counters: several threads
+// read a simulated counter with a short period and extend the readings through the same
+// event, as samplers sharing a reader do, and every extended value must be the total count
+
+#include "x86_64/reader_cpu.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint64_t max = 999;
+    constexpr uint64_t period = max + 1;
+    constexpr uint64_t initial = 123;
+
+    struct thread_result
+    {
+        uint64_t reads = 0;
+        uint64_t wrong = 0;
+        // reads made more than a period after the value they were extended from,
+        // which the counters do not support
+        uint64_t too_late = 0;
+        uint64_t highest = 0;
+    };
+
+    // the count of the hardware, which every read advances
+    std::atomic<uint64_t> counter{ initial };
+
+    void sample(const nrgprf::event_data& ev, size_t reads, unsigned seed, thread_result& res)
+    {
+        std::mt19937 gen(seed);
+        // mostly short intervals between reads, as of concurrent samplers, and some
+        // of more than half a period, as of the bounds of a long section
+        std::uniform_int_distribution<uint64_t> small(0, period / 20);
+        std::uniform_int_distribution<uint64_t> large(period / 2, period * 9 / 10);
+        for (size_t i = 0; i < reads; i++)
+        {
+            uint64_t last = ev.last();
+            uint64_t total = counter.fetch_add(i % 16 ? small(gen) : large(gen));
+            uint64_t value = ev.extend(last, total % period);
+            res.reads++;
+            if (total - last >= period)
+                res.too_late++;
+            else if (value != total)
+                res.wrong++;
+            if (value > res.highest)
+                res.highest = value;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t threads = 8;
+    size_t reads = 1000000;
+    if (argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " [threads (default: " << threads << ")] "
+            << "[reads per thread (default: " << reads << ")]\n";
+        return 1;
+    }
+    if (argc > 1)
+        threads = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2)
+        reads = std::strtoull(argv[2], nullptr, 10);
+    if (!threads || !reads)
+    {
+        std::cerr << "the number of threads and reads must be positive\n";
+        return 1;
+    }
+
+    nrgprf::event_data ev(nrgprf::file_descriptor("/dev/null"), max, initial);
+    std::vector<thread_result> results(threads);
+    std::vector<std::thread> samplers;
+    for (size_t t = 0; t < threads; t++)
+        samplers.emplace_back(sample, std::cref(ev), reads, t, std::ref(results[t]));
+    for (auto& t : samplers)
+        t.join();
+
+    thread_result total;
+    for (const auto& res : results)
+    {
+        total.reads += res.reads;
+        total.wrong += res.wrong;
+        total.too_late += res.too_late;
+        total.highest = std::max(total.highest, res.highest);
+    }
+    std::cout << "threads: " << threads
+        << ", reads: " << total.reads
+        << ", wraparounds: " << (counter.load() - initial) / period
+        << ", reads too late: " << total.too_late
+        << ", wrong values: " << total.wrong << "\n";
+    if (total.wrong)
+        return 1;
+    // the published value is the highest one extended
+    if (ev.last() != total.highest)
+    {
+        std::cerr << "last value " << ev.last() << " is not the highest " << total.highest << "\n";
+        return 1;
+    }
+    if (total.too_late == total.reads)
+    {
+        std::cerr << "no read could be checked\n";
+        return 1;
+    }
+}
@@ -14,6 +14,8 @@ namespace nrgprf
         struct sample_data
         {
             std::array<uint64_t, max_cpu_events> cpu;
+            // in the order in which the cores were added to the reader
+            std::array<uint64_t, max_cores> core_energy;
             std::array<uint32_t, max_devices> gpu_power;
             std::array<uint64_t, max_devices> gpu_energy;
         };
@@ -22,6 +24,7 @@ namespace nrgprf
         {
             std::array<uint64_t, max_cpu_events> timestamps;
             std::array<uint16_t, max_cpu_events> cpu;
+            std::array<uint64_t, max_cpu_events> accumulators;
             std::array<uint32_t, max_devices> gpu_power;
             std::array<uint64_t, max_devices> gpu_energy;
         };
@@ -3,20 +3,44 @@
 #include <nrg/arch.hpp>
 #include <nrg/units.hpp>
 
+#include <vector>
+
 namespace nrgprf
 {
     namespace detail
     {
     #if defined NRG_X86_64
         using reader_return = microjoules<uintmax_t>;
+
+        // the readings of a location in a range of samples, in dense arrays
+        // which skip the samples without a reading, see reader_rapl::values
+        struct reader_batch
+        {
+            // counter values in microjoules
+            std::vector<uintmax_t> energy;
+        };
     #elif defined NRG_PPC64
         struct reader_return_st
         {
             using time_point = std::chrono::time_point<std::chrono::steady_clock>;
             time_point timestamp;
             microwatts<uintmax_t> power;
+            // cumulative energy of the sensor, zero if it has not accumulated any yet
+            microjoules<uintmax_t> energy;
         };
         using reader_return = reader_return_st;
+
+        // the readings of a location in a range of samples, in dense arrays
+        // which skip the samples without a reading, see reader_rapl::values
+        struct reader_batch
+        {
+            // sensor timestamps in nanoseconds
+            std::vector<int64_t> timestamps;
+            // power in microwatts
+            std::vector<uintmax_t> power;
+            // cumulative energy in microjoules, zero where it was not accumulated
+            std::vector<uintmax_t> energy;
+        };
     #endif
     }
 }
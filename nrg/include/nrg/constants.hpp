@@ -23,6 +23,10 @@ namespace nrgprf
     constexpr size_t max_locations = 32;
     constexpr size_t max_sockets = 8;
     constexpr size_t max_devices = 8;
+    // cores with per-core energy, numbered by their first logical CPU
+    constexpr size_t max_cores = 128;
+    // readers of a hybrid reader whose read times are recorded in the sample
+    constexpr size_t max_hybrid_readers = 4;
 
     constexpr size_t max_domains = detail::max_domains;
     constexpr size_t max_cpu_events = max_sockets * max_domains;
@@ -5,12 +5,15 @@
 
 #include <nonstd/expected.hpp>
 
+#include <chrono>
+
 namespace nrgprf
 {
     template<typename... Ts>
     hybrid_reader_tp<Ts...>::caller::caller(sample& s, std::error_code& ec) :
         _sample(s),
-        _ec(ec)
+        _ec(ec),
+        _idx(0)
     {}
 
     template<typename... Ts>
@@ -19,7 +22,15 @@ namespace nrgprf
         const First& first,
         const Rest&... rest)
     {
-        if (!first.read(_sample, _ec))
+        auto now = []()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        };
+        int64_t before = now();
+        bool ok = first.read(_sample, _ec);
+        _sample.reader_times[_idx++] = before + (now() - before) / 2;
+        if (!ok)
             return false;
         if constexpr (sizeof...(rest) > 0)
             if (!operator()(rest...))
@@ -44,6 +44,10 @@ namespace nrgprf
         invalid_device_mask,
         invalid_location_mask,
         unsupported_units,
+        segment_format_error,
+        readings_stale,
+        core_energy_not_supported,
+        too_many_readers,
         unknown_error,
     };
 
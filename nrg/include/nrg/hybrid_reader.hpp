@@ -1,10 +1,12 @@
 // hybrid_reader.hpp
 #pragma once
 
+#include <nrg/constants.hpp>
 #include <nrg/reader.hpp>
 #include <nrg/types.hpp>
 #include <nrg/detail/all_reader_ptrs.hpp>
 
+#include <memory>
 #include <vector>
 
 namespace nrgprf
@@ -15,7 +17,13 @@ namespace nrgprf
     class hybrid_reader : public reader
     {
     private:
+        class reader_threads;
+
         std::vector<const reader*> _readers;
+        bool _parallel;
+        // the threads of every reader but the first, which is read on the calling thread,
+        // when the readers are read in parallel
+        std::unique_ptr<reader_threads> _threads;
 
     public:
         using reader::read;
@@ -25,17 +33,36 @@ namespace nrgprf
             std::enable_if_t<detail::all_reader_ptrs_v<Readers...>, bool> = true
         > hybrid_reader(const Readers&...);
 
+        ~hybrid_reader();
+        hybrid_reader(const hybrid_reader&);
+        hybrid_reader(hybrid_reader&&) noexcept;
+
+        hybrid_reader& operator=(const hybrid_reader&);
+        hybrid_reader& operator=(hybrid_reader&&) noexcept;
+
         void push_back(const reader&);
 
+        // read the readers at the same time, each on a thread of its own, instead of
+        // one after another; the readers must write disjoint readings of the sample
+        // and the reads of the hybrid reader are serialized
+        void parallel(bool);
+        bool parallel() const noexcept;
+
         bool read(sample&, std::error_code&) const override;
         bool read(sample&, uint8_t, std::error_code&) const override;
         size_t num_events() const noexcept override;
+
+    private:
+        explicit hybrid_reader(std::vector<const reader*>&&);
     };
 
     template<
         typename... Readers,
         std::enable_if_t<detail::all_reader_ptrs_v<Readers...>, bool>
     > hybrid_reader::hybrid_reader(const Readers&... reader) :
-        _readers({ &reader... })
-    {}
+        hybrid_reader(std::vector<const nrgprf::reader*>{ &reader... })
+    {
+        static_assert(sizeof...(Readers) <= max_hybrid_readers,
+            "At most max_hybrid_readers Readers must be provided");
+    }
 }
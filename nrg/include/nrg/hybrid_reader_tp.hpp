@@ -1,5 +1,6 @@
 #pragma once
 
+#include <nrg/constants.hpp>
 #include <nrg/reader.hpp>
 #include <nrg/detail/all_reader_ptrs.hpp>
 
@@ -16,6 +17,8 @@ namespace nrgprf
     {
         static_assert(sizeof...(Ts) > 0,
             "At least one Ts must be provided");
+        static_assert(sizeof...(Ts) <= max_hybrid_readers,
+            "At most max_hybrid_readers Ts must be provided");
         static_assert(std::conjunction_v<
             std::is_same<Ts, detail::remove_cvref_t<Ts>>...>,
             "Ts must be non-const, non-volatile, non-reference types");
@@ -27,6 +30,7 @@ namespace nrgprf
         {
             sample& _sample;
             std::error_code& _ec;
+            size_t _idx;
 
             caller(sample&, std::error_code&);
 
@@ -10,5 +10,7 @@ namespace nrgprf
         struct uncore;
         struct mem;
         struct gpu;
+        // the energy of a single core, whose index is the core instead of the socket
+        struct core;
     }
 }
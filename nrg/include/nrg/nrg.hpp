@@ -10,8 +10,10 @@
 #include <nrg/location.hpp>
 #include <nrg/reader_gpu.hpp>
 #include <nrg/reader_rapl.hpp>
+#include <nrg/reader_shm.hpp>
 #include <nrg/reader.hpp>
 #include <nrg/readings_type.hpp>
 #include <nrg/sample.hpp>
+#include <nrg/subscription.hpp>
 #include <nrg/types.hpp>
 #include <nrg/units.hpp>
@@ -24,6 +24,9 @@ namespace nrgprf
     public:
         using reader::read;
 
+        // the energy of every core in core_mask is read as well, see loc::core;
+        // a logical CPU stands for the core it belongs to
+        explicit reader_rapl(location_mask, socket_mask, core_mask, std::ostream & = std::cout);
         explicit reader_rapl(location_mask, socket_mask, std::ostream & = std::cout);
         explicit reader_rapl(location_mask, std::ostream & = std::cout);
         explicit reader_rapl(socket_mask, std::ostream & = std::cout);
@@ -51,6 +54,14 @@ namespace nrgprf
         template<typename Location>
         std::vector<std::pair<uint32_t, sensor_value>> values(const sample&) const;
 
+        // the readings of a location in <count> samples, which are <stride> bytes apart
+        // so that they can be members of larger structures, converted at once;
+        // samples without a reading are skipped, so the batch is compacted: its i-th reading
+        // is not that of the i-th sample unless the result is <count>;
+        // returns the number of readings
+        template<typename Location>
+        size_t values(const sample*, size_t count, size_t stride, uint8_t, sensor_batch&) const;
+
     private:
         const impl* pimpl() const noexcept;
         impl* pimpl() noexcept;
@@ -0,0 +1,86 @@
+// reader_shm.hpp
+
+#pragma once
+
+#include <nrg/reader.hpp>
+#include <nrg/readings_type.hpp>
+#include <nrg/sample.hpp>
+#include <nrg/types.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nrgprf
+{
+    // the readers of a sensor daemon, which the readers of its segment have to be created with
+    // so that they interpret the published samples in the same way
+    struct segment_info
+    {
+        location_mask locations;
+        socket_mask sockets;
+        device_mask devices;
+        readings_type::type gpu_readings;
+        size_t num_events;
+        std::chrono::nanoseconds period;
+    };
+
+    struct published_sample
+    {
+        using time_point = std::chrono::steady_clock::time_point;
+        time_point timestamp;
+        sample value;
+    };
+
+    // publishes samples to a POSIX shared memory segment, which holds the latest samples
+    // in a ring, every slot of which is protected by a sequence lock;
+    // a single publisher writes to a segment, which is removed when the publisher is destroyed
+    class sensor_publisher
+    {
+    private:
+        struct impl;
+        std::unique_ptr<impl> _impl;
+
+    public:
+        static constexpr char default_name[] = "/nrg-sensors";
+        static constexpr size_t default_history = 1024;
+
+        sensor_publisher(const std::string& name, const segment_info&,
+            size_t history = default_history);
+
+        sensor_publisher(sensor_publisher&&) noexcept;
+        sensor_publisher& operator=(sensor_publisher&&) noexcept;
+
+        ~sensor_publisher();
+
+        void publish(const sample&, published_sample::time_point);
+    };
+
+    // reads the latest sample of a segment without system calls;
+    // reading with an index reads the whole sample
+    class reader_shm final : public reader
+    {
+    private:
+        struct impl;
+        std::shared_ptr<const impl> _impl;
+
+    public:
+        using reader::read;
+
+        // readings which are older than this many periods of the publisher are stale,
+        // since the publisher is no longer running
+        static constexpr unsigned stale_periods = 100;
+
+        explicit reader_shm(const std::string& name = sensor_publisher::default_name);
+
+        bool read(sample&, std::error_code&) const override;
+        bool read(sample&, uint8_t, std::error_code&) const override;
+        size_t num_events() const noexcept override;
+
+        const segment_info& info() const noexcept;
+
+        // the samples in the ring, oldest first
+        size_t history(std::vector<published_sample>&) const;
+    };
+}
@@ -21,6 +21,9 @@ namespace nrgprf
         using value_type = uint64_t;
 
         detail::sample_data data;
+        // steady clock time in nanoseconds halfway through the read of every reader
+        // of a hybrid reader, in the order of the readers, 0 if not read by one
+        std::array<int64_t, max_hybrid_readers> reader_times;
 
         sample();
 
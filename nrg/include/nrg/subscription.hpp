@@ -0,0 +1,124 @@
+// subscription.hpp
+
+#pragma once
+
+#include <nrg/reader_shm.hpp>
+#include <nrg/sample.hpp>
+#include <nrg/types.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <system_error>
+
+namespace nrgprf
+{
+    class reader;
+
+    namespace detail
+    {
+        struct poll_state;
+        struct subscription_entry;
+    }
+
+    // how often the reader of a subscription is read and which samples are delivered
+    struct poll_policy
+    {
+        std::chrono::nanoseconds period;
+        // deliver only the samples whose readings differ from the last one delivered
+        bool on_change;
+
+        // every sample read every period
+        static poll_policy rate(std::chrono::nanoseconds period) noexcept;
+        // the samples read every period whose readings changed
+        static poll_policy changes(std::chrono::nanoseconds period) noexcept;
+    };
+
+    // bounded queue of the samples of a subscription, which the engine pushes to
+    // and a single consumer pops from without locking;
+    // samples pushed to a full queue are dropped
+    class sample_queue
+    {
+    private:
+        std::unique_ptr<published_sample[]> _ring;
+        size_t _capacity;
+        alignas(64) std::atomic<size_t> _head;
+        alignas(64) std::atomic<size_t> _tail;
+        std::atomic<uint64_t> _dropped;
+
+    public:
+        static constexpr size_t default_capacity = 1024;
+
+        explicit sample_queue(size_t capacity = default_capacity);
+
+        sample_queue(const sample_queue&) = delete;
+        sample_queue& operator=(const sample_queue&) = delete;
+
+        bool push(const published_sample&) noexcept;
+        bool pop(published_sample&) noexcept;
+
+        size_t size() const noexcept;
+        size_t capacity() const noexcept;
+        // the samples dropped since the queue was full
+        uint64_t dropped() const noexcept;
+    };
+
+    using subscription_callback = std::function<void(const result<published_sample>&)>;
+
+    // a reader registered with an engine, which stops delivering its samples
+    // once the subscription is cancelled or destroyed
+    class subscription
+    {
+    private:
+        friend class poll_engine;
+
+        std::weak_ptr<detail::poll_state> _state;
+        std::shared_ptr<detail::subscription_entry> _entry;
+
+        subscription(std::weak_ptr<detail::poll_state>,
+            std::shared_ptr<detail::subscription_entry>) noexcept;
+
+    public:
+        subscription() noexcept;
+        ~subscription();
+
+        subscription(subscription&&) noexcept;
+        subscription& operator=(subscription&&) noexcept;
+
+        // no sample is delivered after it returns, unless it is called by the callback itself
+        void cancel();
+        bool active() const noexcept;
+        // the error of the last read which failed, reads of queue subscriptions
+        // failing without anything being pushed
+        std::error_code error() const;
+    };
+
+    // background thread which reads the readers of every subscription on a single timer;
+    // the periods of all subscriptions are counted from the same instant and subscriptions
+    // to the same reader which are due at the same time share a single read of it;
+    // readers and queues must outlive their subscriptions
+    class poll_engine
+    {
+    private:
+        std::shared_ptr<detail::poll_state> _state;
+
+    public:
+        poll_engine();
+        // the thread runs on the logical CPUs in the mask
+        explicit poll_engine(const cpu_mask&);
+        // stops the thread and waits for the delivery in progress, unless called by a callback
+        ~poll_engine();
+
+        poll_engine(poll_engine&&) noexcept;
+        poll_engine& operator=(poll_engine&&) noexcept;
+
+        // the engine shared by every consumer in the process
+        static poll_engine& shared();
+
+        void affinity(const cpu_mask&);
+
+        subscription subscribe(const reader&, poll_policy, subscription_callback);
+        subscription subscribe(const reader&, poll_policy, sample_queue&);
+    };
+}
@@ -16,6 +16,7 @@ namespace nrgprf
     using units_power = microwatts<uintmax_t>;
 
     using sensor_value = detail::reader_return;
+    using sensor_batch = detail::reader_batch;
 
     template<typename R>
     using result = nonstd::expected<R, std::error_code>;
@@ -23,4 +24,7 @@ namespace nrgprf
     using location_mask = std::bitset<max_locations>;
     using socket_mask = std::bitset<max_sockets>;
     using device_mask = std::bitset<max_devices>;
+    using core_mask = std::bitset<max_cores>;
+    // logical CPUs
+    using cpu_mask = std::bitset<max_cores>;
 }
@@ -239,6 +239,14 @@ namespace nrgprf
         return detail::unit_cast<power_unit, typename ToUnit::rep, typename ToUnit::ratio, Rep, Ratio>(unit);
     }
 
+    // converts an array of counts at once, e.g., the readings of a sensor_batch
+    template<typename ToUnit, typename FromUnit>
+    void unit_cast(const typename FromUnit::rep* from, size_t count, typename ToUnit::rep* into)
+    {
+        for (size_t ix = 0; ix < count; ix++)
+            into[ix] = unit_cast<ToUnit>(FromUnit(from[ix])).count();
+    }
+
     template<template<typename, typename> typename U, typename LhsRep, typename LhsRatio, typename RhsRep, typename RhsRatio>
     constexpr bool operator==(const U<LhsRep, LhsRatio>& lhs, const U<RhsRep, RhsRatio>& rhs)
     {
@@ -0,0 +1,206 @@
+// nvml_stub.cpp
+// stub of libnvidia-ml which simulates devices, for building and testing the NVIDIA reader
+// on machines without NVIDIA GPUs; configured through the environment:
+//   NVML_STUB_DEVICES  number of devices (default: 1)
+//   NVML_STUB_LATENCY  microseconds every query of a device takes (default: 0)
+//   NVML_STUB_FIELDS   0 if the devices do not support the field values (default: 1)
+//   NVML_STUB_ENERGY   0 if the devices do not support energy readings (default: 1)
+// device i draws a constant 50 + 25 * i W, its energy being accumulated since nvmlInit
+
+#include "nvml.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+struct nvmlDevice_st
+{
+    unsigned int index;
+    unsigned int power;
+};
+
+namespace
+{
+    constexpr unsigned int max_devices = 16;
+
+    struct stub_state
+    {
+        std::mutex mtx;
+        unsigned int refcount = 0;
+        unsigned int devices = 0;
+        std::chrono::microseconds latency{ 0 };
+        bool fields = true;
+        bool energy = true;
+        std::chrono::steady_clock::time_point start;
+        std::array<nvmlDevice_st, max_devices> handles;
+    };
+
+    stub_state state;
+
+    unsigned long env_value(const char* name, unsigned long dflt)
+    {
+        const char* value = std::getenv(name);
+        if (!value || !*value)
+            return dflt;
+        char* end;
+        unsigned long retval = std::strtoul(value, &end, 10);
+        return *end ? dflt : retval;
+    }
+
+    // checks the device and takes the latency of a query
+    nvmlReturn_t query(nvmlDevice_t device)
+    {
+        if (!state.refcount)
+            return NVML_ERROR_UNINITIALIZED;
+        if (!device || device->index >= state.devices)
+            return NVML_ERROR_INVALID_ARGUMENT;
+        if (state.latency.count())
+            std::this_thread::sleep_for(state.latency);
+        return NVML_SUCCESS;
+    }
+
+    // in mJ
+    unsigned long long energy(nvmlDevice_t device)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - state.start);
+        return static_cast<unsigned long long>(elapsed.count()) * device->power / 1000000;
+    }
+}
+
+extern "C"
+{
+    nvmlReturn_t nvmlInit(void)
+    {
+        std::scoped_lock lock(state.mtx);
+        if (state.refcount++)
+            return NVML_SUCCESS;
+        state.devices = std::min<unsigned int>(env_value("NVML_STUB_DEVICES", 1), max_devices);
+        state.latency = std::chrono::microseconds(env_value("NVML_STUB_LATENCY", 0));
+        state.fields = env_value("NVML_STUB_FIELDS", 1);
+        state.energy = env_value("NVML_STUB_ENERGY", 1);
+        state.start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < max_devices; i++)
+            state.handles[i] = { i, (50 + 25 * i) * 1000 };
+        return NVML_SUCCESS;
+    }
+
+    nvmlReturn_t nvmlShutdown(void)
+    {
+        std::scoped_lock lock(state.mtx);
+        if (!state.refcount)
+            return NVML_ERROR_UNINITIALIZED;
+        state.refcount--;
+        return NVML_SUCCESS;
+    }
+
+    const char* nvmlErrorString(nvmlReturn_t result)
+    {
+        switch (result)
+        {
+        case NVML_SUCCESS:
+            return "Success";
+        case NVML_ERROR_UNINITIALIZED:
+            return "Uninitialized";
+        case NVML_ERROR_INVALID_ARGUMENT:
+            return "Invalid Argument";
+        case NVML_ERROR_NOT_SUPPORTED:
+            return "Not Supported";
+        case NVML_ERROR_INSUFFICIENT_SIZE:
+            return "Insufficient Size";
+        default:
+            return "Unknown Error";
+        }
+    }
+
+    nvmlReturn_t nvmlDeviceGetCount(unsigned int* deviceCount)
+    {
+        if (!state.refcount)
+            return NVML_ERROR_UNINITIALIZED;
+        if (!deviceCount)
+            return NVML_ERROR_INVALID_ARGUMENT;
+        *deviceCount = state.devices;
+        return NVML_SUCCESS;
+    }
+
+    nvmlReturn_t nvmlDeviceGetHandleByIndex(unsigned int index, nvmlDevice_t* device)
+    {
+        if (!state.refcount)
+            return NVML_ERROR_UNINITIALIZED;
+        if (index >= state.devices || !device)
+            return NVML_ERROR_INVALID_ARGUMENT;
+        *device = &state.handles[index];
+        return NVML_SUCCESS;
+    }
+
+    nvmlReturn_t nvmlDeviceGetName(nvmlDevice_t device, char* name, unsigned int length)
+    {
+        if (!state.refcount)
+            return NVML_ERROR_UNINITIALIZED;
+        if (!device || device->index >= state.devices || !name)
+            return NVML_ERROR_INVALID_ARGUMENT;
+        if (std::snprintf(name, length, "NVML Stub GPU %u", device->index) >= int(length))
+            return NVML_ERROR_INSUFFICIENT_SIZE;
+        return NVML_SUCCESS;
+    }
+
+    nvmlReturn_t nvmlDeviceGetPowerUsage(nvmlDevice_t device, unsigned int* power)
+    {
+        if (nvmlReturn_t res = query(device); res != NVML_SUCCESS)
+            return res;
+        if (!power)
+            return NVML_ERROR_INVALID_ARGUMENT;
+        *power = device->power;
+        return NVML_SUCCESS;
+    }
+
+    nvmlReturn_t nvmlDeviceGetTotalEnergyConsumption(nvmlDevice_t device, unsigned long long* energy)
+    {
+        if (nvmlReturn_t res = query(device); res != NVML_SUCCESS)
+            return res;
+        if (!energy)
+            return NVML_ERROR_INVALID_ARGUMENT;
+        if (!state.energy)
+            return NVML_ERROR_NOT_SUPPORTED;
+        *energy = ::energy(device);
+        return NVML_SUCCESS;
+    }
+
+    nvmlReturn_t nvmlDeviceGetFieldValues(nvmlDevice_t device, int valuesCount, nvmlFieldValue_t* values)
+    {
+        if (nvmlReturn_t res = query(device); res != NVML_SUCCESS)
+            return res;
+        if (valuesCount < 0 || (valuesCount && !values))
+            return NVML_ERROR_INVALID_ARGUMENT;
+        long long now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (int i = 0; i < valuesCount; i++)
+        {
+            nvmlFieldValue_t& value = values[i];
+            value.timestamp = now;
+            value.latencyUsec = 0;
+            value.nvmlReturn = state.fields ? NVML_SUCCESS : NVML_ERROR_NOT_SUPPORTED;
+            switch (value.fieldId)
+            {
+            case NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION:
+                if (!state.energy)
+                    value.nvmlReturn = NVML_ERROR_NOT_SUPPORTED;
+                value.valueType = NVML_VALUE_TYPE_UNSIGNED_LONG_LONG;
+                value.value.ullVal = ::energy(device);
+                break;
+            case NVML_FI_DEV_POWER_AVERAGE:
+            case NVML_FI_DEV_POWER_INSTANT:
+                value.valueType = NVML_VALUE_TYPE_UNSIGNED_INT;
+                value.value.uiVal = device->power;
+                break;
+            default:
+                value.nvmlReturn = NVML_ERROR_NOT_SUPPORTED;
+            }
+        }
+        return NVML_SUCCESS;
+    }
+}
@@ -3,9 +3,14 @@
 #include <nonstd/expected.hpp>
 #include <util/concat.hpp>
 
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <set>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace nrgprf
 {
@@ -37,4 +42,57 @@ namespace nrgprf
             return rettype(nonstd::unexpect, errc::too_many_sockets);
         return packages.size();
     }
+
+    result<core_mask> first_siblings(core_mask cpus)
+    {
+        using rettype = result<core_mask>;
+        char filename[128];
+        core_mask retval;
+        for (size_t cpu = 0; cpu < cpus.size(); cpu++)
+        {
+            if (!cpus[cpu])
+                continue;
+            snprintf(filename, sizeof(filename),
+                "/sys/devices/system/cpu/cpu%zu/topology/thread_siblings_list", cpu);
+            std::ifstream ifs(filename, std::ios::in);
+            // the list starts with the first sibling, e.g. 0,64 or 0-1
+            uint32_t first;
+            if (!ifs || !(ifs >> first))
+                return rettype(nonstd::unexpect, errno, std::system_category());
+            if (first < retval.size())
+                retval.set(first);
+        }
+        return retval;
+    }
+
+    file_descriptor::file_descriptor(const char* file) :
+        value(open(file, O_RDONLY))
+    {
+        if (value == -1)
+            throw exception(std::error_code{ errno, std::system_category() });
+    }
+
+    file_descriptor::file_descriptor(const file_descriptor& other) :
+        value(dup(other.value))
+    {
+        if (value == -1)
+            throw exception(std::error_code{ errno, std::system_category() });
+    }
+
+    file_descriptor::file_descriptor(file_descriptor&& other) noexcept :
+        value(std::exchange(other.value, -1))
+    {}
+
+    file_descriptor::~file_descriptor() noexcept
+    {
+        if (value >= 0 && close(value) == -1)
+            perror("file_descriptor: error closing file");
+    }
+
+    file_descriptor& file_descriptor::operator=(file_descriptor&& other) noexcept
+    {
+        value = other.value;
+        other.value = -1;
+        return *this;
+    }
 }
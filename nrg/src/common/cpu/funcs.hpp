@@ -21,4 +21,19 @@ namespace nrgprf
     }
 
     NRG_LOCAL result<uint8_t> count_sockets();
+
+    // replaces every logical CPU with the first logical CPU of the core it belongs to
+    NRG_LOCAL result<core_mask> first_siblings(core_mask cpus);
+
+    struct NRG_LOCAL file_descriptor
+    {
+        int value;
+
+        explicit file_descriptor(const char* file);
+        ~file_descriptor() noexcept;
+
+        file_descriptor(const file_descriptor& fd);
+        file_descriptor(file_descriptor&& fd) noexcept;
+        file_descriptor& operator=(file_descriptor&& other) noexcept;
+    };
 }
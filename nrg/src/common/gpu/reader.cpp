@@ -11,6 +11,8 @@ namespace nrgprf
         return ev.read_func(s, ev.stride, ev.handle, ec);
     }
 
+#if !defined(GPU_NV)
+    // the NVIDIA reader queries the events of a device at once
     bool reader_gpu_impl::read(sample& s, std::error_code& ec) const noexcept
     {
         for (size_t idx = 0; idx < events.size(); idx++)
@@ -18,6 +20,7 @@ namespace nrgprf
                 return false;
         return true;
     }
+#endif // !defined(GPU_NV)
 
     int8_t reader_gpu_impl::event_idx(readings_type::type rt, uint8_t device) const noexcept
     {
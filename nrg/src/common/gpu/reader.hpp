@@ -39,11 +39,27 @@ namespace nrgprf
             decltype(&read_energy) read_func;
         };
 
+    #if defined(GPU_NV)
+        // the events of a device read with a single query of their fields
+        struct NRG_LOCAL device_fields
+        {
+            gpu_handle handle;
+            size_t stride;
+            size_t count;
+            std::array<std::pair<unsigned int, readings_type::type>, 2> fields;
+        };
+    #endif // defined(GPU_NV)
+
         static result<readings_type::type> support(device_mask);
 
         lib_handle handle;
         std::array<std::array<int8_t, 2>, max_devices> event_map;
         std::vector<event> events;
+    #if defined(GPU_NV)
+        std::vector<device_fields> devices;
+        // the events whose readings are not fields of the device, read one at a time
+        std::vector<size_t> single_events;
+    #endif // defined(GPU_NV)
 
         reader_gpu_impl(readings_type::type, device_mask, std::ostream&);
 
@@ -78,6 +78,14 @@ namespace
             return "invalid sensor location mask (no sensors set)";
         case errc::unsupported_units:
             return "unsupported units";
+        case errc::segment_format_error:
+            return "invalid shared sensor segment format";
+        case errc::readings_stale:
+            return "readings of the shared sensor segment are stale";
+        case errc::core_energy_not_supported:
+            return "CPU does not support per-core energy readings";
+        case errc::too_many_readers:
+            return "too many readers in hybrid reader";
         case errc::unknown_error:
             return "unknown error";
         }
@@ -98,12 +106,14 @@ namespace
         case errc::invalid_domain_name:
         case errc::file_format_error:
         case errc::file_format_version_error:
+        case errc::segment_format_error:
         case errc::package_num_error:
         case errc::package_num_wrong_domain:
             return error_cause::setup_error;
         case errc::energy_readings_not_supported:
         case errc::power_readings_not_supported:
         case errc::readings_not_supported:
+        case errc::core_energy_not_supported:
             return error_cause::readings_support_error;
         case errc::not_implemented:
         case errc::operation_not_supported:
@@ -114,10 +124,12 @@ namespace
         case errc::unsupported_units:
             return error_cause::query_error;
         case errc::readings_not_valid:
+        case errc::readings_stale:
             return error_cause::read_error;
         case errc::invalid_socket_mask:
         case errc::invalid_device_mask:
         case errc::invalid_location_mask:
+        case errc::too_many_readers:
             return error_cause::invalid_argument;
         }
         return error_cause::unknown;
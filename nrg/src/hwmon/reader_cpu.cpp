@@ -0,0 +1,441 @@
+#include "../fileline.hpp"
+#include "../common/cpu/funcs.hpp"
+#include "reader_cpu.hpp"
+
+#include <nrg/location.hpp>
+#include <nrg/sample.hpp>
+
+#include <nonstd/expected.hpp>
+#include <util/concat.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if !defined(NRG_HWMON_ROOT)
+#define NRG_HWMON_ROOT "/sys/class/hwmon"
+#endif
+
+namespace nrgprf::loc
+{
+    struct pkg : std::integral_constant<int, bitnum(locmask::pkg)> {};
+    struct cores : std::integral_constant<int, bitnum(locmask::cores)> {};
+    struct uncore : std::integral_constant<int, bitnum(locmask::uncore)> {};
+    struct mem : std::integral_constant<int, bitnum(locmask::mem)> {};
+    struct sys : std::integral_constant<int, bitnum(locmask::sys)> {};
+    struct gpu {};
+    struct core {};
+}
+
+namespace
+{
+    constexpr char hwmon_root[] = NRG_HWMON_ROOT;
+
+    // channels are mapped to a location by the prefix of their label, case-insensitively,
+    // the first prefix which matches is used; the trailing number of the label, if any,
+    // is the socket, e.g. 'Esocket1' of amd_energy is the package of socket 1
+    // and 'Ecore003' is core 3, which is read as loc::core
+    constexpr std::string_view core_prefix = "ecore";
+
+    struct label_prefix
+    {
+        std::string_view prefix;
+        int32_t domain;
+    };
+
+    constexpr label_prefix label_prefixes[] = {
+        { "esocket", nrgprf::loc::pkg::value },
+        { "package", nrgprf::loc::pkg::value },
+        { "pkg", nrgprf::loc::pkg::value },
+        { "cpu", nrgprf::loc::pkg::value },
+        { "uncore", nrgprf::loc::uncore::value },
+        { "core", nrgprf::loc::cores::value },
+        { "vcore", nrgprf::loc::cores::value },
+        { "soc", nrgprf::loc::uncore::value },
+        { "dram", nrgprf::loc::mem::value },
+        { "mem", nrgprf::loc::mem::value },
+        { "sys", nrgprf::loc::sys::value },
+        { "board", nrgprf::loc::sys::value },
+        { "total", nrgprf::loc::sys::value },
+    };
+
+    struct channel
+    {
+        std::string prefix;
+        bool power;
+    };
+
+    // begin helper functions
+
+    std::error_code read_uint64(int fd, uint64_t& value)
+    {
+        constexpr static const size_t MAX_UINT64_SZ = 24;
+        char buffer[MAX_UINT64_SZ];
+        ssize_t len = pread(fd, buffer, sizeof(buffer), 0);
+        if (len < 0)
+            return { errno, std::system_category() };
+        auto [p, ec] = std::from_chars(buffer, buffer + len, value, 10);
+        if (ec != std::errc{})
+            return nrgprf::errc::readings_not_valid;
+        return {};
+    }
+
+    bool read_line(const char* filename, std::string& into)
+    {
+        char buffer[64];
+        int fd = open(filename, O_RDONLY);
+        if (fd == -1)
+            return false;
+        ssize_t len = pread(fd, buffer, sizeof(buffer), 0);
+        close(fd);
+        if (len < 0)
+            return false;
+        into.assign(buffer, len);
+        while (!into.empty() && std::isspace(static_cast<unsigned char>(into.back())))
+            into.pop_back();
+        return true;
+    }
+
+    bool label_starts_with(std::string_view label, std::string_view prefix)
+    {
+        return label.size() >= prefix.size() &&
+            std::equal(prefix.begin(), prefix.end(), label.begin(),
+                [](char p, char c)
+                {
+                    return p == std::tolower(static_cast<unsigned char>(c));
+                });
+    }
+
+    int32_t domain_index_from_label(std::string_view label)
+    {
+        for (const auto& [prefix, domain] : label_prefixes)
+            if (label_starts_with(label, prefix))
+                return domain;
+        return -1;
+    }
+
+    uint32_t number_from_label(std::string_view label)
+    {
+        size_t pos = label.size();
+        while (pos > 0 && std::isdigit(static_cast<unsigned char>(label[pos - 1])))
+            pos--;
+        uint32_t skt = 0;
+        std::from_chars(label.data() + pos, label.data() + label.size(), skt, 10);
+        return skt;
+    }
+
+    // the energy<n> and power<n> channels of a device which have a label,
+    // energy channels first since they are preferred over power channels of the same location
+    nrgprf::result<std::vector<channel>> get_channels(const char* base)
+    {
+        using namespace nrgprf;
+        using rettype = result<std::vector<channel>>;
+        DIR* dir = opendir(base);
+        if (!dir)
+            return rettype(nonstd::unexpect, errno, std::system_category());
+        std::vector<channel> channels;
+        while (const dirent* entry = readdir(dir))
+        {
+            std::string_view name = entry->d_name;
+            constexpr std::string_view suffix = "_label";
+            if (name.size() <= suffix.size() ||
+                name.substr(name.size() - suffix.size()) != suffix)
+                continue;
+            name.remove_suffix(suffix.size());
+            bool power = !name.compare(0, 5, "power");
+            if (!power && name.compare(0, 6, "energy"))
+                continue;
+            channels.push_back({ std::string(name), power });
+        }
+        closedir(dir);
+        std::sort(channels.begin(), channels.end(),
+            [](const channel& lhs, const channel& rhs)
+            {
+                if (lhs.power != rhs.power)
+                    return rhs.power;
+                return lhs.prefix.compare(rhs.prefix) < 0;
+            });
+        return channels;
+    }
+
+    int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace nrgprf
+{
+    event_data::event_data(file_descriptor&& fd, bool power, uint64_t initial) noexcept :
+        fd(std::move(fd)),
+        power(power),
+        mtx(),
+        last_time(now_ns()),
+        last_power(initial),
+        energy(0)
+    {}
+
+    event_data::event_data(const event_data& other) :
+        fd(other.fd),
+        power(other.power),
+        mtx()
+    {
+        std::scoped_lock lock(other.mtx);
+        last_time = other.last_time;
+        last_power = other.last_power;
+        energy = other.energy;
+    }
+
+    event_data::event_data(event_data&& other) noexcept :
+        fd(std::move(other.fd)),
+        power(other.power),
+        mtx(),
+        last_time(other.last_time),
+        last_power(other.last_power),
+        energy(other.energy)
+    {}
+
+    // the energy since the reader was created, from the power in microwatts
+    // integrated with the trapezoidal rule; a reading made before the last one
+    // by a concurrent read, which was slower to take the lock, is not integrated
+    uint64_t event_data::integrate(uint64_t curr) const noexcept
+    {
+        std::scoped_lock lock(mtx);
+        int64_t time = now_ns();
+        if (time > last_time)
+        {
+            energy += (last_power + curr) / 2.0 * (time - last_time) / 1e9;
+            last_time = time;
+            last_power = curr;
+        }
+        return std::llround(energy);
+    }
+
+    reader_impl::reader_impl(
+        location_mask dmask,
+        socket_mask skt_mask,
+        core_mask cores,
+        std::ostream& os) :
+        _event_map(),
+        _active_events(),
+        _core_map(),
+        _core_events()
+    {
+        if (dmask.none())
+            throw exception(errc::invalid_location_mask);
+        if (skt_mask.none())
+            throw exception(errc::invalid_socket_mask);
+        for (auto& skts : _event_map)
+            skts.fill(-1);
+        _core_map.fill(-1);
+        if (cores.any())
+        {
+            result<core_mask> first = first_siblings(cores);
+            if (!first)
+                throw exception(first.error());
+            cores = *first;
+        }
+        DIR* dir = opendir(hwmon_root);
+        if (!dir)
+            throw exception(std::error_code{ errno, std::system_category() });
+        std::vector<std::string> devices;
+        while (const dirent* entry = readdir(dir))
+            if (!std::strncmp(entry->d_name, "hwmon", 5))
+                devices.push_back(entry->d_name);
+        closedir(dir);
+        // the devices are added in the same order every time
+        std::sort(devices.begin(), devices.end());
+        for (const auto& device : devices)
+        {
+            std::string base = cmmn::concat(hwmon_root, "/", device);
+            if (auto ec = add_device(base.c_str(), dmask, skt_mask, cores, os))
+                throw exception(ec);
+        }
+        for (size_t core = 0; core < max_cores; core++)
+            if (cores[core] && _core_map[core] < 0)
+                throw exception(errc::core_energy_not_supported);
+        if (!num_events())
+            throw exception(errc::no_events_added);
+    }
+
+    bool reader_impl::read(sample& s, std::error_code& ec) const
+    {
+        for (size_t ix = 0; ix < num_events(); ix++)
+            if (!read(s, ix, ec))
+                return false;
+        ec.clear();
+        return true;
+    }
+
+    bool reader_impl::read(sample& s, uint8_t ev_idx, std::error_code& ec) const
+    {
+        if (ev_idx >= _active_events.size())
+        {
+            size_t pos = ev_idx - _active_events.size();
+            return !(ec = read_uint64(_core_events[pos].fd.value, s.data.core_energy[pos]));
+        }
+        const event_data& ev = _active_events[ev_idx];
+        uint64_t curr;
+        if ((ec = read_uint64(ev.fd.value, curr)))
+            return false;
+        s.data.cpu[ev_idx] = ev.power ? ev.integrate(curr) : curr;
+        return true;
+    }
+
+    size_t reader_impl::num_events() const noexcept
+    {
+        return _active_events.size() + _core_events.size();
+    }
+
+    template<typename Location>
+    int32_t reader_impl::event_idx(uint8_t skt) const noexcept
+    {
+        return _event_map[skt][Location::value];
+    }
+
+    template<>
+    int32_t reader_impl::event_idx<loc::gpu>(uint8_t) const noexcept
+    {
+        return -1;
+    }
+
+    template<>
+    int32_t reader_impl::event_idx<loc::core>(uint8_t core) const noexcept
+    {
+        if (core >= max_cores || _core_map[core] < 0)
+            return -1;
+        return _active_events.size() + _core_map[core];
+    }
+
+    template<typename Location>
+    result<sensor_value> reader_impl::value(const sample& s, uint8_t skt) const noexcept
+    {
+        using rettype = result<sensor_value>;
+        if (event_idx<Location>(skt) < 0)
+            return rettype(nonstd::unexpect, errc::no_such_event);
+        auto res = s.data.cpu[event_idx<Location>(skt)];
+        if (!res)
+            return rettype(nonstd::unexpect, errc::no_such_event);
+        return sensor_value{ res };
+    }
+
+    template<>
+    result<sensor_value> reader_impl::value<loc::gpu>(const sample&, uint8_t) const noexcept
+    {
+        return result<sensor_value>(nonstd::unexpect, errc::no_such_event);
+    }
+
+    template<>
+    result<sensor_value> reader_impl::value<loc::core>(const sample& s, uint8_t core) const noexcept
+    {
+        using rettype = result<sensor_value>;
+        if (core >= max_cores || _core_map[core] < 0)
+            return rettype(nonstd::unexpect, errc::no_such_event);
+        auto res = s.data.core_energy[_core_map[core]];
+        if (!res)
+            return rettype(nonstd::unexpect, errc::no_such_event);
+        return sensor_value{ res };
+    }
+
+    template<typename Location>
+    size_t reader_impl::values(const sample* first, size_t count, size_t stride, uint8_t skt,
+        sensor_batch& into) const
+    {
+        into.energy.clear();
+        int32_t idx = event_idx<Location>(skt);
+        if (idx < 0)
+            return 0;
+        into.energy.reserve(count);
+        const char* curr = reinterpret_cast<const char*>(first);
+        for (size_t ix = 0; ix < count; ix++, curr += stride)
+            if (auto res = reinterpret_cast<const sample*>(curr)->data.cpu[idx])
+                into.energy.push_back(res);
+        return into.energy.size();
+    }
+
+    template<>
+    size_t reader_impl::values<loc::core>(const sample* first, size_t count, size_t stride,
+        uint8_t core, sensor_batch& into) const
+    {
+        into.energy.clear();
+        if (core >= max_cores || _core_map[core] < 0)
+            return 0;
+        int32_t pos = _core_map[core];
+        into.energy.reserve(count);
+        const char* curr = reinterpret_cast<const char*>(first);
+        for (size_t ix = 0; ix < count; ix++, curr += stride)
+            if (auto res = reinterpret_cast<const sample*>(curr)->data.core_energy[pos])
+                into.energy.push_back(res);
+        return into.energy.size();
+    }
+
+    std::error_code reader_impl::add_device(
+        const char* base, location_mask dmask, socket_mask skt_mask, core_mask cores,
+        std::ostream& os)
+    {
+        result<std::vector<channel>> channels = get_channels(base);
+        if (!channels)
+            return channels.error();
+        for (const auto& ch : *channels)
+        {
+            std::string filename = cmmn::concat(base, "/", ch.prefix, "_label");
+            std::string label;
+            if (!read_line(filename.c_str(), label))
+                return { errno, std::system_category() };
+            if (label_starts_with(label, core_prefix))
+            {
+                uint32_t core = number_from_label(label);
+                if (ch.power || core >= max_cores || !cores[core] || _core_map[core] >= 0)
+                    continue;
+                filename = cmmn::concat(base, "/", ch.prefix, "_input");
+                file_descriptor input(filename.c_str());
+                uint64_t initial;
+                if (auto ec = read_uint64(input.value, initial))
+                    return ec;
+                os << fileline(cmmn::concat("added core event: ", filename, " (", label, ")\n"));
+                _core_map[core] = _core_events.size();
+                _core_events.emplace_back(std::move(input), false, initial);
+                continue;
+            }
+            int32_t didx = domain_index_from_label(label);
+            uint32_t skt = number_from_label(label);
+            if (didx < 0 || skt >= max_sockets || !dmask[didx] || !skt_mask[skt])
+                continue;
+            // a location may have both an energy and a power channel
+            if (_event_map[skt][didx] >= 0)
+                continue;
+            if (_active_events.size() == max_cpu_events)
+            {
+                os << fileline(cmmn::concat("ignored event: ", filename,
+                    " (too many events)\n"));
+                continue;
+            }
+            filename = cmmn::concat(base, "/", ch.prefix, "_input");
+            file_descriptor input(filename.c_str());
+            uint64_t initial;
+            if (auto ec = read_uint64(input.value, initial))
+                return ec;
+            os << fileline(cmmn::concat("added event: ", filename, " (", label, ", socket ",
+                std::to_string(skt), ")\n"));
+            _event_map[skt][didx] = _active_events.size();
+            _active_events.emplace_back(std::move(input), ch.power, initial);
+        }
+        return {};
+    }
+}
+
+#include "../instantiate.hpp"
+INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_EVENT_IDX);
+INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_VALUE);
+INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_BATCH);
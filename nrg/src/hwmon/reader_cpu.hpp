@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../visibility.hpp"
+#include "../common/cpu/funcs.hpp"
+
+#include <nrg/arch.hpp>
+#include <nrg/types.hpp>
+
+#include <array>
+#include <iosfwd>
+#include <mutex>
+#include <vector>
+
+// the samples hold energy counters as on x86_64, which the readings are converted to
+#if !defined(NRG_X86_64)
+#error The hwmon CPU reader requires x86_64
+#endif
+
+namespace nrgprf
+{
+    class sample;
+
+    // package, cores, uncore, memory and system
+    constexpr size_t hwmon_domains = 5;
+
+    struct NRG_LOCAL event_data
+    {
+        file_descriptor fd;
+        // power channels are integrated into energy when read,
+        // energy channels are read as they are
+        bool power;
+        mutable std::mutex mtx;
+        mutable int64_t last_time;
+        mutable uint64_t last_power;
+        mutable double energy;
+
+        event_data(file_descriptor&& fd, bool power, uint64_t initial) noexcept;
+        event_data(const event_data&);
+        event_data(event_data&&) noexcept;
+
+        uint64_t integrate(uint64_t curr) const noexcept;
+    };
+
+    struct NRG_LOCAL reader_impl
+    {
+        std::array<std::array<int32_t, hwmon_domains>, max_sockets> _event_map;
+        std::vector<event_data> _active_events;
+        // the position in sample_data::core_energy of every core, read after the other events
+        std::array<int32_t, max_cores> _core_map;
+        std::vector<event_data> _core_events;
+
+        reader_impl(location_mask, socket_mask, core_mask, std::ostream&);
+
+        bool read(sample&, std::error_code&) const;
+        bool read(sample&, uint8_t, std::error_code&) const;
+        size_t num_events() const noexcept;
+
+        template<typename Location>
+        int32_t event_idx(uint8_t) const noexcept;
+
+        template<typename Location>
+        result<sensor_value> value(const sample&, uint8_t) const noexcept;
+
+        template<typename Location>
+        size_t values(const sample*, size_t, size_t, uint8_t, sensor_batch&) const;
+
+    private:
+        std::error_code add_device(
+            const char* base,
+            location_mask dmask,
+            socket_mask skt_mask,
+            core_mask cores,
+            std::ostream& os);
+    };
+}
@@ -7,20 +7,216 @@
 #include <nonstd/expected.hpp>
 
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace nrgprf;
 
+namespace
+{
+    int64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // reads the reader and records the time halfway through the read
+    bool timed_read(const reader& r, sample& s, size_t idx, std::error_code& ec)
+    {
+        int64_t before = now();
+        bool ok = r.read(s, ec);
+        s.reader_times[idx] = before + (now() - before) / 2;
+        return ok;
+    }
+}
+
+// persistent threads, which every read wakes up at the same time
+// instead of spawning new ones, since a read takes microseconds to milliseconds
+class hybrid_reader::reader_threads
+{
+private:
+    // serializes the reads, whose state is shared by the threads
+    std::mutex _read_mtx;
+    std::mutex _mtx;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    uint64_t _round;
+    size_t _pending;
+    bool _stop;
+    const std::vector<const reader*>* _readers;
+    sample* _sample;
+    std::vector<std::error_code> _errors;
+    std::vector<std::thread> _threads;
+
+public:
+    explicit reader_threads(size_t count) :
+        _round(0),
+        _pending(0),
+        _stop(false),
+        _readers(nullptr),
+        _sample(nullptr),
+        _errors(count),
+        _threads()
+    {
+        _threads.reserve(count);
+        try
+        {
+            for (size_t ix = 0; ix < count; ix++)
+                _threads.emplace_back(&reader_threads::run, this, ix);
+        }
+        catch (...)
+        {
+            stop();
+            throw;
+        }
+    }
+
+    ~reader_threads()
+    {
+        stop();
+    }
+
+    bool read(const std::vector<const reader*>& readers, sample& s, std::error_code& ec)
+    {
+        assert(readers.size() == _threads.size() + 1);
+        std::scoped_lock read_lock(_read_mtx);
+        {
+            std::scoped_lock lock(_mtx);
+            _readers = &readers;
+            _sample = &s;
+            _pending = _threads.size();
+            _round++;
+        }
+        _start.notify_all();
+
+        std::error_code first_ec;
+        bool ok = timed_read(*readers.front(), s, 0, first_ec);
+        {
+            std::unique_lock lock(_mtx);
+            _done.wait(lock, [this]() { return !_pending; });
+        }
+        if (!ok)
+        {
+            ec = first_ec;
+            return false;
+        }
+        for (const auto& error : _errors)
+        {
+            if (error)
+            {
+                ec = error;
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    void stop()
+    {
+        {
+            std::scoped_lock lock(_mtx);
+            _stop = true;
+        }
+        _start.notify_all();
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    // the thread at idx reads the reader after it, the first reader being read by the caller
+    void run(size_t idx)
+    {
+        uint64_t round = 0;
+        std::unique_lock lock(_mtx);
+        while (true)
+        {
+            _start.wait(lock, [this, round]() { return _stop || _round != round; });
+            if (_stop)
+                return;
+            round = _round;
+            const reader* r = (*_readers)[idx + 1];
+            sample& s = *_sample;
+            lock.unlock();
+
+            std::error_code ec;
+            if (timed_read(*r, s, idx + 1, ec))
+                ec.clear();
+
+            lock.lock();
+            _errors[idx] = ec;
+            if (!--_pending)
+                _done.notify_one();
+        }
+    }
+};
+
+hybrid_reader::hybrid_reader(std::vector<const reader*>&& readers) :
+    _readers(std::move(readers)),
+    _parallel(false),
+    _threads()
+{}
+
+hybrid_reader::~hybrid_reader() = default;
+
+hybrid_reader::hybrid_reader(const hybrid_reader& other) :
+    _readers(other._readers),
+    _parallel(false),
+    _threads()
+{
+    parallel(other._parallel);
+}
+
+hybrid_reader::hybrid_reader(hybrid_reader&& other) noexcept = default;
+
+hybrid_reader& hybrid_reader::operator=(const hybrid_reader& other)
+{
+    _threads.reset();
+    _readers = other._readers;
+    _parallel = false;
+    parallel(other._parallel);
+    return *this;
+}
+
+hybrid_reader& hybrid_reader::operator=(hybrid_reader&& other) noexcept = default;
+
 void hybrid_reader::push_back(const reader& r)
 {
+    if (_readers.size() == max_hybrid_readers)
+        throw exception(errc::too_many_readers);
     _readers.push_back(&r);
+    if (_parallel)
+    {
+        _threads.reset();
+        _parallel = false;
+        parallel(true);
+    }
+}
+
+void hybrid_reader::parallel(bool value)
+{
+    if (value == _parallel)
+        return;
+    _threads.reset();
+    if (value && _readers.size() > 1)
+        _threads = std::make_unique<reader_threads>(_readers.size() - 1);
+    _parallel = value;
+}
+
+bool hybrid_reader::parallel() const noexcept
+{
+    return _parallel;
 }
 
 bool hybrid_reader::read(sample& s, std::error_code& ec) const
 {
-    for (auto r : _readers)
+    if (_threads)
+        return _threads->read(_readers, s, ec);
+    for (size_t ix = 0; ix < _readers.size(); ix++)
     {
-        assert(r != nullptr);
-        if (!r->read(s, ec))
+        assert(_readers[ix] != nullptr);
+        if (!timed_read(*_readers[ix], s, ix, ec))
             return false;
     }
     return true;
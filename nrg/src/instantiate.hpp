@@ -14,10 +14,16 @@
     std::vector<std::pair<uint32_t, nrgprf::sensor_value>> \
     name::values<nrgprf::loc::location>(const nrgprf::sample& s) const
 
+#define INSTANTIATE_BATCH(name, location) \
+    template \
+    size_t name::values<nrgprf::loc::location>(const nrgprf::sample* first, size_t count, \
+        size_t stride, uint8_t skt, nrgprf::sensor_batch& into) const
+
 #define INSTANTIATE_ALL(name, macro) \
     macro(name, pkg); \
     macro(name, cores); \
     macro(name, uncore); \
     macro(name, mem); \
     macro(name, sys); \
-    macro(name, gpu)
+    macro(name, gpu); \
+    macro(name, core)
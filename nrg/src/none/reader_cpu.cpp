@@ -7,7 +7,7 @@
 namespace nrgprf
 {
     reader_impl::reader_impl(
-        location_mask, socket_mask, std::ostream& os)
+        location_mask, socket_mask, core_mask, std::ostream& os)
     {
         os << fileline("No-op CPU reader\n");
     }
@@ -38,8 +38,15 @@ namespace nrgprf
     {
         return result<sensor_value>(nonstd::unexpect, errc::no_such_event);
     }
+
+    template<typename Location>
+    size_t reader_impl::values(const sample*, size_t, size_t, uint8_t, sensor_batch&) const
+    {
+        return 0;
+    }
 }
 
 #include "../instantiate.hpp"
 INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_EVENT_IDX);
 INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_VALUE);
+INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_BATCH);
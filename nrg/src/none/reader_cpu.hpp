@@ -10,7 +10,7 @@ namespace nrgprf
 
     struct NRG_LOCAL reader_impl
     {
-        reader_impl(location_mask, socket_mask, std::ostream&);
+        reader_impl(location_mask, socket_mask, core_mask, std::ostream&);
 
         bool read(sample&, std::error_code&) const noexcept;
         bool read(sample&, uint8_t, std::error_code&) const noexcept;
@@ -21,5 +21,8 @@ namespace nrgprf
 
         template<typename Location>
         result<sensor_value> value(const sample&, uint8_t) const noexcept;
+
+        template<typename Location>
+        size_t values(const sample*, size_t, size_t, uint8_t, sensor_batch&) const;
     };
 }
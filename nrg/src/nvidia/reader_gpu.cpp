@@ -30,6 +30,59 @@ namespace
             return rettype(nonstd::unexpect, ec);
         return devcount;
     }
+
+    // the first field of the device, in order of preference, with the same readings as
+    // nvmlDeviceGetPowerUsage or nvmlDeviceGetTotalEnergyConsumption, 0 if none
+    unsigned int supported_field(nvmlDevice_t handle, nrgprf::readings_type::type rt)
+    {
+        namespace readings_type = nrgprf::readings_type;
+        // the power usage is averaged over 1 s since Ampere, GA100 excluded,
+        // and instantaneous before, where the average is not supported
+        constexpr std::array<unsigned int, 2> power_fields = {
+        #if defined(NVML_FI_DEV_POWER_AVERAGE)
+            NVML_FI_DEV_POWER_AVERAGE,
+            NVML_FI_DEV_POWER_INSTANT
+        #endif // defined(NVML_FI_DEV_POWER_AVERAGE)
+        };
+        constexpr std::array<unsigned int, 1> energy_fields = {
+            NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION
+        };
+
+        auto first_supported = [handle](const auto& fields) -> unsigned int
+        {
+            for (unsigned int field : fields)
+            {
+                nvmlFieldValue_t value{};
+                value.fieldId = field;
+                if (field && nvmlDeviceGetFieldValues(handle, 1, &value) == NVML_SUCCESS &&
+                    value.nvmlReturn == NVML_SUCCESS)
+                    return field;
+            }
+            return 0;
+        };
+        if (rt == readings_type::power)
+            return first_supported(power_fields);
+        if (rt == readings_type::energy)
+            return first_supported(energy_fields);
+        return 0;
+    }
+
+    unsigned long long field_value(const nvmlFieldValue_t& value)
+    {
+        switch (value.valueType)
+        {
+        case NVML_VALUE_TYPE_DOUBLE:
+            return static_cast<unsigned long long>(value.value.dVal);
+        case NVML_VALUE_TYPE_UNSIGNED_INT:
+            return value.value.uiVal;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG:
+            return value.value.ulVal;
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG:
+            return static_cast<unsigned long long>(value.value.sllVal);
+        default:
+            return value.value.ullVal;
+        }
+    }
 }
 
 namespace nrgprf
@@ -78,7 +131,9 @@ namespace nrgprf
         :
         handle(),
         event_map(),
-        events()
+        events(),
+        devices(),
+        single_events()
     {
         if (dev_mask.none())
             throw exception(errc::invalid_device_mask);
@@ -122,6 +177,24 @@ namespace nrgprf
                     os << event_added(i, elem.first) << "\n";
                 }
             }
+
+            // the readings with a field are read with a single query of the device
+            device_fields dev{ handle, i, 0, {} };
+            for (const auto& elem : type_array)
+            {
+                int8_t idx = event_map[i][bitpos(elem.first)];
+                if (idx < 0)
+                    continue;
+                if (unsigned int field = supported_field(handle, elem.first))
+                    dev.fields[dev.count++] = { field, elem.first };
+                else
+                    single_events.push_back(idx);
+            }
+            if (dev.count)
+            {
+                devices.push_back(dev);
+                os << fileline("device: ") << i << ", readings read at once: " << dev.count << "\n";
+            }
         }
         if (events.empty())
             throw exception(errc::no_events_added);
@@ -178,6 +251,40 @@ namespace nrgprf
         return rt;
     }
 
+    bool reader_gpu_impl::read(sample& s, std::error_code& ec) const noexcept
+    {
+        for (const auto& dev : devices)
+        {
+            std::array<nvmlFieldValue_t, std::tuple_size_v<decltype(dev.fields)>> values{};
+            for (size_t ix = 0; ix < dev.count; ix++)
+                values[ix].fieldId = dev.fields[ix].first;
+            nvmlReturn_t result = nvmlDeviceGetFieldValues(
+                dev.handle, static_cast<int>(dev.count), values.data());
+            if (result != NVML_SUCCESS)
+            {
+                ec = ::make_error_code(result);
+                return false;
+            }
+            for (size_t ix = 0; ix < dev.count; ix++)
+            {
+                if (values[ix].nvmlReturn != NVML_SUCCESS)
+                {
+                    ec = ::make_error_code(values[ix].nvmlReturn);
+                    return false;
+                }
+                if (dev.fields[ix].second == readings_type::energy)
+                    s.data.gpu_energy[dev.stride] = field_value(values[ix]);
+                else
+                    s.data.gpu_power[dev.stride] = static_cast<uint32_t>(field_value(values[ix]));
+            }
+        }
+        for (size_t idx : single_events)
+            if (!read(s, idx, ec))
+                return false;
+        ec.clear();
+        return true;
+    }
+
     bool reader_gpu_impl::read_energy(
         sample& s, size_t stride, nvmlDevice_t handle, std::error_code& ec) noexcept
     {
@@ -8,6 +8,7 @@
 #include <nonstd/expected.hpp>
 #include <util/concat.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
@@ -16,6 +17,8 @@
 #include <iostream>
 #include <sstream>
 
+#include <unistd.h>
+
 #if !defined(NRG_OCC_USE_DUMMY_FILE)
 #define NRG_OCC_USE_DUMMY_FILE "/sys/firmware/opal/exports/occ_inband_sensors"
 #endif
@@ -97,11 +100,15 @@ namespace
             uint32_t update_tag;
         };
 
+        // the fields of a version 1 record which are read when sampling,
+        // which span the record up to the update tag
         struct sensor_structure_v1_sample
         {
-            constexpr static const size_t size = 10;
+            constexpr static const size_t size = 38;
             uint64_t timestamp;
             uint16_t sample;
+            uint64_t accumulator;
+            uint32_t update_tag;
         };
 
         struct sensor_structure_v2 : sensor_structure_common
@@ -136,6 +143,7 @@ namespace nrgprf::loc
     struct mem : std::integral_constant<int, bitnum(locmask::mem)> {};
     struct sys : std::integral_constant<int, bitnum(locmask::sys)> {};
     struct gpu : std::integral_constant<int, bitnum(locmask::gpu)> {};
+    struct core {};
 }
 
 namespace nrgprf
@@ -204,6 +212,10 @@ namespace
         static_assert(sizeof(sensor_buffers) == sensor_buffers::size,
             "occ::sensor_buffers::size != 86016");
 
+        // the gsid and the sampled fields of a version 1 record
+        constexpr size_t sensor_record_size =
+            sizeof(sensor_structure_v1::gsid) + sensor_structure_v1_sample::size;
+
         namespace detail
         {
             template<typename T>
@@ -378,17 +390,19 @@ namespace
             return false;
         }
 
-        sensor_structure_v1_sample get_v1_sample(const sensor_readings_buffer& buffer, size_t offset)
+        sensor_structure_v1_sample get_v1_sample(const uint8_t* record)
         {
-            assert(buffer.valid);
             sensor_structure_v1_sample ret;
 
             // skip the first field gsid, assertions are done during initial parse
-            const uint8_t* curr = buffer.readings + offset -
-                sensor_readings_buffer::pad + sizeof(sensor_structure_v1::gsid);
+            const uint8_t* curr = record + sizeof(sensor_structure_v1::gsid);
 
             curr += detail::retrieve_field(&ret.timestamp, curr);
-            detail::retrieve_field(&ret.sample, curr);
+            curr += detail::retrieve_field(&ret.sample, curr);
+            // skip the minimum and maximum samples
+            curr += 8 * sizeof(sensor_structure_v1::sample_min);
+            curr += detail::retrieve_field(&ret.accumulator, curr);
+            detail::retrieve_field(&ret.update_tag, curr);
             return ret;
         }
 
@@ -508,31 +522,6 @@ namespace
             return false;
         }
 
-        bool get_sensor_record(
-            const sensor_buffers& buffs,
-            const sensor_names_entry& entry,
-            sensor_structure_v1_sample& out)
-        {
-            assert(buffs.ping.valid || buffs.pong.valid);
-            if (!buffs.ping.valid && !buffs.pong.valid)
-                return false;
-
-            if (buffs.ping.valid && buffs.pong.valid)
-            {
-                auto ping_ts = get_timestamp(buffs.ping, entry.reading_offset);
-                auto pong_ts = get_timestamp(buffs.pong, entry.reading_offset);
-                if (ping_ts > pong_ts)
-                    out = get_v1_sample(buffs.ping, entry.reading_offset);
-                else
-                    out = get_v1_sample(buffs.pong, entry.reading_offset);
-            }
-            if (buffs.pong.valid)
-                out = get_v1_sample(buffs.pong, entry.reading_offset);
-            if (buffs.ping.valid)
-                out = get_v1_sample(buffs.ping, entry.reading_offset);
-            return true;
-        }
-
     #if defined NRG_OCC_DEBUG_PRINTS
         std::ostream& operator<<(std::ostream& os, const sensor_data_header_block& hb)
         {
@@ -689,6 +678,16 @@ namespace
         }
     }
 
+    // the accumulator is the sum of the samples of every update of the sensor,
+    // which is updated at the frequency of its names entry
+    nrgprf::joules<double> canonicalize_energy(uint64_t accumulator,
+        const occ::sensor_names_entry& entry)
+    {
+        if (std::string_view(entry.units) != "W" || entry.freq <= 0)
+            return nrgprf::joules<double>{};
+        return nrgprf::joules<double>(accumulator * entry.scaling_factor / entry.freq);
+    }
+
     // OCC timestamps have a resolution of 512 MHz
     // this means that each value incremented in the counter corresponds to 1000/512 ns
     nrgprf::sensor_value::time_point canonicalize_timestamp(uint64_t timestamp)
@@ -719,6 +718,48 @@ namespace
         return {};
     }
 
+    // reads exactly size bytes at offset, the file ending before that is a format error
+    std::error_code read_exact(int fd, void* into, size_t size, size_t offset)
+    {
+        using namespace nrgprf;
+        uint8_t* curr = static_cast<uint8_t*>(into);
+        while (size)
+        {
+            ssize_t ret = pread(fd, curr, size, offset);
+            if (ret == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                return std::error_code{ errno, std::system_category() };
+            }
+            if (!ret)
+                return errc::file_format_error;
+            curr += ret;
+            size -= ret;
+            offset += ret;
+        }
+        return {};
+    }
+
+    // reads the range of the readings buffer at buffer_offset which holds the records of the event,
+    // the range is not read if the buffer is not valid
+    std::error_code get_event_records(int fd,
+        size_t buffer_offset,
+        const nrgprf::event_data& ed,
+        uint8_t* records,
+        bool& valid)
+    {
+        uint8_t valid_byte;
+        if (auto ec = read_exact(fd, &valid_byte, sizeof(valid_byte), buffer_offset))
+            return ec;
+        valid = valid_byte;
+        if (!valid)
+            return {};
+        return read_exact(fd, records,
+            ed.last_offset - ed.first_offset + occ::sensor_record_size,
+            buffer_offset + ed.first_offset);
+    }
+
     std::error_code get_header(std::ifstream& ifs,
         uint32_t occ_num,
         occ::sensor_data_header_block& hb)
@@ -935,13 +976,19 @@ namespace nrgprf
     reader_impl::reader_impl(
         location_mask lmask,
         socket_mask smask,
+        core_mask cores,
         std::ostream& os)
         :
-        _file(std::make_shared<std::ifstream>(occ::sensors_file, std::ios::in | std::ios::binary)),
+        _fd(occ::sensors_file),
         _event_map(),
         _active_events()
     {
-        if (!*_file)
+        if (cores.any())
+            throw exception(errc::core_energy_not_supported);
+
+        // the static data is only read once, through a stream
+        std::ifstream file(occ::sensors_file, std::ios::in | std::ios::binary);
+        if (!file)
             throw exception(std::error_code{ errno, std::system_category() });
 
         for (auto& skts : _event_map)
@@ -958,15 +1005,15 @@ namespace nrgprf
             os << fileline(cmmn::concat("Registered socket: ", std::to_string(occ_num), "\n"));
 
             occ::sensor_data_header_block hb{};
-            if (auto ec = get_header(*_file, occ_num, hb))
+            if (auto ec = get_header(file, occ_num, hb))
                 throw exception(ec);
 
             std::vector<occ::sensor_names_entry> entries(hb.sensor_count, occ::sensor_names_entry{});
-            if (auto ec = get_names_entries(*_file, occ_num, entries))
+            if (auto ec = get_names_entries(file, occ_num, entries))
                 throw exception(ec);
 
             occ::sensor_buffers sbuffs{};
-            if (auto ec = get_sensor_buffers(*_file, occ_num, sbuffs))
+            if (auto ec = get_sensor_buffers(file, occ_num, sbuffs))
                 throw exception(ec);
 
             std::vector<occ::sensor_structure> structs;
@@ -1007,13 +1054,14 @@ namespace nrgprf
         if (idxref < 0)
         {
             idxref = _active_events.size();
-            _active_events.push_back({ occ_num, std::vector<occ::sensor_names_entry>() });
+            _active_events.push_back({ occ_num, std::vector<occ::sensor_names_entry>(), 0, 0 });
         }
 
+        auto& ed = _active_events[idxref];
         for (const auto& entry : entries)
         {
             const auto& sensor_data = bit_to_sensor_data[loc];
-            auto& active_entries = _active_events[idxref].entries;
+            auto& active_entries = ed.entries;
             if (entry.gsid == sensor_data.gsid &&
                 entry.type == sensor_data.type &&
                 entry.location == sensor_data.loc)
@@ -1026,41 +1074,72 @@ namespace nrgprf
                     << " OCC=" << occ_num << " " << entry << "\n";
             }
         }
+        if (ed.entries.empty())
+            return {};
+
+        auto [first, last] = std::minmax_element(ed.entries.begin(), ed.entries.end(),
+            [](const occ::sensor_names_entry& lhs, const occ::sensor_names_entry& rhs)
+            {
+                return lhs.reading_offset < rhs.reading_offset;
+            });
+        ed.first_offset = first->reading_offset;
+        ed.last_offset = last->reading_offset;
+        if (ed.first_offset < occ::sensor_readings_buffer::pad ||
+            ed.last_offset + occ::sensor_record_size > occ::sensor_readings_size)
+            return errc::file_format_error;
         return {};
     }
 
+    // only the records of the entries are read from the ping and pong buffers,
+    // and the most recent record of each entry is kept
     bool reader_impl::read_single_occ(const event_data& ed,
-        sensor_buffers& sbuffs,
         sample& s,
         std::error_code& ec) const
     {
-        ec == get_sensor_buffers(*_file, ed.occ_num, sbuffs);
-        if (ec)
-            return false;
-        for (const auto& entry : ed.entries)
-        {
-            size_t stride = ed.occ_num * nrgprf::max_domains +
-                sensor_gsid_to_index(entry.gsid);
+        ec.clear();
+        if (ed.entries.empty())
+            return true;
 
-            occ::sensor_structure_v1_sample record;
-            if (!get_sensor_record(sbuffs, entry, record))
-            {
-                ec = errc::readings_not_valid;
+        size_t occ_offset = ed.occ_num * occ::sensor_data_block_size;
+        std::array<uint8_t, occ::sensor_readings_size> records;
+        bool any_valid = false;
+        for (size_t buffer_offset : { occ::sensor_ping_buffer_offset, occ::sensor_pong_buffer_offset })
+        {
+            bool valid;
+            ec = get_event_records(_fd.value, occ_offset + buffer_offset, ed, records.data(), valid);
+            if (ec)
                 return false;
-            }
+            if (!valid)
+                continue;
+            for (const auto& entry : ed.entries)
+            {
+                size_t stride = ed.occ_num * nrgprf::max_domains +
+                    sensor_gsid_to_index(entry.gsid);
 
-            s.data.timestamps[stride] = record.timestamp;
-            s.data.cpu[stride] = record.sample;
+                occ::sensor_structure_v1_sample record = occ::get_v1_sample(
+                    records.data() + entry.reading_offset - ed.first_offset);
+                if (!any_valid || record.timestamp >= s.data.timestamps[stride])
+                {
+                    s.data.timestamps[stride] = record.timestamp;
+                    s.data.cpu[stride] = record.sample;
+                    // a sensor which was never updated has not accumulated anything
+                    s.data.accumulators[stride] = record.update_tag ? record.accumulator : 0;
+                }
+            }
+            any_valid = true;
+        }
+        if (!any_valid)
+        {
+            ec = errc::readings_not_valid;
+            return false;
         }
-        ec.clear();
         return true;
     }
 
     bool reader_impl::read(sample& s, std::error_code& ec) const
     {
-        occ::sensor_buffers sbuffs;
         for (const auto& ed : _active_events)
-            if (!read_single_occ(ed, sbuffs, s, ec))
+            if (!read_single_occ(ed, s, ec))
                 return false;
         return true;
     }
@@ -1068,8 +1147,7 @@ namespace nrgprf
     // Since sensors are read in bulk, reading with an index reads all sensors in some OCC
     bool reader_impl::read(sample& s, uint8_t idx, std::error_code& ec) const
     {
-        occ::sensor_buffers sbuffs;
-        return !read_single_occ(_active_events[idx], sbuffs, s, ec);
+        return read_single_occ(_active_events[idx], s, ec);
     }
 
     size_t reader_impl::num_events() const noexcept
@@ -1086,6 +1164,28 @@ namespace nrgprf
         return _event_map[skt][Location::value];
     }
 
+    template<>
+    int32_t reader_impl::event_idx<loc::core>(uint8_t) const noexcept
+    {
+        return -1;
+    }
+
+    template<>
+    result<sensor_value> reader_impl::value<loc::core>(const sample&, uint8_t) const noexcept
+    {
+        return result<sensor_value>(nonstd::unexpect, errc::no_such_event);
+    }
+
+    template<>
+    size_t reader_impl::values<loc::core>(const sample*, size_t, size_t, uint8_t,
+        sensor_batch& into) const
+    {
+        into.timestamps.clear();
+        into.power.clear();
+        into.energy.clear();
+        return 0;
+    }
+
     template<typename Location>
     result<sensor_value> reader_impl::value(const sample& s, uint8_t skt) const noexcept
     {
@@ -1108,13 +1208,66 @@ namespace nrgprf
                 sensor_value::time_point tp = canonicalize_timestamp(value_timestamp);
                 if (!power.count())
                     return rettype(nonstd::unexpect, errc::unsupported_units);
-                return sensor_value{ tp, unit_cast<decltype(sensor_value::power)>(power) };
+                joules<double> energy{};
+                if (auto value_accumulator = s.data.accumulators[stride])
+                    energy = canonicalize_energy(value_accumulator, sensor_entry);
+                return sensor_value{
+                    tp,
+                    unit_cast<decltype(sensor_value::power)>(power),
+                    unit_cast<decltype(sensor_value::energy)>(energy)
+                };
             }
         };
         return rettype(nonstd::unexpect, errc::no_such_event);
     }
+
+    // the sensor entry is looked up once for the whole batch
+    template<typename Location>
+    size_t reader_impl::values(const sample* first, size_t count, size_t stride, uint8_t skt,
+        sensor_batch& into) const
+    {
+        assert(skt < max_sockets);
+        into.timestamps.clear();
+        into.power.clear();
+        into.energy.clear();
+        int32_t idx = event_idx<Location>(skt);
+        if (idx < 0)
+            return 0;
+        const auto& entries = _active_events[idx].entries;
+        auto entry = std::find_if(entries.begin(), entries.end(), [](const sensor_names_entry& e)
+            {
+                return e.gsid == to_sensor_gsid<Location>();
+            });
+        if (entry == entries.end())
+            return 0;
+        uint32_t pos = skt * nrgprf::max_domains + Location::value;
+        into.timestamps.reserve(count);
+        into.power.reserve(count);
+        into.energy.reserve(count);
+        const char* curr = reinterpret_cast<const char*>(first);
+        for (size_t ix = 0; ix < count; ix++, curr += stride)
+        {
+            const sample& s = *reinterpret_cast<const sample*>(curr);
+            auto value_timestamp = s.data.timestamps[pos];
+            auto value_sample = s.data.cpu[pos];
+            if (!value_timestamp || !value_sample)
+                continue;
+            watts<double> power = canonicalize_power(value_sample, *entry);
+            if (!power.count())
+                continue;
+            into.timestamps.push_back(
+                canonicalize_timestamp(value_timestamp).time_since_epoch().count());
+            into.power.push_back(unit_cast<decltype(sensor_value::power)>(power).count());
+            joules<double> energy{};
+            if (auto value_accumulator = s.data.accumulators[pos])
+                energy = canonicalize_energy(value_accumulator, *entry);
+            into.energy.push_back(unit_cast<decltype(sensor_value::energy)>(energy).count());
+        }
+        return into.power.size();
+    }
 }
 
 #include "../instantiate.hpp"
 INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_EVENT_IDX);
 INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_VALUE);
+INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_BATCH);
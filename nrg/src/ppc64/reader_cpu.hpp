@@ -1,12 +1,12 @@
 #pragma once
 
 #include "../visibility.hpp"
+#include "../common/cpu/funcs.hpp"
 
 #include <nrg/types.hpp>
 
 #include <array>
 #include <iosfwd>
-#include <memory>
 #include <vector>
 
 namespace nrgprf
@@ -38,17 +38,22 @@ namespace nrgprf
     {
         uint32_t occ_num;
         std::vector<sensor_names_entry> entries;
+        // the range of the readings buffers which holds the records of the entries,
+        // which is the only part of the buffers read when sampling
+        uint32_t first_offset;
+        uint32_t last_offset;
     };
 
     struct NRG_LOCAL reader_impl
     {
-        // the file here functions as a cache, so as to avoid opening the file every time
+        // the file is kept open, so as to avoid opening it every time
         // we want to read the sensors
-        std::shared_ptr<std::ifstream> _file;
+        file_descriptor _fd;
         std::array<std::array<int8_t, max_domains>, max_sockets> _event_map;
         std::vector<event_data> _active_events;
 
-        reader_impl(location_mask, socket_mask, std::ostream&);
+        // the OCC does not have per-core energy
+        reader_impl(location_mask, socket_mask, core_mask, std::ostream&);
 
         bool read(sample&, std::error_code&) const;
         bool read(sample&, uint8_t, std::error_code&) const;
@@ -60,6 +65,9 @@ namespace nrgprf
         template<typename Location>
         result<sensor_value> value(const sample&, uint8_t) const noexcept;
 
+        template<typename Location>
+        size_t values(const sample*, size_t, size_t, uint8_t, sensor_batch&) const;
+
     private:
         std::error_code add_event(
             const std::vector<sensor_names_entry>& entries,
@@ -69,7 +77,6 @@ namespace nrgprf
 
         bool read_single_occ(
             const event_data&,
-            sensor_buffers&,
             sample&,
             std::error_code&) const;
     };
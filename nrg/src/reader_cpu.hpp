@@ -4,6 +4,8 @@
 
 #if defined(CPU_NONE)
 #include "none/reader_cpu.hpp"
+#elif defined(CPU_HWMON)
+#include "hwmon/reader_cpu.hpp"
 #elif defined(NRG_X86_64)
 #include "x86_64/reader_cpu.hpp"
 #elif defined(NRG_PPC64)
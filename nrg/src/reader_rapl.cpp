@@ -9,6 +9,7 @@
 #include <nonstd/expected.hpp>
 
 #include <cassert>
+#include <type_traits>
 
 using namespace nrgprf;
 
@@ -17,8 +18,13 @@ struct NRG_LOCAL reader_rapl::impl : reader_impl
     using reader_impl::reader_impl;
 };
 
+reader_rapl::reader_rapl(location_mask dmask, socket_mask skt_mask, core_mask cores,
+    std::ostream& os) :
+    _impl(std::make_unique<reader_rapl::impl>(dmask, skt_mask, cores, os))
+{}
+
 reader_rapl::reader_rapl(location_mask dmask, socket_mask skt_mask, std::ostream& os) :
-    _impl(std::make_unique<reader_rapl::impl>(dmask, skt_mask, os))
+    reader_rapl(dmask, skt_mask, core_mask(), os)
 {}
 
 reader_rapl::reader_rapl(location_mask dmask, std::ostream& os) :
@@ -77,15 +83,24 @@ result<sensor_value> reader_rapl::value(const sample & s, uint8_t skt) const noe
 template<typename Location>
 std::vector<std::pair<uint32_t, sensor_value>> reader_rapl::values(const sample & s) const
 {
+    // the values of a core are indexed by the core instead of the socket
+    constexpr size_t count = std::is_same_v<Location, loc::core> ? max_cores : max_sockets;
     std::vector<std::pair<uint32_t, sensor_value>> retval;
-    for (uint32_t skt = 0; skt < max_sockets; skt++)
+    for (uint32_t idx = 0; idx < count; idx++)
     {
-        if (auto val = value<Location>(s, skt))
-            retval.push_back({ skt, *std::move(val) });
+        if (auto val = value<Location>(s, idx))
+            retval.push_back({ idx, *std::move(val) });
     };
     return retval;
 }
 
+template<typename Location>
+size_t reader_rapl::values(const sample * first, size_t count, size_t stride, uint8_t skt,
+    sensor_batch & into) const
+{
+    return pimpl()->values<Location>(first, count, stride, skt, into);
+}
+
 const reader_rapl::impl* reader_rapl::pimpl() const noexcept
 {
     assert(_impl);
@@ -104,3 +119,4 @@ reader_rapl::impl* reader_rapl::pimpl() noexcept
 INSTANTIATE_ALL(reader_rapl, INSTANTIATE_EVENT_IDX);
 INSTANTIATE_ALL(reader_rapl, INSTANTIATE_VALUE);
 INSTANTIATE_ALL(reader_rapl, INSTANTIATE_VALUES);
+INSTANTIATE_ALL(reader_rapl, INSTANTIATE_BATCH);
@@ -0,0 +1,301 @@
+// reader_shm.cpp
+
+#include "visibility.hpp"
+
+#include <nrg/error.hpp>
+#include <nrg/reader_shm.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace nrgprf;
+
+namespace
+{
+    // "NRGSHM1" in little-endian
+    constexpr uint64_t segment_magic = 0x00314d485347524e;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "atomics in shared memory must be lock-free");
+    static_assert(std::is_trivially_copyable_v<sample>);
+
+    // the sequence number of a slot is odd while it is written and
+    // 2 * (n + 1) once sample n has been written to it
+    struct slot
+    {
+        std::atomic<uint64_t> seq;
+        int64_t timestamp;
+        sample value;
+    };
+
+    // the slots follow the header
+    struct header
+    {
+        uint64_t magic;
+        uint32_t sample_size;
+        uint32_t capacity;
+        uint64_t locations;
+        uint64_t sockets;
+        uint64_t devices;
+        uint32_t gpu_readings;
+        uint32_t num_events;
+        int64_t period;
+        // the number of samples published so far, on its own cache line
+        alignas(64) std::atomic<uint64_t> published;
+    };
+
+    size_t segment_size(size_t capacity)
+    {
+        return sizeof(header) + capacity * sizeof(slot);
+    }
+
+    slot* slots(header* hdr)
+    {
+        return reinterpret_cast<slot*>(hdr + 1);
+    }
+
+    const slot* slots(const header* hdr)
+    {
+        return reinterpret_cast<const slot*>(hdr + 1);
+    }
+
+    std::error_code system_error()
+    {
+        return std::error_code{ errno, std::system_category() };
+    }
+
+    // copies sample n out of its slot, returns false if the slot was written meanwhile
+    bool read_slot(const slot& sl, uint64_t n, published_sample& into)
+    {
+        uint64_t seq = sl.seq.load(std::memory_order_acquire);
+        if (seq != 2 * (n + 1))
+            return false;
+        int64_t timestamp = sl.timestamp;
+        std::memcpy(&into.value, &sl.value, sizeof(into.value));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sl.seq.load(std::memory_order_relaxed) != seq)
+            return false;
+        into.timestamp = published_sample::time_point(std::chrono::nanoseconds(timestamp));
+        return true;
+    }
+}
+
+struct NRG_LOCAL sensor_publisher::impl
+{
+    std::string name;
+    header* hdr;
+    size_t size;
+    // only the publisher writes the number of published samples
+    uint64_t published;
+
+    impl(const std::string& name, const segment_info& info, size_t history) :
+        name(name),
+        hdr(nullptr),
+        size(segment_size(history)),
+        published(0)
+    {
+        if (!history || history > UINT32_MAX)
+            throw exception(std::make_error_code(std::errc::invalid_argument));
+        // a segment left behind by a publisher which did not exit cleanly is replaced
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd == -1 && errno == EEXIST && !shm_unlink(name.c_str()))
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd == -1)
+            throw exception(system_error());
+        void* addr = MAP_FAILED;
+        if (ftruncate(fd, size) != -1)
+            addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            std::error_code ec = system_error();
+            close(fd);
+            shm_unlink(name.c_str());
+            throw exception(ec);
+        }
+        close(fd);
+
+        // the segment is zero-filled, so every slot starts out unwritten
+        hdr = new (addr) header{};
+        for (size_t ix = 0; ix < history; ix++)
+            new (slots(hdr) + ix) slot{};
+        hdr->sample_size = sizeof(sample);
+        hdr->capacity = history;
+        hdr->locations = info.locations.to_ullong();
+        hdr->sockets = info.sockets.to_ullong();
+        hdr->devices = info.devices.to_ullong();
+        hdr->gpu_readings = info.gpu_readings;
+        hdr->num_events = info.num_events;
+        hdr->period = info.period.count();
+        // written last, so that readers do not accept a segment which is being set up
+        std::atomic_thread_fence(std::memory_order_release);
+        hdr->magic = segment_magic;
+    }
+
+    ~impl()
+    {
+        munmap(hdr, size);
+        shm_unlink(name.c_str());
+    }
+
+    void publish(const sample& s, published_sample::time_point tp)
+    {
+        slot& sl = slots(hdr)[published % hdr->capacity];
+        sl.seq.store(2 * published + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        sl.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            tp.time_since_epoch()).count();
+        std::memcpy(&sl.value, &s, sizeof(s));
+        sl.seq.store(2 * (published + 1), std::memory_order_release);
+        hdr->published.store(++published, std::memory_order_release);
+    }
+};
+
+struct NRG_LOCAL reader_shm::impl
+{
+    const header* hdr;
+    size_t size;
+    segment_info info;
+
+    explicit impl(const std::string& name) :
+        hdr(nullptr),
+        size(0),
+        info()
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd == -1)
+            throw exception(system_error());
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (fstat(fd, &st) != -1)
+        {
+            size = st.st_size;
+            if (size < sizeof(header))
+            {
+                close(fd);
+                throw exception(errc::segment_format_error);
+            }
+            addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        if (addr == MAP_FAILED)
+        {
+            std::error_code ec = system_error();
+            close(fd);
+            throw exception(ec);
+        }
+        close(fd);
+
+        hdr = static_cast<const header*>(addr);
+        if (hdr->magic != segment_magic ||
+            hdr->sample_size != sizeof(sample) ||
+            !hdr->capacity ||
+            segment_size(hdr->capacity) > size)
+        {
+            munmap(addr, size);
+            throw exception(errc::segment_format_error);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        info.locations = location_mask(hdr->locations);
+        info.sockets = socket_mask(hdr->sockets);
+        info.devices = device_mask(hdr->devices);
+        info.gpu_readings = static_cast<readings_type::type>(hdr->gpu_readings);
+        info.num_events = hdr->num_events;
+        info.period = std::chrono::nanoseconds(hdr->period);
+    }
+
+    ~impl()
+    {
+        munmap(const_cast<header*>(hdr), size);
+    }
+
+    bool latest(published_sample& into, std::error_code& ec) const
+    {
+        while (true)
+        {
+            uint64_t published = hdr->published.load(std::memory_order_acquire);
+            if (!published)
+            {
+                ec = errc::readings_not_valid;
+                return false;
+            }
+            // retried if the publisher has gone around the ring meanwhile
+            uint64_t n = published - 1;
+            if (read_slot(slots(hdr)[n % hdr->capacity], n, into))
+                break;
+        }
+        if (published_sample::time_point::clock::now() - into.timestamp >
+            info.period * reader_shm::stale_periods)
+        {
+            ec = errc::readings_stale;
+            return false;
+        }
+        ec.clear();
+        return true;
+    }
+};
+
+sensor_publisher::sensor_publisher(const std::string& name, const segment_info& info,
+    size_t history) :
+    _impl(std::make_unique<impl>(name, info, history))
+{}
+
+sensor_publisher::sensor_publisher(sensor_publisher&&) noexcept = default;
+sensor_publisher& sensor_publisher::operator=(sensor_publisher&&) noexcept = default;
+sensor_publisher::~sensor_publisher() = default;
+
+void sensor_publisher::publish(const sample& s, published_sample::time_point tp)
+{
+    _impl->publish(s, tp);
+}
+
+reader_shm::reader_shm(const std::string& name) :
+    _impl(std::make_shared<const impl>(name))
+{}
+
+bool reader_shm::read(sample& s, std::error_code& ec) const
+{
+    published_sample ps;
+    if (!_impl->latest(ps, ec))
+        return false;
+    s = ps.value;
+    return true;
+}
+
+bool reader_shm::read(sample& s, uint8_t, std::error_code& ec) const
+{
+    return read(s, ec);
+}
+
+size_t reader_shm::num_events() const noexcept
+{
+    return _impl->info.num_events;
+}
+
+const segment_info& reader_shm::info() const noexcept
+{
+    return _impl->info;
+}
+
+size_t reader_shm::history(std::vector<published_sample>& into) const
+{
+    into.clear();
+    const header* hdr = _impl->hdr;
+    uint64_t published = hdr->published.load(std::memory_order_acquire);
+    uint64_t first = published > hdr->capacity ? published - hdr->capacity : 0;
+    into.reserve(published - first);
+    // the oldest slots may be written again while they are read, in which case they are skipped
+    for (uint64_t n = first; n < published; n++)
+    {
+        published_sample ps;
+        if (read_slot(slots(hdr)[n % hdr->capacity], n, ps))
+            into.push_back(ps);
+    }
+    return into.size();
+}
@@ -9,7 +9,8 @@
 using namespace nrgprf;
 
 sample::sample() :
-    data{}
+    data{},
+    reader_times{}
 {}
 
 bool sample::operator==(const sample& rhs) const
@@ -0,0 +1,448 @@
+// subscription.cpp
+
+#include <nrg/error.hpp>
+#include <nrg/reader.hpp>
+#include <nrg/subscription.hpp>
+
+#include <nonstd/expected.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace nrgprf;
+
+namespace nrgprf
+{
+    namespace detail
+    {
+        struct subscription_entry
+        {
+            const reader* rdr;
+            poll_policy policy;
+            subscription_callback callback;
+            sample_queue* queue;
+            std::atomic_bool active;
+            // the next time the reader is read, guarded by the engine
+            std::chrono::steady_clock::time_point next;
+            // the readings last delivered, for on-change policies, only used by the engine
+            bool delivered;
+            sample_data last;
+            mutable std::mutex error_mtx;
+            std::error_code error;
+
+            subscription_entry(const reader& r, poll_policy p,
+                subscription_callback cb, sample_queue* q) :
+                rdr(&r),
+                policy(p),
+                callback(std::move(cb)),
+                queue(q),
+                active(true),
+                next(),
+                delivered(false),
+                last(),
+                error_mtx(),
+                error()
+            {}
+
+            // whether the sample is delivered, by the engine
+            bool changed(const sample& s)
+            {
+                if (!policy.on_change)
+                    return true;
+                if (delivered && !std::memcmp(&last, &s.data, sizeof(last)))
+                    return false;
+                delivered = true;
+                last = s.data;
+                return true;
+            }
+        };
+
+        // the thread holds a reference to the state until it returns from run,
+        // so that the state is never destroyed while the thread runs
+        struct poll_state : std::enable_shared_from_this<poll_state>
+        {
+            using clock = std::chrono::steady_clock;
+
+            std::mutex mtx;
+            std::condition_variable cv;
+            // held while samples are delivered, so that cancelling waits for the delivery
+            std::mutex delivery_mtx;
+            std::vector<std::shared_ptr<subscription_entry>> entries;
+            // the instant the periods of every subscription are counted from
+            clock::time_point epoch;
+            cpu_mask cpus;
+            // whether the thread was set the affinity of cpus
+            bool pinned;
+            bool stop;
+            std::thread thread;
+
+            explicit poll_state(const cpu_mask& mask) :
+                mtx(),
+                cv(),
+                delivery_mtx(),
+                entries(),
+                epoch(clock::now()),
+                cpus(mask),
+                pinned(false),
+                stop(false),
+                thread()
+            {}
+
+            ~poll_state()
+            {
+                // the thread is stopped by the engine, and drops the last reference itself
+                // after it returns from run if it was stopped by a callback
+                if (!thread.joinable())
+                    return;
+                if (thread.get_id() == std::this_thread::get_id())
+                    thread.detach();
+                else
+                    thread.join();
+            }
+
+            // waits for the thread to return, unless called by it
+            void shutdown()
+            {
+                {
+                    std::scoped_lock lock(mtx);
+                    stop = true;
+                }
+                cv.notify_one();
+                if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+                    thread.join();
+            }
+
+            // the first multiple of the period since the epoch after the time
+            clock::time_point next_after(clock::time_point tp, clock::duration period) const
+            {
+                auto periods = (tp - epoch) / period + 1;
+                return epoch + periods * period;
+            }
+
+            // with the lock held
+            std::error_code set_affinity()
+            {
+                if (!thread.joinable() || cpus.none())
+                    return {};
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (size_t cpu = 0; cpu < cpus.size(); cpu++)
+                    if (cpus[cpu])
+                        CPU_SET(cpu, &set);
+                if (int res = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set))
+                    return { res, std::system_category() };
+                return {};
+            }
+
+            void add(std::shared_ptr<subscription_entry> entry)
+            {
+                std::scoped_lock lock(mtx);
+                if (!thread.joinable())
+                    thread = std::thread([self = shared_from_this()]()
+                        {
+                            self->run();
+                        });
+                // before the entry is registered, since its subscription is not returned
+                // if this fails; the thread is then idle until the next subscription
+                if (!pinned)
+                {
+                    if (std::error_code ec = set_affinity())
+                        throw exception(ec);
+                    pinned = true;
+                }
+                entry->next = next_after(clock::now(), entry->policy.period);
+                entries.push_back(std::move(entry));
+                cv.notify_one();
+            }
+
+            void remove(const std::shared_ptr<subscription_entry>& entry)
+            {
+                std::thread::id id;
+                {
+                    std::scoped_lock lock(mtx);
+                    entry->active = false;
+                    entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+                    id = thread.get_id();
+                }
+                // waits for the delivery in progress, unless cancelled by it
+                if (id != std::this_thread::get_id())
+                    std::scoped_lock lock(delivery_mtx);
+            }
+
+            void run()
+            {
+                std::unique_lock lock(mtx);
+                while (!stop)
+                {
+                    if (entries.empty())
+                    {
+                        cv.wait(lock);
+                        continue;
+                    }
+                    auto next = std::min_element(entries.begin(), entries.end(),
+                        [](const auto& lhs, const auto& rhs)
+                        {
+                            return lhs->next < rhs->next;
+                        });
+                    clock::time_point due = (*next)->next;
+                    if (clock::now() < due)
+                    {
+                        cv.wait_until(lock, due);
+                        continue;
+                    }
+
+                    // periods which were missed are skipped instead of being made up for
+                    clock::time_point now = clock::now();
+                    std::vector<std::shared_ptr<subscription_entry>> ready;
+                    for (const auto& entry : entries)
+                    {
+                        if (entry->next > now)
+                            continue;
+                        ready.push_back(entry);
+                        entry->next = next_after(now, entry->policy.period);
+                    }
+                    lock.unlock();
+                    deliver(ready);
+                    lock.lock();
+                }
+            }
+
+            // reads every reader once and delivers its sample to every subscription to it
+            void deliver(std::vector<std::shared_ptr<subscription_entry>>& ready)
+            {
+                std::scoped_lock lock(delivery_mtx);
+                std::stable_sort(ready.begin(), ready.end(),
+                    [](const auto& lhs, const auto& rhs)
+                    {
+                        return lhs->rdr < rhs->rdr;
+                    });
+                for (auto first = ready.begin(); first != ready.end();)
+                {
+                    const reader* rdr = (*first)->rdr;
+                    auto last = std::find_if(first, ready.end(),
+                        [rdr](const auto& entry)
+                        {
+                            return entry->rdr != rdr;
+                        });
+
+                    published_sample s;
+                    s.timestamp = clock::now();
+                    std::error_code ec;
+                    bool ok = rdr->read(s.value, ec);
+                    for (; first != last; ++first)
+                    {
+                        subscription_entry& entry = **first;
+                        if (!entry.active)
+                            continue;
+                        if (!ok)
+                        {
+                            {
+                                std::scoped_lock error_lock(entry.error_mtx);
+                                entry.error = ec;
+                            }
+                            if (entry.callback)
+                                entry.callback(result<published_sample>(nonstd::unexpect, ec));
+                        }
+                        else if (entry.changed(s.value))
+                        {
+                            if (entry.queue)
+                                entry.queue->push(s);
+                            else
+                                entry.callback(s);
+                        }
+                    }
+                }
+            }
+        };
+    }
+}
+
+poll_policy poll_policy::rate(std::chrono::nanoseconds period) noexcept
+{
+    return { period, false };
+}
+
+poll_policy poll_policy::changes(std::chrono::nanoseconds period) noexcept
+{
+    return { period, true };
+}
+
+
+sample_queue::sample_queue(size_t capacity) :
+    _ring(),
+    _capacity(capacity),
+    _head(0),
+    _tail(0),
+    _dropped(0)
+{
+    if (!capacity)
+        throw exception(std::make_error_code(std::errc::invalid_argument));
+    _ring = std::make_unique<published_sample[]>(capacity);
+}
+
+bool sample_queue::push(const published_sample& s) noexcept
+{
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == _capacity)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _ring[tail % _capacity] = s;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool sample_queue::pop(published_sample& s) noexcept
+{
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire))
+        return false;
+    s = _ring[head % _capacity];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+size_t sample_queue::size() const noexcept
+{
+    return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+}
+
+size_t sample_queue::capacity() const noexcept
+{
+    return _capacity;
+}
+
+uint64_t sample_queue::dropped() const noexcept
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+
+subscription::subscription(std::weak_ptr<detail::poll_state> state,
+    std::shared_ptr<detail::subscription_entry> entry) noexcept :
+    _state(std::move(state)),
+    _entry(std::move(entry))
+{}
+
+subscription::subscription() noexcept = default;
+
+subscription::~subscription()
+{
+    cancel();
+}
+
+subscription::subscription(subscription&&) noexcept = default;
+
+subscription& subscription::operator=(subscription&& other) noexcept
+{
+    if (this != &other)
+    {
+        cancel();
+        _state = std::move(other._state);
+        _entry = std::move(other._entry);
+    }
+    return *this;
+}
+
+void subscription::cancel()
+{
+    if (!_entry)
+        return;
+    if (auto state = _state.lock())
+        state->remove(_entry);
+    _entry->active = false;
+    _entry.reset();
+    _state.reset();
+}
+
+bool subscription::active() const noexcept
+{
+    return _entry && _entry->active && !_state.expired();
+}
+
+std::error_code subscription::error() const
+{
+    if (!_entry)
+        return {};
+    std::scoped_lock lock(_entry->error_mtx);
+    return _entry->error;
+}
+
+
+poll_engine::poll_engine() :
+    poll_engine(cpu_mask{})
+{}
+
+poll_engine::poll_engine(const cpu_mask& cpus) :
+    _state(std::make_shared<detail::poll_state>(cpus))
+{}
+
+poll_engine::~poll_engine()
+{
+    if (_state)
+        _state->shutdown();
+}
+
+poll_engine::poll_engine(poll_engine&&) noexcept = default;
+
+poll_engine& poll_engine::operator=(poll_engine&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (_state)
+            _state->shutdown();
+        _state = std::move(other._state);
+    }
+    return *this;
+}
+
+poll_engine& poll_engine::shared()
+{
+    static poll_engine engine;
+    return engine;
+}
+
+void poll_engine::affinity(const cpu_mask& cpus)
+{
+    assert(_state);
+    std::scoped_lock lock(_state->mtx);
+    // the thread keeps the previous affinity if it cannot be changed
+    cpu_mask previous = std::exchange(_state->cpus, cpus);
+    if (std::error_code ec = _state->set_affinity())
+    {
+        _state->cpus = previous;
+        throw exception(ec);
+    }
+}
+
+subscription poll_engine::subscribe(const reader& r, poll_policy policy,
+    subscription_callback callback)
+{
+    assert(_state);
+    if (policy.period <= decltype(policy.period)::zero() || !callback)
+        throw exception(std::make_error_code(std::errc::invalid_argument));
+    auto entry = std::make_shared<detail::subscription_entry>(
+        r, policy, std::move(callback), nullptr);
+    _state->add(entry);
+    return { _state, std::move(entry) };
+}
+
+subscription poll_engine::subscribe(const reader& r, poll_policy policy, sample_queue& queue)
+{
+    assert(_state);
+    if (policy.period <= decltype(policy.period)::zero())
+        throw exception(std::make_error_code(std::errc::invalid_argument));
+    auto entry = std::make_shared<detail::subscription_entry>(r, policy, nullptr, &queue);
+    _state->add(entry);
+    return { _state, std::move(entry) };
+}
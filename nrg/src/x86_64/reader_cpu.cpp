@@ -9,6 +9,7 @@
 #include <util/concat.hpp>
 
 #include <charconv>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 
@@ -24,6 +25,7 @@ namespace nrgprf::loc
     struct mem : std::integral_constant<int, bitnum(locmask::mem)> {};
     struct sys {};
     struct gpu {};
+    struct core {};
 }
 
 namespace
@@ -33,6 +35,11 @@ namespace
     constexpr char EVENT_PP1[] = "uncore";
     constexpr char EVENT_DRAM[] = "dram";
 
+    // the per-core energy of AMD Zen, read through the msr driver
+    constexpr off_t MSR_AMD_RAPL_POWER_UNIT = 0xc0010299;
+    constexpr off_t MSR_AMD_CORE_ENERGY_STAT = 0xc001029a;
+    constexpr uint64_t CORE_ENERGY_MAX = 0xffffffff;
+
     // begin helper functions
 
     ssize_t read_buff(int fd, char* buffer, size_t buffsz)
@@ -57,6 +64,19 @@ namespace
         return -1;
     }
 
+    std::error_code read_msr(int fd, off_t msr, uint64_t& value)
+    {
+        ssize_t ret = pread(fd, &value, sizeof(value), msr);
+        if (ret == sizeof(value))
+            return {};
+        // the CPU does not have the register
+        if (ret == -1 && errno == EIO)
+            return nrgprf::errc::core_energy_not_supported;
+        if (ret == -1)
+            return { errno, std::system_category() };
+        return nrgprf::errc::readings_not_valid;
+    }
+
     bool is_package_domain(const char* name)
     {
         return !std::strncmp(EVENT_PKG_PREFIX, name, sizeof(EVENT_PKG_PREFIX) - 1);
@@ -133,7 +153,11 @@ namespace
         if (read_uint64(filed.value, &max_value) < 0)
             return rettype(nonstd::unexpect, errno, std::system_category());
         snprintf(filename, sizeof(filename), "%s/energy_uj", base);
-        return event_data{ file_descriptor(filename), max_value };
+        file_descriptor energy(filename);
+        uint64_t initial;
+        if (read_uint64(energy.value, &initial) < 0)
+            return rettype(nonstd::unexpect, errno, std::system_category());
+        return event_data{ std::move(energy), max_value, initial };
     }
 
     bool file_exists(std::string_view path)
@@ -144,50 +168,56 @@ namespace
 
 namespace nrgprf
 {
-    file_descriptor::file_descriptor(const char* file) :
-        value(open(file, O_RDONLY))
-    {
-        if (value == -1)
-            throw exception(std::error_code{ errno, std::system_category() });
-    }
+    event_data::event_data(file_descriptor&& fd, uint64_t max, uint64_t initial) noexcept :
+        fd(std::move(fd)),
+        max(max),
+        extended(initial)
+    {}
 
-    file_descriptor::file_descriptor(const file_descriptor& other) :
-        value(dup(other.value))
-    {
-        if (value == -1)
-            throw exception(std::error_code{ errno, std::system_category() });
-    }
+    event_data::event_data(const event_data& other) :
+        fd(other.fd),
+        max(other.max),
+        extended(other.extended.load(std::memory_order_relaxed))
+    {}
 
-    file_descriptor::file_descriptor(file_descriptor&& other) noexcept :
-        value(std::exchange(other.value, -1))
+    event_data::event_data(event_data&& other) noexcept :
+        fd(std::move(other.fd)),
+        max(other.max),
+        extended(other.extended.load(std::memory_order_relaxed))
     {}
 
-    file_descriptor::~file_descriptor() noexcept
+    uint64_t event_data::last() const noexcept
     {
-        if (value >= 0 && close(value) == -1)
-            perror("file_descriptor: error closing file");
+        return extended.load(std::memory_order_acquire);
     }
 
-    file_descriptor& file_descriptor::operator=(file_descriptor&& other) noexcept
+    // the counter wraps around to zero after max, so its period is max + 1;
+    // since the reading was made after the one last was extended from, it is in the same
+    // period if it is not lower than last and in the next one otherwise, which requires
+    // the counter to be read at least once per period; concurrent reads then only
+    // have to publish the highest value
+    uint64_t event_data::extend(uint64_t last, uint64_t curr) const noexcept
     {
-        value = other.value;
-        other.value = -1;
-        return *this;
+        const uint64_t period = max + 1;
+        uint64_t value = last - last % period + curr;
+        if (curr < last % period)
+            value += period;
+        uint64_t published = last;
+        while (published < value && !extended.compare_exchange_weak(
+            published, value, std::memory_order_release, std::memory_order_relaxed));
+        return value;
     }
 
-    event_data::event_data(file_descriptor&& fd, uint64_t max) noexcept :
-        fd(std::move(fd)),
-        max(max),
-        prev(0),
-        curr_max(0)
-    {}
-
     reader_impl::reader_impl(
         location_mask dmask,
         socket_mask skt_mask,
+        core_mask cores,
         std::ostream& os) :
         _event_map(),
-        _active_events()
+        _active_events(),
+        _core_map(),
+        _core_events(),
+        _core_unit(0)
     {
         if (dmask.none())
             throw exception(errc::invalid_location_mask);
@@ -226,13 +256,15 @@ namespace nrgprf
                         throw exception(ec);
             }
         }
+        if (auto ec = add_cores(cores, os))
+            throw exception(ec);
         if (!num_events())
             throw exception(errc::no_events_added);
     }
 
     bool reader_impl::read(sample& s, std::error_code& ec) const
     {
-        for (size_t ix = 0; ix < _active_events.size(); ix++)
+        for (size_t ix = 0; ix < num_events(); ix++)
             if (!read(s, ix, ec))
                 return false;
         ec.clear();
@@ -241,26 +273,33 @@ namespace nrgprf
 
     bool reader_impl::read(sample& s, uint8_t ev_idx, std::error_code& ec) const
     {
+        if (ev_idx >= _active_events.size())
+        {
+            size_t pos = ev_idx - _active_events.size();
+            const event_data& ev = _core_events[pos];
+            uint64_t last = ev.last();
+            uint64_t raw;
+            if ((ec = read_msr(ev.fd.value, MSR_AMD_CORE_ENERGY_STAT, raw)))
+                return false;
+            s.data.core_energy[pos] = std::llround(ev.extend(last, raw & CORE_ENERGY_MAX) * _core_unit);
+            return true;
+        }
+        const event_data& ev = _active_events[ev_idx];
+        uint64_t last = ev.last();
         uint64_t curr;
-        if (read_uint64(_active_events[ev_idx].fd.value, &curr) == -1)
+        if (read_uint64(ev.fd.value, &curr) == -1)
         {
             ec = std::error_code(errno, std::system_category());
             return false;
         }
-        if (curr < _active_events[ev_idx].prev)
-        {
-            std::cerr << fileline("detected wraparound\n");
-            _active_events[ev_idx].curr_max += _active_events[ev_idx].max;
-        }
-        _active_events[ev_idx].prev = curr;
-        s.data.cpu[ev_idx] = curr + _active_events[ev_idx].curr_max;
+        s.data.cpu[ev_idx] = ev.extend(last, curr);
         ec.clear();
         return true;
     }
 
     size_t reader_impl::num_events() const noexcept
     {
-        return _active_events.size();
+        return _active_events.size() + _core_events.size();
     }
 
     template<typename Location>
@@ -281,6 +320,14 @@ namespace nrgprf
         return -1;
     }
 
+    template<>
+    int32_t reader_impl::event_idx<loc::core>(uint8_t core) const noexcept
+    {
+        if (core >= max_cores || _core_map[core] < 0)
+            return -1;
+        return _active_events.size() + _core_map[core];
+    }
+
     template<typename Location>
     result<sensor_value> reader_impl::value(const sample& s, uint8_t skt) const noexcept
     {
@@ -305,6 +352,52 @@ namespace nrgprf
         return result<sensor_value>(nonstd::unexpect, errc::no_such_event);
     }
 
+    template<>
+    result<sensor_value> reader_impl::value<loc::core>(const sample& s, uint8_t core) const noexcept
+    {
+        using rettype = result<sensor_value>;
+        if (core >= max_cores || _core_map[core] < 0)
+            return rettype(nonstd::unexpect, errc::no_such_event);
+        auto res = s.data.core_energy[_core_map[core]];
+        if (!res)
+            return rettype(nonstd::unexpect, errc::no_such_event);
+        return sensor_value{ res };
+    }
+
+    // the counters are already corrected for wraparounds when read,
+    // so the readings only have to be gathered
+    template<typename Location>
+    size_t reader_impl::values(const sample* first, size_t count, size_t stride, uint8_t skt,
+        sensor_batch& into) const
+    {
+        into.energy.clear();
+        int32_t idx = event_idx<Location>(skt);
+        if (idx < 0)
+            return 0;
+        into.energy.reserve(count);
+        const char* curr = reinterpret_cast<const char*>(first);
+        for (size_t ix = 0; ix < count; ix++, curr += stride)
+            if (auto res = reinterpret_cast<const sample*>(curr)->data.cpu[idx])
+                into.energy.push_back(res);
+        return into.energy.size();
+    }
+
+    template<>
+    size_t reader_impl::values<loc::core>(const sample* first, size_t count, size_t stride,
+        uint8_t core, sensor_batch& into) const
+    {
+        into.energy.clear();
+        if (core >= max_cores || _core_map[core] < 0)
+            return 0;
+        int32_t pos = _core_map[core];
+        into.energy.reserve(count);
+        const char* curr = reinterpret_cast<const char*>(first);
+        for (size_t ix = 0; ix < count; ix++, curr += stride)
+            if (auto res = reinterpret_cast<const sample*>(curr)->data.core_energy[pos])
+                into.energy.push_back(res);
+        return into.energy.size();
+    }
+
     std::error_code reader_impl::add_event(
         const char* base, location_mask dmask, uint8_t skt, std::ostream& os)
     {
@@ -322,8 +415,41 @@ namespace nrgprf
         }
         return {};
     }
+
+    std::error_code reader_impl::add_cores(core_mask cores, std::ostream& os)
+    {
+        _core_map.fill(-1);
+        if (cores.none())
+            return {};
+        result<core_mask> first = first_siblings(cores);
+        if (!first)
+            return first.error();
+        for (size_t core = 0; core < max_cores; core++)
+        {
+            if (!(*first)[core])
+                continue;
+            char filename[64];
+            snprintf(filename, sizeof(filename), "/dev/cpu/%zu/msr", core);
+            file_descriptor msr(filename);
+            uint64_t raw;
+            if (_core_events.empty())
+            {
+                // bits 12:8 are the energy status units, in 1/2^ESU joules
+                if (auto ec = read_msr(msr.value, MSR_AMD_RAPL_POWER_UNIT, raw))
+                    return ec;
+                _core_unit = 1e6 / (1ull << ((raw >> 8) & 0x1f));
+            }
+            if (auto ec = read_msr(msr.value, MSR_AMD_CORE_ENERGY_STAT, raw))
+                return ec;
+            os << fileline(cmmn::concat("added core event: ", filename, "\n"));
+            _core_map[core] = _core_events.size();
+            _core_events.push_back(event_data{ std::move(msr), CORE_ENERGY_MAX, raw & CORE_ENERGY_MAX });
+        }
+        return {};
+    }
 }
 
 #include "../instantiate.hpp"
 INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_EVENT_IDX);
 INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_VALUE);
+INSTANTIATE_ALL(nrgprf::reader_impl, INSTANTIATE_BATCH);
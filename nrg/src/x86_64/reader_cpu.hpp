@@ -1,9 +1,12 @@
 #pragma once
 
 #include "../visibility.hpp"
+#include "../common/cpu/funcs.hpp"
 
 #include <nrg/types.hpp>
 
+#include <array>
+#include <atomic>
 #include <iosfwd>
 #include <vector>
 
@@ -11,33 +14,33 @@ namespace nrgprf
 {
     class sample;
 
-    struct NRG_LOCAL file_descriptor
-    {
-        int value;
-
-        explicit file_descriptor(const char* file);
-        ~file_descriptor() noexcept;
-
-        file_descriptor(const file_descriptor& fd);
-        file_descriptor(file_descriptor&& fd) noexcept;
-        file_descriptor& operator=(file_descriptor&& other) noexcept;
-    };
-
     struct NRG_LOCAL event_data
     {
         file_descriptor fd;
-        mutable uint64_t max;
-        mutable uint64_t prev;
-        mutable uint64_t curr_max;
-        event_data(file_descriptor&& fd, uint64_t max) noexcept;
+        uint64_t max;
+        // the last counter value corrected for wraparounds, which concurrent reads update
+        mutable std::atomic<uint64_t> extended;
+
+        event_data(file_descriptor&& fd, uint64_t max, uint64_t initial) noexcept;
+        event_data(const event_data&);
+        event_data(event_data&&) noexcept;
+
+        // the value to extend the next reading from, loaded before reading the counter
+        uint64_t last() const noexcept;
+        uint64_t extend(uint64_t last, uint64_t curr) const noexcept;
     };
 
     struct NRG_LOCAL reader_impl
     {
         std::array<std::array<int32_t, max_domains>, max_sockets> _event_map;
         std::vector<event_data> _active_events;
+        // the position in sample_data::core_energy of every core, read after the other events
+        std::array<int32_t, max_cores> _core_map;
+        std::vector<event_data> _core_events;
+        // microjoules per unit of the core energy counters
+        double _core_unit;
 
-        reader_impl(location_mask, socket_mask, std::ostream&);
+        reader_impl(location_mask, socket_mask, core_mask, std::ostream&);
 
         bool read(sample&, std::error_code&) const;
         bool read(sample&, uint8_t, std::error_code&) const;
@@ -49,11 +52,16 @@ namespace nrgprf
         template<typename Location>
         result<sensor_value> value(const sample&, uint8_t) const noexcept;
 
+        template<typename Location>
+        size_t values(const sample*, size_t, size_t, uint8_t, sensor_batch&) const;
+
     private:
         std::error_code add_event(
             const char* base,
             location_mask dmask,
             uint8_t skt,
             std::ostream& os);
+
+        std::error_code add_cores(core_mask cores, std::ostream& os);
     };
 }
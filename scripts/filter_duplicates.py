@@ -140,8 +140,11 @@ def filter_execution(
         )
         log("found:{}:{}={}".format(comment, tgt, remove_ix if remove_ix else "{}"))
     if remove_ix:
+        reader_times = e.get("reader_times")
         for ix in reversed(sorted(remove_ix)):
             del sample_times[ix]
+            if reader_times:
+                del reader_times[ix]
         for tgt, rds in ((k, e[k]) for k, v in filters.items() if v and e.get(k)):
             remove_indices(remove_ix, rds, sample_times, targets[tgt])
             log("removed:{}:{}={}".format(comment, tgt, remove_ix))
@@ -1,6 +1,8 @@
 // cmdargs.cpp
 
 #include "cmdargs.hpp"
+#include "idle_baseline.hpp"
+#include "dbg/object_info.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -10,6 +12,7 @@
 #include <charconv>
 
 #include <getopt.h>
+#include <sched.h>
 
 using namespace tep;
 
@@ -46,6 +49,85 @@ namespace
         return retval;
     }
 
+    // a list of logical CPUs and ranges of them, e.g. 0-3,8,
+    // or the CPU affinity of the profiler, which the target inherits
+    std::optional<nrgprf::core_mask>
+        parse_cores_argument(std::string_view option, std::string_view value)
+    {
+        nrgprf::core_mask retval;
+        if (value == "affinity")
+        {
+            cpu_set_t set;
+            if (sched_getaffinity(0, sizeof(set), &set))
+            {
+                std::cerr << "--" << option << ": " << strerror(errno) << "\n";
+                return std::nullopt;
+            }
+            for (size_t cpu = 0; cpu < retval.size(); cpu++)
+                retval[cpu] = CPU_ISSET(cpu, &set);
+            return retval;
+        }
+        const char* it = value.begin();
+        while (it != value.end())
+        {
+            unsigned first;
+            unsigned last;
+            std::from_chars_result res = std::from_chars(it, value.end(), first, 10);
+            if (res.ec == std::errc() && res.ptr != value.end() && *res.ptr == '-')
+                res = std::from_chars(res.ptr + 1, value.end(), last, 10);
+            else
+                last = first;
+            const char* ptr = res.ptr;
+            if (auto err = std::make_error_code(res.ec))
+            {
+                std::cerr << "--" << option << ": " << err << "\n";
+                return std::nullopt;
+            }
+            if (last < first || last >= retval.size())
+            {
+                std::cerr << "--" << option << ": "
+                    << "invalid range in '" << value << "', the maximum CPU is "
+                    << retval.size() - 1 << "\n";
+                return std::nullopt;
+            }
+            if (ptr != value.end() && (*ptr != ',' || ptr + 1 == value.end()))
+            {
+                std::cerr << "--" << option << ": "
+                    << "invalid characters in '" << value << "'" << "\n";
+                return std::nullopt;
+            }
+            for (unsigned cpu = first; cpu <= last; cpu++)
+                retval.set(cpu);
+            it = ptr == value.end() ? ptr : ptr + 1;
+        }
+        if (retval.none())
+        {
+            std::cerr << "--" << option << ": no CPUs in '" << value << "'\n";
+            return std::nullopt;
+        }
+        return retval;
+    }
+
+    std::optional<unsigned long long>
+        parse_count_argument(std::string_view option, std::string_view value)
+    {
+        unsigned long long retval;
+        auto [ptr, ec] =
+            std::from_chars(value.begin(), value.end(), retval, 10);
+        if (auto err = std::make_error_code(ec))
+        {
+            std::cerr << "--" << option << ": " << err << "\n";
+            return std::nullopt;
+        }
+        if (ptr != value.end())
+        {
+            std::cerr << "--" << option << ": "
+                << "invalid decimal characters in '" << value << "'" << "\n";
+            return std::nullopt;
+        }
+        return retval;
+    }
+
     struct parameter
     {
         inline static const auto pad = std::setw(30);
@@ -125,10 +207,28 @@ std::ostream& tep::operator<<(std::ostream& os, const optional_input_file& f)
     return os;
 }
 
+std::ostream& tep::operator<<(std::ostream& os, output_format f)
+{
+    switch (f)
+    {
+    case output_format::json:
+        os << "json";
+        break;
+    case output_format::binary:
+        os << "binary";
+        break;
+    }
+    return os;
+}
+
 std::ostream& tep::operator<<(std::ostream& os, const arguments& args)
 {
     os << "flags: " << args.profiler_flags;
     os << ", output: " << args.output;
+    os << ", format: " << args.format;
+    os << ", journal: " << (args.journal.empty() ? "none" : args.journal);
+    os << ", journal only: " << args.journal_only;
+    os << ", telemetry: " << (args.telemetry.empty() ? "none" : args.telemetry);
     os << ", config: " << args.config;
     os << ", exec: " << args.target;
     return os;
@@ -157,6 +257,28 @@ void print_usage(const char* profiler_name)
         << "if <file> is 'stdout' then stdout is used (default: stdout)"
         << "\n";
 
+    std::cout << parameter{ "--output-format {json,binary}" }
+        << "format of the profiling results; 'binary' is a compact columnar format "
+        << "which can be converted to JSON with convert-results (default: json)"
+        << "\n";
+
+    std::cout << parameter{ "--journal <file>" }
+        << "(optional) append every execution to journal <file> as it finishes, "
+        << "from which recover-results rebuilds the results if the profiler "
+        << "does not finish"
+        << "\n";
+
+    std::cout << parameter{ "--journal-only" }
+        << "keep the executions only in the journal instead of in memory "
+        << "and rebuild the results from it at the end; "
+        << "requires --journal and --output-format binary (default: off)"
+        << "\n";
+
+    std::cout << parameter{ "--telemetry <socket>" }
+        << "(optional) publish section enter and exit events and samples as they happen "
+        << "to the clients of Unix domain socket <socket>, one JSON object per line"
+        << "\n";
+
     std::cout << parameter{ "-q, --quiet" }
         << "suppress log messages except errors to stderr (default: off)"
         << "\n";
@@ -169,6 +291,12 @@ void print_usage(const char* profiler_name)
         << "(optional) dump gathered debug info in JSON format to <file>"
         << "\n";
 
+    std::cout << parameter{ "--debug-dir <dir>" }
+        << "(optional) look up separate debug files of stripped objects "
+        << "by build ID and debug link in <dir> "
+        << "(default: " << dbg::object_info::default_debug_dir << ")"
+        << "\n";
+
     std::cout << parameter{ "--idle" }
         << "gather idle readings at startup (default)"
         << "\n";
@@ -177,6 +305,36 @@ void print_usage(const char* profiler_name)
         << "opposite of --idle"
         << "\n";
 
+    std::cout << parameter{ "--idle-duration <ms>" }
+        << "gather idle readings for <ms> milliseconds; "
+        << "CPU and GPU readings are gathered at the same time (default: "
+        << default_idle_duration.count() << ")"
+        << "\n";
+
+    std::cout << parameter{ "--idle-baseline <file>" }
+        << "(optional) reuse the idle readings saved in <file> if they were gathered "
+        << "on the same host with the same sensors and duration and have not expired, "
+        << "otherwise gather them and save them to <file>"
+        << "\n";
+
+    std::cout << parameter{ "--idle-expiry <s>" }
+        << "idle readings in --idle-baseline expire after <s> seconds (default: "
+        << std::chrono::seconds(idle_baseline::default_expiry).count() << ")"
+        << "\n";
+
+    std::cout << parameter{ "--idle-refresh" }
+        << "reuse expired idle readings in --idle-baseline and gather them again "
+        << "once the results are written (default: off)"
+        << "\n";
+
+    std::cout << parameter{ "--calibrate-overhead <ms>" }
+        << "(optional) before the target runs, measure the time and energy of a read "
+        << "of every reader by every sampling mode used by the sections, reading for <ms> "
+        << "milliseconds while idle and as the sampler does; the overhead is written "
+        << "with every section, and every execution and the energy statistics also have "
+        << "the energy without the overhead of the reads during the execution"
+        << "\n";
+
     std::cout << parameter{ "--cpu-sensors {MASK,all}" }
         << "mask of CPU sensors to read in hexadecimal, "
         << "overwrites config value (default: use value in config)"
@@ -192,6 +350,25 @@ void print_usage(const char* profiler_name)
         << "overwrites config value (default: use value in config)"
         << "\n";
 
+    std::cout << parameter{ "--cpu-cores {LIST,affinity}" }
+        << "(optional) read the energy of every core in LIST of logical CPUs, e.g. 0-3,8, "
+        << "or in the CPU affinity of the profiler, which the target inherits; "
+        << "a CPU stands for its core, which is read through its first sibling "
+        << "(default: none, requires AMD Zen)"
+        << "\n";
+
+    std::cout << parameter{ "--parallel-reads" }
+        << "read the CPU and GPU sensors of sections with multiple targets "
+        << "at the same time, on a thread per target, instead of one after another; "
+        << "the time of every reading is written with the readings (default: off)"
+        << "\n";
+
+    std::cout << parameter{ "--sensor-segment <name>" }
+        << "(optional) read the sensors through the shared memory segment <name> "
+        << "published by sensor-daemon, with the sensors, sockets and devices of the daemon, "
+        << "instead of reading them directly"
+        << "\n";
+
     std::cout << parameter{ "--exec <path>" }
         << "evaluate executable <path> instead of <executable>; "
         << "used when <executable> is some wrapper program "
@@ -207,22 +384,38 @@ std::optional<arguments> tep::parse_arguments(int argc, char* const argv[])
     int c;
     int option_index = 0;
     int idle = 1;
+    int idle_refresh = 0;
+    int parallel_reads = 0;
+    int journal_only = 0;
+    std::chrono::milliseconds idle_duration = default_idle_duration;
+    std::string idle_baseline_path;
+    std::chrono::seconds idle_expiry = idle_baseline::default_expiry;
+    std::chrono::milliseconds calibration_duration(0);
     bool quiet = false;
     std::string output;
+    output_format format = output_format::json;
+    std::string journal;
+    std::string telemetry;
+    std::string sensor_segment;
     std::string config;
     std::string logpath;
     std::string executable;
     std::string debug_dump;
+    std::string debug_dir(dbg::object_info::default_debug_dir);
 
     unsigned long long cpu_sensors = 0;
     unsigned long long cpu_sockets = 0;
     unsigned long long gpu_devices = 0;
+    nrgprf::core_mask cpu_cores;
 
     struct option long_options[] =
     {
         { "help",                 no_argument,       nullptr, 'h' },
         { "idle",                 no_argument,       &idle, 1 },
         { "no-idle",              no_argument,       &idle, 0 },
+        { "idle-refresh",         no_argument,       &idle_refresh, 1 },
+        { "parallel-reads",       no_argument,       &parallel_reads, 1 },
+        { "journal-only",         no_argument,       &journal_only, 1 },
         { "config",               required_argument, nullptr, 'c' },
         { "output",               required_argument, nullptr, 'o' },
         { "quiet",                no_argument,       nullptr, 'q' },
@@ -232,6 +425,16 @@ std::optional<arguments> tep::parse_arguments(int argc, char* const argv[])
         { gpu_devices_str.data(), required_argument, nullptr, 0x102 },
         { "exec",                 required_argument, nullptr, 0x103 },
         { "debug-dump",           required_argument, nullptr, 0x104 },
+        { "debug-dir",            required_argument, nullptr, 0x105 },
+        { "output-format",        required_argument, nullptr, 0x106 },
+        { "journal",              required_argument, nullptr, 0x107 },
+        { "telemetry",            required_argument, nullptr, 0x108 },
+        { "idle-duration",        required_argument, nullptr, 0x109 },
+        { "idle-baseline",        required_argument, nullptr, 0x10a },
+        { "idle-expiry",          required_argument, nullptr, 0x10b },
+        { "sensor-segment",       required_argument, nullptr, 0x10c },
+        { "cpu-cores",            required_argument, nullptr, 0x10d },
+        { "calibrate-overhead",   required_argument, nullptr, 0x10e },
         { nullptr, 0, nullptr, 0 }
     };
 
@@ -279,6 +482,96 @@ std::optional<arguments> tep::parse_arguments(int argc, char* const argv[])
                 return std::nullopt;
             }
             break;
+        case 0x105:
+            debug_dir = optarg;
+            if (debug_dir.empty())
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be empty\n";
+                return std::nullopt;
+            }
+            break;
+        case 0x106:
+            if (std::string_view(optarg) == "json")
+                format = output_format::json;
+            else if (std::string_view(optarg) == "binary")
+                format = output_format::binary;
+            else
+            {
+                std::cerr << "--" << long_options[option_index].name
+                    << ": invalid format '" << optarg << "'\n";
+                return std::nullopt;
+            }
+            break;
+        case 0x107:
+            journal = optarg;
+            if (journal.empty())
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be empty\n";
+                return std::nullopt;
+            }
+            break;
+        case 0x108:
+            telemetry = optarg;
+            if (telemetry.empty())
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be empty\n";
+                return std::nullopt;
+            }
+            break;
+        case 0x109:
+        {
+            auto parsed_value = parse_count_argument(long_options[option_index].name, optarg);
+            if (!parsed_value)
+                return std::nullopt;
+            if (!*parsed_value)
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be 0\n";
+                return std::nullopt;
+            }
+            idle_duration = std::chrono::milliseconds(*parsed_value);
+        } break;
+        case 0x10a:
+            idle_baseline_path = optarg;
+            if (idle_baseline_path.empty())
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be empty\n";
+                return std::nullopt;
+            }
+            break;
+        case 0x10b:
+        {
+            auto parsed_value = parse_count_argument(long_options[option_index].name, optarg);
+            if (!parsed_value)
+                return std::nullopt;
+            idle_expiry = std::chrono::seconds(*parsed_value);
+        } break;
+        case 0x10c:
+            sensor_segment = optarg;
+            if (sensor_segment.empty())
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be empty\n";
+                return std::nullopt;
+            }
+            break;
+        case 0x10d:
+        {
+            auto parsed_value = parse_cores_argument(long_options[option_index].name, optarg);
+            if (!parsed_value)
+                return std::nullopt;
+            cpu_cores = *parsed_value;
+        } break;
+        case 0x10e:
+        {
+            auto parsed_value = parse_count_argument(long_options[option_index].name, optarg);
+            if (!parsed_value)
+                return std::nullopt;
+            if (!*parsed_value)
+            {
+                std::cerr << "--" << long_options[option_index].name << " cannot be 0\n";
+                return std::nullopt;
+            }
+            calibration_duration = std::chrono::milliseconds(*parsed_value);
+        } break;
         case 'c':
             config = optarg;
             break;
@@ -307,6 +600,18 @@ std::optional<arguments> tep::parse_arguments(int argc, char* const argv[])
         return std::nullopt;
     }
 
+    if (idle_refresh && idle_baseline_path.empty())
+    {
+        std::cerr << "--idle-refresh requires --idle-baseline\n";
+        return std::nullopt;
+    }
+
+    if (journal_only && (journal.empty() || format != output_format::binary))
+    {
+        std::cerr << "--journal-only requires --journal and --output-format binary\n";
+        return std::nullopt;
+    }
+
     if (quiet && !logpath.empty())
     {
         std::cerr << "both -q/--quiet and -l/--log provided\n";
@@ -363,9 +668,27 @@ std::optional<arguments> tep::parse_arguments(int argc, char* const argv[])
     }
 
     return arguments{
-        flags{ bool(idle), cpu_sensors, cpu_sockets, gpu_devices },
+        flags{
+            bool(idle),
+            idle_duration,
+            std::move(idle_baseline_path),
+            idle_expiry,
+            bool(idle_refresh),
+            calibration_duration,
+            cpu_sensors,
+            cpu_sockets,
+            gpu_devices,
+            cpu_cores,
+            bool(parallel_reads),
+            std::move(sensor_segment),
+            std::move(debug_dir)
+        },
         std::move(config),
         std::move(of),
+        format,
+        std::move(journal),
+        bool(journal_only),
+        std::move(telemetry),
         std::move(dd),
         log_args{ bool(quiet), std::move(logpath) },
         std::move(executable),
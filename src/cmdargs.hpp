@@ -33,6 +33,12 @@ namespace tep
         friend std::ostream& operator<<(std::ostream&, const optional_input_file&);
     };
 
+    enum class output_format
+    {
+        json,
+        binary,
+    };
+
     struct log_args
     {
         bool quiet;
@@ -44,6 +50,13 @@ namespace tep
         flags profiler_flags;
         optional_input_file config;
         optional_output_file output;
+        output_format format;
+        // empty if executions are not journaled
+        std::string journal;
+        // executions are only kept in the journal and the results are rebuilt from it
+        bool journal_only;
+        // empty if there is no telemetry
+        std::string telemetry;
         std::ofstream debug_dump;
         log_args logargs;
         std::string target;
@@ -54,6 +67,7 @@ namespace tep
 
     std::ostream& operator<<(std::ostream& os, const optional_output_file& f);
     std::ostream& operator<<(std::ostream& os, const optional_input_file& f);
+    std::ostream& operator<<(std::ostream& os, output_format f);
     std::ostream& operator<<(std::ostream& os, const arguments& a);
 
     std::optional<arguments> parse_arguments(int argc, char* const argv[]);
@@ -0,0 +1,167 @@
+// compressed_execution.cpp
+
+#include "compressed_execution.hpp"
+#include "output/varint.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <type_traits>
+
+using namespace tep;
+
+namespace
+{
+    // at most the number of arrays of readings of a sample
+    constexpr size_t max_arrays = 8;
+
+    // invokes func with every array of readings and reader times of the sample
+    // and of its previous value, in the same order for encoding and decoding
+    template<typename Sample, typename Func>
+    void for_each_array(Sample& smp, const nrgprf::sample& prev_smp, Func&& func)
+    {
+        auto& data = smp.data;
+        const auto& prev = prev_smp.data;
+    #if defined NRG_X86_64
+        func(data.cpu, prev.cpu);
+        func(data.core_energy, prev.core_energy);
+    #elif defined NRG_PPC64
+        func(data.timestamps, prev.timestamps);
+        func(data.cpu, prev.cpu);
+        func(data.accumulators, prev.accumulators);
+    #endif
+        func(data.gpu_power, prev.gpu_power);
+        func(data.gpu_energy, prev.gpu_energy);
+        func(smp.reader_times, prev_smp.reader_times);
+    }
+
+    // the number of leading entries of every array which are read by any sample,
+    // since the events are in the first entries and the others are always zero,
+    // e.g. those of the cores when the energy of the cores is not read
+    std::array<size_t, max_arrays> used_entries(const timed_execution& exec)
+    {
+        // the entries which are not zero in any sample are not zero in their union
+        nrgprf::sample any;
+        for (const auto& ts : exec)
+            for_each_array(any, ts.sample, [](auto& arr, const auto& other)
+                {
+                    for (size_t i = 0; i < arr.size(); i++)
+                        arr[i] |= other[i];
+                });
+        std::array<size_t, max_arrays> retval{};
+        size_t arr_idx = 0;
+        for_each_array(any, any, [&retval, &arr_idx](const auto& arr, const auto&)
+            {
+                size_t& used = retval[arr_idx++];
+                used = arr.size();
+                while (used > 0 && !arr[used - 1])
+                    used--;
+            });
+        return retval;
+    }
+
+    int64_t to_ns(timed_sample::time_point tp)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            tp.time_since_epoch()).count();
+    }
+}
+
+compressed_execution::compressed_execution() :
+    _size(0),
+    _data()
+{}
+
+compressed_execution::compressed_execution(const timed_execution& exec) :
+    _size(exec.size()),
+    _data()
+{
+    // the number of entries encoded of every array, followed by the samples
+    std::array<size_t, max_arrays> used = used_entries(exec);
+    for (size_t count : used)
+        varint::put(_data, count);
+    timed_sample prev{};
+    for (const auto& ts : exec)
+    {
+        varint::put_delta(_data, to_ns(ts.timestamp), to_ns(prev.timestamp));
+        size_t arr_idx = 0;
+        for_each_array(ts.sample, prev.sample,
+            [this, &used, &arr_idx](const auto& arr, const auto& prev_arr)
+            {
+                for (size_t i = 0; i < used[arr_idx]; i++)
+                    varint::put_delta(_data, arr[i], prev_arr[i]);
+                arr_idx++;
+            });
+        prev = ts;
+    }
+    _data.shrink_to_fit();
+}
+
+compressed_execution::compressed_execution(size_t size, std::vector<uint8_t>&& data) :
+    _size(size),
+    _data(std::move(data))
+{}
+
+timed_execution compressed_execution::decompress() const
+{
+    timed_execution retval;
+    retval.reserve(_size);
+    const uint8_t* it = _data.data();
+    const uint8_t* end = it + _data.size();
+    [[maybe_unused]] bool ok = true;
+    std::array<size_t, max_arrays> used{};
+    for (size_t& count : used)
+    {
+        uint64_t x = 0;
+        ok = varint::get(it, end, x) && ok;
+        count = x;
+    }
+    timed_sample prev{};
+    for (size_t i = 0; i < _size; i++)
+    {
+        timed_sample& ts = retval.emplace_back();
+        uint64_t ns = 0;
+        ok = varint::get_delta(it, end, ns, to_ns(prev.timestamp)) && ok;
+        ts.timestamp = timed_sample::time_point(
+            std::chrono::duration_cast<timed_sample::duration>(
+                std::chrono::nanoseconds(static_cast<int64_t>(ns))));
+        size_t arr_idx = 0;
+        // the entries which are not encoded are zero, as constructed
+        for_each_array(ts.sample, prev.sample,
+            [&it, end, &ok, &used, &arr_idx](auto& arr, const auto& prev_arr)
+            {
+                size_t count = std::min(used[arr_idx], arr.size());
+                for (size_t i = 0; i < count; i++)
+                {
+                    uint64_t x = 0;
+                    ok = varint::get_delta(it, end, x, prev_arr[i]) && ok;
+                    arr[i] = static_cast<std::remove_reference_t<decltype(arr[i])>>(x);
+                }
+                arr_idx++;
+            });
+        prev = ts;
+    }
+    assert(ok);
+    assert(it == end);
+    return retval;
+}
+
+size_t compressed_execution::size() const noexcept
+{
+    return _size;
+}
+
+bool compressed_execution::empty() const noexcept
+{
+    return !_size;
+}
+
+size_t compressed_execution::bytes() const noexcept
+{
+    return _data.size();
+}
+
+const std::vector<uint8_t>& compressed_execution::data() const noexcept
+{
+    return _data;
+}
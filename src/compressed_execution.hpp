@@ -0,0 +1,40 @@
+// compressed_execution.hpp
+
+#pragma once
+
+#include "timed_sample.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tep
+{
+    // an execution kept in memory until the results are written;
+    // timestamps and the readings of every event are stored as zig-zag varint
+    // deltas to the previous sample, which are mostly one or two bytes
+    // since timestamps are monotonic and counters increase slowly;
+    // the entries of a sample which no event of the execution reads are not stored
+    class compressed_execution
+    {
+    private:
+        size_t _size;
+        std::vector<uint8_t> _data;
+
+    public:
+        compressed_execution();
+        explicit compressed_execution(const timed_execution& exec);
+        // from the encoding of <size> samples, as returned by data()
+        compressed_execution(size_t size, std::vector<uint8_t>&& data);
+
+        timed_execution decompress() const;
+
+        // number of samples
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        // size of the encoded samples, in bytes
+        size_t bytes() const noexcept;
+        // the encoded samples, e.g. to store them in a file
+        const std::vector<uint8_t>& data() const noexcept;
+    };
+}
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <iomanip>
 #include <charconv>
+#include <regex>
 
 #include <pugixml.hpp>
 #include <nonstd/expected.hpp>
@@ -29,7 +30,7 @@ static constexpr std::string_view error_messages[] =
     "section: extra data cannot be empty",
     "section: frequency must be a positive decimal number",
     "section: interval must be a positive integer",
-    "section: method must be 'profile' or 'total'",
+    "section: method must be 'profile', 'total' or 'stats'",
     "section: executions must be a positive integer",
     "section: samples must be a positive integer",
     "section: duration must be a positive integer",
@@ -57,8 +58,11 @@ static constexpr std::string_view error_messages[] =
     "start/end: invalid line number: must be a positive integer",
 
     "func: invalid compilation unit: cannot be empty",
-    "func: attribute 'name' not found",
+    "func: attribute 'name', 'pattern' or 'glob' not found",
     "func: invalid name: cannot be empty",
+    "func: invalid pattern: cannot be empty and must be a valid regular expression",
+    "func: only one of the attributes 'name', 'pattern' or 'glob' can be provided",
+    "func: invalid module: cannot be empty",
 
     "addr: no start address",
     "addr: no end address",
@@ -119,6 +123,40 @@ namespace
         return tokens;
     }
 
+    std::string glob_to_regex(std::string_view glob)
+    {
+        std::string retval;
+        for (char c : glob)
+        {
+            switch (c)
+            {
+            case '*':
+                retval.append(".*");
+                break;
+            case '?':
+                retval.push_back('.');
+                break;
+            case '\\':
+            case '^':
+            case '$':
+            case '.':
+            case '|':
+            case '+':
+            case '(':
+            case ')':
+            case '[':
+            case ']':
+            case '{':
+            case '}':
+                retval.push_back('\\');
+                [[fallthrough]];
+            default:
+                retval.push_back(c);
+            }
+        }
+        return retval;
+    }
+
     std::string to_lower_case(std::string_view x)
     {
         std::string retval(x);
@@ -308,7 +346,7 @@ namespace
         if (!nmethod)
             return rettype(nonstd::unexpect, errc::sec_no_method);
         std::string method = to_lower_case(nmethod.child_value());
-        if (method == "profile" || method == "total")
+        if (method == "profile" || method == "total" || method == "stats")
             return method;
         return rettype(nonstd::unexpect, errc::sec_invalid_method);
     }
@@ -448,7 +486,19 @@ namespace tep::cfg
         line = *lineno;
     }
 
+    // attribute "module" names the shared object which defines the function
+    static std::optional<std::string> get_module(const config_entry& entry)
+    {
+        pugi::xml_attribute attr = entry.node.attribute("module");
+        if (!attr)
+            return std::nullopt;
+        if (!*attr.value())
+            throw exception(errc::func_invalid_module);
+        return attr.value();
+    }
+
     function_t::function_t(const config_entry& entry) :
+        module(get_module(entry)),
         compilation_unit(std::nullopt)
     {
         using namespace pugi;
@@ -464,11 +514,54 @@ namespace tep::cfg
         xml_attribute name_attr = entry.node.attribute("name");
         if (!name_attr)
             throw exception(errc::func_no_name);
+        if (entry.node.attribute("pattern") || entry.node.attribute("glob"))
+            throw exception(errc::func_too_many_selectors);
         if (!*name_attr.value())
             throw exception(errc::func_invalid_name);
         name = name_attr.value();
     }
 
+    function_pattern_t::function_pattern_t(const config_entry& entry) :
+        module(get_module(entry)),
+        compilation_unit(std::nullopt)
+    {
+        using namespace pugi;
+        xml_attribute cu_attr = entry.node.attribute("cu");
+        if (cu_attr)
+        {
+            if (!*cu_attr.value())
+                throw exception(errc::func_invalid_comp_unit);
+            compilation_unit = cu_attr.value();
+        }
+        xml_attribute regex_attr = entry.node.attribute("pattern");
+        xml_attribute glob_attr = entry.node.attribute("glob");
+        if (entry.node.attribute("name") || (regex_attr && glob_attr))
+            throw exception(errc::func_too_many_selectors);
+        if (!regex_attr && !glob_attr)
+            throw exception(errc::func_no_name);
+        xml_attribute attr = regex_attr ? regex_attr : glob_attr;
+        if (!*attr.value())
+            throw exception(errc::func_invalid_pattern);
+        pattern = attr.value();
+        syntax = regex_attr ? pattern_syntax::regex : pattern_syntax::glob;
+        // validate the expression now instead of when inserting the traps
+        try
+        {
+            std::regex re(regex());
+        }
+        catch (const std::regex_error&)
+        {
+            throw exception(errc::func_invalid_pattern);
+        }
+    }
+
+    std::string function_pattern_t::regex() const
+    {
+        if (syntax == pattern_syntax::glob)
+            return glob_to_regex(pattern);
+        return pattern;
+    }
+
     bounds_t::bounds_t(const config_entry& entry, key<section_t>)
     {
         using namespace pugi;
@@ -499,7 +592,10 @@ namespace tep::cfg
         else if (nfunc)
         {
             assert(!nstart && !nend && !naddr);
-            _value = function_t(nfunc);
+            if (nfunc.node.attribute("pattern") || nfunc.node.attribute("glob"))
+                _value = function_pattern_t(nfunc);
+            else
+                _value = function_t(nfunc);
         }
         else if (naddr)
         {
@@ -556,6 +652,16 @@ namespace tep::cfg
         short_section = bool(nshort);
     }
 
+    method_stats_t::method_stats_t(const config_entry& entry)
+    {
+        using namespace pugi;
+        xml_node nshort = entry.node.child("short");
+        xml_node nlong = entry.node.child("long");
+        if (nshort && nlong)
+            throw exception(errc::sec_both_short_and_long);
+        short_section = bool(nshort);
+    }
+
     method_profile_t::method_profile_t(const config_entry& entry)
     {
         using namespace pugi;
@@ -578,6 +684,8 @@ namespace tep::cfg
             _value = method_total_t(entry);
         else if (*res_method == "profile")
             _value = method_profile_t(entry);
+        else if (*res_method == "stats")
+            _value = method_stats_t(entry);
         else
         {
             assert(false);
@@ -783,12 +891,24 @@ namespace tep::cfg
 
     std::ostream& operator<<(std::ostream& os, const function_t& x)
     {
+        if (x.module)
+            os << *x.module << "!";
         if (x.compilation_unit)
             os << *x.compilation_unit << ":";
         os << x.name;
         return os;
     }
 
+    std::ostream& operator<<(std::ostream& os, const function_pattern_t& x)
+    {
+        if (x.module)
+            os << *x.module << "!";
+        if (x.compilation_unit)
+            os << *x.compilation_unit << ":";
+        os << (x.syntax == pattern_syntax::glob ? "glob " : "regex ") << x.pattern;
+        return os;
+    }
+
     std::ostream& operator<<(std::ostream& os, const bounds_t::position_range_t& x)
     {
         os << x.first << " - " << x.second;
@@ -822,6 +942,12 @@ namespace tep::cfg
         return os;
     }
 
+    std::ostream& operator<<(std::ostream& os, const method_stats_t& x)
+    {
+        os << "statistics method, short section? " << (x.short_section ? "yes" : "no");
+        return os;
+    }
+
     std::ostream& operator<<(std::ostream& os, const misc_attributes_t& x)
     {
         std::visit(overloaded{
@@ -909,10 +1035,19 @@ namespace tep::cfg
 
     bool operator==(const function_t& lhs, const function_t& rhs)
     {
-        return lhs.compilation_unit == rhs.compilation_unit &&
+        return lhs.module == rhs.module &&
+            lhs.compilation_unit == rhs.compilation_unit &&
             lhs.name == rhs.name;
     }
 
+    bool operator==(const function_pattern_t& lhs, const function_pattern_t& rhs)
+    {
+        return lhs.module == rhs.module &&
+            lhs.compilation_unit == rhs.compilation_unit &&
+            lhs.pattern == rhs.pattern &&
+            lhs.syntax == rhs.syntax;
+    }
+
     bool operator==(const bounds_t& lhs, const bounds_t& rhs)
     {
         return lhs._value == rhs._value;
@@ -928,6 +1063,11 @@ namespace tep::cfg
         return lhs.interval == rhs.interval && lhs.samples == rhs.samples;
     }
 
+    static bool operator==(const method_stats_t& lhs, const method_stats_t& rhs)
+    {
+        return lhs.short_section == rhs.short_section;
+    }
+
     bool operator==(const misc_attributes_t& lhs, const misc_attributes_t& rhs)
     {
         return lhs._value == rhs._value;
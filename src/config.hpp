@@ -71,6 +71,9 @@ namespace tep
             func_invalid_comp_unit,
             func_no_name,
             func_invalid_name,
+            func_invalid_pattern,
+            func_too_many_selectors,
+            func_invalid_module,
             addr_range_no_start,
             addr_range_no_end,
             addr_range_invalid_value,
@@ -139,12 +142,32 @@ namespace tep
 
         struct function_t
         {
+            std::optional<std::string> module;
             std::optional<std::string> compilation_unit;
             std::string name;
 
             explicit function_t(const config_entry&);
         };
 
+        enum class pattern_syntax : uint32_t
+        {
+            regex,
+            glob,
+        };
+
+        struct function_pattern_t
+        {
+            std::optional<std::string> module;
+            std::optional<std::string> compilation_unit;
+            std::string pattern;
+            pattern_syntax syntax;
+
+            explicit function_pattern_t(const config_entry&);
+
+            // the pattern as an ECMAScript regular expression
+            std::string regex() const;
+        };
+
         class bounds_t
         {
         public:
@@ -173,7 +196,8 @@ namespace tep
                 std::monostate,
                 address_range_t,
                 position_range_t,
-                function_t
+                function_t,
+                function_pattern_t
             >;
             holder_type _value;
         };
@@ -185,6 +209,15 @@ namespace tep
             explicit method_total_t(const config_entry&);
         };
 
+        // same sampling as method_total_t, but executions are folded into
+        // statistics of the section as they finish instead of being stored
+        struct method_stats_t
+        {
+            bool short_section;
+
+            explicit method_stats_t(const config_entry&);
+        };
+
         struct method_profile_t
         {
             std::chrono::milliseconds interval;
@@ -216,7 +249,8 @@ namespace tep
             using holder_type = std::variant<
                 std::monostate,
                 method_total_t,
-                method_profile_t
+                method_profile_t,
+                method_stats_t
             >;
             holder_type _value;
         };
@@ -261,11 +295,13 @@ namespace tep
         std::ostream& operator<<(std::ostream&, const params_t&);
         std::ostream& operator<<(std::ostream&, const address_range_t&);
         std::ostream& operator<<(std::ostream&, const function_t&);
+        std::ostream& operator<<(std::ostream&, const function_pattern_t&);
         std::ostream& operator<<(std::ostream&, const position_t&);
         std::ostream& operator<<(std::ostream&, const bounds_t::position_range_t&);
         std::ostream& operator<<(std::ostream&, const bounds_t&);
         std::ostream& operator<<(std::ostream&, const method_total_t&);
         std::ostream& operator<<(std::ostream&, const method_profile_t&);
+        std::ostream& operator<<(std::ostream&, const method_stats_t&);
         std::ostream& operator<<(std::ostream&, const misc_attributes_t&);
         std::ostream& operator<<(std::ostream&, const section_t&);
         std::ostream& operator<<(std::ostream&, const group_t&);
@@ -275,6 +311,7 @@ namespace tep
         bool operator==(const address_range_t&, const address_range_t&);
         bool operator==(const position_t&, const position_t&);
         bool operator==(const function_t&, const function_t&);
+        bool operator==(const function_pattern_t&, const function_pattern_t&);
         bool operator==(const bounds_t&, const bounds_t&);
         bool operator==(const misc_attributes_t&, const misc_attributes_t&);
         bool operator==(const section_t&, const section_t&);
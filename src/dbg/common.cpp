@@ -31,7 +31,8 @@ namespace tep::dbg
     {
         if (elf_version(EV_CURRENT) == EV_NONE)
             throw exception(elf_errno(), elf_category());
-        if (!(value = elf_begin(fd.value, ELF_C_READ, nullptr)))
+        // map the file so that only the sections which are used are read
+        if (!(value = elf_begin(fd.value, ELF_C_READ_MMAP, nullptr)))
             throw exception(elf_errno(), elf_category());
         if (elf_kind(value) != ELF_K_ELF)
             throw exception(errc::not_an_elf_object);
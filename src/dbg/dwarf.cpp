@@ -270,11 +270,12 @@ namespace tep::dbg
                 lhs.linkage_name == rhs.linkage_name;
         };
 
-        auto [files, nfiles] = get_source_files(x.cu_die);
+        Dwarf_Die& die = x.split_die ? *x.split_die : x.cu_die;
+        auto [files, nfiles] = get_source_files(die);
         // initially, add all concrete functions
         container<function> inlined;
         passkey<compilation_unit> key;
-        for (auto& func_die : get_funcs(x.cu_die))
+        for (auto& func_die : get_funcs(die))
         {
             bool is_inline =
                 dwarf_func_inline(&func_die);
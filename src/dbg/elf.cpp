@@ -111,4 +111,40 @@ namespace tep::dbg
 #else
 #error Unsupported architecture detected
 #endif
+
+    std::optional<uintptr_t> find_symbol_address(
+        std::string_view path, std::string_view name)
+    {
+        ro_file_descriptor fd(path);
+        elf_descriptor elf(fd);
+        for (Elf_Scn* scn = elf_nextscn(elf.value, nullptr);
+            scn;
+            scn = elf_nextscn(elf.value, scn))
+        {
+            GElf_Shdr header;
+            if (!gelf_getshdr(scn, &header))
+                throw exception(elf_errno(), elf_category());
+            if (header.sh_type != SHT_DYNSYM && header.sh_type != SHT_SYMTAB)
+                continue;
+            size_t entry_count = header.sh_size / header.sh_entsize;
+            Elf_Data* data = elf_getdata(scn, nullptr);
+            if (!data)
+                throw exception(elf_errno(), elf_category());
+            for (size_t i = 0; i < entry_count; ++i)
+            {
+                GElf_Sym sym;
+                if (!gelf_getsym(data, i, &sym))
+                    throw exception(elf_errno(), elf_category());
+                if (sym.st_shndx == SHN_UNDEF)
+                    continue;
+                if (GELF_ST_TYPE(sym.st_info) != STT_FUNC &&
+                    GELF_ST_TYPE(sym.st_info) != STT_OBJECT)
+                    continue;
+                const char* sym_name = elf_strptr(elf.value, header.sh_link, sym.st_name);
+                if (sym_name && name == sym_name)
+                    return sym.st_value;
+            }
+        }
+        return std::nullopt;
+    }
 }
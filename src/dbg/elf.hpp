@@ -2,7 +2,9 @@
 
 #include <cstdint>
 #include <iosfwd>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace tep::dbg
 {
@@ -54,6 +56,19 @@ namespace tep::dbg
         uint8_t st_other;
     };
 
+    /**
+     * @brief Find the address of a function or object symbol by its exact name
+     * in the dynamic and static symbol tables of an ELF object.
+     * Debug information is not loaded, so it can be used on stripped objects
+     * such as the dynamic loader.
+     *
+     * @param path path of the ELF object
+     * @param name the mangled symbol name
+     * @return std::optional<uintptr_t> empty if no symbol is found
+     */
+    std::optional<uintptr_t> find_symbol_address(
+        std::string_view path, std::string_view name);
+
     std::ostream& operator<<(std::ostream&, executable_type);
     std::ostream& operator<<(std::ostream&, symbol_visibility);
     std::ostream& operator<<(std::ostream&, symbol_binding);
@@ -21,4 +21,8 @@ namespace tep::dbg
     struct compilation_unit;
 
     struct object_info;
+
+    struct inline_frame;
+    struct symbolized_address;
+    class symbolizer;
 }
@@ -3,7 +3,15 @@
 #include "params_structs.hpp"
 #include "error.hpp"
 
+#include <elfutils/libdwelf.h>
+
 #include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
 
 namespace
 {
@@ -25,6 +33,147 @@ namespace
         }
         throw exception(errc::symtab_not_found);
     }
+
+    bool has_debug_info(const tep::dbg::elf_descriptor& elf)
+    {
+        using tep::dbg::exception;
+        using tep::dbg::elf_category;
+        size_t shstrndx;
+        if (elf_getshdrstrndx(elf.value, &shstrndx) != 0)
+            throw exception(elf_errno(), elf_category());
+        bool symtab = false;
+        bool dwarf = false;
+        for (Elf_Scn* scn = elf_nextscn(elf.value, nullptr);
+            scn;
+            scn = elf_nextscn(elf.value, scn))
+        {
+            GElf_Shdr header;
+            if (!gelf_getshdr(scn, &header))
+                throw exception(elf_errno(), elf_category());
+            // sections of stripped objects may be kept with no contents
+            if (header.sh_type == SHT_NOBITS)
+                continue;
+            const char* name = elf_strptr(elf.value, shstrndx, header.sh_name);
+            symtab = symtab || header.sh_type == SHT_SYMTAB;
+            dwarf = dwarf || (name && std::string_view(name) == ".debug_info");
+        }
+        return symtab && dwarf;
+    }
+
+    std::optional<std::filesystem::path> existing_file(
+        const std::filesystem::path& candidate,
+        const std::filesystem::path& object)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(candidate, ec))
+            return std::nullopt;
+        // the debug link may name the object itself
+        if (std::filesystem::equivalent(candidate, object, ec) || ec)
+            return std::nullopt;
+        return candidate;
+    }
+
+    std::string_view build_id_of(const tep::dbg::elf_descriptor& elf)
+    {
+        const void* build_id;
+        ssize_t len = dwelf_elf_gnu_build_id(elf.value, &build_id);
+        if (len <= 0)
+            return {};
+        return { static_cast<const char*>(build_id), static_cast<size_t>(len) };
+    }
+
+    // a debug file whose build ID is not the same as the object's describes another build,
+    // whose addresses would place the traps at the wrong instructions
+    bool same_build_id(const std::filesystem::path& candidate, std::string_view build_id)
+    {
+        try
+        {
+            tep::dbg::ro_file_descriptor fd(candidate.native());
+            tep::dbg::elf_descriptor elf(fd);
+            return build_id_of(elf) == build_id;
+        }
+        catch (const std::system_error&)
+        {
+            return false;
+        }
+    }
+
+    // CRC-32 of the whole file, as stored in the debug link by objcopy
+    std::optional<uint32_t> file_crc32(const std::filesystem::path& path)
+    {
+        static const std::array<uint32_t, 256> table = []()
+        {
+            std::array<uint32_t, 256> retval;
+            for (uint32_t i = 0; i < retval.size(); i++)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++)
+                    crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+                retval[i] = crc;
+            }
+            return retval;
+        }();
+
+        std::ifstream is(path, std::ios::binary);
+        if (!is)
+            return std::nullopt;
+        uint32_t crc = 0xffffffff;
+        std::array<char, 1 << 16> buffer;
+        while (is.read(buffer.data(), buffer.size()) || is.gcount())
+        {
+            for (std::streamsize i = 0; i < is.gcount(); i++)
+                crc = table[(crc ^ static_cast<unsigned char>(buffer[i])) & 0xff] ^ (crc >> 8);
+        }
+        if (is.bad())
+            return std::nullopt;
+        return ~crc;
+    }
+
+    // same search order as gdb: build ID first, then the debug link
+    // next to the object, in its .debug subdirectory and in the debug directory;
+    // candidates are only accepted if their build ID is the same as the object's
+    // and, for the debug link, if the CRC of the file is the one the link holds
+    std::optional<std::filesystem::path> find_debug_file(
+        const tep::dbg::elf_descriptor& elf,
+        const std::filesystem::path& object,
+        const std::filesystem::path& debug_dir)
+    {
+        namespace fs = std::filesystem;
+        std::string_view build_id = build_id_of(elf);
+        if (build_id.size() > 1)
+        {
+            std::string hex;
+            for (unsigned char byte : build_id)
+            {
+                char str[3];
+                snprintf(str, sizeof(str), "%02x", byte);
+                hex.append(str);
+            }
+            fs::path candidate = debug_dir / ".build-id" / hex.substr(0, 2);
+            candidate /= hex.substr(2) + ".debug";
+            if (auto retval = existing_file(candidate, object))
+                if (same_build_id(*retval, build_id))
+                    return retval;
+        }
+
+        GElf_Word crc;
+        if (const char* link = dwelf_elf_gnu_debuglink(elf.value, &crc))
+        {
+            fs::path dir = fs::absolute(object).parent_path();
+            for (const fs::path& candidate : {
+                dir / link,
+                dir / ".debug" / link,
+                debug_dir / dir.relative_path() / link })
+            {
+                auto retval = existing_file(candidate, object);
+                if (!retval || file_crc32(*retval) != crc)
+                    continue;
+                if (build_id.empty() || same_build_id(*retval, build_id))
+                    return retval;
+            }
+        }
+        return std::nullopt;
+    }
 }
 
 namespace tep::dbg
@@ -35,16 +184,33 @@ namespace tep::dbg
         std::vector<function_symbol> function_symbols;
         std::vector<compilation_unit> compilation_units;
 
-        explicit impl(std::string_view path) :
-            impl(ro_file_descriptor{ path })
+        impl(std::string_view path, std::string_view debug_dir) :
+            impl(ro_file_descriptor{ path }, path, debug_dir)
         {}
 
     private:
-        explicit impl(ro_file_descriptor fd) :
-            impl(elf_descriptor{ fd })
+        impl(ro_file_descriptor fd, std::string_view path, std::string_view debug_dir) :
+            impl(elf_descriptor{ fd }, path, debug_dir)
         {}
 
-        explicit impl(elf_descriptor elf) : header({ elf })
+        impl(elf_descriptor elf, std::string_view path, std::string_view debug_dir) :
+            header({ elf })
+        {
+            // the header always comes from the object, since that is what gets executed
+            std::optional<std::filesystem::path> debug_file;
+            if (!has_debug_info(elf))
+                debug_file = find_debug_file(elf, path, debug_dir);
+            if (!debug_file)
+            {
+                load(elf);
+                return;
+            }
+            ro_file_descriptor debug_fd(debug_file->native());
+            elf_descriptor debug_elf(debug_fd);
+            load(debug_elf);
+        }
+
+        void load(elf_descriptor& elf)
         {
             load_function_symbols(elf);
             load_debug_info(dwarf_descriptor{ elf });
@@ -89,26 +255,30 @@ namespace tep::dbg
 
     void object_info::impl::load_debug_info(dwarf_descriptor dbg)
     {
-        Dwarf_Off offset = 0;
+        Dwarf_CU* cu = nullptr;
         while (true)
         {
-            size_t hdr_size;
-            Dwarf_Off prev_offset = offset;
-            int res = dwarf_nextcu(dbg.value, offset, &offset, &hdr_size,
-                nullptr, nullptr, nullptr);
+            uint8_t unit_type;
+            Dwarf_Die cu_die;
+            Dwarf_Die split_die;
+            int res = dwarf_get_units(dbg.value, cu, &cu, nullptr,
+                &unit_type, &cu_die, &split_die);
             if (res == -1)
                 throw exception(dwarf_errno(), dwarf_category());
             if (res != 0)
                 break;
-            Dwarf_Die cu_die;
-            if (!dwarf_offdie(dbg.value, prev_offset + hdr_size, &cu_die))
-                throw exception(dwarf_errno(), dwarf_category());
-            compilation_units.emplace_back(compilation_unit::param{ cu_die });
+            if (unit_type != DW_UT_compile && unit_type != DW_UT_skeleton)
+                continue;
+            // the functions of skeleton units are in their split units;
+            // if the .dwo or .dwp file is missing, only the skeleton is loaded
+            compilation_units.emplace_back(compilation_unit::param{
+                cu_die,
+                unit_type == DW_UT_skeleton && split_die.addr ? &split_die : nullptr });
         }
     }
 
-    object_info::object_info(std::string_view path) :
-        impl_(std::make_shared<impl>(path))
+    object_info::object_info(std::string_view path, std::string_view debug_dir) :
+        impl_(std::make_shared<impl>(path, debug_dir))
     {}
 
     const executable_header& object_info::header() const noexcept
@@ -11,7 +11,21 @@ namespace tep::dbg
 {
     struct object_info
     {
-        explicit object_info(std::string_view);
+        // global directory of separate debug files, as used by gdb
+        static constexpr std::string_view default_debug_dir = "/usr/lib/debug";
+
+        /**
+         * @brief Load the symbols and debug information of an ELF object.
+         * If the object is stripped, they are loaded from its separate debug
+         * file, found by build ID or debug link. Split DWARF units are loaded
+         * from their .dwo files or from a .dwp package next to the file which
+         * contains the skeleton units.
+         *
+         * @param path path of the ELF object
+         * @param debug_dir global directory of separate debug files
+         */
+        explicit object_info(std::string_view path,
+            std::string_view debug_dir = default_debug_dir);
 
         const executable_header& header() const noexcept;
         const std::vector<function_symbol>& function_symbols() const noexcept;
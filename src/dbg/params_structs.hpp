@@ -43,6 +43,8 @@ namespace tep::dbg
     struct compilation_unit::param
     {
         Dwarf_Die& cu_die;
+        // the split unit of a skeleton unit, which contains its functions
+        Dwarf_Die* split_die;
     };
 
 } // namespace tep::dbg
@@ -1,6 +1,7 @@
 #include "elf.hpp"
 #include "dwarf.hpp"
 #include "object_info.hpp"
+#include "symbolizer.hpp"
 
 #include <iostream>
 
@@ -205,4 +206,30 @@ namespace tep::dbg
             os << cu << "\n";
         return os;
     }
+
+    std::ostream& operator<<(std::ostream& os, const symbolized_address& x)
+    {
+        std::ios::fmtflags flags(os.flags());
+        os << std::hex << x.address;
+        os.flags(flags);
+        os << " in ";
+        if (x.func)
+            os << x.func->die_name;
+        else if (x.symbol)
+            os << x.symbol->name;
+        else
+            os << "??";
+        for (const auto& frame : x.inline_chain)
+        {
+            os << ", inlined " << frame.func->die_name;
+            if (frame.instance->call_loc)
+                os << " at " << *frame.instance->call_loc;
+        }
+        os << " @ ";
+        if (x.line)
+            os << x.line->file.native() << ":" << x.line->number << ":" << x.line->column;
+        else
+            os << "??";
+        return os;
+    }
 } // namespace tep::dbg
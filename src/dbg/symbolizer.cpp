@@ -0,0 +1,352 @@
+#include "symbolizer.hpp"
+
+#include <nonstd/expected.hpp>
+
+#include <algorithm>
+#include <array>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    using namespace tep::dbg;
+
+    struct range_entry
+    {
+        uintptr_t low;
+        uintptr_t high;
+        const compilation_unit* cu;
+        const function* func;
+    };
+
+    struct line_entry
+    {
+        uintptr_t address;
+        // nullptr marks the end of a sequence
+        const source_line* line;
+    };
+
+    struct inline_segment
+    {
+        uintptr_t low;
+        uintptr_t high;
+        size_t first;
+        size_t count;
+    };
+
+    struct inline_range
+    {
+        uintptr_t low;
+        uintptr_t high;
+        inline_frame frame;
+    };
+
+    template<typename It>
+    It find_containing(It first, It last, uintptr_t addr)
+    {
+        auto it = std::upper_bound(first, last, addr,
+            [](uintptr_t addr, const auto& entry)
+            {
+                return addr < entry.low;
+            });
+        if (it == first)
+            return last;
+        if (addr < (--it)->high)
+            return it;
+        return last;
+    }
+
+    template<typename T>
+    void sort_by_low(std::vector<T>& entries)
+    {
+        std::sort(entries.begin(), entries.end(),
+            [](const T& lhs, const T& rhs)
+            {
+                return lhs.low < rhs.low;
+            });
+    }
+
+    // cache of recently resolved addresses split into independently locked shards,
+    // so that concurrent callers rarely contend for the same lock
+    class lru_cache
+    {
+    public:
+        explicit lru_cache(size_t capacity) :
+            _shard_capacity((capacity + num_shards - 1) / num_shards)
+        {}
+
+        bool get(uintptr_t key, result<symbolized_address>& value)
+        {
+            if (!_shard_capacity)
+                return false;
+            shard& s = get_shard(key);
+            std::scoped_lock lock(s.mtx);
+            auto it = s.index.find(key);
+            if (it == s.index.end())
+                return false;
+            s.entries.splice(s.entries.begin(), s.entries, it->second);
+            value = it->second->second;
+            return true;
+        }
+
+        void put(uintptr_t key, const result<symbolized_address>& value)
+        {
+            if (!_shard_capacity)
+                return;
+            shard& s = get_shard(key);
+            std::scoped_lock lock(s.mtx);
+            if (s.index.find(key) != s.index.end())
+                return;
+            if (s.entries.size() >= _shard_capacity)
+            {
+                s.index.erase(s.entries.back().first);
+                s.entries.pop_back();
+            }
+            s.entries.emplace_front(key, value);
+            s.index.emplace(key, s.entries.begin());
+        }
+
+    private:
+        static constexpr size_t num_shards = 16;
+
+        using entry_list = std::list<std::pair<uintptr_t, result<symbolized_address>>>;
+
+        struct shard
+        {
+            std::mutex mtx;
+            entry_list entries;
+            std::unordered_map<uintptr_t, entry_list::iterator> index;
+        };
+
+        size_t _shard_capacity;
+        std::array<shard, num_shards> _shards;
+
+        shard& get_shard(uintptr_t key)
+        {
+            // instructions are usually aligned, so ignore the lowest bits
+            return _shards[(key >> 2) % num_shards];
+        }
+    };
+}
+
+namespace tep::dbg
+{
+    struct symbolizer::impl
+    {
+        object_info info;
+        uintptr_t load_address;
+        std::vector<range_entry> cus;
+        std::vector<range_entry> funcs;
+        std::vector<const function_symbol*> symbols;
+        std::vector<line_entry> lines;
+        std::vector<inline_segment> inline_segments;
+        std::vector<inline_frame> inline_frames;
+        mutable lru_cache cache;
+
+        impl(const object_info& info, uintptr_t load_address, size_t cache_capacity);
+
+        result<symbolized_address> lookup(uintptr_t rel) const;
+
+    private:
+        void load_symbols();
+        void load_inline_segments(std::vector<inline_range>);
+    };
+
+    symbolizer::impl::impl(
+        const object_info& info,
+        uintptr_t load_address,
+        size_t cache_capacity)
+        :
+        info(info),
+        load_address(load_address),
+        cache(cache_capacity)
+    {
+        std::vector<inline_range> inlined;
+        for (const auto& cu : info.compilation_units())
+        {
+            for (const auto& r : cu.addresses)
+                cus.push_back({ r.low_pc, r.high_pc, &cu, nullptr });
+            for (const auto& l : cu.lines)
+                lines.push_back({ l.address, l.end_text_sequence ? nullptr : &l });
+            for (const auto& f : cu.funcs)
+            {
+                if (f.addresses)
+                    for (const auto& r : f.addresses->values)
+                        funcs.push_back({ r.low_pc, r.high_pc, &cu, &f });
+                if (f.instances)
+                    for (const auto& inst : f.instances->insts)
+                        for (const auto& r : inst.addresses.values)
+                            inlined.push_back({ r.low_pc, r.high_pc, { &f, &inst } });
+            }
+        }
+        sort_by_low(cus);
+        sort_by_low(funcs);
+        // at equal addresses, the start of a sequence must prevail over the end
+        // of the previous one; otherwise, keep the last row, as addr2line does
+        std::stable_sort(lines.begin(), lines.end(),
+            [](const line_entry& lhs, const line_entry& rhs)
+            {
+                if (lhs.address != rhs.address)
+                    return lhs.address < rhs.address;
+                return !lhs.line && rhs.line;
+            });
+        lines.erase(lines.begin(), std::unique(lines.rbegin(), lines.rend(),
+            [](const line_entry& lhs, const line_entry& rhs)
+            {
+                return lhs.address == rhs.address;
+            }).base());
+        load_symbols();
+        load_inline_segments(std::move(inlined));
+    }
+
+    void symbolizer::impl::load_symbols()
+    {
+        for (const auto& sym : info.function_symbols())
+            symbols.push_back(&sym);
+        // prefer global symbols over aliases at the same address
+        std::stable_sort(symbols.begin(), symbols.end(),
+            [](const function_symbol* lhs, const function_symbol* rhs)
+            {
+                if (lhs->address != rhs->address)
+                    return lhs->address < rhs->address;
+                return lhs->binding == symbol_binding::global &&
+                    rhs->binding != symbol_binding::global;
+            });
+    }
+
+    // inline instances nest, so flatten them into disjoint segments, each of
+    // which holds the full chain of instances which contain it
+    void symbolizer::impl::load_inline_segments(std::vector<inline_range> inlined)
+    {
+        sort_by_low(inlined);
+        std::vector<uintptr_t> bounds;
+        for (const auto& r : inlined)
+        {
+            bounds.push_back(r.low);
+            bounds.push_back(r.high);
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        std::vector<const inline_range*> active;
+        auto next = inlined.begin();
+        for (size_t ix = 0; ix + 1 < bounds.size(); ix++)
+        {
+            uintptr_t low = bounds[ix];
+            uintptr_t high = bounds[ix + 1];
+            active.erase(std::remove_if(active.begin(), active.end(),
+                [low](const inline_range* r)
+                {
+                    return r->high <= low;
+                }), active.end());
+            for (; next != inlined.end() && next->low == low; ++next)
+                if (next->high > low)
+                    active.push_back(&*next);
+            if (active.empty())
+                continue;
+            // the smallest range is the innermost instance
+            std::stable_sort(active.begin(), active.end(),
+                [](const inline_range* lhs, const inline_range* rhs)
+                {
+                    return lhs->high - lhs->low < rhs->high - rhs->low;
+                });
+            inline_segments.push_back({ low, high, inline_frames.size(), active.size() });
+            for (const inline_range* r : active)
+                inline_frames.push_back(r->frame);
+        }
+    }
+
+    result<symbolized_address> symbolizer::impl::lookup(uintptr_t rel) const
+    {
+        symbolized_address retval;
+        retval.address = rel;
+        if (auto it = find_containing(cus.begin(), cus.end(), rel); it != cus.end())
+            retval.cu = it->cu;
+        if (auto it = find_containing(funcs.begin(), funcs.end(), rel); it != funcs.end())
+        {
+            retval.cu = it->cu;
+            retval.func = it->func;
+        }
+
+        auto sym = std::upper_bound(symbols.begin(), symbols.end(), rel,
+            [](uintptr_t addr, const function_symbol* sym)
+            {
+                return addr < sym->address;
+            });
+        if (sym != symbols.begin())
+        {
+            const function_symbol* candidate = *std::prev(sym);
+            // walk back to the preferred symbol at the same address
+            auto first = std::lower_bound(symbols.begin(), sym, candidate->address,
+                [](const function_symbol* sym, uintptr_t addr)
+                {
+                    return sym->address < addr;
+                });
+            candidate = *first;
+            if (rel < candidate->address + std::max<size_t>(candidate->size, 1))
+                retval.symbol = candidate;
+        }
+
+        if (auto it = find_containing(inline_segments.begin(), inline_segments.end(), rel);
+            it != inline_segments.end())
+        {
+            retval.inline_chain.assign(
+                inline_frames.begin() + it->first,
+                inline_frames.begin() + it->first + it->count);
+        }
+
+        auto line = std::upper_bound(lines.begin(), lines.end(), rel,
+            [](uintptr_t addr, const line_entry& entry)
+            {
+                return addr < entry.address;
+            });
+        if (line != lines.begin())
+            retval.line = std::prev(line)->line;
+
+        if (!retval.cu && !retval.symbol)
+            return result<symbolized_address>(nonstd::unexpect, util_errc::address_not_found);
+        return retval;
+    }
+
+    symbolizer::symbolizer(
+        const object_info& info,
+        uintptr_t load_address,
+        size_t cache_capacity)
+        :
+        impl_(std::make_shared<impl>(info, load_address, cache_capacity))
+    {}
+
+    const object_info& symbolizer::info() const noexcept
+    {
+        return impl_->info;
+    }
+
+    uintptr_t symbolizer::load_address() const noexcept
+    {
+        return impl_->load_address;
+    }
+
+    result<symbolized_address> symbolizer::resolve(uintptr_t addr) const
+    {
+        if (addr < impl_->load_address)
+            return result<symbolized_address>(nonstd::unexpect, util_errc::address_not_found);
+        uintptr_t rel = addr - impl_->load_address;
+        result<symbolized_address> retval(nonstd::unexpect, util_errc::address_not_found);
+        if (impl_->cache.get(rel, retval))
+            return retval;
+        retval = impl_->lookup(rel);
+        impl_->cache.put(rel, retval);
+        return retval;
+    }
+
+    std::vector<result<symbolized_address>>
+        symbolizer::resolve(const std::vector<uintptr_t>& addrs) const
+    {
+        std::vector<result<symbolized_address>> retval;
+        retval.reserve(addrs.size());
+        for (uintptr_t addr : addrs)
+            retval.push_back(resolve(addr));
+        return retval;
+    }
+}
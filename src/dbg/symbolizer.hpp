@@ -0,0 +1,77 @@
+#pragma once
+
+#include "object_info.hpp"
+#include "utility_funcs.hpp"
+
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+namespace tep::dbg
+{
+    struct inline_frame
+    {
+        const function* func;
+        const inline_instance* instance;
+    };
+
+    struct symbolized_address
+    {
+        // address relative to the start of the object
+        uintptr_t address = 0;
+        const compilation_unit* cu = nullptr;
+        const function* func = nullptr;
+        const function_symbol* symbol = nullptr;
+        // innermost inlined function first
+        std::vector<inline_frame> inline_chain;
+        const source_line* line = nullptr;
+    };
+
+    class symbolizer
+    {
+    public:
+        static constexpr size_t default_cache_capacity = 1 << 16;
+
+        /**
+         * @brief Construct a symbolizer for an object loaded at some address.
+         * The object info is shared, so it is kept alive by the symbolizer.
+         *
+         * @param info the object's debug and symbol information
+         * @param load_address the runtime entrypoint of the object if PIE or 0
+         * @param cache_capacity maximum number of cached results
+         */
+        explicit symbolizer(
+            const object_info& info,
+            uintptr_t load_address = 0,
+            size_t cache_capacity = default_cache_capacity);
+
+        const object_info& info() const noexcept;
+        uintptr_t load_address() const noexcept;
+
+        /**
+         * @brief Resolve a runtime address to the function, inlined-at chain
+         * and source line it belongs to. Safe to call concurrently.
+         *
+         * @param addr the runtime address
+         * @return result<symbolized_address>
+         */
+        result<symbolized_address> resolve(uintptr_t addr) const;
+
+        /**
+         * @brief Resolve a batch of runtime addresses.
+         * Safe to call concurrently.
+         *
+         * @param addrs the runtime addresses
+         * @return std::vector<result<symbolized_address>> one result
+         * per address, in the same order
+         */
+        std::vector<result<symbolized_address>>
+            resolve(const std::vector<uintptr_t>& addrs) const;
+
+    private:
+        struct impl;
+        std::shared_ptr<impl> impl_;
+    };
+
+    std::ostream& operator<<(std::ostream&, const symbolized_address&);
+} // namespace tep::dbg
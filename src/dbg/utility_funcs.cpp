@@ -894,4 +894,86 @@ namespace tep::dbg
             return unexpected{ util_errc::function_ambiguous };
         return &*it;
     }
+
+    result<std::vector<function_match>>
+        find_functions(
+            const object_info& oi,
+            const std::regex& pattern,
+            const compilation_unit* cu)
+    {
+        using unexpected = nonstd::unexpected<std::error_code>;
+
+        // index the symbols by address once instead of searching the
+        // symbol table for every function
+        std::vector<const function_symbol*> symbols;
+        symbols.reserve(oi.function_symbols().size());
+        for (const auto& sym : oi.function_symbols())
+            symbols.push_back(&sym);
+        std::stable_sort(symbols.begin(), symbols.end(),
+            [](const function_symbol* lhs, const function_symbol* rhs)
+            {
+                if (lhs->address != rhs->address)
+                    return lhs->address < rhs->address;
+                return lhs->binding == symbol_binding::global &&
+                    rhs->binding != symbol_binding::global;
+            });
+
+        auto find_symbol = [&symbols](const function& f) -> const function_symbol*
+        {
+            if (!f.addresses)
+                return nullptr;
+            for (const auto& rng : f.addresses->values)
+            {
+                auto it = std::lower_bound(symbols.begin(), symbols.end(), rng.low_pc,
+                    [](const function_symbol* sym, uintptr_t addr)
+                    {
+                        return sym->address < addr;
+                    });
+                if (it != symbols.end() && (*it)->address == rng.low_pc)
+                    return *it;
+            }
+            return nullptr;
+        };
+
+        std::vector<function_match> matches;
+        auto match_cu = [&](const compilation_unit& cu) -> std::error_code
+        {
+            for (const auto& f : cu.funcs)
+            {
+                if (!f.addresses && !f.instances)
+                    continue;
+                const function_symbol* sym = find_symbol(f);
+                std::string_view mangled = f.die_name;
+                if (sym)
+                    mangled = sym->name;
+                else if (f.linkage_name)
+                    mangled = *f.linkage_name;
+                std::error_code ec;
+                auto name = demangle(mangled, ec);
+                if (!name)
+                    return ec;
+                if (std::regex_match(*name, pattern) ||
+                    std::regex_match(f.die_name, pattern))
+                {
+                    matches.push_back({ &cu, &f, sym, *std::move(name) });
+                }
+            }
+            return {};
+        };
+
+        if (cu)
+        {
+            if (auto ec = match_cu(*cu))
+                return unexpected{ ec };
+        }
+        else
+        {
+            for (const auto& cu : oi.compilation_units())
+                if (auto ec = match_cu(cu))
+                    return unexpected{ ec };
+        }
+        if (matches.empty())
+            return unexpected{ util_errc::no_matches };
+        return matches;
+    }
 } // namespace tep::dbg
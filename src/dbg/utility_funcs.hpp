@@ -5,6 +5,7 @@
 #include <util/expectedfwd.hpp>
 
 #include <filesystem>
+#include <regex>
 #include <system_error>
 
 namespace tep::dbg
@@ -41,6 +42,16 @@ namespace tep::dbg
         other,
     };
 
+    struct function_match
+    {
+        const compilation_unit* cu;
+        const function* func;
+        // nullptr if the function has no out-of-line definition
+        const function_symbol* symbol;
+        // demangled name the pattern was matched against
+        std::string name;
+    };
+
     enum class new_statement_flag : bool { no, yes };
     enum class exact_line_value_flag : bool { no, yes };
     enum class exact_column_value_flag : bool { no, yes };
@@ -322,4 +333,20 @@ namespace tep::dbg
             const std::filesystem::path& file,
             uint32_t lineno,
             uint32_t colno = 0) noexcept;
+
+    /**
+     * @brief Find all functions whose demangled name matches a regular expression.
+     * The name is the demangled symbol or linkage name if one exists,
+     * otherwise the DIE name. Functions without any out-of-line or inlined
+     * code are ignored.
+     *
+     * @param pattern regular expression which must match the whole name
+     * @param cu compilation unit to search or nullptr to search all
+     * @return result<std::vector<function_match>>
+     */
+    result<std::vector<function_match>>
+        find_functions(
+            const object_info&,
+            const std::regex& pattern,
+            const compilation_unit* cu = nullptr);
 } // namespace tep::dbg
@@ -76,10 +76,6 @@ tracer_error tep::get_syserror__(const char* file, int line, int errnum,
 {
     char error_msg[256];
     char* msg = strerror_r(errnum, error_msg, sizeof(error_msg));
-    log::write(
-        log::error,
-        { "[%d] %s: %s", tid, comment, msg },
-        { file, line }
-    );
+    log::write(log::error, { file, line }, "[%d] %s: %s", tid, comment, msg);
     return { code, msg };
 }
@@ -3,12 +3,26 @@
 #include "flags.hpp"
 
 #include <iostream>
+#include <string>
 
 std::ostream& tep::operator<<(std::ostream& os, const flags& f)
 {
     os << "collect idle readings? " << (f.obtain_idle ? "yes" : "no") << ", ";
+    os << "idle duration: " << f.idle_duration.count() << " ms, ";
+    os << "idle baseline: " << (f.idle_baseline.empty() ? "none" : f.idle_baseline) << ", ";
+    os << "idle baseline expiry: " << f.idle_expiry.count() << " s, ";
+    os << "refresh idle baseline? " << (f.idle_refresh ? "yes" : "no") << ", ";
+    os << "overhead calibration: ";
+    if (f.calibration_duration.count())
+        os << f.calibration_duration.count() << " ms, ";
+    else
+        os << "none, ";
     os << "CPU sensor location mask: " << f.locations << ", ";
     os << "CPU socket mask: " << f.sockets << ", ";
-    os << "GPU device mask: " << f.devices;
+    os << "GPU device mask: " << f.devices << ", ";
+    os << "CPU cores: " << (f.cores.none() ? "none" : std::to_string(f.cores.count())) << ", ";
+    os << "parallel reads? " << (f.parallel_reads ? "yes" : "no") << ", ";
+    os << "sensor segment: " << (f.sensor_segment.empty() ? "none" : f.sensor_segment) << ", ";
+    os << "debug directory: " << f.debug_dir;
     return os;
 }
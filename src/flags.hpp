@@ -4,17 +4,36 @@
 
 #include <nrg/types.hpp>
 
+#include <chrono>
 #include <iosfwd>
+#include <string>
 
 namespace tep
 {
 
+    constexpr std::chrono::milliseconds default_idle_duration{ 5000 };
+
     struct flags
     {
         bool obtain_idle;
+        std::chrono::milliseconds idle_duration;
+        // file of the idle readings reused between runs, empty if not reused
+        std::string idle_baseline;
+        std::chrono::seconds idle_expiry;
+        // reuse expired idle readings and measure them again once the target exits
+        bool idle_refresh;
+        // calibrate the overhead of the reads of every sampler for this long, 0 if not calibrated
+        std::chrono::milliseconds calibration_duration;
         nrgprf::location_mask locations;
         nrgprf::socket_mask sockets;
         nrgprf::device_mask devices;
+        // cores whose energy is read, none by default
+        nrgprf::core_mask cores;
+        // read the CPU and GPU of multi-target sections at the same time
+        bool parallel_reads;
+        // segment of a sensor daemon the readings are read from, empty if they are read directly
+        std::string sensor_segment;
+        std::string debug_dir;
     };
 
     std::ostream& operator<<(std::ostream& os, const flags& f);
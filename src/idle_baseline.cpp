@@ -0,0 +1,234 @@
+// idle_baseline.cpp
+
+#include "idle_baseline.hpp"
+#include "compressed_execution.hpp"
+#include "flags.hpp"
+#include "log.hpp"
+#include "reader_container.hpp"
+#include "output/binary_writer.hpp"
+#include "output/journal_format.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+using namespace tep;
+
+namespace
+{
+    constexpr std::array<char, 8> magic = { 'T', 'E', 'P', 'I', 'D', 'L', 'E', '2' };
+
+    // reads the fields of the payload, returns false once it is truncated
+    class payload_cursor
+    {
+    private:
+        const std::string& _data;
+        size_t _pos;
+
+    public:
+        explicit payload_cursor(const std::string& data) :
+            _data(data),
+            _pos(0)
+        {}
+
+        template<typename T>
+        bool read(T& into)
+        {
+            return read_bytes(&into, sizeof(into));
+        }
+
+        bool read(std::string& into)
+        {
+            uint32_t size;
+            if (!read(size) || _data.size() - _pos < size)
+                return false;
+            into.assign(_data, _pos, size);
+            _pos += size;
+            return true;
+        }
+
+        bool read(std::optional<timed_execution>& into)
+        {
+            uint8_t present;
+            if (!read(present))
+                return false;
+            if (!present)
+                return true;
+            uint64_t count;
+            std::string samples;
+            // every encoded sample takes at least a byte
+            if (!read(count) || !read(samples) || samples.size() < count)
+                return false;
+            into.emplace(compressed_execution(count,
+                std::vector<uint8_t>(samples.begin(), samples.end())).decompress());
+            return true;
+        }
+
+        bool at_end() const noexcept
+        {
+            return _pos == _data.size();
+        }
+
+    private:
+        bool read_bytes(void* into, size_t size)
+        {
+            if (_data.size() - _pos < size)
+                return false;
+            std::memcpy(into, _data.data() + _pos, size);
+            _pos += size;
+            return true;
+        }
+    };
+
+    void write_entry(binary_writer& bw, const std::optional<timed_execution>& exec)
+    {
+        bw.write(static_cast<uint8_t>(bool(exec)));
+        if (!exec)
+            return;
+        compressed_execution compressed(*exec);
+        bw.write(static_cast<uint64_t>(compressed.size()));
+        bw.write(std::string_view(reinterpret_cast<const char*>(compressed.data().data()),
+            compressed.bytes()));
+    }
+
+    uint32_t payload_checksum(const std::string& payload)
+    {
+        return journal::checksum(reinterpret_cast<const uint8_t*>(payload.data()),
+            payload.size());
+    }
+}
+
+bool idle_baseline::expired(std::chrono::seconds expiry) const
+{
+    return std::chrono::system_clock::now() - created >= expiry;
+}
+
+std::string tep::idle_baseline_key(const flags& f, const reader_container& readers,
+    bool cpu, bool gpu)
+{
+    std::ostringstream key;
+    utsname uts;
+    if (!uname(&uts))
+        key << uts.nodename << ";" << uts.machine << ";";
+#if defined NRG_X86_64
+    key << "x86_64;";
+#elif defined NRG_PPC64
+    key << "ppc64;";
+#endif
+    key << "sample:" << sizeof(timed_sample) << ";";
+    key << "duration:" << f.idle_duration.count() << ";";
+    if (cpu)
+        key << "cpu:" << readers.reader_rapl().num_events()
+            << ":" << f.locations << ":" << f.sockets << ":" << f.cores << ";";
+    if (gpu)
+        key << "gpu:" << readers.reader_gpu().num_events() << ":" << f.devices << ";";
+    return key.str();
+}
+
+std::optional<idle_baseline> tep::load_idle_baseline(const std::string& path,
+    const std::string& key)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+
+    std::array<char, magic.size()> file_magic;
+    uint32_t checksum;
+    uint64_t size;
+    if (!file.read(file_magic.data(), file_magic.size()) || file_magic != magic ||
+        !file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)) ||
+        !file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        TEP_LOG(log::warning, "idle baseline '%s' is not valid, ignoring it", path.c_str());
+        return std::nullopt;
+    }
+    std::string payload(std::istreambuf_iterator<char>(file), {});
+    if (payload.size() != size || payload_checksum(payload) != checksum)
+    {
+        TEP_LOG(log::warning, "idle baseline '%s' is corrupted, ignoring it", path.c_str());
+        return std::nullopt;
+    }
+
+    payload_cursor cursor(payload);
+    std::string file_key;
+    int64_t created;
+    idle_baseline retval;
+    if (!cursor.read(file_key) || !cursor.read(created) ||
+        !cursor.read(retval.readings.cpu) || !cursor.read(retval.readings.gpu) ||
+        !cursor.at_end())
+    {
+        TEP_LOG(log::warning, "idle baseline '%s' is corrupted, ignoring it", path.c_str());
+        return std::nullopt;
+    }
+    if (file_key != key)
+    {
+        TEP_LOG(log::info, "idle baseline '%s' was measured with a different "
+            "host or sensor configuration, ignoring it", path.c_str());
+        return std::nullopt;
+    }
+    retval.created = std::chrono::system_clock::time_point(std::chrono::seconds(created));
+    return retval;
+}
+
+bool tep::save_idle_baseline(const std::string& path, const std::string& key,
+    const idle_baseline& baseline)
+{
+    std::ostringstream payload;
+    {
+        binary_writer bw(payload);
+        bw.write(std::string_view(key));
+        bw.write(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+            baseline.created.time_since_epoch()).count()));
+        write_entry(bw, baseline.readings.cpu);
+        write_entry(bw, baseline.readings.gpu);
+    }
+    std::string data = payload.str();
+
+    // written to a temporary file first, so that concurrent runs never read a partial file;
+    // unique to every run, which would otherwise write to the same one
+    std::string tmp_path = path + ".XXXXXX";
+    int fd = ::mkstemp(tmp_path.data());
+    if (fd == -1)
+    {
+        TEP_LOG(log::error, "error creating temporary file of idle baseline '%s': %s",
+            path.c_str(), strerror(errno));
+        return false;
+    }
+    // readable by other users, as the baseline files written directly
+    ::fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    ::close(fd);
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        binary_writer bw(file);
+        for (char c : magic)
+            bw.write(c);
+        bw.write(payload_checksum(data)).write(static_cast<uint64_t>(data.size()));
+        bw.raw(data);
+        file.flush();
+        if (!file)
+        {
+            TEP_LOG(log::error, "error writing idle baseline '%s': %s",
+                tmp_path.c_str(), strerror(errno));
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()))
+    {
+        TEP_LOG(log::error, "error replacing idle baseline '%s': %s",
+            path.c_str(), strerror(errno));
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    TEP_LOG(log::success, "saved idle baseline '%s'", path.c_str());
+    return true;
+}
@@ -0,0 +1,54 @@
+// idle_baseline.hpp
+
+#pragma once
+
+#include "timed_sample.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace tep
+{
+    struct flags;
+    class reader_container;
+
+    // the idle readings of every target
+    struct idle_readings
+    {
+        std::optional<timed_execution> cpu;
+        std::optional<timed_execution> gpu;
+    };
+
+    // idle readings measured by an earlier run, which later runs on the same host
+    // with the same sensor configuration reuse instead of measuring them again;
+    // the file is only valid for the key with which it was saved
+    //
+    // file    := magic:char[8] checksum:u32 size:u64 payload:byte[size]
+    // payload := key:str created:i64 cpu:entry gpu:entry
+    // entry   := present:u8 (count:u64 samples:str)?
+    //
+    // samples are encoded as in compressed_execution, which depends on their layout,
+    // which the key includes
+    struct idle_baseline
+    {
+        static constexpr std::chrono::hours default_expiry{ 24 };
+
+        // when the readings were measured, stored in seconds
+        std::chrono::system_clock::time_point created;
+        idle_readings readings;
+
+        bool expired(std::chrono::seconds expiry) const;
+    };
+
+    // identifies the host, the sensors which are read and the duration of the readings
+    std::string idle_baseline_key(const flags&, const reader_container&, bool cpu, bool gpu);
+
+    // returns nullopt if the file does not exist, is corrupted or has a different key
+    std::optional<idle_baseline> load_idle_baseline(const std::string& path,
+        const std::string& key);
+
+    // replaces the file atomically, returns false and logs the error on failure
+    bool save_idle_baseline(const std::string& path, const std::string& key,
+        const idle_baseline& baseline);
+}
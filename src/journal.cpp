@@ -0,0 +1,236 @@
+// journal.cpp
+
+#include "journal.hpp"
+#include "log.hpp"
+#include "output.hpp"
+#include "output/binary_writer.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace tep;
+
+namespace
+{
+    bool write_all(int fd, const uint8_t* data, size_t size)
+    {
+        while (size)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+}
+
+results_journal::results_journal(const std::string& path,
+    bool keep_executions,
+    std::chrono::milliseconds sync_interval) :
+    _mx(),
+    _path(path),
+    _fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+    _sync_interval(sync_interval),
+    _last_sync(std::chrono::steady_clock::now()),
+    _record(),
+    _keep_executions(keep_executions),
+    _failed(false)
+{
+    if (_fd == -1)
+        throw std::system_error(errno, std::generic_category(),
+            "error opening journal '" + path + "'");
+
+    std::ostringstream header;
+    {
+        binary_writer bw(header);
+        write_binary_header(bw);
+    }
+    std::scoped_lock lock(_mx);
+    if (!write_all(_fd, reinterpret_cast<const uint8_t*>(journal::magic.data()),
+        journal::magic.size()))
+    {
+        int errnum = errno;
+        ::close(_fd);
+        throw std::system_error(errnum, std::generic_category(),
+            "error writing journal '" + path + "'");
+    }
+    write_record(journal::record_kind::header, header.str());
+    sync_locked();
+}
+
+results_journal::~results_journal()
+{
+    std::scoped_lock lock(_mx);
+    sync_locked();
+    ::close(_fd);
+}
+
+const std::string& results_journal::path() const noexcept
+{
+    return _path;
+}
+
+std::chrono::milliseconds results_journal::sync_interval() const noexcept
+{
+    return _sync_interval;
+}
+
+bool results_journal::keeps_executions() const noexcept
+{
+    return _keep_executions;
+}
+
+bool results_journal::failed()
+{
+    std::scoped_lock lock(_mx);
+    return _failed;
+}
+
+void results_journal::add_section(uint32_t group, uint32_t section,
+    const group_output& go, const section_output& so)
+{
+    std::ostringstream payload;
+    {
+        binary_writer bw(payload);
+        bw.write(group).write(section);
+        bw.write(go.label()).write(go.extra());
+        bw.write(so.label()).write(so.extra()).write(overhead_json(so));
+    }
+    std::scoped_lock lock(_mx);
+    write_record(journal::record_kind::section, payload.str());
+}
+
+bool results_journal::append(uint32_t group, uint32_t section, const readings_output& rout,
+    const read_overhead* overhead, const trap_context& start, const trap_context& end,
+    const timed_execution& exec)
+{
+    // the execution is formatted outside of the lock
+    std::ostringstream payload;
+    {
+        binary_writer bw(payload);
+        bw.write(group).write(section);
+        write_binary_execution(bw, rout, exec, start, end, overhead);
+    }
+    std::scoped_lock lock(_mx);
+    write_record(journal::record_kind::exec, payload.str());
+    if (std::chrono::steady_clock::now() - _last_sync >= _sync_interval)
+        sync_locked();
+    return !_keep_executions && !_failed;
+}
+
+void results_journal::append_idle(uint32_t index, const idle_output& io)
+{
+    std::ostringstream payload;
+    {
+        binary_writer bw(payload);
+        bw.write(index);
+        if (!io.exec().empty())
+            write_binary_idle(bw, io.readings_out(), io.exec());
+    }
+    std::scoped_lock lock(_mx);
+    write_record(journal::record_kind::idle, payload.str());
+}
+
+void results_journal::append_stats(uint32_t group, uint32_t section,
+    const section_stats& stats)
+{
+    std::ostringstream payload;
+    {
+        binary_writer bw(payload);
+        bw.write(group).write(section).write(std::string_view(stats_json(stats)));
+    }
+    std::scoped_lock lock(_mx);
+    write_record(journal::record_kind::stats, payload.str());
+    if (std::chrono::steady_clock::now() - _last_sync >= _sync_interval)
+        sync_locked();
+}
+
+void results_journal::sync()
+{
+    std::scoped_lock lock(_mx);
+    sync_locked();
+}
+
+void results_journal::write_record(journal::record_kind kind, const std::string& payload)
+{
+    if (_failed)
+        return;
+    assert(payload.size() < UINT32_MAX);
+    uint32_t size = static_cast<uint32_t>(payload.size() + 1);
+    uint8_t kind_byte = static_cast<uint8_t>(kind);
+    uint32_t checksum = journal::checksum(
+        reinterpret_cast<const uint8_t*>(payload.data()), payload.size(),
+        journal::checksum(&kind_byte, 1));
+
+    // a single write for the whole record, so that it is only ever truncated
+    // when the profiler is killed mid-write
+    _record.clear();
+    _record.insert(_record.end(), reinterpret_cast<const uint8_t*>(&size),
+        reinterpret_cast<const uint8_t*>(&size) + sizeof(size));
+    _record.insert(_record.end(), reinterpret_cast<const uint8_t*>(&checksum),
+        reinterpret_cast<const uint8_t*>(&checksum) + sizeof(checksum));
+    _record.push_back(kind_byte);
+    _record.insert(_record.end(), payload.begin(), payload.end());
+    if (!write_all(_fd, _record.data(), _record.size()))
+    {
+        TEP_LOG(log::error, "error writing journal '%s': %s, discarding following records",
+            _path.c_str(), strerror(errno));
+        _failed = true;
+    }
+}
+
+void results_journal::sync_locked()
+{
+    if (!_failed && ::fdatasync(_fd) == -1)
+        TEP_LOG(log::warning, "error syncing journal '%s': %s",
+            _path.c_str(), strerror(errno));
+    _last_sync = std::chrono::steady_clock::now();
+}
+
+section_journal::section_journal(std::shared_ptr<results_journal> journal,
+    std::shared_ptr<const readings_output> rout,
+    std::shared_ptr<const read_overhead> overhead,
+    uint32_t group,
+    uint32_t section) :
+    _journal(std::move(journal)),
+    _rout(std::move(rout)),
+    _overhead(std::move(overhead)),
+    _group(group),
+    _section(section),
+    _last_snapshot(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count())
+{
+    assert(_journal && _rout);
+}
+
+bool section_journal::append(const trap_context& start, const trap_context& end,
+    const timed_execution& exec) const
+{
+    return _journal->append(_group, _section, *_rout, _overhead.get(), start, end, exec);
+}
+
+void section_journal::snapshot(const section_stats& stats) const
+{
+    using namespace std::chrono;
+    int64_t now = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    int64_t last = _last_snapshot.load(std::memory_order_relaxed);
+    // only one of the threads which finish an execution at once takes the snapshot
+    if (now - last < duration_cast<nanoseconds>(_journal->sync_interval()).count() ||
+        !_last_snapshot.compare_exchange_strong(last, now, std::memory_order_relaxed))
+    {
+        return;
+    }
+    _journal->append_stats(_group, _section, stats);
+}
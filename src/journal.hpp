@@ -0,0 +1,107 @@
+// journal.hpp
+
+#pragma once
+
+#include "output/journal_format.hpp"
+#include "timed_sample.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tep
+{
+    class group_output;
+    class idle_output;
+    class readings_output;
+    class section_output;
+    struct read_overhead;
+    class section_stats;
+    struct trap_context;
+
+    // appends every execution to a file as soon as it finishes, and snapshots of the
+    // statistics of the sections which fold them, so that the results gathered so far
+    // can be recovered with recover-results if the profiler does not reach the end of the run;
+    // unless the executions are kept, they are only in the journal, up to the first record
+    // which cannot be written, and the results are written from the journal and the rest
+    // of the results at the end; see output/journal_format.hpp for the layout
+    class results_journal
+    {
+    public:
+        static constexpr std::chrono::milliseconds default_sync_interval{ 1000 };
+
+    private:
+        std::mutex _mx;
+        std::string _path;
+        int _fd;
+        std::chrono::milliseconds _sync_interval;
+        std::chrono::steady_clock::time_point _last_sync;
+        std::vector<uint8_t> _record;
+        bool _keep_executions;
+        bool _failed;
+
+    public:
+        // throws std::system_error if the file cannot be created
+        explicit results_journal(const std::string& path,
+            bool keep_executions = true,
+            std::chrono::milliseconds sync_interval = default_sync_interval);
+        ~results_journal();
+
+        results_journal(const results_journal&) = delete;
+        results_journal& operator=(const results_journal&) = delete;
+
+        const std::string& path() const noexcept;
+        std::chrono::milliseconds sync_interval() const noexcept;
+        bool keeps_executions() const noexcept;
+        // thread-safe; whether a record could not be written
+        bool failed();
+
+        // thread-safe; errors are logged and the following records are discarded,
+        // since the results kept in memory are still written at the end of the run
+        void add_section(uint32_t group, uint32_t section,
+            const group_output& go, const section_output& so);
+        // returns true if the execution was journaled and does not need to be kept
+        bool append(uint32_t group, uint32_t section, const readings_output& rout,
+            const read_overhead* overhead, const trap_context& start, const trap_context& end,
+            const timed_execution& exec);
+        void append_idle(uint32_t index, const idle_output& io);
+        void append_stats(uint32_t group, uint32_t section, const section_stats& stats);
+
+        // writes the records to disk
+        void sync();
+
+    private:
+        void write_record(journal::record_kind kind, const std::string& payload);
+        void sync_locked();
+    };
+
+    // the journal of the executions or statistics of a section, held by its start trap
+    class section_journal
+    {
+    private:
+        std::shared_ptr<results_journal> _journal;
+        std::shared_ptr<const readings_output> _rout;
+        std::shared_ptr<const read_overhead> _overhead;
+        uint32_t _group;
+        uint32_t _section;
+        // time of the last snapshot of the statistics, in ns since the clock's epoch
+        mutable std::atomic<int64_t> _last_snapshot;
+
+    public:
+        section_journal(std::shared_ptr<results_journal> journal,
+            std::shared_ptr<const readings_output> rout,
+            std::shared_ptr<const read_overhead> overhead,
+            uint32_t group,
+            uint32_t section);
+
+        // returns true if the execution was journaled and does not need to be kept
+        bool append(const trap_context& start, const trap_context& end,
+            const timed_execution& exec) const;
+        // journals the statistics at most once per sync interval of the journal
+        void snapshot(const section_stats& stats) const;
+    };
+}
@@ -1,13 +1,21 @@
 #include "log.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstring>
 #include <cstdarg>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <array>
+#include <memory>
 #include <sstream>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
 
 using namespace tep;
 
@@ -20,7 +28,8 @@ using namespace tep;
 
 namespace
 {
-    using write_func_ptr = void(*)(const log::content&, log::loc);
+    using write_func_ptr = void(*)(const log::content&, log::loc,
+        std::chrono::system_clock::time_point);
     using stream_getter_ptr = std::ostream& (*)();
 
     constexpr const char error_message[] = "<log error>";
@@ -67,10 +76,9 @@ namespace
         char buff[128];
 
     public:
-        timestamp()
+        explicit timestamp(std::chrono::system_clock::time_point stp)
         {
             using namespace std::chrono;
-            system_clock::time_point stp(system_clock::now());
             microseconds us = duration_cast<microseconds>(stp.time_since_epoch());
             seconds sec = duration_cast<seconds>(us);
             std::tm tm;
@@ -106,6 +114,9 @@ namespace
 
     std::ostream& operator<<(std::ostream& os, tep::log::loc at)
     {
+        // messages of log::logline have no location
+        if (!at)
+            return os << "-";
         std::ios::fmtflags flags(os.flags());
         os << at.file << ":" << std::left << std::setw(3) << at.line;
         os.flags(flags);
@@ -135,10 +146,10 @@ namespace
     }
 
     template<typename Term>
-    void write_single(
-        log::level lvl, const log::content& cnt, log::loc at, Term term, std::ostream& os)
+    void write_single(log::level lvl, const log::content& cnt, log::loc at,
+        std::chrono::system_clock::time_point time, Term term, std::ostream& os)
     {
-        auto ts = timestamp{};
+        auto ts = timestamp{ time };
         if (ts && cnt)
             os << ts << ": " << at << " " << lvl << ": " << cnt << term;
         else
@@ -146,22 +157,23 @@ namespace
     }
 
     template<typename Term, typename... Args>
-    void write_multiple(
-        log::level lvl, const log::content& cnt, log::loc at, Term term, Args&... streams)
+    void write_multiple(log::level lvl, const log::content& cnt, log::loc at,
+        std::chrono::system_clock::time_point time, Term term, Args&... streams)
     {
         std::ostringstream oss;
-        write_single(lvl, cnt, at, term, oss);
+        write_single(lvl, cnt, at, time, term, oss);
         std::string str = oss.str();
         ((streams << str), ...);
     }
 
     template<log::level lvl, typename Term, auto& os, auto&... other>
-    void write_impl(const log::content& cnt, log::loc at)
+    void write_impl(const log::content& cnt, log::loc at,
+        std::chrono::system_clock::time_point time)
     {
         if constexpr (!sizeof...(other))
-            write_single(lvl, cnt, at, Term{}, os);
+            write_single(lvl, cnt, at, time, Term{}, os);
         else
-            write_multiple(lvl, cnt, at, Term{}, os, other...);
+            write_multiple(lvl, cnt, at, time, Term{}, os, other...);
     }
 
     template<auto& os>
@@ -170,7 +182,7 @@ namespace
         return os;
     }
 
-    void do_nothing(const log::content&, log::loc) {}
+    void do_nothing(const log::content&, log::loc, std::chrono::system_clock::time_point) {}
 
     std::array<std::pair<write_func_ptr, stream_getter_ptr>, 5> funcs =
     {
@@ -181,10 +193,14 @@ namespace
         std::pair{ do_nothing, getter_impl<_stream> }
     };
 
+    // set once by log::init, before the other threads are created
+    std::array<bool, 5> enabled_levels = {};
+
     template<auto& os, typename Term, log::level... lvl>
     void set_funcs()
     {
         ((funcs[lvl] = { write_impl<lvl, Term, os>, getter_impl<os> }), ...);
+        ((enabled_levels[lvl] = true), ...);
     }
 
     std::string error_opening_file(const std::string& file)
@@ -201,6 +217,176 @@ namespace
 
 namespace tep
 {
+    // the rings of the threads which log and the thread which writes their messages
+    struct log::queue
+    {
+        // the single producer is the thread which owns it,
+        // the single consumer whichever thread holds the log mutex
+        struct ring
+        {
+            static constexpr size_t capacity = 256;
+
+            std::array<entry, capacity> entries;
+            std::atomic<size_t> head{ 0 };
+            std::atomic<size_t> tail{ 0 };
+            // set when the thread exits, after its last message
+            std::atomic_bool closed{ false };
+        };
+
+        struct owner
+        {
+            std::shared_ptr<ring> r;
+
+            owner();
+            ~owner();
+        };
+
+        struct message
+        {
+            std::chrono::system_clock::time_point time;
+            level lvl;
+            loc at;
+            content cnt;
+        };
+
+        static constexpr std::chrono::milliseconds interval{ 10 };
+
+        std::mutex rings_mx;
+        std::vector<std::shared_ptr<ring>> rings;
+        // messages are written by the threads which log them,
+        // before init and in forked children, where the writer does not exist
+        std::atomic_bool sync{ true };
+        std::mutex stop_mx;
+        std::condition_variable stop_cv;
+        bool stop = false;
+        // set by a thread whose ring is half full, so that it does not wait for the interval
+        bool wake = false;
+        std::thread writer;
+
+        static queue instance;
+        // the ring of the calling thread
+        static thread_local owner current;
+        // holds the message while it is written synchronously
+        static thread_local entry scratch;
+
+        ~queue();
+
+        void start();
+        void run();
+        void wake_writer();
+        // requires the log mutex
+        void drain();
+    };
+
+    log::queue log::queue::instance;
+    thread_local log::queue::owner log::queue::current;
+    thread_local log::entry log::queue::scratch;
+
+    log::queue::owner::owner() :
+        r(std::make_shared<ring>())
+    {
+        std::scoped_lock lock(instance.rings_mx);
+        instance.rings.push_back(r);
+    }
+
+    log::queue::owner::~owner()
+    {
+        r->closed.store(true, std::memory_order_release);
+    }
+
+    log::queue::~queue()
+    {
+        if (!writer.joinable())
+            return;
+        {
+            std::scoped_lock lock(stop_mx);
+            stop = true;
+        }
+        stop_cv.notify_one();
+        writer.join();
+        sync.store(true, std::memory_order_release);
+        std::scoped_lock lock(_logmtx);
+        drain();
+    }
+
+    void log::queue::start()
+    {
+        // the child only has the thread which forked, so it writes its own messages
+        pthread_atfork(
+            []() { _logmtx.lock(); },
+            []() { _logmtx.unlock(); },
+            []()
+            {
+                queue::instance.sync.store(true, std::memory_order_release);
+                _logmtx.unlock();
+            });
+        sync.store(false, std::memory_order_release);
+        writer = std::thread(&queue::run, this);
+    }
+
+    void log::queue::run()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock lock(stop_mx);
+                stop_cv.wait_for(lock, interval, [this]() { return stop || wake; });
+                if (stop)
+                    return;
+                wake = false;
+            }
+            std::scoped_lock lock(_logmtx);
+            drain();
+        }
+    }
+
+    void log::queue::wake_writer()
+    {
+        {
+            std::scoped_lock lock(stop_mx);
+            wake = true;
+        }
+        stop_cv.notify_one();
+    }
+
+    void log::queue::drain()
+    {
+        std::vector<std::shared_ptr<ring>> snapshot;
+        {
+            std::scoped_lock lock(rings_mx);
+            snapshot = rings;
+        }
+        std::vector<message> messages;
+        for (const auto& r : snapshot)
+        {
+            size_t tail = r->tail.load(std::memory_order_relaxed);
+            size_t head = r->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++)
+            {
+                entry& e = r->entries[tail % ring::capacity];
+                messages.push_back({ e.time, e.lvl, e.at, e.format(e) });
+            }
+            r->tail.store(tail, std::memory_order_release);
+        }
+        // the messages of different threads are merged in the order in which they were logged
+        std::stable_sort(messages.begin(), messages.end(),
+            [](const message& lhs, const message& rhs)
+            {
+                return lhs.time < rhs.time;
+            });
+        for (const auto& m : messages)
+            (*funcs[m.lvl].first)(m.cnt, m.at, m.time);
+
+        std::scoped_lock lock(rings_mx);
+        rings.erase(std::remove_if(rings.begin(), rings.end(),
+            [](const std::shared_ptr<ring>& r)
+            {
+                return r->closed.load(std::memory_order_acquire) &&
+                    r->head.load(std::memory_order_relaxed) ==
+                    r->tail.load(std::memory_order_relaxed);
+            }), rings.end());
+    }
+
     log::loc::operator bool() const
     {
         return file && line;
@@ -258,6 +444,7 @@ namespace tep
                         set_funcs<_stream, term_newline, debug, info, success, warning>();
                         set_funcs<_stream, term_endl, error>();
                     }
+                    queue::instance.start();
                 }, quiet, path);
         }
         catch (...)
@@ -273,6 +460,11 @@ namespace tep
 
     std::ostream& log::stream(level lvl)
     {
+        if (!queue::instance.sync.load(std::memory_order_acquire))
+        {
+            std::scoped_lock lock(_logmtx);
+            queue::instance.drain();
+        }
         return (*funcs[lvl].second)();
     }
 
@@ -281,9 +473,47 @@ namespace tep
         return stream(lvl).flush();
     }
 
-    void log::write(level lvl, const content& cnt, loc at)
+    bool log::enabled(level lvl) noexcept
     {
-        std::scoped_lock lock(_logmtx);
-        (*funcs[lvl].first)(cnt, at);
+        return enabled_levels[lvl];
+    }
+
+    log::entry& log::acquire()
+    {
+        if (queue::instance.sync.load(std::memory_order_acquire))
+            return queue::scratch;
+        queue::ring& r = *queue::current.r;
+        size_t head = r.head.load(std::memory_order_relaxed);
+        while (head - r.tail.load(std::memory_order_acquire) == queue::ring::capacity)
+        {
+            if (queue::instance.sync.load(std::memory_order_acquire))
+                return queue::scratch;
+            std::this_thread::yield();
+        }
+        return r.entries[head % queue::ring::capacity];
+    }
+
+    void log::commit(entry& e)
+    {
+        if (&e == &queue::scratch)
+        {
+            std::scoped_lock lock(_logmtx);
+            content cnt = e.format(e);
+            (*funcs[e.lvl].first)(cnt, e.at, e.time);
+            return;
+        }
+        queue::ring& r = *queue::current.r;
+        size_t head = r.head.load(std::memory_order_relaxed) + 1;
+        r.head.store(head, std::memory_order_release);
+        // a burst of messages, e.g., of breakpoints hit in a loop, would otherwise fill the ring
+        // and wait for the interval of the writer
+        if (head - r.tail.load(std::memory_order_acquire) == queue::ring::capacity / 2)
+            queue::instance.wake_writer();
+        // errors are written, after the messages logged before them, before returning
+        if (e.lvl == error)
+        {
+            std::scoped_lock lock(_logmtx);
+            queue::instance.drain();
+        }
     }
 }
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <iosfwd>
+#include <new>
 #include <string>
 #include <mutex>
+#include <tuple>
+#include <type_traits>
 
 namespace tep
 {
@@ -44,17 +49,121 @@ namespace tep
             void init(const char*, ...);
         };
 
+        // messages are queued in a ring of the calling thread and formatted and
+        // written by a background thread, except for errors, which are written
+        // before the call returns, and the messages of a forked child
         static void init(bool quiet = false, const std::string& path = "");
 
         static std::mutex& mutex();
 
+        // the queued messages are written first
         static std::ostream& stream(level lvl = info);
 
         static std::ostream& flush(level lvl = info);
 
-        static void write(level lvl, const content& cnt, loc at);
+        static bool enabled(level lvl) noexcept;
 
-    #define logline(lvl, ...) \
-        write((lvl), { __VA_ARGS__ }, { __FILE__, __LINE__ })
+        template<typename... Args>
+        static void write(level lvl, loc at, const char* fmt, const Args&... args)
+        {
+            if (enabled(lvl))
+                push(lvl, at, fmt, args...);
+        }
+
+        // evaluates the arguments with func only if the level is enabled
+        template<typename Func>
+        static void write_if(level lvl, loc at, Func&& func)
+        {
+            if (enabled(lvl))
+                func([lvl, at](const char* fmt, const auto&... args)
+                    {
+                        push(lvl, at, fmt, args...);
+                    });
+        }
+
+        // a message without its location, whose arguments are evaluated even if the level
+        // is disabled; TEP_LOG adds the location and only evaluates them if it is enabled
+        template<typename... Args>
+        static void logline(level lvl, const char* fmt, const Args&... args)
+        {
+            write(lvl, { nullptr, 0 }, fmt, args...);
+        }
+
+    private:
+        // strings are copied, since they may not outlive the call
+        struct string_arg
+        {
+            std::string value;
+            string_arg(const char* s) : value(s ? s : "(null)") {}
+        };
+
+        template<typename T>
+        using stored_t = std::conditional_t<
+            std::is_same_v<std::decay_t<T>, char*> || std::is_same_v<std::decay_t<T>, const char*>,
+            string_arg,
+            std::decay_t<T>>;
+
+        template<typename T>
+        static const T& printf_arg(const T& x) noexcept
+        {
+            return x;
+        }
+
+        static const char* printf_arg(const string_arg& x) noexcept
+        {
+            return x.value.c_str();
+        }
+
+        // a message whose arguments are formatted when it is written
+        struct entry
+        {
+            static constexpr size_t args_size = 256;
+
+            level lvl;
+            loc at;
+            std::chrono::system_clock::time_point time;
+            const char* fmt;
+            // formats the arguments and destroys them
+            content(*format)(entry&);
+            alignas(std::max_align_t) unsigned char args[args_size];
+        };
+
+        template<typename... Args>
+        static void push(level lvl, loc at, const char* fmt, const Args&... args)
+        {
+            using tuple = std::tuple<stored_t<Args>...>;
+            static_assert(sizeof(tuple) <= entry::args_size, "too many log arguments");
+            static_assert(alignof(tuple) <= alignof(std::max_align_t));
+
+            entry& e = acquire();
+            e.lvl = lvl;
+            e.at = at;
+            e.time = std::chrono::system_clock::now();
+            e.fmt = fmt;
+            new (e.args) tuple(args...);
+            e.format = [](entry& e)
+            {
+                tuple& stored = *std::launder(reinterpret_cast<tuple*>(e.args));
+                content retval = std::apply([&e](const auto&... args)
+                    {
+                        return content(e.fmt, printf_arg(args)...);
+                    }, stored);
+                stored.~tuple();
+                return retval;
+            };
+            commit(e);
+        }
+
+        struct queue;
+
+        // the next entry of the ring of the calling thread, which waits while it is full
+        static entry& acquire();
+        static void commit(entry& e);
     };
 }
+
+// logs the message at the location of the call, e.g., TEP_LOG(log::info, "%d", x),
+// evaluating the arguments only if the level is enabled
+#define TEP_LOG(lvl, ...) \
+    ::tep::log::write_if((lvl), { __FILE__, __LINE__ }, \
+        [&](auto&& log_push) { log_push(__VA_ARGS__); })
@@ -13,6 +13,7 @@
 #include <nonstd/expected.hpp>
 
 #include <cstring>
+#include <fstream>
 #include <iostream>
 
 static void handle_exception()
@@ -53,7 +54,7 @@ int main(int argc, char* argv[])
         if (!args)
             return 1;
         log::init(args->logargs.quiet, args->logargs.path);
-        dbg::object_info oinfo(args->target);
+        dbg::object_info oinfo(args->target, args->profiler_flags.debug_dir);
         cfg::config_t config(args->config);
 
     #ifndef NDEBUG
@@ -65,11 +66,19 @@ int main(int argc, char* argv[])
         if (args->debug_dump)
             args->debug_dump << dbg::debug_dump{ oinfo };
 
+        // created before the target so that an error does not leave it behind
+        std::shared_ptr<results_journal> journal;
+        if (!args->journal.empty())
+            journal = std::make_shared<results_journal>(args->journal, !args->journal_only);
+        std::shared_ptr<telemetry> tm;
+        if (!args->telemetry.empty())
+            tm = std::make_shared<telemetry>(args->telemetry);
+
         int errnum;
         pid_t child_pid = ptrace_wrapper::instance.fork(errnum, &run_target, args->argv);
         if (child_pid > 0)
         {
-            profiler prof(child_pid, args->profiler_flags, oinfo, config);
+            profiler prof(child_pid, args->profiler_flags, oinfo, config, journal, tm);
             if (!args->same_target())
             {
                 if (auto err = prof.await_executable(args->target))
@@ -86,11 +95,33 @@ int main(int argc, char* argv[])
                 return 1;
             }
 
-            (*args).output << *results;
+            if (journal && !journal->keeps_executions())
+            {
+                // the executions are in the journal, which was synced by the profiler,
+                // up to the first one which could not be written, and the rest in the results
+                std::ifstream file(journal->path(), std::ios::binary);
+                if (!file)
+                {
+                    std::cerr << "error opening journal '" << journal->path() << "': "
+                        << strerror(errno) << std::endl;
+                    return 1;
+                }
+                write_binary(args->output, *results, file);
+                if (journal->failed())
+                    std::cerr << "error writing journal '" << journal->path()
+                        << "', the executions which followed were kept in memory" << std::endl;
+            }
+            else if (args->format == output_format::binary)
+                write_binary(args->output, *results);
+            else
+                (*args).output << *results;
+            static_cast<std::ostream&>(args->output).flush();
+            // the output is written on every core, so the system is only idle afterwards
+            prof.refresh_idle_baseline();
             return 0;
         }
         else if (child_pid == -1)
-            log::logline(log::error, "fork(): %s", strerror(errnum));
+            TEP_LOG(log::error, "fork(): %s", strerror(errnum));
         return 1;
     }
     catch (...)
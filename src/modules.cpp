@@ -0,0 +1,85 @@
+// modules.cpp
+
+#include "modules.hpp"
+#include "util.hpp"
+
+#include <nonstd/expected.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <elf.h>
+#include <unistd.h>
+
+using namespace tep;
+
+nonstd::expected<std::vector<mapped_object>, tracer_error>
+tep::get_mapped_objects(pid_t pid)
+{
+    using rettype = nonstd::expected<std::vector<mapped_object>, tracer_error>;
+    char filename[24];
+    snprintf(filename, sizeof(filename), "/proc/%d/maps", pid);
+    std::ifstream maps(filename);
+    if (!maps)
+        return rettype(nonstd::unexpect,
+            get_syserror(errno, tracer_errcode::SYSTEM_ERROR, gettid(), "open"));
+
+    std::vector<mapped_object> retval;
+    for (std::string line; std::getline(maps, line); )
+    {
+        uintptr_t start;
+        uintptr_t offset;
+        int path_pos = -1;
+        // start-end perms offset dev inode path
+        if (sscanf(line.c_str(), "%" SCNxPTR "-%*x %*s %" SCNxPTR " %*s %*s %n",
+            &start, &offset, &path_pos) < 2 || path_pos < 0)
+        {
+            continue;
+        }
+        // anonymous and special mappings, such as [heap] or [vdso], have no file
+        if (offset != 0 || line[path_pos] != '/')
+            continue;
+        std::filesystem::path path = line.substr(path_pos);
+        auto it = std::find_if(retval.begin(), retval.end(),
+            [&path](const mapped_object& obj)
+            {
+                return obj.path == path;
+            });
+        if (it == retval.end())
+            retval.push_back({ std::move(path), start });
+    }
+    return retval;
+}
+
+nonstd::expected<uintptr_t, tracer_error>
+tep::get_interpreter_base(pid_t pid)
+{
+    using rettype = nonstd::expected<uintptr_t, tracer_error>;
+    char filename[24];
+    snprintf(filename, sizeof(filename), "/proc/%d/auxv", pid);
+    std::ifstream auxv(filename, std::ios::binary);
+    if (!auxv)
+        return rettype(nonstd::unexpect,
+            get_syserror(errno, tracer_errcode::SYSTEM_ERROR, gettid(), "open"));
+
+    unsigned long entry[2];
+    while (auxv.read(reinterpret_cast<char*>(entry), sizeof(entry)))
+    {
+        if (entry[0] == AT_NULL)
+            break;
+        if (entry[0] == AT_BASE)
+            return entry[1];
+    }
+    return 0;
+}
+
+bool tep::module_matches(const mapped_object& obj, std::string_view name)
+{
+    if (name.find('/') != std::string_view::npos)
+        return obj.path == std::filesystem::path(name);
+    std::string filename = obj.path.filename();
+    if (filename.compare(0, name.size(), name) != 0)
+        return false;
+    return filename.size() == name.size() || filename[name.size()] == '.';
+}
@@ -0,0 +1,48 @@
+// modules.hpp
+
+#pragma once
+
+#include "error.hpp"
+#include "dbg/object_info.hpp"
+
+#include <util/expectedfwd.hpp>
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tep
+{
+    // a file mapped into the address space of the tracee
+    struct mapped_object
+    {
+        std::filesystem::path path;
+        // address at which the start of the file is mapped,
+        // i.e., the load bias of position-independent objects
+        uintptr_t base;
+    };
+
+    // a shared object which defines the code of some section;
+    // its debug information is only loaded once the tracee maps it
+    struct loaded_module
+    {
+        std::string name;
+        mapped_object object;
+        dbg::object_info info;
+    };
+
+    // Retrieve the files mapped by process <pid>, in ascending order of address
+    nonstd::expected<std::vector<mapped_object>, tracer_error>
+        get_mapped_objects(pid_t pid);
+
+    // Retrieve the address at which the dynamic loader of process <pid>
+    // is mapped or 0 if it is statically linked
+    nonstd::expected<uintptr_t, tracer_error>
+        get_interpreter_base(pid_t pid);
+
+    // Whether an object is the module named <name>, which is either its path,
+    // its file name or its file name without the version suffix,
+    // e.g., libfoo.so matches /usr/lib/libfoo.so.1.2
+    bool module_matches(const mapped_object& obj, std::string_view name);
+}
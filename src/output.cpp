@@ -1,175 +1,666 @@
 // output.cpp
 
 #include "output.hpp"
+#include "overhead.hpp"
+#include "output/binary_writer.hpp"
+#include "output/journal_reader.hpp"
 #include "output/output_writer.hpp"
 
 #include <nrg/reader_gpu.hpp>
 #include <nrg/reader_rapl.hpp>
 #include <nonstd/expected.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <functional>
+#include <future>
 #include <iostream>
-#include <iomanip>
-
-#include <nlohmann/json.hpp>
+#include <limits>
+#include <sstream>
+#include <thread>
 
 using namespace tep;
 
 namespace
 {
-    template<typename T>
-    std::string to_string(const T& obj)
-    {
-        std::ostringstream oss;
-        oss << obj;
-        return oss.str();
-    }
-
-    void units_output(nlohmann::json& j)
-    {
-        j["time"] = "ns";
-        j["energy"] = "J";
-        j["power"] = "W";
-    }
+    constexpr std::string_view time_unit = "ns";
+    constexpr std::string_view energy_unit = "J";
+    constexpr std::string_view power_unit = "W";
 
 #if defined NRG_X86_64
-    void cpu_format(nlohmann::json& j)
-    {
-        j.push_back("energy");
-    }
+    constexpr std::array<std::string_view, 1> cpu_format = { "energy" };
+    constexpr std::array<binary::field, 1> cpu_fields = { binary::field::energy };
+
+    static_assert(std::is_same_v<nrgprf::sensor_value::ratio, nrgprf::units_energy::ratio>);
 #elif defined NRG_PPC64
-    void cpu_format(nlohmann::json& j)
-    {
-        j.push_back("sensor_time");
-        j.push_back("power");
-    }
+    // the energy is 0 where the sensor has not accumulated any
+    constexpr std::array<std::string_view, 3> cpu_format = { "sensor_time", "power", "energy" };
+    constexpr std::array<binary::field, 3> cpu_fields = {
+        binary::field::time, binary::field::power, binary::field::energy
+    };
+
+    static_assert(std::is_same_v<
+        decltype(nrgprf::sensor_value::power)::ratio, nrgprf::units_power::ratio>);
+    static_assert(std::is_same_v<
+        decltype(nrgprf::sensor_value::energy)::ratio, nrgprf::units_energy::ratio>);
 #endif // defined NRG_X86_64
 
-    void gpu_format(nlohmann::json& j)
+    std::vector<std::string_view> gpu_format()
     {
         using namespace nrgprf;
+        std::vector<std::string_view> retval;
         auto support = reader_gpu::support();
         assert(support);
         if (support)
         {
             if (*support & readings_type::energy)
-                j.push_back("energy");
+                retval.push_back("energy");
             else if (*support & readings_type::power)
-                j.push_back("power");
+                retval.push_back("power");
         }
+        return retval;
     }
 
-    void format_output(nlohmann::json& j)
+    // the scale which converts counters of Unit to the output units
+    template<typename Unit>
+    constexpr binary::scale scale_of()
     {
-        cpu_format(j["cpu"] = nlohmann::json::array());
-        gpu_format(j["gpu"] = nlohmann::json::array());
+        return { Unit::ratio::num, Unit::ratio::den };
     }
-}
 
-namespace nlohmann
-{
-    template<>
-    struct adl_serializer<tep::timed_sample>
+    void units_output(output_writer& ow)
+    {
+        ow.begin_object();
+        ow.key("energy").value(energy_unit);
+        ow.key("power").value(power_unit);
+        ow.key("time").value(time_unit);
+        ow.end_object();
+    }
+
+    void format_output(output_writer& ow)
+    {
+        ow.begin_object();
+        ow.key("cpu").begin_array();
+        for (auto f : cpu_format)
+            ow.value(f);
+        ow.end_array();
+        ow.key("gpu").begin_array();
+        for (auto f : gpu_format())
+            ow.value(f);
+        ow.end_array();
+        ow.end_object();
+    }
+
+    void sample_times_output(output_writer& ow, const timed_execution& exec)
+    {
+        ow.begin_array();
+        for (const auto& sample : exec)
+            ow.value(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                sample.timestamp.time_since_epoch()).count());
+        ow.end_array();
+    }
+
+    // the readers whose read times the samples hold, none unless read by a hybrid reader
+    size_t reader_count(const timed_execution& exec)
     {
-        static void to_json(json& j, const tep::timed_sample& sample)
+        size_t count = 0;
+        for (const auto& sample : exec)
+            for (size_t ix = count; ix < sample.sample.reader_times.size(); ix++)
+                if (sample.sample.reader_times[ix])
+                    count = ix + 1;
+        return count;
+    }
+
+    void reader_times_output(output_writer& ow, const timed_execution& exec, size_t readers)
+    {
+        ow.begin_array();
+        for (const auto& sample : exec)
         {
-            j = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                sample.timestamp.time_since_epoch())
-                .count();
+            ow.begin_array();
+            for (size_t ix = 0; ix < readers; ix++)
+                ow.value(sample.sample.reader_times[ix]);
+            ow.end_array();
         }
-    };
+        ow.end_array();
+    }
+
+    // the readings of every location of a socket, in the order of binary::cpu_locations
+    using location_batches = std::array<nrgprf::sensor_batch, binary::cpu_locations.size()>;
+
+    // converts the readings of every location of a socket at once,
+    // returns whether the socket has any readings
+    bool socket_batches(const nrgprf::reader_rapl& reader, const timed_execution& exec,
+        uint32_t skt, location_batches& into)
+    {
+        using namespace nrgprf;
+        const sample* first = exec.empty() ? nullptr : &exec.front().sample;
+        size_t count = exec.size();
+        size_t stride = sizeof(timed_sample);
+        size_t readings = reader.values<loc::cores>(first, count, stride, skt, into[0]);
+        readings += reader.values<loc::mem>(first, count, stride, skt, into[1]);
+        readings += reader.values<loc::gpu>(first, count, stride, skt, into[2]);
+        readings += reader.values<loc::pkg>(first, count, stride, skt, into[3]);
+        readings += reader.values<loc::sys>(first, count, stride, skt, into[4]);
+        readings += reader.values<loc::uncore>(first, count, stride, skt, into[5]);
+        return readings;
+    }
+
+    // the readings of every core which has any, keyed by core
+    using core_batches = std::vector<std::pair<uint32_t, nrgprf::sensor_batch>>;
 
-    template<>
-    struct adl_serializer<std::optional<std::string>>
+    core_batches get_core_batches(const nrgprf::reader_rapl& reader, const timed_execution& exec)
     {
-        static void to_json(json& j, const std::optional<std::string>& x)
+        using namespace nrgprf;
+        core_batches retval;
+        const sample* first = exec.empty() ? nullptr : &exec.front().sample;
+        for (uint32_t core = 0; core < max_cores; core++)
         {
-            if (x)
-                j = *x;
-            else
-                j = nullptr;
+            if (reader.event_idx<loc::core>(core) < 0)
+                continue;
+            sensor_batch batch;
+            if (reader.values<loc::core>(first, exec.size(), sizeof(timed_sample), core, batch))
+                retval.emplace_back(core, std::move(batch));
         }
-    };
+        return retval;
+    }
+
+    bool has_board(const nrgprf::reader_gpu& reader, const timed_execution& exec,
+        uint32_t dev)
+    {
+        for (const auto& sample : exec)
+            if (reader.get_board_energy(sample, dev) || reader.get_board_power(sample, dev))
+                return true;
+        return false;
+    }
 
 #if defined NRG_X86_64
-    template<>
-    struct adl_serializer<nrgprf::sensor_value>
+    void batch_output(output_writer& ow, const nrgprf::sensor_batch& batch)
     {
-        static void to_json(json& j, const nrgprf::sensor_value& sensor_value)
+        using namespace nrgprf;
+        std::vector<double> energy(batch.energy.size());
+        unit_cast<joules<double>, units_energy>(batch.energy.data(), energy.size(), energy.data());
+        ow.begin_array();
+        for (double value : energy)
         {
-            nlohmann::json values;
-            values.push_back(nrgprf::unit_cast<nrgprf::joules<double>>(sensor_value).count());
-            j = std::move(values);
+            ow.begin_array();
+            ow.value(value);
+            ow.end_array();
         }
-    };
+        ow.end_array();
+    }
+
+    void batch_binary(binary_writer& bw, const nrgprf::sensor_batch& batch)
+    {
+        bw.write(static_cast<uint64_t>(batch.energy.size()));
+        bw.write_deltas(batch.energy);
+    }
 #elif defined NRG_PPC64
-    template<>
-    struct adl_serializer<nrgprf::sensor_value>
+    void batch_output(output_writer& ow, const nrgprf::sensor_batch& batch)
     {
-        static void to_json(json& j, const nrgprf::sensor_value& sensor_value)
+        using namespace nrgprf;
+        std::vector<double> power(batch.power.size());
+        unit_cast<watts<double>, units_power>(batch.power.data(), power.size(), power.data());
+        std::vector<double> energy(batch.energy.size());
+        unit_cast<joules<double>, units_energy>(batch.energy.data(), energy.size(), energy.data());
+        ow.begin_array();
+        for (size_t ix = 0; ix < power.size(); ix++)
         {
-            nlohmann::json values;
-            values.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                sensor_value.timestamp.time_since_epoch()).count());
-            values.push_back(nrgprf::unit_cast<nrgprf::watts<double>>(sensor_value.power).count());
-            j = std::move(values);
+            ow.begin_array();
+            ow.value(batch.timestamps[ix]);
+            ow.value(power[ix]);
+            ow.value(energy[ix]);
+            ow.end_array();
         }
-    };
+        ow.end_array();
+    }
+
+    void batch_binary(binary_writer& bw, const nrgprf::sensor_batch& batch)
+    {
+        bw.write(static_cast<uint64_t>(batch.power.size()));
+        bw.write_deltas(batch.timestamps).write_deltas(batch.power).write_deltas(batch.energy);
+    }
 #endif // defined NRG_X86_64
-}
 
-namespace tep
-{
-    static void to_json(nlohmann::json& j, const trap_context& ctx)
+    std::string context_json(const trap_context& ctx)
+    {
+        std::ostringstream oss;
+        {
+            output_writer ow(oss);
+            ow << ctx;
+        }
+        return oss.str();
+    }
+
+    // returns the offset of the execution
+    uint64_t execution_binary(binary_writer& bw, const readings_output& rout,
+        const timed_execution& exec, std::string_view start, std::string_view end,
+        const std::optional<std::string>& overhead)
+    {
+        uint64_t offset = bw.offset();
+        bw.write(start).write(end).write(overhead);
+        std::vector<int64_t> sample_times;
+        sample_times.reserve(exec.size());
+        for (const auto& sample : exec)
+            sample_times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                sample.timestamp.time_since_epoch()).count());
+        bw.write(static_cast<uint64_t>(sample_times.size())).write_deltas(sample_times);
+        size_t readers = reader_count(exec);
+        bw.write(static_cast<uint8_t>(readers));
+        for (size_t ix = 0; ix < readers; ix++)
+        {
+            std::vector<int64_t> reader_times;
+            reader_times.reserve(exec.size());
+            for (const auto& sample : exec)
+                reader_times.push_back(sample.sample.reader_times[ix]);
+            bw.write_deltas(reader_times);
+        }
+        rout.output(bw, exec);
+        bw.write(binary::readings_kind::end);
+        return offset;
+    }
+
+#if defined NRG_X86_64
+    // the energy of counters is the difference between the last and first readings
+    void batch_energy(const nrgprf::sensor_batch& batch, std::string_view target, uint32_t id,
+        std::string_view location, std::vector<sensor_energy>& into)
     {
-        output_writer ow;
-        ow << ctx;
-        j = std::move(ow.json);
+        using namespace nrgprf;
+        if (batch.energy.size() < 2 || batch.energy.front() == batch.energy.back())
+            return;
+        double first = unit_cast<joules<double>>(units_energy(batch.energy.front())).count();
+        double last = unit_cast<joules<double>>(units_energy(batch.energy.back())).count();
+        into.push_back({ target, id, location, last - first });
+    }
+#elif defined NRG_PPC64
+    // the energy is the difference of the accumulated energy of the first and last readings,
+    // or, if the sensor did not accumulate it, power readings integrated over the time of the sensor
+    void batch_energy(const nrgprf::sensor_batch& batch, std::string_view target, uint32_t id,
+        std::string_view location, std::vector<sensor_energy>& into)
+    {
+        using namespace nrgprf;
+        if (batch.power.empty())
+            return;
+        if (batch.energy.front() && batch.energy.back() >= batch.energy.front())
+        {
+            units_energy accumulated(batch.energy.back() - batch.energy.front());
+            into.push_back({ target, id, location,
+                unit_cast<joules<double>>(accumulated).count() });
+            return;
+        }
+        std::vector<double> power(batch.power.size());
+        unit_cast<watts<double>, units_power>(batch.power.data(), power.size(), power.data());
+        double energy = 0;
+        for (size_t ix = 1; ix < power.size(); ix++)
+        {
+            std::chrono::duration<double> dt = std::chrono::nanoseconds(
+                batch.timestamps[ix] - batch.timestamps[ix - 1]);
+            energy += dt.count() * (power[ix - 1] + power[ix]) / 2;
+        }
+        into.push_back({ target, id, location, energy });
+    }
+#endif // defined NRG_X86_64
+
+    void running_stats_output(output_writer& ow, const running_stats& rs,
+        std::optional<double> duration = std::nullopt, const running_stats* corrected = nullptr)
+    {
+        ow.begin_object();
+        if (corrected)
+        {
+            ow.key("corrected");
+            running_stats_output(ow, *corrected, duration);
+        }
+        ow.key("count").value(rs.count);
+        ow.key("max").value(rs.max);
+        ow.key("mean").value(rs.mean());
+        ow.key("min").value(rs.min);
+        ow.key("p50").value(rs.sketch.quantile(0.5));
+        ow.key("p90").value(rs.sketch.quantile(0.9));
+        ow.key("p99").value(rs.sketch.quantile(0.99));
+        // energy per second
+        if (duration)
+            ow.key("power").value(rs.total / (*duration * 1e-9));
+        ow.key("total").value(rs.total);
+        ow.end_object();
+    }
+
+    // the value of every sensor of every socket, device or core of <target> in <values>,
+    // whose keys are the locations and the <id_key>
+    template<typename Map, typename Func>
+    void target_values_output(output_writer& ow, const Map& values,
+        std::string_view target, std::string_view id_key, Func value_output)
+    {
+        auto it = values.lower_bound({ target, 0, {} });
+        auto end = values.lower_bound({ target, std::numeric_limits<uint32_t>::max(), {} });
+        if (it == end)
+            return;
+        ow.key(target).begin_array();
+        while (it != end)
+        {
+            uint32_t id = std::get<1>(it->first);
+            bool id_written = false;
+            ow.begin_object();
+            for (; it != end && std::get<1>(it->first) == id; ++it)
+            {
+                std::string_view location = std::get<2>(it->first);
+                if (!id_written && location > id_key)
+                {
+                    ow.key(id_key).value(id);
+                    id_written = true;
+                }
+                ow.key(location);
+                value_output(it->second);
+            }
+            if (!id_written)
+                ow.key(id_key).value(id);
+            ow.end_object();
+        }
+        ow.end_array();
+    }
+
+    // the energy statistics of every socket, device or core of <target>
+    void target_stats_output(output_writer& ow, const section_stats& stats,
+        std::string_view target, std::string_view id_key)
+    {
+        target_values_output(ow, stats.energy(), target, id_key,
+            [&ow, corrected = bool(stats.overhead())](const section_stats::energy_stats& es)
+            {
+                running_stats_output(ow, es.energy, es.duration,
+                    corrected ? &es.corrected : nullptr);
+            });
+    }
+
+    void stats_output(output_writer& ow, const section_stats& stats)
+    {
+        ow.begin_object();
+        ow.key("count").value(stats.duration().count);
+        target_stats_output(ow, stats, "cpu", "socket");
+        target_stats_output(ow, stats, "cpu_cores", "core");
+        ow.key("duration");
+        running_stats_output(ow, stats.duration());
+        target_stats_output(ow, stats, "gpu", "device");
+        ow.end_object();
+    }
+
+    // the energy of a read of every sensor, the mode and period of the sampler,
+    // the mean time of a read and the reads during the calibration
+    void overhead_output(output_writer& ow, const read_overhead& ovh)
+    {
+        std::map<section_stats::key_type, double> energy;
+        for (const auto& e : ovh.energy)
+            energy[{ e.target, e.id, e.location }] = e.energy;
+        auto value_output = [&ow](double value)
+        {
+            ow.value(value);
+        };
+        ow.begin_object();
+        target_values_output(ow, energy, "cpu", "socket", value_output);
+        target_values_output(ow, energy, "cpu_cores", "core", value_output);
+        target_values_output(ow, energy, "gpu", "device", value_output);
+        ow.key("mode").value(to_string(ovh.mode));
+        if (ovh.mode != sampling_mode::short_section)
+            ow.key("period").value(ovh.period.count());
+        ow.key("read_time").value(ovh.read_time.count());
+        ow.key("reads").value(ovh.reads);
+        ow.end_object();
+    }
+
+    // the energy of every sensor during an execution, with and without the energy
+    // of the reads of the sampler, and the number of reads it was corrected for
+    void execution_overhead_output(output_writer& ow, const readings_output& rout,
+        const read_overhead& ovh, const timed_execution& exec)
+    {
+        std::vector<sensor_energy> energy;
+        rout.energy(exec, energy);
+        std::vector<sensor_energy> corrected = energy;
+        ovh.correct(exec, corrected);
+        std::map<section_stats::key_type, std::pair<double, double>> values;
+        for (size_t ix = 0; ix < energy.size(); ix++)
+            values[{ energy[ix].target, energy[ix].id, energy[ix].location }] =
+                { corrected[ix].energy, energy[ix].energy };
+        auto value_output = [&ow](const std::pair<double, double>& value)
+        {
+            ow.begin_object();
+            ow.key("corrected").value(value.first);
+            ow.key("energy").value(value.second);
+            ow.end_object();
+        };
+        ow.begin_object();
+        target_values_output(ow, values, "cpu", "socket", value_output);
+        target_values_output(ow, values, "cpu_cores", "core", value_output);
+        target_values_output(ow, values, "gpu", "device", value_output);
+        ow.key("reads").value(ovh.reads_during(exec));
+        ow.end_object();
+    }
+
+    std::optional<std::string> execution_overhead_json(const readings_output& rout,
+        const read_overhead* ovh, const timed_execution& exec)
+    {
+        if (!ovh)
+            return std::nullopt;
+        std::ostringstream oss;
+        {
+            output_writer ow(oss);
+            execution_overhead_output(ow, rout, *ovh, exec);
+        }
+        return oss.str();
     }
 
-    static void to_json(nlohmann::json& j, const idle_output& io)
+    // serializes the executions of every section in chunks on every core, a window
+    // of chunks ahead of the writer, which takes the chunks in the order of the sections;
+    // the chunks are then concatenated in order, so the output does not change
+    template<typename Chunk>
+    class parallel_chunks
+    {
+    public:
+        using function = std::function<Chunk(const section_output&, size_t, size_t)>;
+
+        static constexpr size_t chunk_size = 32;
+
+    private:
+        struct job
+        {
+            const section_output* so;
+            size_t first;
+            size_t last;
+        };
+
+        function _fn;
+        unsigned _threads;
+        std::vector<job> _jobs;
+        size_t _window;
+        // the next window is computed while the writer takes the chunks of the current one
+        std::vector<Chunk> _current;
+        size_t _current_pos;
+        size_t _next_job;
+        std::future<std::vector<Chunk>> _pending;
+
+    public:
+        parallel_chunks(const profiling_results& pr, function fn) :
+            _fn(std::move(fn)),
+            _threads(std::max(1u, std::thread::hardware_concurrency())),
+            _jobs(),
+            _window(4 * static_cast<size_t>(_threads)),
+            _current(),
+            _current_pos(0),
+            _next_job(0),
+            _pending()
+        {
+            for (const auto& go : pr.groups())
+                for (const auto& so : go.sections())
+                    for (size_t first = 0; first < so.executions().size(); first += chunk_size)
+                        _jobs.push_back({ &so, first,
+                            std::min(first + chunk_size, so.executions().size()) });
+            launch();
+        }
+
+        ~parallel_chunks()
+        {
+            if (_pending.valid())
+                _pending.wait();
+        }
+
+        static size_t count(const section_output& so)
+        {
+            return (so.executions().size() + chunk_size - 1) / chunk_size;
+        }
+
+        // the next chunk, which must belong to the section being written
+        Chunk next()
+        {
+            if (_current_pos == _current.size())
+            {
+                assert(_pending.valid());
+                _current = _pending.get();
+                _current_pos = 0;
+                launch();
+            }
+            assert(_current_pos < _current.size());
+            return std::move(_current[_current_pos++]);
+        }
+
+    private:
+        void launch()
+        {
+            size_t first = _next_job;
+            size_t last = std::min(first + _window, _jobs.size());
+            _next_job = last;
+            if (first == last)
+                return;
+            _pending = std::async(std::launch::async, [this, first, last]()
+                {
+                    std::vector<Chunk> chunks(last - first);
+                    std::atomic<size_t> next(first);
+                    auto work = [&]()
+                    {
+                        for (size_t ix; (ix = next.fetch_add(1)) < last;)
+                            chunks[ix - first] = _fn(*_jobs[ix].so, _jobs[ix].first, _jobs[ix].last);
+                    };
+                    std::vector<std::future<void>> workers;
+                    for (unsigned t = 1; t < std::min<size_t>(_threads, last - first); t++)
+                        workers.push_back(std::async(std::launch::async, work));
+                    work();
+                    for (auto& w : workers)
+                        w.get();
+                    return chunks;
+                });
+        }
+    };
+
+    // the keys of every object must be written in lexicographic order
+
+    void idle_output_write(output_writer& ow, const idle_output& io)
     {
-        if (!io.exec().empty())
+        if (io.exec().empty())
         {
-            output_writer ow;
-            ow.json["sample_times"] = io.exec();
-            io.readings_out().output(ow, io.exec());
-            j = std::move(ow.json);
+            ow.null();
+            return;
         }
+        ow.begin_object();
+        io.readings_out().output(ow, io.exec());
+        if (size_t readers = reader_count(io.exec()))
+        {
+            ow.key("reader_times");
+            reader_times_output(ow, io.exec(), readers);
+        }
+        ow.key("sample_times");
+        sample_times_output(ow, io.exec());
+        ow.end_object();
     }
 
-    static void to_json(nlohmann::json& j, const section_output& so)
+    std::string executions_chunk(const section_output& so, size_t first, size_t last)
     {
-        using json = nlohmann::json;
+        std::ostringstream oss;
+        {
+            output_writer ow(oss);
+            ow.begin_elements();
+            for (size_t ix = first; ix < last; ix++)
+            {
+                const position_exec& pe = so.executions()[ix];
+                // only one execution of a chunk is decompressed at a time
+                timed_execution exec = pe.exec.decompress();
+                ow.begin_object();
+                so.readings_out().output(ow, exec);
+                if (so.overhead())
+                {
+                    ow.key("overhead");
+                    execution_overhead_output(ow, so.readings_out(), *so.overhead(), exec);
+                }
+                ow.key("range").begin_object();
+                ow.key("end") << pe.interval.second;
+                ow.key("start") << pe.interval.first;
+                ow.end_object();
+                if (size_t readers = reader_count(exec))
+                {
+                    ow.key("reader_times");
+                    reader_times_output(ow, exec, readers);
+                }
+                ow.key("sample_times");
+                sample_times_output(ow, exec);
+                ow.end_object();
+            }
+            ow.end_elements();
+        }
+        return oss.str();
+    }
+
+    using json_chunks = parallel_chunks<std::string>;
 
-        j["label"] = so.label();
-        j["extra"] = so.extra();
-        json& execs = j["executions"] = nlohmann::json::array();
-        for (const auto& pe : so.executions())
+    void section_output_write(output_writer& ow, json_chunks& chunks, const section_output& so)
+    {
+        ow.begin_object();
+        ow.key("executions").begin_array();
+        for (size_t c = 0; c < json_chunks::count(so); c++)
+            ow.raw(chunks.next());
+        ow.end_array();
+        ow.key("extra").value(so.extra());
+        ow.key("label").value(so.label());
+        if (so.overhead())
+        {
+            ow.key("overhead");
+            overhead_output(ow, *so.overhead());
+        }
+        if (so.stats())
         {
-            output_writer exec;
-            exec.json["range"]["start"] = pe.interval.first;
-            exec.json["range"]["end"] = pe.interval.second;
-            exec.json["sample_times"] = pe.exec;
-            so.readings_out().output(exec, pe.exec);
-            execs.push_back(std::move(exec.json));
+            ow.key("stats");
+            stats_output(ow, *so.stats());
         }
+        ow.end_object();
     }
 
-    static void to_json(nlohmann::json& j, const group_output& go)
+    void group_output_write(output_writer& ow, json_chunks& chunks, const group_output& go)
     {
-        j["label"] = go.label();
-        j["extra"] = go.extra();
-        for (const auto& so : go.sections())
-            j["sections"].emplace_back(so);
+        ow.begin_object();
+        ow.key("extra").value(go.extra());
+        ow.key("label").value(go.label());
+        if (!go.sections().empty())
+        {
+            ow.key("sections").begin_array();
+            for (const auto& so : go.sections())
+                section_output_write(ow, chunks, so);
+            ow.end_array();
+        }
+        ow.end_object();
     }
 
-    static void to_json(nlohmann::json& j, const profiling_results& pr)
+    void results_output(output_writer& ow, const profiling_results& pr)
     {
-        units_output(j["units"]);
-        format_output(j["format"]);
-        j["idle"] = pr.idle();
-        j["groups"] = pr.groups();
+        ow.begin_object();
+        ow.key("format");
+        format_output(ow);
+        ow.key("groups").begin_array();
+        json_chunks chunks(pr, executions_chunk);
+        for (const auto& go : pr.groups())
+            group_output_write(ow, chunks, go);
+        ow.end_array();
+        ow.key("idle").begin_array();
+        for (const auto& io : pr.idle())
+            idle_output_write(ow, io);
+        ow.end_array();
+        ow.key("units");
+        units_output(ow);
+        ow.end_object();
     }
 }
 
@@ -184,6 +675,19 @@ void readings_output_holder::output(output_writer& os, const timed_execution& ex
         out->output(os, exec);
 }
 
+void readings_output_holder::output(binary_writer& os, const timed_execution& exec) const
+{
+    for (const auto& out : _outputs)
+        out->output(os, exec);
+}
+
+void readings_output_holder::energy(const timed_execution& exec,
+    std::vector<sensor_energy>& into) const
+{
+    for (const auto& out : _outputs)
+        out->energy(exec, into);
+}
+
 template
 class tep::readings_output_dev<nrgprf::reader_rapl>;
 
@@ -199,71 +703,266 @@ template<>
 void readings_output_dev<nrgprf::reader_rapl>::output(output_writer& os,
     const timed_execution& exec) const
 {
-    assert(exec.size() > 1);
+    // single samples are written by the telemetry
+    assert(!exec.empty());
     using namespace nrgprf;
-    using json = nlohmann::json;
 
-    os.json["cpu"] = json::array();
+    os.key("cpu").begin_array();
+    location_batches batches;
     for (uint32_t skt = 0; skt < nrgprf::max_sockets; skt++)
     {
-        json readings;
-        readings["socket"] = skt;
-        json& jpkg = readings["package"] = json::array();
-        json& jcores = readings["cores"] = json::array();
-        json& juncore = readings["uncore"] = json::array();
-        json& jdram = readings["dram"] = json::array();
-        json& jgpu = readings["gpu"] = json::array();
-        json& jsys = readings["sys"] = json::array();
-
-        for (const auto& sample : exec)
+        if (!socket_batches(_reader, exec, skt, batches))
+            continue;
+        os.begin_object();
+        for (size_t ix = 0; ix < batches.size(); ix++)
         {
-            if (result<sensor_value> sens_value = _reader.value<loc::pkg>(sample, skt))
-                jpkg.push_back(*sens_value);
-            if (result<sensor_value> sens_value = _reader.value<loc::cores>(sample, skt))
-                jcores.push_back(*sens_value);
-            if (result<sensor_value> sens_value = _reader.value<loc::uncore>(sample, skt))
-                juncore.push_back(*sens_value);
-            if (result<sensor_value> sens_value = _reader.value<loc::mem>(sample, skt))
-                jdram.push_back(*sens_value);
-            if (result<sensor_value> sens_value = _reader.value<loc::sys>(sample, skt))
-                jsys.push_back(*sens_value);
-            if (result<sensor_value> sens_value = _reader.value<loc::gpu>(sample, skt))
-                jgpu.push_back(*sens_value);
+            // the socket is written between the package and sys locations
+            if (binary::cpu_locations[ix] == "sys")
+                os.key("socket").value(skt);
+            os.key(binary::cpu_locations[ix]);
+            batch_output(os, batches[ix]);
         }
-        if (!jpkg.empty() || !jcores.empty() || !juncore.empty()
-            || !jdram.empty() || !jgpu.empty() || !jsys.empty())
+        os.end_object();
+    }
+    os.end_array();
+
+    core_batches cores = get_core_batches(_reader, exec);
+    if (cores.empty())
+        return;
+    os.key("cpu_cores").begin_array();
+    for (const auto& [core, batch] : cores)
+    {
+        os.begin_object();
+        os.key("core").value(core);
+        os.key("readings");
+        batch_output(os, batch);
+        os.end_object();
+    }
+    os.end_array();
+}
+
+template<>
+void readings_output_dev<nrgprf::reader_gpu>::output(output_writer& os,
+    const timed_execution& exec) const
+{
+    // single samples are written by the telemetry
+    assert(!exec.empty());
+    using namespace nrgprf;
+
+    os.key("gpu").begin_array();
+    for (uint32_t dev = 0; dev < nrgprf::max_devices; dev++)
+    {
+        if (!has_board(_reader, exec, dev))
+            continue;
+        os.begin_object();
+        os.key("board").begin_array();
+        for (const auto& sample : exec)
         {
-            os.json["cpu"].push_back(std::move(readings));
+            if (result<units_energy> energy = _reader.get_board_energy(sample, dev))
+            {
+                os.begin_array();
+                os.value(unit_cast<joules<double>>(*energy).count());
+                os.end_array();
+            }
+            else if (result<units_power> power = _reader.get_board_power(sample, dev))
+            {
+                os.begin_array();
+                os.value(unit_cast<watts<double>>(*power).count());
+                os.end_array();
+            }
         }
+        os.end_array();
+        os.key("device").value(dev);
+        os.end_object();
     }
+    os.end_array();
 }
 
 template<>
-void readings_output_dev<nrgprf::reader_gpu>::output(output_writer& os,
+void readings_output_dev<nrgprf::reader_rapl>::output(binary_writer& os,
+    const timed_execution& exec) const
+{
+    assert(exec.size() > 1);
+    using namespace nrgprf;
+
+    // the readings are converted before the number of sockets is known
+    std::vector<std::pair<uint32_t, location_batches>> sockets;
+    for (uint32_t skt = 0; skt < nrgprf::max_sockets; skt++)
+    {
+        location_batches batches;
+        if (socket_batches(_reader, exec, skt, batches))
+            sockets.emplace_back(skt, std::move(batches));
+    }
+
+    os.write(binary::readings_kind::cpu);
+    os.write(static_cast<uint8_t>(cpu_fields.size()));
+    for (auto field : cpu_fields)
+        os.write(field);
+    os.write(static_cast<uint32_t>(sockets.size()));
+    for (const auto& [skt, batches] : sockets)
+    {
+        os.write(skt);
+        for (const auto& batch : batches)
+            batch_binary(os, batch);
+    }
+
+    core_batches cores = get_core_batches(_reader, exec);
+    if (cores.empty())
+        return;
+    os.write(binary::readings_kind::cores);
+    os.write(static_cast<uint8_t>(cpu_fields.size()));
+    for (auto field : cpu_fields)
+        os.write(field);
+    os.write(static_cast<uint32_t>(cores.size()));
+    for (const auto& [core, batch] : cores)
+    {
+        os.write(core);
+        batch_binary(os, batch);
+    }
+}
+
+template<>
+void readings_output_dev<nrgprf::reader_gpu>::output(binary_writer& os,
     const timed_execution& exec) const
 {
     assert(exec.size() > 1);
     using namespace nrgprf;
-    using json = nlohmann::json;
 
-    os.json["gpu"] = json::array();
+    std::vector<uint32_t> devices;
+    for (uint32_t dev = 0; dev < nrgprf::max_devices; dev++)
+        if (has_board(_reader, exec, dev))
+            devices.push_back(dev);
+
+    os.write(binary::readings_kind::gpu);
+    os.write(static_cast<uint32_t>(devices.size()));
+    for (uint32_t dev : devices)
+    {
+        // the readings of a device are either all energy or all power,
+        // depending on what it supports
+        binary::field field = binary::field::power;
+        std::vector<uint64_t> board;
+        for (const auto& sample : exec)
+        {
+            if (result<units_energy> energy = _reader.get_board_energy(sample, dev))
+            {
+                field = binary::field::energy;
+                board.push_back(energy->count());
+            }
+            else if (result<units_power> power = _reader.get_board_power(sample, dev))
+                board.push_back(power->count());
+        }
+        os.write(dev).write(field);
+        os.write(static_cast<uint64_t>(board.size())).write_deltas(board);
+    }
+}
+
+template<>
+void readings_output_dev<nrgprf::reader_rapl>::energy(const timed_execution& exec,
+    std::vector<sensor_energy>& into) const
+{
+    location_batches batches;
+    for (uint32_t skt = 0; skt < nrgprf::max_sockets; skt++)
+        if (socket_batches(_reader, exec, skt, batches))
+            for (size_t ix = 0; ix < batches.size(); ix++)
+                batch_energy(batches[ix], "cpu", skt, binary::cpu_locations[ix], into);
+    // the cores are a target of their own, keyed by core as in the executions
+    for (const auto& [core, batch] : get_core_batches(_reader, exec))
+        batch_energy(batch, "cpu_cores", core, "energy", into);
+}
+
+template<>
+void readings_output_dev<nrgprf::reader_gpu>::energy(const timed_execution& exec,
+    std::vector<sensor_energy>& into) const
+{
+    using namespace nrgprf;
     for (uint32_t dev = 0; dev < nrgprf::max_devices; dev++)
     {
-        json readings;
-        readings["device"] = dev;
-        readings["board"] = json::array();
+        // difference of energy counters or power integrated over the sample times
+        std::optional<double> first_energy;
+        std::optional<double> last_energy;
+        std::optional<std::pair<timed_sample::time_point, double>> prev_power;
+        double power_energy = 0;
         for (const auto& sample : exec)
         {
             if (result<units_energy> energy = _reader.get_board_energy(sample, dev))
-                readings["board"].push_back(
-                    json::array({ unit_cast<joules<double>>(*energy).count() }));
+            {
+                last_energy = unit_cast<joules<double>>(*energy).count();
+                if (!first_energy)
+                    first_energy = last_energy;
+            }
             else if (result<units_power> power = _reader.get_board_power(sample, dev))
-                readings["board"].push_back(
-                    json::array({ unit_cast<watts<double>>(*power).count() }));
+            {
+                double watts_now = unit_cast<watts<double>>(*power).count();
+                if (prev_power)
+                {
+                    std::chrono::duration<double> dt = sample.timestamp - prev_power->first;
+                    power_energy += dt.count() * (prev_power->second + watts_now) / 2;
+                }
+                prev_power.emplace(sample.timestamp, watts_now);
+            }
         }
-        if (!readings["board"].empty())
-            os.json["gpu"].push_back(std::move(readings));
+        if (first_energy && last_energy != first_energy)
+            into.push_back({ "gpu", dev, "board", *last_energy - *first_energy });
+        else if (prev_power)
+            into.push_back({ "gpu", dev, "board", power_energy });
+    }
+}
+
+section_stats::section_stats(std::shared_ptr<const readings_output> rout,
+    std::shared_ptr<const read_overhead> overhead) :
+    _rout(std::move(rout)),
+    _overhead(std::move(overhead))
+{
+    assert(_rout);
+}
+
+void section_stats::add(const timed_execution& exec)
+{
+    if (exec.size() < 2)
+        return;
+    std::vector<sensor_energy> energy;
+    _rout->energy(exec, energy);
+    std::vector<sensor_energy> corrected;
+    if (_overhead)
+    {
+        corrected = energy;
+        _overhead->correct(exec, corrected);
     }
+    double duration = std::chrono::duration<double, std::nano>(
+        exec.back().timestamp - exec.front().timestamp).count();
+
+    std::scoped_lock lock(_mx);
+    _duration.add(duration);
+    for (size_t ix = 0; ix < energy.size(); ix++)
+    {
+        const sensor_energy& e = energy[ix];
+        energy_stats& stats = _energy[{ e.target, e.id, e.location }];
+        stats.energy.add(e.energy);
+        if (_overhead)
+            stats.corrected.add(corrected[ix].energy);
+        stats.duration += duration;
+    }
+}
+
+std::unique_lock<std::mutex> section_stats::lock() const
+{
+    return std::unique_lock(_mx);
+}
+
+const std::shared_ptr<const read_overhead>& section_stats::overhead() const
+{
+    return _overhead;
+}
+
+const running_stats& section_stats::duration() const
+{
+    return _duration;
+}
+
+const std::map<section_stats::key_type, section_stats::energy_stats>&
+section_stats::energy() const
+{
+    return _energy;
 }
 
 idle_output::idle_output(std::unique_ptr<readings_output>&& rout, timed_execution&& exec) :
@@ -290,11 +989,15 @@ const readings_output& idle_output::readings_out() const
 section_output::section_output(
     std::unique_ptr<readings_output> rout,
     std::optional<std::string_view> label,
-    std::optional<std::string_view> extra)
+    std::optional<std::string_view> extra,
+    bool stats,
+    std::shared_ptr<const read_overhead> overhead)
     :
     _rout(std::move(rout)),
     _label(label ? std::optional<std::string>(*label) : std::nullopt),
-    _extra(extra ? std::optional<std::string>(*extra) : std::nullopt)
+    _extra(extra ? std::optional<std::string>(*extra) : std::nullopt),
+    _overhead(std::move(overhead)),
+    _stats(stats ? std::make_shared<section_stats>(_rout, _overhead) : nullptr)
 {}
 
 position_exec& section_output::push_back(position_exec&& pe)
@@ -308,6 +1011,21 @@ const readings_output& section_output::readings_out() const
     return *_rout;
 }
 
+std::shared_ptr<const readings_output> section_output::shared_readings_out() const
+{
+    return _rout;
+}
+
+const std::shared_ptr<section_stats>& section_output::stats() const
+{
+    return _stats;
+}
+
+const std::shared_ptr<const read_overhead>& section_output::overhead() const
+{
+    return _overhead;
+}
+
 const std::optional<std::string>& section_output::label() const
 {
     return _label;
@@ -378,8 +1096,164 @@ const profiling_results::container& profiling_results::groups() const
 
 // operator overloads
 
+std::optional<std::string> tep::overhead_json(const section_output& so)
+{
+    if (!so.overhead())
+        return std::nullopt;
+    std::ostringstream oss;
+    {
+        output_writer ow(oss);
+        overhead_output(ow, *so.overhead());
+    }
+    return oss.str();
+}
+
+std::string tep::stats_json(const section_stats& stats)
+{
+    auto lock = stats.lock();
+    std::ostringstream oss;
+    {
+        output_writer ow(oss);
+        stats_output(ow, stats);
+    }
+    return oss.str();
+}
+
 std::ostream& tep::operator<<(std::ostream& os, const profiling_results& pr)
 {
-    os << nlohmann::json(pr);
+    output_writer ow(os);
+    results_output(ow, pr);
     return os;
 }
+
+void tep::write_binary_header(binary_writer& bw)
+{
+    for (char c : binary::magic)
+        bw.write(c);
+    bw.write(binary::version).write(binary::byte_order);
+    bw.write(time_unit).write(energy_unit).write(power_unit);
+    bw.write(static_cast<uint32_t>(cpu_format.size()));
+    for (auto f : cpu_format)
+        bw.write(f);
+    std::vector<std::string_view> gpu_fmt = gpu_format();
+    bw.write(static_cast<uint32_t>(gpu_fmt.size()));
+    for (auto f : gpu_fmt)
+        bw.write(f);
+    bw.write(scale_of<nrgprf::units_energy>()).write(scale_of<nrgprf::units_power>());
+}
+
+uint64_t tep::write_binary_execution(binary_writer& bw, const readings_output& rout,
+    const timed_execution& exec, const trap_context& start, const trap_context& end,
+    const read_overhead* overhead)
+{
+    return execution_binary(bw, rout, exec, context_json(start), context_json(end),
+        execution_overhead_json(rout, overhead, exec));
+}
+
+uint64_t tep::write_binary_idle(binary_writer& bw, const readings_output& rout,
+    const timed_execution& exec)
+{
+    return execution_binary(bw, rout, exec, {}, {}, std::nullopt);
+}
+
+namespace
+{
+    // the executions of a chunk and their offsets from the start of the chunk
+    struct binary_chunk
+    {
+        std::string bytes;
+        std::vector<uint64_t> offsets;
+    };
+
+    binary_chunk executions_binary_chunk(const section_output& so, size_t first, size_t last)
+    {
+        binary_chunk retval;
+        std::ostringstream oss;
+        {
+            binary_writer bw(oss);
+            for (size_t ix = first; ix < last; ix++)
+            {
+                const position_exec& pe = so.executions()[ix];
+                retval.offsets.push_back(write_binary_execution(bw, so.readings_out(),
+                    pe.exec.decompress(), pe.interval.first, pe.interval.second,
+                    so.overhead().get()));
+            }
+        }
+        retval.bytes = oss.str();
+        return retval;
+    }
+
+    // the executions of <pr> after those of <journaled>, already written, and the index
+    void binary_results(binary_writer& bw, const profiling_results& pr,
+        journal::section_executions journaled)
+    {
+        std::vector<uint64_t> idle;
+        for (const auto& io : pr.idle())
+        {
+            if (io.exec().empty())
+                idle.push_back(0);
+            else
+                idle.push_back(write_binary_idle(bw, io.readings_out(), io.exec()));
+        }
+
+        // offsets of the executions of every section of every group
+        std::vector<std::vector<std::vector<uint64_t>>> groups;
+        parallel_chunks<binary_chunk> chunks(pr, executions_binary_chunk);
+        for (const auto& go : pr.groups())
+        {
+            auto& sections = groups.emplace_back();
+            for (const auto& so : go.sections())
+            {
+                // the journaled executions of the section precede those kept in memory
+                auto& execs = sections.emplace_back();
+                auto it = journaled.find({ static_cast<uint32_t>(groups.size() - 1),
+                    static_cast<uint32_t>(sections.size() - 1) });
+                if (it != journaled.end())
+                    execs = std::move(it->second);
+                for (size_t c = 0; c < parallel_chunks<binary_chunk>::count(so); c++)
+                {
+                    binary_chunk chunk = chunks.next();
+                    uint64_t base = bw.offset();
+                    for (uint64_t offset : chunk.offsets)
+                        execs.push_back(base + offset);
+                    bw.raw(chunk.bytes);
+                }
+            }
+        }
+
+        uint64_t index_offset = bw.offset();
+        bw.write(static_cast<uint32_t>(idle.size())).write(idle);
+        bw.write(static_cast<uint32_t>(groups.size()));
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            const group_output& go = pr.groups()[g];
+            bw.write(go.label()).write(go.extra());
+            bw.write(static_cast<uint32_t>(groups[g].size()));
+            for (size_t s = 0; s < groups[g].size(); s++)
+            {
+                const section_output& so = go.sections()[s];
+                std::optional<std::string> stats;
+                if (so.stats())
+                    stats = stats_json(*so.stats());
+                bw.write(so.label()).write(so.extra()).write(stats).write(overhead_json(so));
+                bw.write(static_cast<uint64_t>(groups[g][s].size())).write(groups[g][s]);
+            }
+        }
+        bw.write(index_offset);
+        for (char c : binary::magic)
+            bw.write(c);
+    }
+}
+
+void tep::write_binary(std::ostream& os, const profiling_results& pr)
+{
+    binary_writer bw(os);
+    write_binary_header(bw);
+    binary_results(bw, pr, {});
+}
+
+void tep::write_binary(std::ostream& os, const profiling_results& pr, std::istream& journal)
+{
+    binary_writer bw(os);
+    binary_results(bw, pr, journal::copy_executions(journal, bw));
+}
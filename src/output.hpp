@@ -2,18 +2,34 @@
 
 #pragma once
 
+#include "compressed_execution.hpp"
+#include "stats.hpp"
 #include "timed_sample.hpp"
 #include "trap_context.hpp"
 #include "output/fwd.hpp"
 
+#include <map>
+#include <mutex>
 #include <optional>
+#include <tuple>
 
 namespace tep
 {
+    struct read_overhead;
+
     struct position_exec
     {
         std::pair<trap_context, trap_context> interval;
-        timed_execution exec;
+        compressed_execution exec;
+    };
+
+    // energy consumed by a sensor location of a CPU socket or GPU device
+    struct sensor_energy
+    {
+        std::string_view target;
+        uint32_t id;
+        std::string_view location;
+        double energy;
     };
 
     class readings_output
@@ -21,6 +37,9 @@ namespace tep
     public:
         virtual ~readings_output() = default;
         virtual void output(output_writer& os, const timed_execution& exec) const = 0;
+        virtual void output(binary_writer& os, const timed_execution& exec) const = 0;
+        // the energy consumed during an execution, in joules
+        virtual void energy(const timed_execution& exec, std::vector<sensor_energy>& into) const = 0;
     };
 
     class readings_output_holder final : public readings_output
@@ -32,6 +51,8 @@ namespace tep
         readings_output_holder() = default;
         void push_back(std::unique_ptr<readings_output>&& outputs);
         void output(output_writer& os, const timed_execution& exec) const override;
+        void output(binary_writer& os, const timed_execution& exec) const override;
+        void energy(const timed_execution& exec, std::vector<sensor_energy>& into) const override;
     };
 
     template<typename Reader>
@@ -44,6 +65,45 @@ namespace tep
         readings_output_dev(const Reader& reader);
 
         void output(output_writer& os, const timed_execution& exec) const override;
+        void output(binary_writer& os, const timed_execution& exec) const override;
+        void energy(const timed_execution& exec, std::vector<sensor_energy>& into) const override;
+    };
+
+    // statistics of the executions of a section, which are folded in as they finish;
+    // memory does not depend on the number of executions
+    class section_stats
+    {
+    public:
+        struct energy_stats
+        {
+            running_stats energy;
+            // the energy without the overhead of the reads, if it was calibrated
+            running_stats corrected;
+            // total duration of the executions in energy, in ns
+            double duration = 0;
+        };
+
+        using key_type = std::tuple<std::string_view, uint32_t, std::string_view>;
+
+    private:
+        std::shared_ptr<const readings_output> _rout;
+        std::shared_ptr<const read_overhead> _overhead;
+        mutable std::mutex _mx;
+        running_stats _duration;
+        std::map<key_type, energy_stats> _energy;
+
+    public:
+        explicit section_stats(std::shared_ptr<const readings_output> rout,
+            std::shared_ptr<const read_overhead> overhead = nullptr);
+
+        // thread-safe
+        void add(const timed_execution& exec);
+        // holds off the executions being added while the statistics are read
+        std::unique_lock<std::mutex> lock() const;
+
+        const std::shared_ptr<const read_overhead>& overhead() const;
+        const running_stats& duration() const;
+        const std::map<key_type, energy_stats>& energy() const;
     };
 
     class idle_output
@@ -63,20 +123,29 @@ namespace tep
     class section_output
     {
     private:
-        std::unique_ptr<readings_output> _rout;
+        std::shared_ptr<readings_output> _rout;
         std::optional<std::string> _label;
         std::optional<std::string> _extra;
         std::vector<position_exec> _executions;
+        std::shared_ptr<const read_overhead> _overhead;
+        std::shared_ptr<section_stats> _stats;
 
     public:
+        // executions are folded into statistics instead of being stored if <stats> is true;
+        // <overhead> is the calibrated overhead of the reads of the section, if any
         section_output(
             std::unique_ptr<readings_output> rout,
             std::optional<std::string_view> label,
-            std::optional<std::string_view> extra);
+            std::optional<std::string_view> extra,
+            bool stats = false,
+            std::shared_ptr<const read_overhead> overhead = nullptr);
 
         position_exec& push_back(position_exec&& pe);
 
         const readings_output& readings_out() const;
+        std::shared_ptr<const readings_output> shared_readings_out() const;
+        const std::shared_ptr<section_stats>& stats() const;
+        const std::shared_ptr<const read_overhead>& overhead() const;
         const std::optional<std::string>& label() const;
         const std::optional<std::string>& extra() const;
         const std::vector<position_exec>& executions() const;
@@ -129,6 +198,27 @@ namespace tep
 
     std::ostream& operator<<(std::ostream& os, const profiling_results& pr);
 
+    // write the results in the binary format, see output/binary_format.hpp
+    void write_binary(std::ostream& os, const profiling_results& pr);
+    // the same with the executions of <journal> which are not kept in <pr> as well,
+    // see results_journal; the rest of the results are those of <pr>
+    void write_binary(std::ostream& os, const profiling_results& pr, std::istream& journal);
+
+    // the calibrated overhead of the reads of a section in JSON, if any
+    std::optional<std::string> overhead_json(const section_output& so);
+
+    // thread-safe, the statistics of a section in JSON
+    std::string stats_json(const section_stats& stats);
+
+    // write the parts of the binary format, the offsets of the executions are returned
+    void write_binary_header(binary_writer& bw);
+    // <overhead> is the calibrated overhead of the reads of the section of the execution, if any
+    uint64_t write_binary_execution(binary_writer& bw, const readings_output& rout,
+        const timed_execution& exec, const trap_context& start, const trap_context& end,
+        const read_overhead* overhead = nullptr);
+    uint64_t write_binary_idle(binary_writer& bw, const readings_output& rout,
+        const timed_execution& exec);
+
     // deduction guides
 
     template<typename Reader>
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace tep
+{
+    // Layout of the binary results file, all integers in host byte order:
+    //
+    // file      := header execution* index trailer
+    // header    := magic version:u16 byte_order:u16
+    //              units:(time:str energy:str power:str)
+    //              format:(cpu:strs gpu:strs)
+    //              energy_scale:scale power_scale:scale
+    // execution := start:str end:str overhead:optstr
+    //              nsamples:u64 sample_times:deltas
+    //              nreaders:u8 reader_times:deltas[nreaders]
+    //              readings* kind:u8=end
+    // readings  := kind:u8 (cpu | cores | gpu)
+    // cpu       := nfields:u8 fields:u8[nfields] nsockets:u32
+    //              (socket:u32 (count:u64 deltas[nfields])[cpu_locations])[nsockets]
+    // cores     := nfields:u8 fields:u8[nfields] ncores:u32
+    //              (core:u32 count:u64 deltas[nfields])[ncores]
+    // gpu       := ndevices:u32 (device:u32 field:u8 count:u64 deltas)[ndevices]
+    // index     := nidle:u32 idle:u64[nidle]
+    //              ngroups:u32 (label:optstr extra:optstr nsections:u32
+    //              (label:optstr extra:optstr stats:optstr overhead:optstr
+    //              nexecs:u64 execs:u64[nexecs])[nsections])[ngroups]
+    // trailer   := index_offset:u64 magic
+    //
+    // str := size:u32 char[size], strs := count:u32 str[count],
+    // optstr := present:u8 str?, scale := num:i64 den:i64,
+    // deltas := size:u64 byte[size], the preceding count of values, each one encoded as
+    // the zig-zag varint of its difference to the previous value (see varint.hpp),
+    // the first one to 0;
+    // executions are referenced by their offset from the start of the file,
+    // offset 0 being an idle execution without samples;
+    // the range of an execution holds its trap contexts in JSON, empty for idle executions;
+    // the stats of a section hold its statistics in JSON, only with the stats method;
+    // the overhead of a section holds the calibrated overhead of its reads in JSON,
+    // only with --calibrate-overhead, as is the overhead of its executions, which holds
+    // their energy with and without the energy of the reads in JSON;
+    // the reader times of an execution are the times at which every target, CPU first,
+    // was read by a hybrid reader, none if the samples were not read by one;
+    // the cores of the CPU readings, if any were read, follow them;
+    // readings are raw integer counters, which are converted to the output units
+    // with the scale of their field
+    namespace binary
+    {
+        constexpr std::array<char, 8> magic = { 'T', 'E', 'P', 'R', 'S', 'L', 'T', 'S' };
+        constexpr uint16_t version = 8;
+        constexpr uint16_t byte_order = 0x0102;
+
+        enum class field : uint8_t
+        {
+            time,
+            energy,
+            power,
+        };
+
+        enum class readings_kind : uint8_t
+        {
+            cpu,
+            gpu,
+            cores,
+            end,
+        };
+
+        // the locations of every CPU socket, in the order in which they are written
+        constexpr std::array<std::string_view, 6> cpu_locations = {
+            "cores", "dram", "gpu", "package", "sys", "uncore"
+        };
+
+        struct scale
+        {
+            int64_t num;
+            int64_t den;
+        };
+    } // namespace binary
+} // namespace tep
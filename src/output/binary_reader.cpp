@@ -0,0 +1,274 @@
+#include "binary_reader.hpp"
+#include "varint.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace tep
+{
+    namespace binary
+    {
+        size_t column::size() const noexcept
+        {
+            return values.empty() ? 0 : values.front().size();
+        }
+    } // namespace binary
+
+    template<typename T>
+    T binary_reader::read()
+    {
+        T retval;
+        if (!_file.read(reinterpret_cast<char*>(&retval), sizeof(retval)))
+            throw binary::format_error("unexpected end of file");
+        if constexpr (std::is_same_v<T, binary::field>)
+        {
+            if (retval > binary::field::power)
+                throw binary::format_error("invalid field");
+        }
+        return retval;
+    }
+
+    template<typename T>
+    std::vector<T> binary_reader::read_vector(uint64_t count)
+    {
+        // do not trust the count of a corrupted file before allocating
+        uint64_t pos = _file.tellg();
+        if (count > (_size - std::min(pos, _size)) / sizeof(T))
+            throw binary::format_error("unexpected end of file");
+        std::vector<T> retval(count);
+        if (!_file.read(reinterpret_cast<char*>(retval.data()), count * sizeof(T)))
+            throw binary::format_error("unexpected end of file");
+        if constexpr (std::is_same_v<T, binary::field>)
+        {
+            if (std::any_of(retval.begin(), retval.end(),
+                [](binary::field f) { return f > binary::field::power; }))
+                throw binary::format_error("invalid field");
+        }
+        return retval;
+    }
+
+    template<typename T>
+    std::vector<T> binary_reader::read_deltas(uint64_t count)
+    {
+        std::vector<uint8_t> bytes = read_vector<uint8_t>(read<uint64_t>());
+        // every value takes at least one byte
+        if (count > bytes.size())
+            throw binary::format_error("truncated deltas");
+        std::vector<T> retval;
+        retval.reserve(count);
+        const uint8_t* it = bytes.data();
+        const uint8_t* end = it + bytes.size();
+        uint64_t value = 0;
+        for (uint64_t i = 0; i < count; i++)
+        {
+            if (!varint::get_delta(it, end, value, value))
+                throw binary::format_error("truncated deltas");
+            retval.push_back(static_cast<T>(value));
+        }
+        if (it != end)
+            throw binary::format_error("trailing bytes after deltas");
+        return retval;
+    }
+
+    binary_reader::binary_reader(const std::string& path) :
+        _file(path, std::ios::binary | std::ios::ate)
+    {
+        if (!_file)
+            throw binary::format_error("error opening '" + path + "'");
+        _size = _file.tellg();
+
+        seek(0);
+        read_magic();
+        if (read<uint16_t>() != binary::version)
+            throw binary::format_error("unsupported version");
+        if (read<uint16_t>() != binary::byte_order)
+            throw binary::format_error("unsupported byte order");
+        _header.time_unit = read_string();
+        _header.energy_unit = read_string();
+        _header.power_unit = read_string();
+        for (auto* format : { &_header.cpu_format, &_header.gpu_format })
+        {
+            uint32_t count = read<uint32_t>();
+            for (uint32_t i = 0; i < count; i++)
+                format->push_back(read_string());
+        }
+        _header.energy_scale = read_scale();
+        _header.power_scale = read_scale();
+
+        constexpr uint64_t trailer_size = sizeof(uint64_t) + binary::magic.size();
+        if (_size < trailer_size)
+            throw binary::format_error("missing trailer");
+        seek(_size - trailer_size);
+        uint64_t index_offset = read<uint64_t>();
+        read_magic();
+
+        seek(index_offset);
+        _idle = read_vector<uint64_t>(read<uint32_t>());
+        uint32_t ngroups = read<uint32_t>();
+        for (uint32_t g = 0; g < ngroups; g++)
+        {
+            binary::group_index& group = _groups.emplace_back();
+            group.label = read_optional_string();
+            group.extra = read_optional_string();
+            uint32_t nsections = read<uint32_t>();
+            for (uint32_t s = 0; s < nsections; s++)
+            {
+                binary::section_index& section = group.sections.emplace_back();
+                section.label = read_optional_string();
+                section.extra = read_optional_string();
+                section.stats = read_optional_string();
+                section.overhead = read_optional_string();
+                section.executions = read_vector<uint64_t>(read<uint64_t>());
+            }
+        }
+    }
+
+    const binary::header& binary_reader::header() const noexcept
+    {
+        return _header;
+    }
+
+    const std::vector<uint64_t>& binary_reader::idle() const noexcept
+    {
+        return _idle;
+    }
+
+    const std::vector<binary::group_index>& binary_reader::groups() const noexcept
+    {
+        return _groups;
+    }
+
+    binary::execution binary_reader::read_execution(uint64_t offset)
+    {
+        binary::execution retval;
+        if (!offset)
+            return retval;
+
+        seek(offset);
+        retval.start = read_string();
+        retval.end = read_string();
+        retval.overhead = read_optional_string();
+        retval.sample_times = read_deltas<int64_t>(read<uint64_t>());
+        for (uint8_t readers = read<uint8_t>(); readers; readers--)
+            retval.reader_times.push_back(read_deltas<int64_t>(retval.sample_times.size()));
+        for (auto kind = read<binary::readings_kind>();
+            kind != binary::readings_kind::end;
+            kind = read<binary::readings_kind>())
+        {
+            binary::target_readings& readings = retval.readings.emplace_back();
+            readings.kind = kind;
+            switch (kind)
+            {
+            case binary::readings_kind::cpu:
+            {
+                std::vector<binary::field> fields = read_vector<binary::field>(read<uint8_t>());
+                uint32_t nsockets = read<uint32_t>();
+                for (uint32_t skt = 0; skt < nsockets; skt++)
+                {
+                    binary::unit_readings& socket = readings.units.emplace_back();
+                    socket.id = read<uint32_t>();
+                    for (size_t loc = 0; loc < binary::cpu_locations.size(); loc++)
+                    {
+                        binary::column& column = socket.columns.emplace_back();
+                        column.fields = fields;
+                        uint64_t count = read<uint64_t>();
+                        for (size_t f = 0; f < fields.size(); f++)
+                            column.values.push_back(read_deltas<uint64_t>(count));
+                    }
+                }
+            } break;
+            case binary::readings_kind::cores:
+            {
+                std::vector<binary::field> fields = read_vector<binary::field>(read<uint8_t>());
+                uint32_t ncores = read<uint32_t>();
+                for (uint32_t core = 0; core < ncores; core++)
+                {
+                    binary::unit_readings& unit = readings.units.emplace_back();
+                    unit.id = read<uint32_t>();
+                    binary::column& column = unit.columns.emplace_back();
+                    column.fields = fields;
+                    uint64_t count = read<uint64_t>();
+                    for (size_t f = 0; f < fields.size(); f++)
+                        column.values.push_back(read_deltas<uint64_t>(count));
+                }
+            } break;
+            case binary::readings_kind::gpu:
+            {
+                uint32_t ndevices = read<uint32_t>();
+                for (uint32_t dev = 0; dev < ndevices; dev++)
+                {
+                    binary::unit_readings& device = readings.units.emplace_back();
+                    device.id = read<uint32_t>();
+                    binary::column& column = device.columns.emplace_back();
+                    column.fields.push_back(read<binary::field>());
+                    column.values.push_back(read_deltas<uint64_t>(read<uint64_t>()));
+                }
+            } break;
+            default:
+                throw binary::format_error("invalid readings kind");
+            }
+        }
+        return retval;
+    }
+
+    binary::execution binary_reader::read_execution(size_t group, size_t section, size_t exec)
+    {
+        return read_execution(_groups.at(group).sections.at(section).executions.at(exec));
+    }
+
+    int64_t binary_reader::time(uint64_t value) const noexcept
+    {
+        return static_cast<int64_t>(value);
+    }
+
+    // same conversion as nrgprf::unit_cast
+    double binary_reader::energy(uint64_t value) const noexcept
+    {
+        return static_cast<double>(value)
+            * static_cast<double>(_header.energy_scale.num)
+            / static_cast<double>(_header.energy_scale.den);
+    }
+
+    double binary_reader::power(uint64_t value) const noexcept
+    {
+        return static_cast<double>(value)
+            * static_cast<double>(_header.power_scale.num)
+            / static_cast<double>(_header.power_scale.den);
+    }
+
+    std::string binary_reader::read_string()
+    {
+        std::vector<char> chars = read_vector<char>(read<uint32_t>());
+        return std::string(chars.begin(), chars.end());
+    }
+
+    std::optional<std::string> binary_reader::read_optional_string()
+    {
+        if (read<uint8_t>())
+            return read_string();
+        return std::nullopt;
+    }
+
+    binary::scale binary_reader::read_scale()
+    {
+        binary::scale retval;
+        retval.num = read<int64_t>();
+        retval.den = read<int64_t>();
+        if (!retval.den)
+            throw binary::format_error("invalid scale");
+        return retval;
+    }
+
+    void binary_reader::read_magic()
+    {
+        std::array<char, binary::magic.size()> magic = read<decltype(magic)>();
+        if (magic != binary::magic)
+            throw binary::format_error("not a binary results file");
+    }
+
+    void binary_reader::seek(uint64_t offset)
+    {
+        if (offset > _size || !_file.seekg(offset))
+            throw binary::format_error("invalid offset");
+    }
+} // namespace tep
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "binary_format.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tep
+{
+    namespace binary
+    {
+        struct format_error : std::runtime_error
+        {
+            using std::runtime_error::runtime_error;
+        };
+
+        struct header
+        {
+            std::string time_unit;
+            std::string energy_unit;
+            std::string power_unit;
+            std::vector<std::string> cpu_format;
+            std::vector<std::string> gpu_format;
+            scale energy_scale;
+            scale power_scale;
+        };
+
+        // the readings of a CPU location or GPU board, one column of raw values per field
+        struct column
+        {
+            std::vector<field> fields;
+            std::vector<std::vector<uint64_t>> values;
+
+            size_t size() const noexcept;
+        };
+
+        // a CPU socket, with one column per location in cpu_locations,
+        // a CPU core, with its column, or a GPU device, with its board column
+        struct unit_readings
+        {
+            uint32_t id;
+            std::vector<column> columns;
+        };
+
+        struct target_readings
+        {
+            readings_kind kind;
+            std::vector<unit_readings> units;
+        };
+
+        struct execution
+        {
+            std::string start;
+            std::string end;
+            // the energy with and without the overhead of the reads in JSON, if it was calibrated
+            std::optional<std::string> overhead;
+            std::vector<int64_t> sample_times;
+            // the read times of every reader of a hybrid reader, in ns
+            std::vector<std::vector<int64_t>> reader_times;
+            std::vector<target_readings> readings;
+        };
+
+        struct section_index
+        {
+            std::optional<std::string> label;
+            std::optional<std::string> extra;
+            // JSON document of the statistics of a section with the stats method
+            std::optional<std::string> stats;
+            // JSON document of the calibrated overhead of the reads of a section
+            std::optional<std::string> overhead;
+            std::vector<uint64_t> executions;
+        };
+
+        struct group_index
+        {
+            std::optional<std::string> label;
+            std::optional<std::string> extra;
+            std::vector<section_index> sections;
+        };
+    } // namespace binary
+
+    // reads a binary results file written with --output-format binary;
+    // the header and index are read on construction and executions are read on demand,
+    // throws binary::format_error if the file is malformed
+    class binary_reader
+    {
+    public:
+        explicit binary_reader(const std::string& path);
+
+        const binary::header& header() const noexcept;
+        // offsets of the idle executions, 0 if an idle execution has no samples
+        const std::vector<uint64_t>& idle() const noexcept;
+        const std::vector<binary::group_index>& groups() const noexcept;
+
+        binary::execution read_execution(uint64_t offset);
+        binary::execution read_execution(size_t group, size_t section, size_t exec);
+
+        // raw values of time fields in ns, energy and power fields in the output units
+        int64_t time(uint64_t value) const noexcept;
+        double energy(uint64_t value) const noexcept;
+        double power(uint64_t value) const noexcept;
+
+    private:
+        std::ifstream _file;
+        uint64_t _size;
+        binary::header _header;
+        std::vector<uint64_t> _idle;
+        std::vector<binary::group_index> _groups;
+
+        template<typename T>
+        T read();
+
+        template<typename T>
+        std::vector<T> read_vector(uint64_t count);
+
+        template<typename T>
+        std::vector<T> read_deltas(uint64_t count);
+
+        std::string read_string();
+        std::optional<std::string> read_optional_string();
+        binary::scale read_scale();
+        void read_magic();
+        void seek(uint64_t offset);
+    };
+} // namespace tep
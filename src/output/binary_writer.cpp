@@ -0,0 +1,51 @@
+#include "binary_writer.hpp"
+
+#include <cassert>
+#include <limits>
+#include <ostream>
+
+namespace tep
+{
+    binary_writer::binary_writer(std::ostream& os) :
+        _os(os),
+        _offset(0),
+        _deltas()
+    {}
+
+    uint64_t binary_writer::offset() const noexcept
+    {
+        return _offset;
+    }
+
+    binary_writer& binary_writer::write(std::string_view x)
+    {
+        assert(x.size() <= std::numeric_limits<uint32_t>::max());
+        write(static_cast<uint32_t>(x.size()));
+        return write_bytes(x.data(), x.size());
+    }
+
+    binary_writer& binary_writer::write(const std::optional<std::string>& x)
+    {
+        write(static_cast<uint8_t>(x.has_value()));
+        if (x)
+            write(std::string_view(*x));
+        return *this;
+    }
+
+    binary_writer& binary_writer::write(const binary::scale& x)
+    {
+        return write(x.num).write(x.den);
+    }
+
+    binary_writer& binary_writer::raw(std::string_view x)
+    {
+        return write_bytes(x.data(), x.size());
+    }
+
+    binary_writer& binary_writer::write_bytes(const void* data, size_t size)
+    {
+        _os.write(static_cast<const char*>(data), size);
+        _offset += size;
+        return *this;
+    }
+} // namespace tep
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "fwd.hpp"
+#include "binary_format.hpp"
+#include "varint.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace tep
+{
+    // writes the primitives of the binary results format, see binary_format.hpp,
+    // and keeps track of the offset of the next byte
+    struct binary_writer
+    {
+    public:
+        explicit binary_writer(std::ostream& os);
+
+        binary_writer(const binary_writer&) = delete;
+        binary_writer& operator=(const binary_writer&) = delete;
+
+        uint64_t offset() const noexcept;
+
+        template<typename T>
+        std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>, binary_writer&>
+            write(T x)
+        {
+            return write_bytes(&x, sizeof(x));
+        }
+
+        template<typename T>
+        binary_writer& write(const std::vector<T>& x)
+        {
+            static_assert(std::is_arithmetic_v<T>);
+            return write_bytes(x.data(), x.size() * sizeof(T));
+        }
+
+        // writes the values as deltas, see binary_format.hpp;
+        // the count of values is not written
+        template<typename T>
+        binary_writer& write_deltas(const std::vector<T>& x)
+        {
+            static_assert(std::is_integral_v<T>);
+            _deltas.clear();
+            uint64_t prev = 0;
+            for (T value : x)
+            {
+                varint::put_delta(_deltas, static_cast<uint64_t>(value), prev);
+                prev = static_cast<uint64_t>(value);
+            }
+            write(static_cast<uint64_t>(_deltas.size()));
+            return write_bytes(_deltas.data(), _deltas.size());
+        }
+
+        binary_writer& write(std::string_view);
+        binary_writer& write(const std::optional<std::string>&);
+        binary_writer& write(const binary::scale&);
+        // bytes which are already serialised, without their size
+        binary_writer& raw(std::string_view);
+
+    private:
+        std::ostream& _os;
+        uint64_t _offset;
+        // reused between columns
+        std::vector<uint8_t> _deltas;
+
+        binary_writer& write_bytes(const void* data, size_t size);
+    };
+} // namespace tep
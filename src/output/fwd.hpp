@@ -5,5 +5,5 @@
 namespace tep
 {
     struct output_writer;
-    std::ostream& operator<<(std::ostream&, const output_writer&);
+    struct binary_writer;
 } // namespace tep
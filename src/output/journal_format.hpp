@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tep
+{
+    // Layout of the results journal, all integers in host byte order:
+    //
+    // journal := magic record*
+    // record  := size:u32 checksum:u32 kind:u8 payload:byte[size - 1]
+    // header  := the header of the binary results file, see binary_format.hpp
+    // section := group:u32 section:u32
+    //            group_label:optstr group_extra:optstr label:optstr extra:optstr
+    //            overhead:optstr
+    // exec    := group:u32 section:u32 execution
+    // idle    := index:u32 execution?
+    // stats   := group:u32 section:u32 stats:str
+    //
+    // the first record is the header, followed by a section record for every section
+    // before any of its executions or statistics; the statistics of a section are
+    // snapshots in JSON, of which the last one is the one recovered;
+    // executions and idle executions are written
+    // in the layout of the binary results file, so that they can be copied verbatim;
+    // the checksum covers the kind and the payload, and a record which is truncated
+    // or whose checksum does not match ends the journal, which is the case
+    // of the last record written when the profiler was killed
+    namespace journal
+    {
+        constexpr std::array<char, 8> magic = { 'T', 'E', 'P', 'J', 'R', 'N', 'L', '1' };
+
+        enum class record_kind : uint8_t
+        {
+            header,
+            section,
+            exec,
+            idle,
+            stats,
+        };
+
+        // FNV-1a
+        inline uint32_t checksum(const uint8_t* data, size_t size,
+            uint32_t hash = 2166136261u) noexcept
+        {
+            for (size_t i = 0; i < size; i++)
+                hash = (hash ^ data[i]) * 16777619u;
+            return hash;
+        }
+    } // namespace journal
+} // namespace tep
@@ -0,0 +1,240 @@
+// journal_reader.cpp
+
+#include "journal_reader.hpp"
+#include "binary_writer.hpp"
+#include "journal_format.hpp"
+
+#include <cstring>
+#include <istream>
+#include <map>
+
+using namespace tep;
+using namespace tep::journal;
+
+namespace
+{
+    // reads the fields of a record payload
+    class payload_cursor
+    {
+    private:
+        const std::vector<char>& _data;
+        size_t _pos;
+
+    public:
+        explicit payload_cursor(const std::vector<char>& data) :
+            _data(data),
+            _pos(0)
+        {}
+
+        template<typename T>
+        T read()
+        {
+            T retval;
+            if (_data.size() - _pos < sizeof(retval))
+                throw format_error("truncated record payload");
+            std::memcpy(&retval, _data.data() + _pos, sizeof(retval));
+            _pos += sizeof(retval);
+            return retval;
+        }
+
+        std::string read_string()
+        {
+            uint32_t size = read<uint32_t>();
+            if (_data.size() - _pos < size)
+                throw format_error("truncated record payload");
+            std::string retval(_data.data() + _pos, size);
+            _pos += size;
+            return retval;
+        }
+
+        std::optional<std::string> read_optional_string()
+        {
+            if (!read<uint8_t>())
+                return std::nullopt;
+            return read_string();
+        }
+
+        std::vector<char> rest() const
+        {
+            return std::vector<char>(_data.begin() + _pos, _data.end());
+        }
+    };
+
+    struct section_entry
+    {
+        std::optional<std::string> label;
+        std::optional<std::string> extra;
+        std::optional<std::string> stats;
+        std::optional<std::string> overhead;
+        std::vector<uint64_t> executions;
+    };
+
+    struct group_entry
+    {
+        std::optional<std::string> label;
+        std::optional<std::string> extra;
+        std::map<uint32_t, section_entry> sections;
+    };
+
+    struct recovered
+    {
+        std::map<uint32_t, uint64_t> idle;
+        std::map<uint32_t, group_entry> groups;
+        size_t executions = 0;
+    };
+
+    // returns false at the end of the journal, which is either the end of the file
+    // or the first incomplete or corrupted record
+    bool read_record(std::istream& is, record_kind& kind, std::vector<char>& payload)
+    {
+        uint32_t size;
+        uint32_t checksum;
+        if (!is.read(reinterpret_cast<char*>(&size), sizeof(size)) ||
+            !is.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)) ||
+            !size)
+        {
+            return false;
+        }
+        uint8_t kind_byte;
+        if (!is.read(reinterpret_cast<char*>(&kind_byte), sizeof(kind_byte)))
+            return false;
+        payload.resize(size - 1);
+        if (!is.read(payload.data(), payload.size()))
+            return false;
+        uint32_t computed = journal::checksum(
+            reinterpret_cast<const uint8_t*>(payload.data()), payload.size(),
+            journal::checksum(&kind_byte, 1));
+        if (computed != checksum || kind_byte > static_cast<uint8_t>(record_kind::stats))
+            return false;
+        kind = static_cast<record_kind>(kind_byte);
+        return true;
+    }
+
+    void check_header(const std::vector<char>& header)
+    {
+        payload_cursor cursor(header);
+        for (char c : binary::magic)
+            if (cursor.read<char>() != c)
+                throw format_error("invalid results header");
+        if (cursor.read<uint16_t>() != binary::version)
+            throw format_error("journal written by an unsupported version");
+        if (cursor.read<uint16_t>() != binary::byte_order)
+            throw format_error("unsupported byte order");
+    }
+
+    section_entry& find_section(recovered& rec, uint32_t group, uint32_t section)
+    {
+        auto grp_it = rec.groups.find(group);
+        if (grp_it == rec.groups.end())
+            throw format_error("record of an unknown section");
+        auto sec_it = grp_it->second.sections.find(section);
+        if (sec_it == grp_it->second.sections.end())
+            throw format_error("record of an unknown section");
+        return sec_it->second;
+    }
+
+    // the executions are copied as they are read, the idle executions only if <idle> is true
+    recovered recover(std::istream& is, binary_writer& bw, bool idle)
+    {
+        std::array<char, journal::magic.size()> magic;
+        if (!is.read(magic.data(), magic.size()) || magic != journal::magic)
+            throw format_error("not a results journal");
+
+        recovered retval;
+        record_kind kind;
+        std::vector<char> payload;
+        if (!read_record(is, kind, payload) || kind != record_kind::header)
+            throw format_error("missing results header");
+        check_header(payload);
+        bw.write(payload);
+
+        while (read_record(is, kind, payload))
+        {
+            payload_cursor cursor(payload);
+            switch (kind)
+            {
+            case record_kind::section:
+            {
+                group_entry& group = retval.groups[cursor.read<uint32_t>()];
+                section_entry& section = group.sections[cursor.read<uint32_t>()];
+                group.label = cursor.read_optional_string();
+                group.extra = cursor.read_optional_string();
+                section.label = cursor.read_optional_string();
+                section.extra = cursor.read_optional_string();
+                section.overhead = cursor.read_optional_string();
+            } break;
+            case record_kind::exec:
+            {
+                uint32_t group = cursor.read<uint32_t>();
+                uint32_t section = cursor.read<uint32_t>();
+                find_section(retval, group, section).executions.push_back(bw.offset());
+                bw.write(cursor.rest());
+                retval.executions++;
+            } break;
+            case record_kind::idle:
+            {
+                if (!idle)
+                    break;
+                uint32_t index = cursor.read<uint32_t>();
+                std::vector<char> exec = cursor.rest();
+                retval.idle[index] = exec.empty() ? 0 : bw.offset();
+                bw.write(exec);
+            } break;
+            case record_kind::stats:
+            {
+                uint32_t group = cursor.read<uint32_t>();
+                uint32_t section = cursor.read<uint32_t>();
+                find_section(retval, group, section).stats = cursor.read_string();
+            } break;
+            default:
+                throw format_error("unexpected results header");
+            }
+        }
+        return retval;
+    }
+
+    void write_index(binary_writer& bw, const recovered& rec)
+    {
+        uint64_t index_offset = bw.offset();
+        // idle executions which were not journaled have no samples
+        uint32_t nidle = rec.idle.empty() ? 0 : rec.idle.rbegin()->first + 1;
+        bw.write(nidle);
+        for (uint32_t ix = 0; ix < nidle; ix++)
+        {
+            auto it = rec.idle.find(ix);
+            bw.write(it == rec.idle.end() ? uint64_t(0) : it->second);
+        }
+        bw.write(static_cast<uint32_t>(rec.groups.size()));
+        for (const auto& [g, group] : rec.groups)
+        {
+            bw.write(group.label).write(group.extra);
+            bw.write(static_cast<uint32_t>(group.sections.size()));
+            for (const auto& [s, section] : group.sections)
+            {
+                bw.write(section.label).write(section.extra).write(section.stats)
+                    .write(section.overhead);
+                bw.write(static_cast<uint64_t>(section.executions.size())).write(section.executions);
+            }
+        }
+        bw.write(index_offset);
+        for (char c : binary::magic)
+            bw.write(c);
+    }
+}
+
+rebuilt tep::journal::rebuild(std::istream& is, binary_writer& bw)
+{
+    recovered rec = recover(is, bw, true);
+    write_index(bw, rec);
+    return { rec.groups.size(), rec.executions };
+}
+
+section_executions tep::journal::copy_executions(std::istream& is, binary_writer& bw)
+{
+    section_executions retval;
+    recovered rec = recover(is, bw, false);
+    for (auto& [g, group] : rec.groups)
+        for (auto& [s, section] : group.sections)
+            retval[{ g, s }] = std::move(section.executions);
+    return retval;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace tep
+{
+    namespace journal
+    {
+        struct format_error : std::runtime_error
+        {
+            using std::runtime_error::runtime_error;
+        };
+
+        struct rebuilt
+        {
+            size_t groups;
+            size_t executions;
+        };
+
+        // writes the binary results file of the records of the journal, up to its end
+        // or its first incomplete or corrupted record; the executions are copied verbatim
+        // and every section gets the last statistics journaled for it;
+        // throws format_error if the journal cannot be read
+        rebuilt rebuild(std::istream& is, binary_writer& bw);
+
+        // the offsets of the executions of every section, by group and section index
+        using section_executions =
+            std::map<std::pair<uint32_t, uint32_t>, std::vector<uint64_t>>;
+
+        // writes the header and the executions of the records of the journal, up to its end
+        // or its first incomplete or corrupted record, without the index, so that the results
+        // which were not journaled can be written after them;
+        // throws format_error if the journal cannot be read
+        section_executions copy_executions(std::istream& is, binary_writer& bw);
+    } // namespace journal
+} // namespace tep
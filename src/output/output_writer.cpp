@@ -1,10 +1,304 @@
 #include "output_writer.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+namespace
+{
+    // same limits as nlohmann::json's float serialisation,
+    // outside of which numbers are written in scientific notation
+    constexpr int min_exp = -4;
+    constexpr int max_exp = std::numeric_limits<double>::digits10;
+
+    void append_exponent(std::string& out, int e)
+    {
+        out.push_back(e < 0 ? '-' : '+');
+        e = std::abs(e);
+        // always write at least two digits
+        if (e < 10)
+            out.push_back('0');
+        char buf[4];
+        auto [ptr, ec] = std::to_chars(std::begin(buf), std::end(buf), e);
+        assert(ec == std::errc{});
+        out.append(buf, ptr);
+    }
+
+    // the shortest digits which round-trip are formatted like nlohmann::json does,
+    // i.e., as digits[000].0, dig.its, 0.[000]digits or d.igitse+XX
+    void append_double(std::string& out, double x)
+    {
+        if (!std::isfinite(x))
+        {
+            out.append("null");
+            return;
+        }
+        if (std::signbit(x))
+        {
+            out.push_back('-');
+            x = -x;
+        }
+        if (x == 0)
+        {
+            out.append("0.0");
+            return;
+        }
+
+        char sci[32];
+        auto [end, ec] = std::to_chars(std::begin(sci), std::end(sci), x,
+            std::chars_format::scientific);
+        assert(ec == std::errc{});
+        char* e = std::find(sci, end, 'e');
+        std::string digits;
+        digits.push_back(sci[0]);
+        if (sci + 1 != e)
+            digits.append(sci + 2, e);
+        int exponent = 0;
+        std::from_chars(e[1] == '+' ? e + 2 : e + 1, end, exponent);
+
+        const int k = static_cast<int>(digits.size());
+        const int n = exponent + 1;
+        if (k <= n && n <= max_exp)
+        {
+            out.append(digits);
+            out.append(n - k, '0');
+            out.append(".0");
+        }
+        else if (0 < n && n <= max_exp)
+        {
+            out.append(digits, 0, n);
+            out.push_back('.');
+            out.append(digits, n, std::string::npos);
+        }
+        else if (min_exp < n && n <= 0)
+        {
+            out.append("0.");
+            out.append(-n, '0');
+            out.append(digits);
+        }
+        else
+        {
+            out.push_back(digits[0]);
+            if (k > 1)
+            {
+                out.push_back('.');
+                out.append(digits, 1, std::string::npos);
+            }
+            out.push_back('e');
+            append_exponent(out, n - 1);
+        }
+    }
+
+    void append_escaped(std::string& out, std::string_view str)
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+        out.push_back('"');
+        for (char c : str)
+        {
+            switch (c)
+            {
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '\b':
+                out.append("\\b");
+                break;
+            case '\f':
+                out.append("\\f");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            case '\r':
+                out.append("\\r");
+                break;
+            case '\t':
+                out.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) <= 0x1f)
+                {
+                    out.append("\\u00");
+                    out.push_back(hex[(c >> 4) & 0xf]);
+                    out.push_back(hex[c & 0xf]);
+                }
+                else
+                    out.push_back(c);
+            }
+        }
+        out.push_back('"');
+    }
+}
+
 namespace tep
 {
-    std::ostream& operator<<(std::ostream& os, const output_writer& x)
+    output_writer::output_writer(std::ostream& os) :
+        _os(os),
+        _after_key(false)
+    {
+        _buffer.reserve(buffer_size);
+    }
+
+    output_writer::~output_writer()
+    {
+        flush();
+    }
+
+    void output_writer::flush()
+    {
+        _os.write(_buffer.data(), _buffer.size());
+        _buffer.clear();
+    }
+
+    void output_writer::separate()
+    {
+        if (_after_key)
+            _after_key = false;
+        else if (!_first.empty())
+        {
+            if (!_first.back())
+                _buffer.push_back(',');
+            _first.back() = false;
+        }
+        if (_buffer.size() >= buffer_size)
+            flush();
+    }
+
+    void output_writer::append(std::string_view x)
+    {
+        separate();
+        _buffer.append(x);
+    }
+
+    output_writer& output_writer::begin_object()
+    {
+        append("{");
+        _first.push_back(true);
+        return *this;
+    }
+
+    output_writer& output_writer::end_object()
+    {
+        assert(!_first.empty() && !_after_key);
+        _first.pop_back();
+        _buffer.push_back('}');
+        return *this;
+    }
+
+    output_writer& output_writer::begin_array()
+    {
+        append("[");
+        _first.push_back(true);
+        return *this;
+    }
+
+    output_writer& output_writer::end_array()
+    {
+        assert(!_first.empty() && !_after_key);
+        _first.pop_back();
+        _buffer.push_back(']');
+        return *this;
+    }
+
+    output_writer& output_writer::begin_elements()
+    {
+        _first.push_back(true);
+        return *this;
+    }
+
+    output_writer& output_writer::end_elements()
+    {
+        assert(!_first.empty() && !_after_key);
+        _first.pop_back();
+        return *this;
+    }
+
+    output_writer& output_writer::key(std::string_view k)
+    {
+        assert(!_after_key);
+        separate();
+        append_escaped(_buffer, k);
+        _buffer.push_back(':');
+        _after_key = true;
+        return *this;
+    }
+
+    output_writer& output_writer::null()
+    {
+        append("null");
+        return *this;
+    }
+
+    output_writer& output_writer::value(bool x)
+    {
+        append(x ? "true" : "false");
+        return *this;
+    }
+
+    output_writer& output_writer::value(double x)
+    {
+        separate();
+        append_double(_buffer, x);
+        return *this;
+    }
+
+    output_writer& output_writer::value(std::string_view x)
+    {
+        separate();
+        append_escaped(_buffer, x);
+        return *this;
+    }
+
+    output_writer& output_writer::value(const char* x)
+    {
+        return value(std::string_view(x));
+    }
+
+    output_writer& output_writer::value(const std::string& x)
+    {
+        return value(std::string_view(x));
+    }
+
+    output_writer& output_writer::value(const std::optional<std::string>& x)
+    {
+        if (x)
+            return value(std::string_view(*x));
+        return null();
+    }
+
+    output_writer& output_writer::value(const nlohmann::json& x)
+    {
+        append(x.dump());
+        return *this;
+    }
+
+    output_writer& output_writer::raw(std::string_view x)
+    {
+        append(x);
+        return *this;
+    }
+
+    output_writer& output_writer::value_integer(int64_t x)
+    {
+        char buf[24];
+        auto [ptr, ec] = std::to_chars(std::begin(buf), std::end(buf), x);
+        assert(ec == std::errc{});
+        append(std::string_view(buf, ptr - buf));
+        return *this;
+    }
+
+    output_writer& output_writer::value_integer(uint64_t x)
     {
-        os << x.json;
-        return os;
+        char buf[24];
+        auto [ptr, ec] = std::to_chars(std::begin(buf), std::end(buf), x);
+        assert(ec == std::errc{});
+        append(std::string_view(buf, ptr - buf));
+        return *this;
     }
 } // namespace tep
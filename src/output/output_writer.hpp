@@ -4,14 +4,75 @@
 
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
 namespace tep
 {
+    // writes a JSON document to a stream as it is produced, instead of
+    // building the whole document in memory first;
+    // the output is the same as the compact serialisation of nlohmann::json,
+    // which sorts object keys, so keys must be written in lexicographic order
     struct output_writer
     {
-        nlohmann::json json;
+    public:
+        explicit output_writer(std::ostream& os);
+        ~output_writer();
 
-        output_writer() = default;
         output_writer(const output_writer&) = delete;
         output_writer& operator=(const output_writer&) = delete;
+
+        output_writer& begin_object();
+        output_writer& end_object();
+        output_writer& begin_array();
+        output_writer& end_array();
+        output_writer& key(std::string_view);
+        // elements of an array which is opened and closed by another writer,
+        // e.g., a chunk of the array written in parallel, which is then written with raw
+        output_writer& begin_elements();
+        output_writer& end_elements();
+
+        output_writer& null();
+        output_writer& value(bool);
+        output_writer& value(double);
+        output_writer& value(std::string_view);
+        output_writer& value(const char*);
+        output_writer& value(const std::string&);
+        output_writer& value(const std::optional<std::string>&);
+        // small values which are already built, e.g., trap contexts
+        output_writer& value(const nlohmann::json&);
+        // a value which is already serialised
+        output_writer& raw(std::string_view);
+
+        template<typename T>
+        std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, output_writer&>
+            value(T x)
+        {
+            if constexpr (std::is_signed_v<T>)
+                return value_integer(static_cast<int64_t>(x));
+            else
+                return value_integer(static_cast<uint64_t>(x));
+        }
+
+        void flush();
+
+    private:
+        static constexpr size_t buffer_size = 1 << 16;
+
+        std::ostream& _os;
+        std::string _buffer;
+        // whether the next element of each open container is its first
+        std::vector<bool> _first;
+        bool _after_key;
+
+        output_writer& value_integer(int64_t);
+        output_writer& value_integer(uint64_t);
+
+        void separate();
+        void append(std::string_view);
     };
 } // namespace tep
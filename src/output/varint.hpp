@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tep
+{
+    // LEB128 variable length integers, 7 bits per byte and the high bit set
+    // on every byte but the last, so that small values take a single byte;
+    // signed values are zig-zag encoded first, so that small negative values are small too
+    namespace varint
+    {
+        // the size of the encoding of the largest 64-bit value
+        constexpr size_t max_size = 10;
+
+        constexpr uint64_t zigzag(int64_t x) noexcept
+        {
+            return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63);
+        }
+
+        constexpr int64_t unzigzag(uint64_t x) noexcept
+        {
+            return static_cast<int64_t>(x >> 1) ^ -static_cast<int64_t>(x & 1);
+        }
+
+        inline void put(std::vector<uint8_t>& into, uint64_t x)
+        {
+            while (x >= 0x80)
+            {
+                into.push_back(static_cast<uint8_t>(x) | 0x80);
+                x >>= 7;
+            }
+            into.push_back(static_cast<uint8_t>(x));
+        }
+
+        // the difference to <prev>, wrapping around, so that counters which overflow
+        // between two values are encoded as small values as well
+        inline void put_delta(std::vector<uint8_t>& into, uint64_t x, uint64_t prev)
+        {
+            put(into, zigzag(static_cast<int64_t>(x - prev)));
+        }
+
+        // decodes the value at <it> and advances it,
+        // returns false if the value is truncated or too large
+        inline bool get(const uint8_t*& it, const uint8_t* end, uint64_t& x) noexcept
+        {
+            x = 0;
+            for (unsigned shift = 0; it != end && shift < 64; shift += 7)
+            {
+                uint8_t byte = *it++;
+                x |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return true;
+            }
+            return false;
+        }
+
+        inline bool get_delta(const uint8_t*& it, const uint8_t* end,
+            uint64_t& x, uint64_t prev) noexcept
+        {
+            uint64_t delta;
+            if (!get(it, end, delta))
+                return false;
+            x = prev + static_cast<uint64_t>(unzigzag(delta));
+            return true;
+        }
+    } // namespace varint
+} // namespace tep
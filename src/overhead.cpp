@@ -0,0 +1,216 @@
+// overhead.cpp
+
+#include "overhead.hpp"
+#include "config.hpp"
+#include "log.hpp"
+#include "sampler.hpp"
+
+#include <nrg/reader.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <thread>
+
+using namespace tep;
+
+namespace
+{
+    // the interval at which samples are kept when reading as fast as possible
+    constexpr std::chrono::milliseconds keep_period(10);
+    // the interval at which the sensors are read while idle, so that power readings
+    // are integrated; long, since the idle energy includes that of these reads
+    constexpr std::chrono::milliseconds idle_period(100);
+
+    sampler_expected read_idle(const nrgprf::reader& reader, std::chrono::milliseconds duration)
+    {
+        return async_sampler_fn(
+            std::make_unique<unbounded_ps>(&reader, duration / idle_period + 2, idle_period),
+            [duration]()
+            {
+                std::this_thread::sleep_for(duration);
+            }).run();
+    }
+
+    // reads on the calling thread until <duration> elapses, keeping a sample every keep_period
+    sampler_expected read_back_to_back(const nrgprf::reader& reader,
+        std::chrono::milliseconds duration, uint64_t& reads)
+    {
+        timed_execution exec;
+        exec.reserve(duration / keep_period + 2);
+        timed_sample smp;
+        auto read = [&reader, &smp, &reads](std::error_code& ec)
+        {
+            smp.timestamp = timed_sample::clock::now();
+            reads++;
+            return reader.read(smp, ec);
+        };
+
+        std::error_code ec;
+        if (!read(ec))
+            return sampler_expected(nonstd::unexpect, ec);
+        exec.push_back(smp);
+        auto end = exec.front().timestamp + duration;
+        while (smp.timestamp < end)
+        {
+            if (!read(ec))
+                return sampler_expected(nonstd::unexpect, ec);
+            if (smp.timestamp - exec.back().timestamp >= keep_period)
+                exec.push_back(smp);
+        }
+        if (exec.back() != smp)
+            exec.push_back(smp);
+        return exec;
+    }
+
+    double seconds(const timed_execution& exec)
+    {
+        assert(!exec.empty());
+        return std::chrono::duration<double>(exec.back().timestamp - exec.front().timestamp).count();
+    }
+
+    const sensor_energy* find_sensor(const std::vector<sensor_energy>& energy,
+        const sensor_energy& sensor)
+    {
+        auto it = std::find_if(energy.begin(), energy.end(),
+            [&sensor](const sensor_energy& e)
+            {
+                return e.target == sensor.target && e.id == sensor.id &&
+                    e.location == sensor.location;
+            });
+        return it == energy.end() ? nullptr : &*it;
+    }
+}
+
+std::string_view tep::to_string(sampling_mode mode)
+{
+    switch (mode)
+    {
+    case sampling_mode::short_section:
+        return "short";
+    case sampling_mode::bounded:
+        return "bounded";
+    case sampling_mode::periodic:
+        return "periodic";
+    }
+    assert(false);
+    return "";
+}
+
+uint64_t read_overhead::reads_during(const timed_execution& exec) const
+{
+    switch (mode)
+    {
+    case sampling_mode::short_section:
+        return 2;
+    case sampling_mode::bounded:
+        // at the bounds and at the end of every period in between
+        if (exec.size() < 2)
+            return exec.size();
+        return 2 + (exec.back().timestamp - exec.front().timestamp) / period;
+    case sampling_mode::periodic:
+        return exec.size();
+    }
+    assert(false);
+    return 0;
+}
+
+void read_overhead::correct(const timed_execution& exec, std::vector<sensor_energy>& energy) const
+{
+    uint64_t count = reads_during(exec);
+    for (auto& e : energy)
+        if (const sensor_energy* cost = find_sensor(this->energy, e))
+            e.energy -= count * cost->energy;
+}
+
+std::pair<sampling_mode, std::chrono::milliseconds> tep::sampling_of(const cfg::section_t& sec)
+{
+    const cfg::misc_attributes_t& misc = sec.misc;
+    if (misc.holds<cfg::method_profile_t>())
+        return { sampling_mode::periodic, misc.get<cfg::method_profile_t>().interval };
+    bool short_section = misc.holds<cfg::method_total_t>() ?
+        misc.get<cfg::method_total_t>().short_section :
+        misc.get<cfg::method_stats_t>().short_section;
+    if (short_section)
+        return { sampling_mode::short_section, std::chrono::milliseconds::zero() };
+    return { sampling_mode::bounded, bounded_ps::default_period };
+}
+
+nonstd::expected<std::vector<read_overhead>, std::error_code> tep::calibrate_overhead(
+    const nrgprf::reader& reader,
+    const readings_output& rout,
+    const std::vector<std::pair<sampling_mode, std::chrono::milliseconds>>& modes,
+    std::chrono::milliseconds duration)
+{
+    using rettype = nonstd::expected<std::vector<read_overhead>, std::error_code>;
+    auto error = [](const char* what, std::error_code ec)
+    {
+        TEP_LOG(log::error, "error reading %s during calibration: %s",
+            what, ec.message().c_str());
+        return rettype(nonstd::unexpect, ec);
+    };
+
+    TEP_LOG(log::info, "calibrating the overhead of reads for %" PRId64 " ms...",
+        static_cast<int64_t>(duration.count()));
+    sampler_expected idle = read_idle(reader, duration);
+    if (!idle)
+        return error("idle sensors", idle.error());
+    std::vector<sensor_energy> idle_energy;
+    rout.energy(*idle, idle_energy);
+    double idle_time = seconds(*idle);
+    uint64_t idle_reads = idle->size();
+
+    // the energy of the reads is whatever was consumed on top of the idle energy,
+    // which itself includes the energy of the idle reads, as many as idle_reads
+    // over the same time, so that only the reads beyond those are counted
+    auto energy_per_read = [&](const timed_execution& exec, uint64_t reads)
+    {
+        std::vector<sensor_energy> retval;
+        rout.energy(exec, retval);
+        double time = seconds(exec);
+        double scale = idle_time > 0 ? time / idle_time : 0;
+        for (auto& e : retval)
+        {
+            const sensor_energy* idle_e = find_sensor(idle_energy, e);
+            double extra = e.energy;
+            double extra_reads = reads;
+            if (idle_e && scale > 0)
+            {
+                extra -= idle_e->energy * scale;
+                extra_reads -= idle_reads * scale;
+            }
+            e.energy = extra_reads > 0 ? std::max(0.0, extra) / extra_reads : 0;
+        }
+        return retval;
+    };
+
+    uint64_t b2b_reads = 0;
+    sampler_expected b2b = read_back_to_back(reader, duration, b2b_reads);
+    if (!b2b)
+        return error("sensors", b2b.error());
+    timed_sample::duration read_time = (b2b->back().timestamp - b2b->front().timestamp) / b2b_reads;
+    std::vector<sensor_energy> b2b_energy = energy_per_read(*b2b, b2b_reads);
+
+    std::vector<read_overhead> retval;
+    for (auto [mode, period] : modes)
+    {
+        auto& ovh = retval.emplace_back(read_overhead{ mode, period, read_time, b2b_reads, b2b_energy });
+        // the reads of longer periods are not more than those while idle,
+        // so they are assumed to take the energy of the reads back to back
+        if (mode != sampling_mode::periodic || period >= idle_period || period >= duration)
+            continue;
+        sampler_expected exec = async_sampler_fn(
+            std::make_unique<unbounded_ps>(&reader, duration / period + 2, period),
+            [duration]()
+            {
+                std::this_thread::sleep_for(duration);
+            }).run();
+        if (!exec)
+            return error("sensors", exec.error());
+        ovh.reads = exec->size();
+        ovh.energy = energy_per_read(*exec, ovh.reads);
+    }
+    TEP_LOG(log::success, "calibrated the overhead of reads: %" PRId64 " ns per read",
+        static_cast<int64_t>(read_time.count()));
+    return retval;
+}
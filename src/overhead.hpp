@@ -0,0 +1,73 @@
+// overhead.hpp
+
+#pragma once
+
+#include "output.hpp"
+#include "timed_sample.hpp"
+
+#include <nonstd/expected.hpp>
+
+#include <chrono>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace nrgprf
+{
+    class reader;
+}
+
+namespace tep
+{
+    namespace cfg
+    {
+        struct section_t;
+    }
+
+    // how the sampler of a section reads: twice on the tracer thread for short sections,
+    // at the bounds and every period otherwise, every period being stored when profiling
+    enum class sampling_mode
+    {
+        short_section,
+        bounded,
+        periodic,
+    };
+
+    std::string_view to_string(sampling_mode);
+
+    // the cost of every read of a reader by a sampler, measured before the target runs,
+    // which is subtracted from the energy of the executions of the sections sampled that way
+    struct read_overhead
+    {
+        sampling_mode mode;
+        // the period of bounded and periodic samplers
+        std::chrono::milliseconds period;
+        // mean time of a read, on the calling thread
+        timed_sample::duration read_time;
+        // the reads during the calibration
+        uint64_t reads;
+        // the energy of every read, in joules, of every sensor of the reader
+        std::vector<sensor_energy> energy;
+
+        // the reads of the sampler during an execution
+        uint64_t reads_during(const timed_execution&) const;
+        // subtracts the energy of the reads during <exec> from its energy
+        void correct(const timed_execution& exec, std::vector<sensor_energy>& energy) const;
+    };
+
+    // the sampling mode and period of the sampler of a section
+    std::pair<sampling_mode, std::chrono::milliseconds> sampling_of(const cfg::section_t&);
+
+    // calibrates the overhead of reading <reader> in every sampling mode of <modes>:
+    // the sensors are read for <duration> while idle, as fast as possible,
+    // like short sections and bounded samplers do, whose period is longer than any calibration,
+    // and every period, like periodic samplers do; the energy of a read is the energy
+    // consumed on top of the idle energy over the reads, negative differences, i.e.,
+    // of reads cheaper than the noise of the sensors, being rounded to 0
+    nonstd::expected<std::vector<read_overhead>, std::error_code> calibrate_overhead(
+        const nrgprf::reader& reader,
+        const readings_output& rout,
+        const std::vector<std::pair<sampling_mode, std::chrono::milliseconds>>& modes,
+        std::chrono::milliseconds duration);
+}
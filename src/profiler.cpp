@@ -1,6 +1,7 @@
 // profiler.cpp
 #include "profiler.hpp"
 #include "error.hpp"
+#include "idle_baseline.hpp"
 #include "ptrace_wrapper.hpp"
 #include "util.hpp"
 #include "log.hpp"
@@ -8,6 +9,7 @@
 #include "registers.hpp"
 #include "ptrace_misc.hpp"
 #include "trap_types.hpp"
+#include "dbg/error.hpp"
 #include "dbg/utility_funcs.hpp"
 
 #include <util/concat.hpp>
@@ -22,7 +24,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <future>
+#include <map>
+#include <regex>
 #include <sstream>
+#include <unordered_set>
 #include <utility>
 
 using namespace tep;
@@ -34,7 +40,7 @@ namespace
     tracer_error generic_error(pid_t tid, const char* comment, std::error_code ec)
     {
         auto msg = ec.message();
-        log::logline(log::error, "[%d] %s: %s", tid, comment, msg.c_str());
+        TEP_LOG(log::error, "[%d] %s: %s", tid, comment, msg.c_str());
         return tracer_error(tracer_errcode::NO_SYMBOL, std::move(msg));
     }
 
@@ -67,9 +73,13 @@ namespace
         const nrgprf::reader* reader = readers.find(section.targets);
         const cfg::misc_attributes_t& misc = section.misc;
         assert(reader != nullptr);
-        if (misc.holds<cfg::method_total_t>())
+        // statistics only need the readings at the bounds of the section, like the total
+        if (misc.holds<cfg::method_total_t>() || misc.holds<cfg::method_stats_t>())
         {
-            if (misc.get<cfg::method_total_t>().short_section)
+            bool short_section = misc.holds<cfg::method_total_t>() ?
+                misc.get<cfg::method_total_t>().short_section :
+                misc.get<cfg::method_stats_t>().short_section;
+            if (short_section)
             {
                 return [reader]()
                 {
@@ -151,20 +161,20 @@ namespace
         return holder;
     }
 
-    tracer_error sample_idle(const char* target, const nrgprf::reader* reader, timed_execution& into)
+    tracer_error sample_idle(const char* target, const nrgprf::reader* reader,
+        std::chrono::milliseconds duration, timed_execution& into)
     {
         assert(target);
         assert(reader);
-        constexpr static const std::chrono::milliseconds default_sleep(5000);
         constexpr static const std::chrono::milliseconds default_period(40);
-        constexpr static const size_t initial_size = default_sleep / default_period + 100;
+        const size_t initial_size = duration / default_period + 100;
 
-        auto sleep_func = []()
+        auto sleep_func = [duration]()
         {
-            log::logline(log::info, "sleeping for %lu milliseconds", default_sleep.count());
-            std::this_thread::sleep_for(default_sleep);
+            TEP_LOG(log::info, "sleeping for %lu milliseconds", duration.count());
+            std::this_thread::sleep_for(duration);
         };
-        log::logline(log::info, "gathering idle readings for %s...", target);
+        TEP_LOG(log::info, "gathering idle readings for %s...", target);
 
         // reserve enough initially in order to avoid future allocations
         auto results = async_sampler_fn(
@@ -172,16 +182,85 @@ namespace
             .run();
         if (!results)
         {
-            log::logline(log::error, "unsuccessfuly gathered %s idle readings: %s", target,
+            TEP_LOG(log::error, "unsuccessfuly gathered %s idle readings: %s", target,
                 results.error().message().c_str());
             return { tracer_errcode::READER_ERROR, results.error().message() };
         }
-        log::logline(log::success, "successfuly gathered %s idle readings", target);
+        TEP_LOG(log::success, "successfuly gathered %s idle readings", target);
         into = std::move(*results);
         into.shrink_to_fit();
         return tracer_error::success();
     }
 
+    // the CPU and GPU readings are gathered at the same time, by different readers
+    tracer_error sample_idle(const reader_container& readers, bool cpu, bool gpu,
+        std::chrono::milliseconds duration, idle_readings& into)
+    {
+        std::future<tracer_error> cpu_result;
+        std::future<tracer_error> gpu_result;
+        if (cpu)
+            cpu_result = std::async(std::launch::async, [&]()
+                {
+                    return sample_idle("CPU", &readers.reader_rapl(), duration, into.cpu.emplace());
+                });
+        if (gpu)
+            gpu_result = std::async(std::launch::async, [&]()
+                {
+                    return sample_idle("GPU", &readers.reader_gpu(), duration, into.gpu.emplace());
+                });
+        tracer_error cpu_error = cpu ? cpu_result.get() : tracer_error::success();
+        tracer_error gpu_error = gpu ? gpu_result.get() : tracer_error::success();
+        if (cpu_error)
+            return cpu_error;
+        return gpu_error;
+    }
+
+    bool has_section(const cfg::config_t& c, cfg::target t)
+    {
+        for (const auto& g : c.groups())
+            for (const auto& s : g.sections)
+                if (cfg::target_valid(s.targets & t))
+                    return true;
+        return false;
+    }
+
+    // an inlined instance can only be profiled if its code is a single non-empty range
+    std::pair<bool, dbg::contiguous_range> can_profile_instance(const dbg::inline_instance& i)
+    {
+        auto pred = [](dbg::contiguous_range rng)
+        {
+            return (rng.high_pc - rng.low_pc) > 0;
+        };
+
+        auto end = i.addresses.values.end();
+        auto it = std::find_if(i.addresses.values.begin(), end, pred);
+        if (it == end)
+            return { false, {} };
+        if (end != std::find_if(it + 1, end, pred))
+            return { false, {} };
+        return { true, *it };
+    }
+
+    // contexts of traps in modules also identify the module
+    template<typename T>
+    trap_context make_context(T x, const loaded_module* module)
+    {
+        if (module)
+            return trap_context{ in_module<T>{ std::move(x), module } };
+        return trap_context{ std::move(x) };
+    }
+
+    // the module which defines the code of a section, if not the executable
+    const std::optional<std::string>& section_module(const cfg::section_t& sec)
+    {
+        static const std::optional<std::string> executable;
+        if (sec.bounds.holds<cfg::function_t>())
+            return sec.bounds.get<cfg::function_t>().module;
+        if (sec.bounds.holds<cfg::function_pattern_t>())
+            return sec.bounds.get<cfg::function_pattern_t>().module;
+        return executable;
+    }
+
     template<typename Container, typename Func>
     typename Container::iterator find_or_insert_output(
         Container& cont,
@@ -211,6 +290,16 @@ bool profiler::output_mapping::insert(start_addr bounds,
     const reader_container& readers,
     const cfg::group_t& group,
     const cfg::section_t& sec)
+{
+    return insert(bounds, readers, group, sec, sec.label);
+}
+
+bool profiler::output_mapping::insert(start_addr bounds,
+    const reader_container& readers,
+    const cfg::group_t& group,
+    const cfg::section_t& sec,
+    std::optional<std::string_view> label,
+    std::shared_ptr<const read_overhead> overhead)
 {
     auto grp_it = find_or_insert_output(results.groups(), group.label,
         [&group]()
@@ -218,13 +307,15 @@ bool profiler::output_mapping::insert(start_addr bounds,
             return group_output{ group.label, group.extra };
         });
 
-    auto sec_it = find_or_insert_output(grp_it->sections(), sec.label,
-        [&sec, &readers]()
+    auto sec_it = find_or_insert_output(grp_it->sections(), label,
+        [&sec, &readers, label, &overhead]()
         {
             return section_output{
                 results_from_target(readers, sec.targets),
-                sec.label,
-                sec.extra
+                label,
+                sec.extra,
+                sec.misc.holds<cfg::method_stats_t>(),
+                std::move(overhead)
             };
         });
 
@@ -257,15 +348,56 @@ section_output* profiler::output_mapping::find(start_addr bounds)
     return &*sec_it;
 }
 
+bool profiler::insert_output(start_addr start,
+    const cfg::group_t& group,
+    const cfg::section_t& sec)
+{
+    return insert_output(start, group, sec, sec.label);
+}
+
+bool profiler::insert_output(start_addr start,
+    const cfg::group_t& group,
+    const cfg::section_t& sec,
+    std::optional<std::string_view> label)
+{
+    if (!_output.insert(start, _readers, group, sec, label, find_overhead(sec)))
+        return false;
+    // the tracer folds the executions of the section into its statistics
+    // or appends them to the journal, and publishes them to the telemetry
+    section_output* so = _output.find(start);
+    start_trap* strap = _traps.find(start);
+    assert(so && strap);
+    if (_telemetry)
+        strap->set_telemetry(std::make_shared<section_telemetry>(_telemetry,
+            telemetry_section{ group.label, so->label(), so->shared_readings_out() }));
+    if (so->stats())
+        strap->set_stats(so->stats());
+    if (_journal)
+    {
+        auto [distance_group, distance_sec] = _output.map.find(start)->second;
+        uint32_t group_idx = static_cast<uint32_t>(distance_group);
+        uint32_t sec_idx = static_cast<uint32_t>(distance_sec);
+        _journal->add_section(group_idx, sec_idx,
+            _output.results.groups()[group_idx], *so);
+        strap->set_journal(std::make_shared<section_journal>(
+            _journal, so->shared_readings_out(), so->overhead(), group_idx, sec_idx));
+    }
+    return true;
+}
+
 
 profiler::profiler(pid_t child, flags flags,
-    dbg::object_info dli, cfg::config_t cd) :
+    dbg::object_info dli, cfg::config_t cd,
+    std::shared_ptr<results_journal> journal,
+    std::shared_ptr<telemetry> tm) :
     _tid(gettid()),
     _child(child),
     _flags(std::move(flags)),
     _dli(std::move(dli)),
     _cd(std::move(cd)),
-    _readers(_flags, _cd)
+    _readers(_flags, _cd),
+    _journal(std::move(journal)),
+    _telemetry(std::move(tm))
 {}
 
 
@@ -299,16 +431,16 @@ tracer_error profiler::await_executable(const std::string& name) const
     assert(waited_pid == _child);
     if (WIFEXITED(wait_status))
     {
-        log::logline(log::error, "[%d] failed to run target in child %d",
+        TEP_LOG(log::error, "[%d] failed to run target in child %d",
             _tid, _child);
         return tracer_error(tracer_errcode::SIGNAL_DURING_SECTION_ERROR,
             "Child failed to run target");
     }
-    log::logline(log::info, "[%d] started the profiling procedure for child %d",
+    TEP_LOG(log::info, "[%d] started the profiling procedure for child %d",
         _tid, _child);
     if (!WIFSTOPPED(wait_status))
     {
-        log::logline(log::error, "[%d] ptrace(PTRACE_TRACEME, ...) "
+        TEP_LOG(log::error, "[%d] ptrace(PTRACE_TRACEME, ...) "
             "called but target was not stopped", _tid);
         return tracer_error(tracer_errcode::PTRACE_ERROR,
             "Tracee not stopped despite being attached with ptrace");
@@ -356,25 +488,25 @@ tracer_error profiler::await_executable(const std::string& name) const
             if (*filename == name)
             {
                 matched = true;
-                log::logline(log::success, "[%d] found matching execve: "
+                TEP_LOG(log::success, "[%d] found matching execve: "
                     "path=%s args=%s",
                     _tid, filename->c_str(), ::to_string(*args).c_str());
             }
             else
-                log::logline(log::success, "[%d] found execve: "
+                TEP_LOG(log::success, "[%d] found execve: "
                     "path=%s args=%s",
                     _tid, filename->c_str(), ::to_string(*args).c_str());
         }
         else if (WIFEXITED(wait_status))
         {
-            log::logline(log::error, "[%d] child %d exited with status %d",
+            TEP_LOG(log::error, "[%d] child %d exited with status %d",
                 _tid, _child, WEXITSTATUS(wait_status));
             return tracer_error(tracer_errcode::UNKNOWN_ERROR,
                 cmmn::concat("Child exited before executing ", name));
         }
         else if (WIFSIGNALED(wait_status))
         {
-            log::logline(log::error, "[%d] child %d signaled: %s",
+            TEP_LOG(log::error, "[%d] child %d signaled: %s",
                 _tid, _child, sig_str(WTERMSIG(wait_status)));
             return tracer_error(tracer_errcode::UNKNOWN_ERROR,
                 cmmn::concat("Child signaled before executing ", name));
@@ -411,15 +543,15 @@ tracer_expected<profiling_results> profiler::run()
     assert(waited_pid == _child);
     if (WIFEXITED(wait_status))
     {
-        log::logline(log::error, "[%d] failed to run target in child %d", _tid, waited_pid);
+        TEP_LOG(log::error, "[%d] failed to run target in child %d", _tid, waited_pid);
         return rettype(nonstd::unexpect,
             tracer_errcode::SIGNAL_DURING_SECTION_ERROR,
             "Child failed to run target");
     }
-    log::logline(log::info, "[%d] started the profiling procedure for child %d", _tid, waited_pid);
+    TEP_LOG(log::info, "[%d] started the profiling procedure for child %d", _tid, waited_pid);
     if (!WIFSTOPPED(wait_status))
     {
-        log::logline(log::error, "[%d] ptrace(PTRACE_TRACEME, ...) "
+        TEP_LOG(log::error, "[%d] ptrace(PTRACE_TRACEME, ...) "
             "called but target was not stopped", _tid);
         return rettype(nonstd::unexpect,
             tracer_errcode::PTRACE_ERROR,
@@ -427,8 +559,16 @@ tracer_expected<profiling_results> profiler::run()
     }
 
     if (_flags.obtain_idle)
+    {
         if (tracer_error err = obtain_idle_results())
             return rettype(nonstd::unexpect, std::move(err));
+        if (_journal)
+            for (size_t ix = 0; ix < _output.results.idle().size(); ix++)
+                _journal->append_idle(ix, _output.results.idle()[ix]);
+    }
+    if (_flags.calibration_duration.count())
+        if (tracer_error err = calibrate_readers())
+            return move_error(err);
     cpu_gp_regs regs(waited_pid);
     if (tracer_error err = regs.getregs())
         return move_error(err);
@@ -436,19 +576,19 @@ tracer_expected<profiling_results> profiler::run()
     switch (_dli.header().type)
     {
     case dbg::executable_type::shared_object:
-        log::logline(log::success, "[%d] target is a PIE", _tid);
+        TEP_LOG(log::success, "[%d] target is a PIE", _tid);
         if (get_entrypoint_addr(_child, entrypoint) == -1)
             return system_error(_tid, "get_entrypoint_addr");
         break;
     case dbg::executable_type::executable:
-        log::logline(log::success, "[%d] target is not a PIE", _tid);
+        TEP_LOG(log::success, "[%d] target is not a PIE", _tid);
         entrypoint = 0;
         break;
     default:
         assert(false);
     }
 
-    log::logline(log::info, "[%d] tracee %d rip @ 0x%" PRIxPTR ", entrypoint @ 0x%" PRIxPTR,
+    TEP_LOG(log::info, "[%d] tracee %d rip @ 0x%" PRIxPTR ", entrypoint @ 0x%" PRIxPTR,
         _tid, waited_pid, regs.get_ip(), entrypoint);
 
     int errnum;
@@ -458,17 +598,27 @@ tracer_expected<profiling_results> profiler::run()
         return rettype(nonstd::unexpect,
             get_syserror(errnum, tracer_errcode::PTRACE_ERROR, _tid, "PTRACE_SETOPTIONS"));
     }
-    log::logline(log::debug, "[%d] ptrace options successfully set", _tid);
+    TEP_LOG(log::debug, "[%d] ptrace options successfully set", _tid);
 
     // iterate the sections defined in the config and insert their respective breakpoints
+    code_object executable{ _child, entrypoint, _dli, nullptr };
     for (const auto& group : _cd.groups())
     {
         for (const auto& sec : group.sections)
         {
-            if (sec.bounds.holds<cfg::function_t>())
+            // the traps of sections in modules are inserted once the modules are loaded
+            if (section_module(sec))
+                _pending.emplace_back(&group, &sec);
+            else if (sec.bounds.holds<cfg::function_t>())
             {
                 if (tracer_error err = insert_traps_function(group, sec,
-                    sec.bounds.get<cfg::function_t>(), entrypoint))
+                    sec.bounds.get<cfg::function_t>(), executable))
+                    return move_error(err);
+            }
+            else if (sec.bounds.holds<cfg::function_pattern_t>())
+            {
+                if (tracer_error err = insert_traps_function_pattern(group, sec,
+                    sec.bounds.get<cfg::function_pattern_t>(), executable))
                     return move_error(err);
             }
             else if (sec.bounds.holds<cfg::bounds_t::position_range_t>())
@@ -496,21 +646,43 @@ tracer_expected<profiling_results> profiler::run()
         }
     }
 
+    if (!_pending.empty())
+        if (tracer_error err = insert_loader_trap())
+            return move_error(err);
+
     // first tracer has the same tracee tgid and tid, since there is only one tracee at this point
     tracer trc(_traps, _child, _child, entrypoint, std::launch::deferred);
     auto results = trc.results();
+    // the final statistics, so that the results can be rebuilt from the journal
+    if (_journal)
+    {
+        for (size_t g = 0; g < _output.results.groups().size(); g++)
+        {
+            const auto& sections = _output.results.groups()[g].sections();
+            for (size_t s = 0; s < sections.size(); s++)
+                if (sections[s].stats())
+                    _journal->append_stats(static_cast<uint32_t>(g), static_cast<uint32_t>(s),
+                        *sections[s].stats());
+        }
+        _journal->sync();
+    }
     if (!results)
         return move_error(results.error());
 
-    for (auto& [start, end, values] : *results)
+    for (const auto& sec : _pending)
+        TEP_LOG(log::warning, "[%d] module %s of section %s was never loaded",
+            _tid, section_module(*sec.second)->c_str(),
+            sec.second->label ? sec.second->label->c_str() : "<unlabelled>");
+
+    for (auto& [start, end, values, address] : *results)
     {
-        start_trap* strap = _traps.find(entrypoint + start.addr());
+        start_trap* strap = _traps.find(address);
         assert(strap);
         if (!strap)
             return rettype(nonstd::unexpect,
                 tracer_errcode::NO_TRAP,
                 "Registered start traps are malformed");
-        section_output* sec_out = _output.find(entrypoint + start.addr());
+        section_output* sec_out = _output.find(address);
         assert(sec_out);
         if (!sec_out)
             return rettype(nonstd::unexpect,
@@ -519,7 +691,7 @@ tracer_expected<profiling_results> profiler::run()
 
         if (!values)
         {
-            log::logline(log::error,
+            TEP_LOG(log::error,
                 "[%d] failed to gather results for section %s - %s: %s",
                 _tid,
                 to_string(start).c_str(),
@@ -528,7 +700,7 @@ tracer_expected<profiling_results> profiler::run()
         }
         else
         {
-            log::logline(log::success,
+            TEP_LOG(log::success,
                 "[%d] registered execution of section %s - %s as successful",
                 _tid,
                 to_string(start).c_str(),
@@ -543,44 +715,244 @@ tracer_expected<profiling_results> profiler::run()
 
 tracer_error profiler::obtain_idle_results()
 {
-    auto find_section = [](const cfg::config_t& c, cfg::target t)
-    {
-        for (const auto& g : c.groups())
-            for (const auto& s : g.sections)
-                if (cfg::target_valid(s.targets & t))
-                    return true;
-        return false;
-    };
-
-    bool cpu = find_section(_cd, cfg::target::cpu);
-    bool gpu = find_section(_cd, cfg::target::gpu);
+    bool cpu = has_section(_cd, cfg::target::cpu);
+    bool gpu = has_section(_cd, cfg::target::gpu);
 
     assert(cpu || gpu);
     if (!cpu && !gpu)
         return tracer_error(tracer_errcode::UNKNOWN_ERROR, "no CPU or GPU sections found");
-    if (timed_execution into; cpu)
+
+    idle_baseline baseline;
+    std::string key;
+    std::optional<idle_baseline> cached;
+    if (!_flags.idle_baseline.empty())
+    {
+        key = idle_baseline_key(_flags, _readers, cpu, gpu);
+        cached = load_idle_baseline(_flags.idle_baseline, key);
+    }
+    if (cached && (!cached->expired(_flags.idle_expiry) || _flags.idle_refresh))
+    {
+        TEP_LOG(log::success, "reusing idle readings of baseline '%s'",
+            _flags.idle_baseline.c_str());
+        if (cached->expired(_flags.idle_expiry))
+        {
+            TEP_LOG(log::info, "idle baseline '%s' expired, "
+                "gathering it again once the results are written", _flags.idle_baseline.c_str());
+            _idle_refresh = std::move(key);
+        }
+        baseline = *std::move(cached);
+    }
+    else
     {
-        if (tracer_error err = sample_idle("CPU", &_readers.reader_rapl(), into))
+        if (tracer_error err = sample_idle(_readers, cpu, gpu, _flags.idle_duration,
+            baseline.readings))
+        {
             return err;
+        }
+        baseline.created = std::chrono::system_clock::now();
+        if (!_flags.idle_baseline.empty())
+            save_idle_baseline(_flags.idle_baseline, key, baseline);
+    }
+
+    if (baseline.readings.cpu)
+        _output.results.idle().emplace_back(
+            std::make_unique<readings_output_cpu>(_readers.reader_rapl()),
+            *std::move(baseline.readings.cpu));
+    if (baseline.readings.gpu)
         _output.results.idle().emplace_back(
-            std::make_unique<readings_output_cpu>(_readers.reader_rapl()), std::move(into));
+            std::make_unique<readings_output_gpu>(_readers.reader_gpu()),
+            *std::move(baseline.readings.gpu));
+    return tracer_error::success();
+}
+
+void profiler::refresh_idle_baseline()
+{
+    if (!_idle_refresh)
+        return;
+    TEP_LOG(log::info, "gathering idle baseline '%s' again", _flags.idle_baseline.c_str());
+    idle_baseline baseline;
+    if (sample_idle(_readers,
+        has_section(_cd, cfg::target::cpu),
+        has_section(_cd, cfg::target::gpu),
+        _flags.idle_duration,
+        baseline.readings))
+    {
+        return;
+    }
+    baseline.created = std::chrono::system_clock::now();
+    save_idle_baseline(_flags.idle_baseline, *_idle_refresh, baseline);
+    _idle_refresh.reset();
+}
+
+
+tracer_error profiler::calibrate_readers()
+{
+    // the sampling modes of the sections of every combination of targets
+    std::map<cfg::target, std::vector<std::pair<sampling_mode, std::chrono::milliseconds>>> modes;
+    for (const auto& group : _cd.groups())
+    {
+        for (const auto& sec : group.sections)
+        {
+            auto& target_modes = modes[sec.targets];
+            auto mode = sampling_of(sec);
+            if (std::find(target_modes.begin(), target_modes.end(), mode) == target_modes.end())
+                target_modes.push_back(mode);
+        }
+    }
+
+    for (const auto& [targets, target_modes] : modes)
+    {
+        const nrgprf::reader* reader = _readers.find(targets);
+        assert(reader);
+        auto overheads = calibrate_overhead(*reader, *results_from_target(_readers, targets),
+            target_modes, _flags.calibration_duration);
+        if (!overheads)
+            return { tracer_errcode::READER_ERROR, overheads.error().message() };
+        for (auto& ovh : *overheads)
+        {
+            overhead_key key{ targets, ovh.mode, ovh.period };
+            _overheads.emplace(std::move(key), std::make_shared<const read_overhead>(std::move(ovh)));
+        }
+    }
+    return tracer_error::success();
+}
+
+std::shared_ptr<const read_overhead> profiler::find_overhead(const cfg::section_t& sec) const
+{
+    auto [mode, period] = sampling_of(sec);
+    auto it = _overheads.find({ sec.targets, mode, period });
+    return it == _overheads.end() ? nullptr : it->second;
+}
+
+
+tracer_error profiler::insert_loader_trap()
+{
+    // the dynamic loader calls _dl_debug_state before and after it changes
+    // the list of loaded objects, so that debuggers can track them
+    static constexpr const char loader_hook[] = "_dl_debug_state";
+
+    auto base = get_interpreter_base(_child);
+    if (!base)
+        return std::move(base.error());
+    if (!*base)
+    {
+        TEP_LOG(log::error, "[%d] target is statically linked and cannot load modules", _tid);
+        return tracer_error(tracer_errcode::UNSUPPORTED,
+            "Sections in modules require a dynamically linked target");
+    }
+    auto objects = get_mapped_objects(_child);
+    if (!objects)
+        return std::move(objects.error());
+    auto loader = std::find_if(objects->begin(), objects->end(),
+        [base = *base](const mapped_object& obj)
+        {
+            return obj.base == base;
+        });
+    if (loader == objects->end())
+        return tracer_error(tracer_errcode::NO_SYMBOL, "Dynamic loader not found");
+
+    std::optional<uintptr_t> hook;
+    try
+    {
+        hook = dbg::find_symbol_address(loader->path.native(), loader_hook);
+    }
+    catch (const dbg::exception& e)
+    {
+        return generic_error(_tid, __func__, e.code());
+    }
+    if (!hook)
+    {
+        TEP_LOG(log::error, "[%d] symbol %s not found in dynamic loader %s",
+            _tid, loader_hook, loader->path.c_str());
+        return tracer_error(tracer_errcode::NO_SYMBOL,
+            cmmn::concat("Dynamic loader symbol ", loader_hook, " not found"));
     }
-    if (timed_execution into; gpu)
+
+    uintptr_t addr = loader->base + *hook;
+    tracer_expected<long> origw = insert_trap(_child, addr);
+    if (!origw)
+        return std::move(origw.error());
+    _traps.insert(loader_trap(*origw, addr,
+        [this](pid_t tid)
+        {
+            return load_modules(tid);
+        }));
+    TEP_LOG(log::info, "[%d] inserted trap at dynamic loader %s %s @ 0x%" PRIxPTR,
+        _tid, loader->path.c_str(), loader_hook, addr);
+
+    // some modules may have been mapped already
+    return load_modules(_child);
+}
+
+tracer_error profiler::load_modules(pid_t tid)
+{
+    auto objects = get_mapped_objects(tid);
+    if (!objects)
+        return std::move(objects.error());
+    for (auto it = _pending.begin(); it != _pending.end(); )
     {
-        if (tracer_error err = sample_idle("GPU", &_readers.reader_gpu(), into))
+        const auto& [group, sec] = *it;
+        const std::string& name = *section_module(*sec);
+        auto obj = std::find_if(objects->begin(), objects->end(),
+            [&name](const mapped_object& obj)
+            {
+                return module_matches(obj, name);
+            });
+        if (obj == objects->end())
+        {
+            ++it;
+            continue;
+        }
+        auto module = load_module(name, *obj);
+        if (!module)
+            return std::move(module.error());
+
+        code_object code{ tid, (*module)->object.base, (*module)->info, *module };
+        tracer_error err = sec->bounds.holds<cfg::function_t>() ?
+            insert_traps_function(*group, *sec, sec->bounds.get<cfg::function_t>(), code) :
+            insert_traps_function_pattern(*group, *sec,
+                sec->bounds.get<cfg::function_pattern_t>(), code);
+        if (err)
             return err;
-        _output.results.idle().emplace_back(
-            std::make_unique<readings_output_gpu>(_readers.reader_gpu()), std::move(into));
+        it = _pending.erase(it);
     }
     return tracer_error::success();
 }
 
+tracer_expected<const loaded_module*> profiler::load_module(
+    const std::string& name, const mapped_object& obj)
+{
+    using rettype = tracer_expected<const loaded_module*>;
+    auto it = std::find_if(_modules.begin(), _modules.end(),
+        [&obj](const std::unique_ptr<loaded_module>& mod)
+        {
+            return mod->object.path == obj.path && mod->object.base == obj.base;
+        });
+    if (it != _modules.end())
+        return it->get();
+
+    // only now that the module is mapped is its debug information needed
+    TEP_LOG(log::info, "[%d] loading module %s from %s @ 0x%" PRIxPTR,
+        _tid, name.c_str(), obj.path.c_str(), obj.base);
+    try
+    {
+        dbg::object_info info(obj.path.native(), _flags.debug_dir);
+        _modules.push_back(std::make_unique<loaded_module>(
+            loaded_module{ name, obj, std::move(info) }));
+    }
+    catch (const dbg::exception& e)
+    {
+        return rettype(nonstd::unexpect, generic_error(_tid, __func__, e.code()));
+    }
+    TEP_LOG(log::success, "[%d] loaded module %s", _tid, name.c_str());
+    return _modules.back().get();
+}
 
 tracer_error profiler::insert_traps_function(
     const cfg::group_t& group,
     const cfg::section_t& sec,
     const cfg::function_t& cfunc,
-    uintptr_t entrypoint)
+    const code_object& obj)
 {
     auto find_function = [&, this](const cfg::function_t& f) ->
         dbg::result<std::pair<const dbg::function*, const dbg::function_symbol*>>
@@ -588,13 +960,13 @@ tracer_error profiler::insert_traps_function(
         using unexpected = nonstd::unexpected<std::error_code>;
         if (f.compilation_unit)
         {
-            auto cu = dbg::find_compilation_unit(_dli, *f.compilation_unit);
+            auto cu = dbg::find_compilation_unit(obj.info, *f.compilation_unit);
             if (!cu)
                 return unexpected{ cu.error() };
-            return dbg::find_function(_dli, **cu, f.name,
+            return dbg::find_function(obj.info, **cu, f.name,
                 dbg::exact_symbol_name_flag::no);
         }
-        return dbg::find_function(_dli, f.name,
+        return dbg::find_function(obj.info, f.name,
             dbg::exact_symbol_name_flag::no);
     };
 
@@ -602,7 +974,7 @@ tracer_error profiler::insert_traps_function(
     if (!func_res)
         return generic_error(_tid, __func__, func_res.error());
 
-    log::logline(log::info,
+    TEP_LOG(log::info,
         "[%d] [%s] found matching function: %s declared at %s",
         _tid, __func__,
         func_res->first->die_name.c_str(),
@@ -614,89 +986,72 @@ tracer_error profiler::insert_traps_function(
     if (func_res->second)
     {
         assert(func_res->first->addresses);
-        log::logline(log::info, "[%d] [%s] symbol: %s",
+        TEP_LOG(log::info, "[%d] [%s] symbol: %s",
             _tid, __func__, func_res->second->name.c_str());
-        start_addr start = entrypoint + func_res->second->local_entrypoint();
-        tracer_expected<long> origw = insert_trap(_child, start.val());
+        start_addr start = obj.base + func_res->second->local_entrypoint();
+        tracer_expected<long> origw = insert_trap(obj.tracee, start.val());
         if (!origw)
             return std::move(origw.error());
-        auto cu = dbg::find_compilation_unit(_dli, *func_res->second);
+        auto cu = dbg::find_compilation_unit(obj.info, *func_res->second);
         auto insert_res = _traps.insert(
             start,
             start_trap(
                 *origw,
-                trap_context{ function_call{
+                make_context(function_call{
                     func_res->second->local_entrypoint(),
                     cu ? *cu : nullptr,
                     func_res->first,
                     func_res->second
-                } },
+                }, obj.module),
                 sec.allow_concurrency,
                 creator_from_section(_readers, sec)));
         if (!insert_res.second)
         {
-            log::logline(log::error,
+            TEP_LOG(log::error,
                 "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
-                _tid, start.val(), start.val() - entrypoint);
+                _tid, start.val(), start.val() - obj.base);
             return tracer_error(tracer_errcode::NO_TRAP,
                 cmmn::concat("Trap ", ::to_string(start), " already exists"));
         }
-        log::logline(log::info,
+        TEP_LOG(log::info,
             "[%d] inserted trap at function call address 0x%" PRIxPTR " (offset 0x%" PRIxPTR ")",
-            _tid, start.val(), start.val() - entrypoint);
-        if (!_output.insert(start, _readers, group, sec))
+            _tid, start.val(), start.val() - obj.base);
+        if (!insert_output(start, group, sec))
             return tracer_error(tracer_errcode::NO_TRAP,
                 "Trap address already exists");
         ++inserted_traps;
     }
     if (func_res->first->instances)
     {
-        auto can_profile_intance = [](const dbg::inline_instance& i)
-            -> std::pair<bool, dbg::contiguous_range>
-        {
-            auto pred = [](dbg::contiguous_range rng)
-            {
-                return (rng.high_pc - rng.low_pc) > 0;
-            };
-
-            auto end = i.addresses.values.end();
-            auto it = std::find_if(i.addresses.values.begin(), end, pred);
-            if (it == end)
-                return { false, {} };
-            if (end != std::find_if(it + 1, end, pred))
-                return { false, {} };
-            return { true, *it };
-        };
-
         auto insert = [&](auto addr, auto creator)
         {
-            auto offset = addr.val() - entrypoint;
-            tracer_expected<long> origw = insert_trap(_child, addr.val());
+            auto offset = addr.val() - obj.base;
+            tracer_expected<long> origw = insert_trap(obj.tracee, addr.val());
             if (!origw)
                 return std::move(origw.error());
-            auto cu = dbg::find_compilation_unit(_dli, offset);
+            auto cu = dbg::find_compilation_unit(obj.info, offset);
             auto insert_res = _traps.insert(addr, creator(*origw));
             if (!insert_res.second)
             {
-                log::logline(log::error,
+                TEP_LOG(log::error,
                     "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
-                    _tid, addr.val(), addr.val() - entrypoint);
+                    _tid, addr.val(), addr.val() - obj.base);
                 return tracer_error(tracer_errcode::NO_TRAP,
                     cmmn::concat("Trap ", ::to_string(addr), " already exists"));
             }
-            log::logline(log::info,
+            TEP_LOG(log::info,
                 "[%d] inserted trap at inlined instance 0x%" PRIxPTR " (offset 0x%" PRIxPTR ")",
-                _tid, addr.val(), addr.val() - entrypoint);
+                _tid, addr.val(), addr.val() - obj.base);
             return tracer_error::success();
         };
 
         for (const auto& inst : func_res->first->instances->insts)
         {
             assert(inst.entry_pc);
-            auto [can_profile, range_idx] = can_profile_intance(inst);
+            auto [can_profile, range_idx] = can_profile_instance(inst);
             if (!can_profile)
             {
-                log::logline(log::warning,
+                TEP_LOG(log::warning,
                     "[%d] [%s] unable to profile instance inlined at %s"
                     ": no or multiple contiguous ranges found",
                     _tid, __func__,
@@ -704,9 +1059,9 @@ tracer_error profiler::insert_traps_function(
                 continue;
             }
 
-            auto cu = dbg::find_compilation_unit(_dli, range_idx.low_pc);
-            start_addr start = entrypoint + range_idx.low_pc;
-            end_addr end = entrypoint + range_idx.high_pc;
+            auto cu = dbg::find_compilation_unit(obj.info, range_idx.low_pc);
+            start_addr start = obj.base + range_idx.low_pc;
+            end_addr end = obj.base + range_idx.high_pc;
             inline_function start_ctx{
                 range_idx.low_pc,
                 cu ? *cu : nullptr,
@@ -717,7 +1072,7 @@ tracer_error profiler::insert_traps_function(
                 range_idx.high_pc,
                 cu ? *cu : nullptr };
 
-            log::logline(log::info, "[%d] [%s] %s at %s",
+            TEP_LOG(log::info, "[%d] [%s] %s at %s",
                 _tid, __func__,
                 to_string(start_ctx).c_str(),
                 inst.call_loc ? ::to_string(*inst.call_loc).c_str() : "n/a");
@@ -726,7 +1081,7 @@ tracer_error profiler::insert_traps_function(
             {
                 return start_trap{
                     origw,
-                    trap_context{ start_ctx },
+                    make_context(start_ctx, obj.module),
                     sec.allow_concurrency,
                     creator_from_section(_readers, sec) };
             };
@@ -735,7 +1090,7 @@ tracer_error profiler::insert_traps_function(
             {
                 return end_trap{
                     origw,
-                    trap_context{ end_ctx },
+                    make_context(end_ctx, obj.module),
                     start };
             };
 
@@ -745,14 +1100,14 @@ tracer_error profiler::insert_traps_function(
             if (auto err = insert(end, end_creator))
                 return err;
             ++inserted_traps;
-            if (!_output.insert(start, _readers, group, sec))
+            if (!insert_output(start, group, sec))
                 return tracer_error(tracer_errcode::NO_TRAP,
                     "Trap address already exists");
         }
     }
     if (!inserted_traps)
     {
-        log::logline(log::error,
+        TEP_LOG(log::error,
             "[%d] [%s] unable to profile function %s declared at %s",
             _tid, __func__,
             func_res->first->die_name.c_str(),
@@ -764,6 +1119,203 @@ tracer_error profiler::insert_traps_function(
     return tracer_error::success();
 }
 
+tracer_error profiler::insert_traps_function_pattern(
+    const cfg::group_t& group,
+    const cfg::section_t& sec,
+    const cfg::function_pattern_t& cpattern,
+    const code_object& obj)
+{
+    struct planned_start
+    {
+        start_addr addr;
+        trap_context ctx;
+        const std::string* label;
+        const dbg::function* func;
+        const dbg::compilation_unit* cu;
+    };
+
+    struct planned_end
+    {
+        end_addr addr;
+        trap_context ctx;
+        start_addr start;
+    };
+
+    const dbg::compilation_unit* cu = nullptr;
+    if (cpattern.compilation_unit)
+    {
+        auto cu_res = dbg::find_compilation_unit(obj.info, *cpattern.compilation_unit);
+        if (!cu_res)
+            return generic_error(_tid, __func__, cu_res.error());
+        cu = *cu_res;
+    }
+    auto matches = dbg::find_functions(obj.info, std::regex(cpattern.regex()), cu);
+    if (!matches)
+        return generic_error(_tid, __func__, matches.error());
+    TEP_LOG(log::info, "[%d] [%s] pattern %s matched %zu function(s)",
+        _tid, __func__, ::to_string(cpattern).c_str(), matches->size());
+
+    // plan every trap first so that all of them are written to the tracee at once;
+    // the same code may be reached from more than one match, e.g., functions
+    // defined in headers, in which case the first match keeps the trap
+    std::vector<planned_start> starts;
+    std::vector<planned_end> ends;
+    std::unordered_set<uintptr_t> start_addrs;
+    std::unordered_set<uintptr_t> end_addrs;
+    for (const auto& match : *matches)
+    {
+        if (match.symbol)
+        {
+            start_addr start = obj.base + match.symbol->local_entrypoint();
+            if (start_addrs.insert(start.val()).second)
+            {
+                starts.push_back({
+                    start,
+                    make_context(function_call{
+                        match.symbol->local_entrypoint(),
+                        match.cu,
+                        match.func,
+                        match.symbol }, obj.module),
+                    &match.name,
+                    match.func,
+                    match.cu });
+            }
+        }
+        if (!match.func->instances)
+            continue;
+        for (const auto& inst : match.func->instances->insts)
+        {
+            auto [can_profile, range] = can_profile_instance(inst);
+            if (!can_profile)
+            {
+                TEP_LOG(log::warning,
+                    "[%d] [%s] unable to profile instance of %s inlined at %s"
+                    ": no or multiple contiguous ranges found",
+                    _tid, __func__, match.name.c_str(),
+                    inst.call_loc ? ::to_string(*inst.call_loc).c_str() : "n/a");
+                continue;
+            }
+            start_addr start = obj.base + range.low_pc;
+            end_addr end = obj.base + range.high_pc;
+            if (start_addrs.count(start.val()) || end_addrs.count(end.val()))
+            {
+                TEP_LOG(log::warning,
+                    "[%d] [%s] instance of %s inlined at %s shares its bounds "
+                    "with another instance, skipping",
+                    _tid, __func__, match.name.c_str(),
+                    inst.call_loc ? ::to_string(*inst.call_loc).c_str() : "n/a");
+                continue;
+            }
+            start_addrs.insert(start.val());
+            end_addrs.insert(end.val());
+            starts.push_back({
+                start,
+                make_context(inline_function{
+                    range.low_pc, match.cu, match.func, match.symbol, &inst }, obj.module),
+                &match.name,
+                match.func,
+                match.cu });
+            ends.push_back({
+                end,
+                make_context(address{ range.high_pc, match.cu }, obj.module),
+                start });
+        }
+    }
+    if (starts.empty())
+    {
+        TEP_LOG(log::error, "[%d] [%s] unable to profile any function matching %s",
+            _tid, __func__, ::to_string(cpattern).c_str());
+        return tracer_error(tracer_errcode::NO_TRAP, "Unable to profile any matching function");
+    }
+
+    std::vector<uintptr_t> addrs;
+    addrs.reserve(starts.size() + ends.size());
+    for (const auto& s : starts)
+        addrs.push_back(s.addr.val());
+    for (const auto& e : ends)
+        addrs.push_back(e.addr.val());
+    auto origwords = insert_traps(obj.tracee, addrs);
+    if (!origwords)
+        return std::move(origwords.error());
+    TEP_LOG(log::info, "[%d] [%s] inserted %zu trap(s) for pattern %s",
+        _tid, __func__, addrs.size(), ::to_string(cpattern).c_str());
+
+    // every start of a function has the same label, so that the function and its inlined
+    // instances are written to the same section; distinct functions with the same name,
+    // e.g., static functions of different compilation units, are told apart by their
+    // compilation unit and, if that is not enough, by the offset of their first start
+    std::vector<std::string> labels;
+    labels.reserve(starts.size());
+    {
+        struct function_label
+        {
+            std::string label;
+            uintptr_t first;
+        };
+        using function_key = std::pair<const dbg::function*, const dbg::compilation_unit*>;
+        std::map<function_key, function_label> functions;
+        std::unordered_map<std::string, size_t> count;
+        for (const auto& s : starts)
+        {
+            auto [it, inserted] = functions.insert({ { s.func, s.cu },
+                function_label{ *s.label, s.addr.val() - obj.base } });
+            if (inserted)
+                count[*s.label]++;
+            else
+                it->second.first = std::min(it->second.first, s.addr.val() - obj.base);
+        }
+        for (auto& [key, fl] : functions)
+            if (count[fl.label] > 1)
+                fl.label = cmmn::concat(fl.label, "@",
+                    key.second ? key.second->path.native() : "??");
+        count.clear();
+        for (const auto& [key, fl] : functions)
+            count[fl.label]++;
+        for (auto& [key, fl] : functions)
+            if (count[fl.label] > 1)
+                fl.label = cmmn::concat(fl.label, ":", ::to_string(start_addr(fl.first)));
+        for (const auto& s : starts)
+            labels.push_back(functions.at({ s.func, s.cu }).label);
+    }
+
+    sampler_creator creator = creator_from_section(_readers, sec);
+    auto origw = origwords->begin();
+    auto label_it = labels.begin();
+    for (auto& s : starts)
+    {
+        auto insert_res = _traps.insert(s.addr,
+            start_trap(*origw++, std::move(s.ctx), sec.allow_concurrency, creator));
+        if (!insert_res.second)
+        {
+            TEP_LOG(log::error,
+                "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
+                _tid, s.addr.val(), s.addr.val() - obj.base);
+            return tracer_error(tracer_errcode::NO_TRAP,
+                cmmn::concat("Trap ", ::to_string(s.addr), " already exists"));
+        }
+        std::optional<std::string> label = *label_it++;
+        if (sec.label)
+            label = cmmn::concat(*sec.label, "/", *label);
+        if (!insert_output(s.addr, group, sec, label))
+            return tracer_error(tracer_errcode::NO_TRAP,
+                "Trap address already exists");
+    }
+    for (auto& e : ends)
+    {
+        auto insert_res = _traps.insert(e.addr,
+            end_trap(*origw++, std::move(e.ctx), e.start));
+        if (!insert_res.second)
+        {
+            TEP_LOG(log::error,
+                "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
+                _tid, e.addr.val(), e.addr.val() - obj.base);
+            return tracer_error(tracer_errcode::NO_TRAP,
+                cmmn::concat("Trap ", ::to_string(e.addr), " already exists"));
+        }
+    }
+    return tracer_error::success();
+}
+
 tracer_error profiler::insert_traps_address_range(
     const cfg::group_t& group,
     const cfg::section_t& sec,
@@ -786,12 +1338,12 @@ tracer_error profiler::insert_traps_address_range(
                 creator_from_section(_readers, sec)));
         if (!insert_res.second)
         {
-            log::logline(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
+            TEP_LOG(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
                 _tid, start.val(), start.val() - entrypoint);
             return tracer_error(tracer_errcode::NO_TRAP,
                 cmmn::concat("Trap ", ::to_string(start), " already exists"));
         }
-        log::logline(log::info, "[%d] inserted trap at start address 0x%" PRIxPTR
+        TEP_LOG(log::info, "[%d] inserted trap at start address 0x%" PRIxPTR
             " (offset 0x%" PRIxPTR ")", _tid, start.val(), start.val() - entrypoint);
     }
     origw = insert_trap(_child, end.val());
@@ -806,15 +1358,15 @@ tracer_error profiler::insert_traps_address_range(
                 start));
         if (!insert_res.second)
         {
-            log::logline(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
+            TEP_LOG(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
                 _tid, end.val(), end.val() - entrypoint);
             return tracer_error(tracer_errcode::NO_TRAP,
                 cmmn::concat("Trap ", ::to_string(end), " already exists"));
         }
-        log::logline(log::info, "[%d] inserted trap at end address 0x%" PRIxPTR
+        TEP_LOG(log::info, "[%d] inserted trap at end address 0x%" PRIxPTR
             " (offset 0x%" PRIxPTR ")", _tid, end.val(), end.val() - entrypoint);
     }
-    if (!_output.insert(start, _readers, group, sec))
+    if (!insert_output(start, group, sec))
         return tracer_error(tracer_errcode::NO_TRAP, "Trap address already exists");
     return tracer_error::success();
 }
@@ -841,7 +1393,7 @@ tracer_expected<start_addr> profiler::insert_traps_position_start(
     tracer_expected<long> origw = insert_trap(_child, eaddr.val());
     if (!origw)
         return unexpected{ std::move(origw).error() };
-    log::logline(log::info, "[%d] inserted trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ")",
+    TEP_LOG(log::info, "[%d] inserted trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ")",
         _tid, eaddr.val(), eaddr.val() - entrypoint);
 
     auto insert_res = _traps.insert(eaddr,
@@ -852,16 +1404,16 @@ tracer_expected<start_addr> profiler::insert_traps_position_start(
             creator_from_section(_readers, sec)));
     if (!insert_res.second)
     {
-        log::logline(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
+        TEP_LOG(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
             _tid, eaddr.val(), eaddr.val() - entrypoint);
         return unexpected{ tracer_error{
             tracer_errcode::NO_TRAP,
             cmmn::concat("Trap ", ::to_string(eaddr), " already exists") } };
     }
 
-    log::logline(log::debug, "[%d] line %s @ offset 0x%" PRIxPTR,
+    TEP_LOG(log::debug, "[%d] line %s @ offset 0x%" PRIxPTR,
         _tid, ::to_string(**line).c_str(), (*line)->number);
-    log::logline(log::success, "[%d] inserted trap on line: %s",
+    TEP_LOG(log::success, "[%d] inserted trap on line: %s",
         _tid, ::to_string(**line).c_str());
     return eaddr;
 }
@@ -888,7 +1440,7 @@ tracer_error profiler::insert_traps_position_end(
     tracer_expected<long> origw = insert_trap(_child, eaddr.val());
     if (!origw)
         return std::move(origw.error());
-    log::logline(log::info, "[%d] inserted trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ")",
+    TEP_LOG(log::info, "[%d] inserted trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ")",
         _tid, eaddr.val(), eaddr.val() - entrypoint);
 
     auto insert_res = _traps.insert(eaddr,
@@ -898,17 +1450,17 @@ tracer_error profiler::insert_traps_position_end(
             start));
     if (!insert_res.second)
     {
-        log::logline(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
+        TEP_LOG(log::error, "[%d] trap @ 0x%" PRIxPTR " (offset 0x%" PRIxPTR ") already exists",
             _tid, eaddr.val(), eaddr.val() - entrypoint);
         return tracer_error(tracer_errcode::NO_TRAP,
             cmmn::concat("Trap ", ::to_string(eaddr), " already exists"));
     }
-    if (!_output.insert(start, _readers, group, sec))
+    if (!insert_output(start, group, sec))
         return tracer_error(tracer_errcode::NO_TRAP, "Trap address already exists");
 
-    log::logline(log::debug, "[%d] line %s @ offset 0x%" PRIxPTR,
+    TEP_LOG(log::debug, "[%d] line %s @ offset 0x%" PRIxPTR,
         _tid, ::to_string(**line).c_str(), (*line)->number);
-    log::logline(log::success, "[%d] inserted trap on line: %s",
+    TEP_LOG(log::success, "[%d] inserted trap on line: %s",
         _tid, ::to_string(**line).c_str());
     return tracer_error::success();
 }
@@ -4,13 +4,20 @@
 
 #include "config.hpp"
 #include "flags.hpp"
+#include "journal.hpp"
+#include "modules.hpp"
 #include "output.hpp"
+#include "overhead.hpp"
 #include "reader_container.hpp"
+#include "telemetry.hpp"
 #include "trap.hpp"
 #include "dbg/object_info.hpp"
 
 #include <util/expectedfwd.hpp>
 
+#include <map>
+#include <tuple>
+
 namespace tep
 {
     class profiling_results;
@@ -37,9 +44,30 @@ namespace tep
                 const cfg::group_t&,
                 const cfg::section_t&);
 
+            bool insert(start_addr,
+                const reader_container&,
+                const cfg::group_t&,
+                const cfg::section_t&,
+                std::optional<std::string_view> label,
+                std::shared_ptr<const read_overhead> overhead = nullptr);
+
             section_output* find(start_addr);
         };
 
+        // the object which defines the code of a section, i.e., the executable
+        // or a module, and the tracee through which its traps are inserted
+        struct code_object
+        {
+            pid_t tracee;
+            uintptr_t base;
+            const dbg::object_info& info;
+            const loaded_module* module;
+        };
+
+        using section_ref = std::pair<const cfg::group_t*, const cfg::section_t*>;
+        // the targets of a section and the sampling mode and period of its sampler
+        using overhead_key = std::tuple<cfg::target, sampling_mode, std::chrono::milliseconds>;
+
         pid_t _tid;
         pid_t _child;
         flags _flags;
@@ -48,9 +76,22 @@ namespace tep
         reader_container _readers;
         registered_traps _traps;
         output_mapping _output;
+        std::shared_ptr<results_journal> _journal;
+        std::shared_ptr<telemetry> _telemetry;
+        std::vector<std::unique_ptr<loaded_module>> _modules;
+        // sections in modules which have not been loaded yet
+        std::vector<section_ref> _pending;
+        // the calibrated overhead of the reads of the sections, empty if not calibrated
+        std::map<overhead_key, std::shared_ptr<const read_overhead>> _overheads;
+        // key of an expired idle baseline which was reused, to be measured again
+        std::optional<std::string> _idle_refresh;
 
     public:
-        profiler(pid_t child, flags, dbg::object_info, cfg::config_t);
+        // executions are also appended to <journal> as they finish
+        // and published to <tm> as they happen, if not null
+        profiler(pid_t child, flags, dbg::object_info, cfg::config_t,
+            std::shared_ptr<results_journal> journal = nullptr,
+            std::shared_ptr<telemetry> tm = nullptr);
 
         const dbg::object_info& debug_line_info() const;
         const cfg::config_t& config() const;
@@ -59,14 +100,42 @@ namespace tep
         tracer_error await_executable(const std::string& name) const;
         nonstd::expected<profiling_results, tracer_error> run();
 
+        // measures again the expired idle baseline which was reused, if any;
+        // to be called once the results are written, so that the system is idle
+        void refresh_idle_baseline();
+
     private:
         tracer_error obtain_idle_results();
+        tracer_error calibrate_readers();
+        std::shared_ptr<const read_overhead> find_overhead(const cfg::section_t&) const;
+
+        // inserts the output of the section of the start trap at start,
+        // which must have already been inserted
+        bool insert_output(start_addr start,
+            const cfg::group_t&,
+            const cfg::section_t&);
+
+        bool insert_output(start_addr start,
+            const cfg::group_t&,
+            const cfg::section_t&,
+            std::optional<std::string_view> label);
+
+        tracer_error insert_loader_trap();
+        tracer_error load_modules(pid_t);
+        nonstd::expected<const loaded_module*, tracer_error> load_module(
+            const std::string&, const mapped_object&);
 
         tracer_error insert_traps_function(
             const cfg::group_t&,
             const cfg::section_t&,
             const cfg::function_t&,
-            uintptr_t);
+            const code_object&);
+
+        tracer_error insert_traps_function_pattern(
+            const cfg::group_t&,
+            const cfg::section_t&,
+            const cfg::function_pattern_t&,
+            const code_object&);
 
         tracer_error insert_traps_address_range(
             const cfg::group_t&,
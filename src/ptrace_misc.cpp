@@ -5,10 +5,42 @@
 
 #include "nonstd/expected.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <numeric>
 #include <string>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // maximum distance between two traps patched with the same memory access
+    constexpr uintptr_t cluster_gap = 4096;
+
+    struct mem_file
+    {
+        int fd;
+
+        explicit mem_file(pid_t pid)
+        {
+            char path[32];
+            snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+            fd = open(path, O_RDWR | O_CLOEXEC);
+        }
+
+        ~mem_file()
+        {
+            if (fd != -1)
+                close(fd);
+        }
+
+        mem_file(const mem_file&) = delete;
+        mem_file& operator=(const mem_file&) = delete;
+    };
+}
+
 namespace tep
 {
     nonstd::expected<std::string, tracer_error>
@@ -84,4 +116,78 @@ namespace tep
                 "insert_trap: PTRACE_POKEDATA") };
         return word;
     }
+
+    nonstd::expected<std::vector<long>, tracer_error>
+        insert_traps(pid_t pid, const std::vector<uintptr_t>& addrs)
+    {
+        using unexpected = nonstd::expected<std::vector<long>, tracer_error>::unexpected_type;
+        constexpr size_t wordsz = sizeof(long);
+
+        // insert from the highest to the lowest address: the original word of
+        // a trap then contains the traps at higher addresses which overlap it,
+        // so restoring it does not remove them
+        std::vector<size_t> order(addrs.size());
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::sort(order.begin(), order.end(), [&addrs](size_t lhs, size_t rhs)
+            {
+                return addrs[lhs] > addrs[rhs];
+            });
+
+        std::vector<long> retval(addrs.size());
+        mem_file mem(pid);
+        if (mem.fd == -1)
+        {
+            // no access to the tracee's memory file, patch one word at a time
+            for (auto it = order.begin(); it != order.end(); ++it)
+            {
+                if (it != order.begin() && addrs[*it] == addrs[*std::prev(it)])
+                {
+                    retval[*it] = retval[*std::prev(it)];
+                    continue;
+                }
+                auto word = insert_trap(pid, addrs[*it]);
+                if (!word)
+                    return unexpected{ std::move(word.error()) };
+                retval[*it] = *word;
+            }
+            return retval;
+        }
+
+        std::vector<unsigned char> buffer;
+        for (auto first = order.begin(); first != order.end(); )
+        {
+            // clusters are formed from the highest address downwards
+            uintptr_t high = addrs[*first] + wordsz;
+            auto last = std::next(first);
+            while (last != order.end() && addrs[*std::prev(last)] - addrs[*last] <= cluster_gap)
+                ++last;
+            uintptr_t low = addrs[*std::prev(last)];
+
+            buffer.resize(high - low);
+            ssize_t res = pread(mem.fd, buffer.data(), buffer.size(), low);
+            if (res != static_cast<ssize_t>(buffer.size()))
+                return unexpected{ get_syserror(res == -1 ? errno : EIO,
+                    tracer_errcode::SYSTEM_ERROR, pid, "insert_traps: pread") };
+            for (auto it = first; it != last; ++it)
+            {
+                if (it != first && addrs[*it] == addrs[*std::prev(it)])
+                {
+                    retval[*it] = retval[*std::prev(it)];
+                    continue;
+                }
+                unsigned char* ptr = buffer.data() + (addrs[*it] - low);
+                long word;
+                std::memcpy(&word, ptr, wordsz);
+                retval[*it] = word;
+                word = set_trap(word);
+                std::memcpy(ptr, &word, wordsz);
+            }
+            res = pwrite(mem.fd, buffer.data(), buffer.size(), low);
+            if (res != static_cast<ssize_t>(buffer.size()))
+                return unexpected{ get_syserror(res == -1 ? errno : EIO,
+                    tracer_errcode::SYSTEM_ERROR, pid, "insert_traps: pwrite") };
+            first = last;
+        }
+        return retval;
+    }
 }
@@ -30,4 +30,17 @@ namespace tep
      */
     nonstd::expected<long, tracer_error>
         insert_trap(pid_t pid, uintptr_t addr);
+
+    /**
+     * @brief Insert traps at multiple addresses and return the old word values
+     * in the same order as the addresses. Neighbouring addresses are patched
+     * with a single read and write of the tracee's memory and traps whose words
+     * overlap keep each other intact when restored.
+     *
+     * @param pid the pid of the tracee process
+     * @param addrs the addresses, which may contain duplicates
+     * @return nonstd::expected<std::vector<long>, tracer_error>
+     */
+    nonstd::expected<std::vector<long>, tracer_error>
+        insert_traps(pid_t pid, const std::vector<uintptr_t>& addrs);
 }
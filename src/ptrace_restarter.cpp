@@ -9,6 +9,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <utility>
 #include <sys/user.h>
 #include <sys/wait.h>
 
@@ -32,7 +33,7 @@ namespace tep
             if (errnum != ESRCH)
                 return get_syserror(errnum, tracer_errcode::PTRACE_ERROR, _tid, "PTRACE_CONT");
 
-            log::logline(log::warning,
+            TEP_LOG(log::warning,
                 "[%d] PTRACE_CONT failed with ESRCH: waiting for tracee %d",
                 _tid, _tracee);
             pid_t waited_pid = waitpid(_tracee, &wait_status, 0);
@@ -45,7 +46,7 @@ namespace tep
                 return err;
 
             const char* sigstr = sig_str(WSTOPSIG(wait_status));
-            log::logline(log::warning,
+            TEP_LOG(log::warning,
                 "[%d] waited for tracee %d with signal: %s (status 0x%x),"
                 " rip @ 0x%" PRIxPTR,
                 _tid,
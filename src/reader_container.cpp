@@ -19,13 +19,50 @@ effective_readings_type(nrgprf::readings_type::type rt)
         nrgprf::readings_type::energy : nrgprf::readings_type::power;
 }
 
+static std::optional<nrgprf::reader_shm>
+open_sensor_segment(const flags& flags)
+{
+    if (flags.sensor_segment.empty())
+        return std::nullopt;
+    try
+    {
+        nrgprf::reader_shm reader(flags.sensor_segment);
+        const nrgprf::segment_info& info = reader.info();
+        if ((flags.locations.any() && flags.locations != info.locations) ||
+            (flags.sockets.any() && flags.sockets != info.sockets) ||
+            (flags.devices.any() && flags.devices != info.devices))
+            TEP_LOG(log::warning, "the sensors, sockets and devices of the daemon "
+                "publishing to '%s' are read instead of those provided",
+                flags.sensor_segment.c_str());
+        if (flags.cores.any())
+            TEP_LOG(log::warning, "the daemon publishing to '%s' does not read "
+                "the energy of cores", flags.sensor_segment.c_str());
+        if (flags.parallel_reads)
+            TEP_LOG(log::warning, "the sensors are read by the daemon publishing to '%s', "
+                "which reads them at the same time if started with --parallel",
+                flags.sensor_segment.c_str());
+        TEP_LOG(log::success, "opened sensor segment '%s' (period: %lld ns)",
+            flags.sensor_segment.c_str(), static_cast<long long>(info.period.count()));
+        return reader;
+    }
+    catch (const nrgprf::exception& e)
+    {
+        TEP_LOG(log::error, "%s: error opening sensor segment '%s': %s",
+            __func__, flags.sensor_segment.c_str(), e.what());
+        throw;
+    }
+}
+
 static nrgprf::reader_rapl
 create_cpu_reader(
     const flags& flags,
-    const cfg::config_t::opt_params_t& params)
+    const cfg::config_t::opt_params_t& params,
+    const std::optional<nrgprf::reader_shm>& segment)
 {
-    auto get_domain_mask = [&flags, &params]()
+    auto get_domain_mask = [&flags, &params, &segment]()
     {
+        if (segment)
+            return segment->info().locations;
         if (flags.locations.any())
             return flags.locations;
         if (!params || !params->domain_mask)
@@ -33,8 +70,10 @@ create_cpu_reader(
         return nrgprf::location_mask(*params->domain_mask);
     };
 
-    auto get_socket_mask = [&flags, &params]()
+    auto get_socket_mask = [&flags, &params, &segment]()
     {
+        if (segment)
+            return segment->info().sockets;
         if (flags.sockets.any())
             return flags.sockets;
         if (!params || !params->socket_mask)
@@ -47,13 +86,14 @@ create_cpu_reader(
         nrgprf::reader_rapl reader(
             get_domain_mask(),
             get_socket_mask(),
+            segment ? nrgprf::core_mask() : flags.cores,
             log::stream());
-        log::logline(log::success, "created CPU reader");
+        TEP_LOG(log::success, "created CPU reader");
         return reader;
     }
     catch (const nrgprf::exception& e)
     {
-        log::logline(log::error,
+        TEP_LOG(log::error,
             "%s: error creating CPU reader: %s", __func__, e.what());
         throw;
     }
@@ -62,10 +102,13 @@ create_cpu_reader(
 static nrgprf::reader_gpu
 create_gpu_reader(
     const flags& flags,
-    const cfg::config_t::opt_params_t& params)
+    const cfg::config_t::opt_params_t& params,
+    const std::optional<nrgprf::reader_shm>& segment)
 {
-    auto get_device_mask = [&flags, &params]()
+    auto get_device_mask = [&flags, &params, &segment]()
     {
+        if (segment)
+            return segment->info().devices;
         if (flags.devices.any())
             return flags.devices;
         if (!params || !params->device_mask)
@@ -80,23 +123,25 @@ create_gpu_reader(
     try
     {
         nrgprf::reader_gpu reader(
+            segment ? segment->info().gpu_readings :
             effective_readings_type(support ? *support : nrgprf::readings_type::all),
             devmask,
             log::stream());
-        log::logline(log::success, "created GPU reader", "GPU");
+        TEP_LOG(log::success, "created GPU reader", "GPU");
         return reader;
     }
     catch (const nrgprf::exception& e)
     {
-        log::logline(log::error,
+        TEP_LOG(log::error,
             "%s: error creating GPU reader: %s", __func__, e.what());
         throw;
     }
 }
 
 reader_container::reader_container(const flags& flags, const cfg::config_t& cd) :
-    _rdr_cpu(create_cpu_reader(flags, cd.parameters())),
-    _rdr_gpu(create_gpu_reader(flags, cd.parameters()))
+    _rdr_shm(open_sensor_segment(flags)),
+    _rdr_cpu(create_cpu_reader(flags, cd.parameters(), _rdr_shm)),
+    _rdr_gpu(create_gpu_reader(flags, cd.parameters(), _rdr_shm))
 {
     for (const auto& g : cd.groups())
     {
@@ -104,7 +149,7 @@ reader_container::reader_container(const flags& flags, const cfg::config_t& cd)
         {
             assert(cfg::target_valid(s.targets));
             if (cfg::target_multiple(s.targets))
-                emplace_hybrid_reader<true>(s.targets);
+                emplace_hybrid_reader<true>(s.targets, flags.parallel_reads);
         }
     }
 }
@@ -112,45 +157,49 @@ reader_container::reader_container(const flags& flags, const cfg::config_t& cd)
 reader_container::~reader_container() = default;
 
 reader_container::reader_container(const reader_container & other) :
+    _rdr_shm(other._rdr_shm),
     _rdr_cpu(other._rdr_cpu),
     _rdr_gpu(other._rdr_gpu),
     _hybrids()
 {
     _hybrids.reserve(other._hybrids.size());
     for (const auto& [tgts, hr] : other._hybrids)
-        emplace_hybrid_reader(tgts);
+        emplace_hybrid_reader(tgts, hr.parallel());
 }
 
 reader_container& reader_container::operator=(const reader_container & other)
 {
+    _rdr_shm = other._rdr_shm;
     _rdr_cpu = other._rdr_cpu;
     _rdr_gpu = other._rdr_gpu;
     _hybrids.clear();
     _hybrids.reserve(other._hybrids.size());
     for (const auto& [tgts, hr] : other._hybrids)
-        emplace_hybrid_reader(tgts);
+        emplace_hybrid_reader(tgts, hr.parallel());
     return *this;
 
 }
 
 reader_container::reader_container(reader_container && other) :
+    _rdr_shm(std::move(other._rdr_shm)),
     _rdr_cpu(std::move(other._rdr_cpu)),
     _rdr_gpu(std::move(other._rdr_gpu)),
     _hybrids()
 {
     _hybrids.reserve(other._hybrids.size());
     for (auto& [tgts, hr] : other._hybrids)
-        emplace_hybrid_reader(std::move(tgts));
+        emplace_hybrid_reader(std::move(tgts), hr.parallel());
 }
 
 reader_container& reader_container::operator=(reader_container && other)
 {
+    _rdr_shm = std::move(other._rdr_shm);
     _rdr_cpu = std::move(other._rdr_cpu);
     _rdr_gpu = std::move(other._rdr_gpu);
     _hybrids.clear();
     _hybrids.reserve(other._hybrids.size());
     for (auto& [tgts, hr] : other._hybrids)
-        emplace_hybrid_reader(std::move(tgts));
+        emplace_hybrid_reader(std::move(tgts), hr.parallel());
     return *this;
 }
 
@@ -176,14 +225,20 @@ const nrgprf::reader_gpu& reader_container::reader_gpu() const
 
 const nrgprf::reader* reader_container::find(cfg::target target) const
 {
+    // the samples of the segment hold the readings of every target
+    if (_rdr_shm)
+    {
+        TEP_LOG(log::debug, "retrieved sensor segment reader");
+        return &*_rdr_shm;
+    }
     if (target == cfg::target::cpu)
     {
-        log::logline(log::debug, "retrieved RAPL reader");
+        TEP_LOG(log::debug, "retrieved RAPL reader");
         return &_rdr_cpu;
     }
     if (target == cfg::target::gpu)
     {
-        log::logline(log::debug, "retrieved GPU reader");
+        TEP_LOG(log::debug, "retrieved GPU reader");
         return &_rdr_gpu;
     }
     for (const auto& [tgt, hr] : _hybrids)
@@ -191,7 +246,7 @@ const nrgprf::reader* reader_container::find(cfg::target target) const
         {
             std::stringstream ss;
             ss << target;
-            log::logline(log::debug, "retrieved hybrid reader for targets: %s",
+            TEP_LOG(log::debug, "retrieved hybrid reader for targets: %s",
                 ss.str().c_str());
             return &hr;
         }
@@ -200,7 +255,7 @@ const nrgprf::reader* reader_container::find(cfg::target target) const
 }
 
 template<bool Log>
-void reader_container::emplace_hybrid_reader(cfg::target targets)
+void reader_container::emplace_hybrid_reader(cfg::target targets, bool parallel)
 {
     auto& [tgts, hr] = _hybrids.emplace_back(targets, nrgprf::hybrid_reader{});
     for (cfg::target t = tgts, curr = cfg::target::cpu;
@@ -211,16 +266,20 @@ void reader_container::emplace_hybrid_reader(cfg::target targets)
         {
         case cfg::target::cpu:
             if constexpr (Log)
-                log::logline(log::debug, "insert RAPL reader to hybrid");
+                TEP_LOG(log::debug, "insert RAPL reader to hybrid");
             hr.push_back(_rdr_cpu);
             break;
         case cfg::target::gpu:
             if constexpr (Log)
-                log::logline(log::debug, "insert GPU reader to hybrid");
+                TEP_LOG(log::debug, "insert GPU reader to hybrid");
             hr.push_back(_rdr_gpu);
             break;
         default:
             assert(false);
         }
     }
+    if constexpr (Log)
+        if (parallel)
+            TEP_LOG(log::debug, "hybrid reader reads in parallel");
+    hr.parallel(parallel);
 }
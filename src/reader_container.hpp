@@ -6,8 +6,11 @@
 
 #include <nrg/reader_gpu.hpp>
 #include <nrg/reader_rapl.hpp>
+#include <nrg/reader_shm.hpp>
 #include <nrg/hybrid_reader.hpp>
 
+#include <optional>
+
 namespace tep
 {
     struct flags;
@@ -15,6 +18,9 @@ namespace tep
     class reader_container
     {
     private:
+        // when set, every target is sampled through it and the other readers,
+        // created like those of the daemon, only interpret the samples
+        std::optional<nrgprf::reader_shm> _rdr_shm;
         nrgprf::reader_rapl _rdr_cpu;
         nrgprf::reader_gpu _rdr_gpu;
         std::vector<std::pair<cfg::target, nrgprf::hybrid_reader>> _hybrids;
@@ -38,6 +44,6 @@ namespace tep
 
     private:
         template<bool Log = false>
-        void emplace_hybrid_reader(cfg::target);
+        void emplace_hybrid_reader(cfg::target, bool parallel);
     };
 }
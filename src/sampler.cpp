@@ -31,16 +31,28 @@ sampler_expected null_sampler::results()
 
 
 sampler::sampler(const nrgprf::reader* r) :
-    _reader(r)
+    _reader(r),
+    _listener()
 {
     assert(_reader != nullptr);
 }
 
+void sampler::set_listener(listener l)
+{
+    _listener = std::move(l);
+}
+
 const nrgprf::reader* sampler::reader() const
 {
     return _reader;
 }
 
+void sampler::notify(const timed_sample& s) const
+{
+    if (_listener)
+        _listener(s);
+}
+
 
 sampler_promise short_sampler::run()&
 {
@@ -53,6 +65,7 @@ sampler_promise short_sampler::run()&
         };
         return promise;
     }
+    notify(_start);
     return [this]()
     {
         return results();
@@ -69,6 +82,7 @@ sampler_expected short_sampler::results()
     _end.timestamp = timed_sample::clock::now();
     if (std::error_code ec; !reader()->read(_end, ec))
         return sampler_expected(nonstd::unexpect, ec);
+    notify(_end);
     return timed_execution{ std::move(_start), std::move(_end) };
 }
 
@@ -79,10 +93,11 @@ sampler_expected sync_sampler::results()
     s1.timestamp = timed_sample::clock::now();
     if (std::error_code ec; !reader()->read(s1, ec))
     {
-        log::logline(log::error, "%s: error when reading counters: %s",
+        TEP_LOG(log::error, "%s: error when reading counters: %s",
             __func__, ec.message().c_str());
         return sampler_expected(nonstd::unexpect, ec);
     }
+    notify(s1);
 
     work();
 
@@ -90,10 +105,11 @@ sampler_expected sync_sampler::results()
     s2.timestamp = timed_sample::clock::now();
     if (std::error_code ec; !reader()->read(s2, ec))
     {
-        log::logline(log::error, "%s: error when reading counters: %s",
+        TEP_LOG(log::error, "%s: error when reading counters: %s",
             __func__, ec.message().c_str());
         return sampler_expected(nonstd::unexpect, ec);
     }
+    notify(s2);
     return timed_execution{ std::move(s1), std::move(s2) };
 }
 
@@ -158,7 +174,7 @@ periodic_sampler::periodic_sampler(const nrgprf::reader* r,
     _future = std::async(std::launch::async,
         [this]()
         {
-            log::logline(log::debug, "periodic_sampler: waiting to start");
+            TEP_LOG(log::debug, "periodic_sampler: waiting to start");
             _sig.wait();
             return async_work();
         });
@@ -219,22 +235,24 @@ sampler_expected bounded_ps::async_work()
     _first.timestamp = timed_sample::clock::now();
     if (std::error_code ec; !reader()->read(_first, ec))
     {
-        log::logline(log::error, "%s: error when reading counters: %s",
+        TEP_LOG(log::error, "%s: error when reading counters: %s",
             __func__, ec.message().c_str());
         return sampler_expected(nonstd::unexpect, ec);
     }
+    notify(_first);
     while (!finished())
     {
         _sig.wait_for(period());
         _last.timestamp = timed_sample::clock::now();
         if (std::error_code ec; !reader()->read(_last, ec))
         {
-            log::logline(log::error, "%s: error when reading counters: %s",
+            TEP_LOG(log::error, "%s: error when reading counters: %s",
                 __func__, ec.message().c_str());
             return sampler_expected(nonstd::unexpect, ec);;
         }
+        notify(_last);
     };
-    log::logline(log::success, "%s: finished evaluation with %zu samples",
+    TEP_LOG(log::success, "%s: finished evaluation with %zu samples",
         __func__, 2);
     return timed_execution{ std::move(_first), std::move(_last) };
 }
@@ -255,10 +273,11 @@ sampler_expected unbounded_ps::async_work()
         smp.timestamp = timed_sample::clock::now();
         if (std::error_code ec; !reader()->read(smp, ec))
         {
-            log::logline(log::error, "%s: error when reading counters: %s",
+            TEP_LOG(log::error, "%s: error when reading counters: %s",
                 __func__, ec.message().c_str());
             return sampler_expected(nonstd::unexpect, ec);;
         }
+        notify(smp);
         _sig.wait_for(period());
     } while (!finished());
 
@@ -266,12 +285,13 @@ sampler_expected unbounded_ps::async_work()
     smp.timestamp = timed_sample::clock::now();
     if (std::error_code ec; !reader()->read(smp, ec))
     {
-        log::logline(log::error, "%s: error when reading counters: %s",
+        TEP_LOG(log::error, "%s: error when reading counters: %s",
             __func__, ec.message().c_str());
         return sampler_expected(nonstd::unexpect, ec);;
     }
+    notify(smp);
 
-    log::logline(log::success, "%s: finished evaluation with %zu samples",
+    TEP_LOG(log::success, "%s: finished evaluation with %zu samples",
         __func__, _exec.size());
     return std::move(_exec);
 }
@@ -44,14 +44,23 @@ namespace tep
 
     class sampler : public sampler_interface
     {
+    public:
+        using listener = std::function<void(const timed_sample&)>;
+
     private:
         const nrgprf::reader* _reader;
+        listener _listener;
 
     public:
         explicit sampler(const nrgprf::reader*);
 
+        // <l> is invoked with every sample as soon as it is read, from the sampling thread;
+        // must be set before the sampler is run
+        void set_listener(listener l);
+
     protected:
         const nrgprf::reader* reader() const;
+        void notify(const timed_sample&) const;
     };
 
     // short sampler
@@ -0,0 +1,132 @@
+// stats.cpp
+
+#include "stats.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+using namespace tep;
+
+namespace
+{
+    // smallest value which is bucketed, smaller ones are counted as zero
+    constexpr double min_value = 1e-12;
+}
+
+quantile_sketch::quantile_sketch(double accuracy, size_t max_buckets) :
+    _gamma((1 + accuracy) / (1 - accuracy)),
+    _log_gamma(std::log(_gamma)),
+    _max_buckets(max_buckets),
+    _count(0),
+    _zero_count(0),
+    _buckets()
+{
+    assert(accuracy > 0 && accuracy < 1);
+    assert(max_buckets > 0);
+}
+
+void quantile_sketch::add(double value)
+{
+    if (std::isnan(value))
+        return;
+    _count++;
+    if (value < min_value)
+        _zero_count++;
+    else
+    {
+        _buckets[key(value)]++;
+        collapse();
+    }
+}
+
+void quantile_sketch::merge(const quantile_sketch& other)
+{
+    assert(_gamma == other._gamma);
+    _count += other._count;
+    _zero_count += other._zero_count;
+    for (const auto& [k, n] : other._buckets)
+        _buckets[k] += n;
+    collapse();
+}
+
+double quantile_sketch::quantile(double q) const
+{
+    if (!_count)
+        return std::numeric_limits<double>::quiet_NaN();
+    assert(q >= 0 && q <= 1);
+    uint64_t rank = static_cast<uint64_t>(q * (_count - 1));
+    if (rank < _zero_count)
+        return 0;
+    uint64_t seen = _zero_count;
+    for (const auto& [k, n] : _buckets)
+    {
+        seen += n;
+        if (seen > rank)
+            return value(k);
+    }
+    assert(false);
+    return value(_buckets.rbegin()->first);
+}
+
+uint64_t quantile_sketch::count() const noexcept
+{
+    return _count;
+}
+
+int32_t quantile_sketch::key(double value) const
+{
+    return static_cast<int32_t>(std::ceil(std::log(value) / _log_gamma));
+}
+
+// the value with the least relative error to every value in the bucket
+double quantile_sketch::value(int32_t key) const
+{
+    return 2 * std::pow(_gamma, key) / (_gamma + 1);
+}
+
+void quantile_sketch::collapse()
+{
+    // the lowest quantiles lose accuracy, which are the least interesting ones
+    while (_buckets.size() > _max_buckets)
+    {
+        auto lowest = _buckets.begin();
+        std::next(lowest)->second += lowest->second;
+        _buckets.erase(lowest);
+    }
+}
+
+running_stats::running_stats() :
+    count(0),
+    total(0),
+    min(std::numeric_limits<double>::infinity()),
+    max(-std::numeric_limits<double>::infinity()),
+    sketch()
+{}
+
+void running_stats::add(double value)
+{
+    count++;
+    total += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+    sketch.add(value);
+}
+
+void running_stats::merge(const running_stats& other)
+{
+    count += other.count;
+    total += other.total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sketch.merge(other.sketch);
+}
+
+double running_stats::mean() const noexcept
+{
+    if (!count)
+        return std::numeric_limits<double>::quiet_NaN();
+    return total / count;
+}
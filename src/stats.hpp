@@ -0,0 +1,64 @@
+// stats.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace tep
+{
+    // approximates quantiles of positive values with a bounded relative error,
+    // using logarithmically sized buckets (DDSketch);
+    // memory is bounded by the maximum number of buckets, past which the lowest
+    // buckets are collapsed, and sketches with the same accuracy can be merged
+    class quantile_sketch
+    {
+    public:
+        static constexpr double default_accuracy = 0.01;
+        static constexpr size_t default_max_buckets = 2048;
+
+        explicit quantile_sketch(
+            double accuracy = default_accuracy,
+            size_t max_buckets = default_max_buckets);
+
+        void add(double value);
+        void merge(const quantile_sketch& other);
+
+        // value at quantile q in [0, 1], NaN if the sketch is empty
+        double quantile(double q) const;
+        uint64_t count() const noexcept;
+
+    private:
+        double _gamma;
+        double _log_gamma;
+        size_t _max_buckets;
+        uint64_t _count;
+        // values too small to be bucketed, including zero and negative values
+        uint64_t _zero_count;
+        std::map<int32_t, uint64_t> _buckets;
+
+        int32_t key(double value) const;
+        double value(int32_t key) const;
+        void collapse();
+    };
+
+    // count, total, min, max and quantiles of a series of values,
+    // without storing them
+    struct running_stats
+    {
+        uint64_t count;
+        double total;
+        double min;
+        double max;
+        quantile_sketch sketch;
+
+        running_stats();
+
+        void add(double value);
+        void merge(const running_stats& other);
+
+        // NaN if there are no values
+        double mean() const noexcept;
+    };
+}
@@ -0,0 +1,266 @@
+// telemetry.cpp
+
+#include "telemetry.hpp"
+#include "log.hpp"
+#include "output.hpp"
+#include "output/output_writer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace tep;
+
+namespace
+{
+    // how often the queued events are written to the clients
+    constexpr int poll_timeout_ms = 20;
+
+    int64_t to_ns(timed_sample::time_point tp)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            tp.time_since_epoch()).count();
+    }
+
+    // the keys of every object are written in lexicographic order, as in the results
+    std::string event_json(const telemetry_event& event)
+    {
+        static constexpr const char* event_names[] = { "enter", "exit", "sample" };
+
+        std::ostringstream oss;
+        {
+            output_writer ow(oss);
+            ow.begin_object();
+            ow.key("event").value(event_names[static_cast<uint8_t>(event.type)]);
+            ow.key("group").value(event.section->group);
+            // nested, since the keys of the readings depend on the readers of the section
+            if (event.type == telemetry_event::kind::sample)
+            {
+                ow.key("readings").begin_object();
+                event.section->rout->output(ow, timed_execution{ event.sample });
+                ow.end_object();
+            }
+            ow.key("section").value(event.section->label);
+            ow.key("tid").value(event.tid);
+            ow.key("time").value(to_ns(event.sample.timestamp));
+            ow.end_object();
+        }
+        oss << '\n';
+        return oss.str();
+    }
+
+    std::string dropped_json(uint64_t count)
+    {
+        std::ostringstream oss;
+        {
+            output_writer ow(oss);
+            ow.begin_object();
+            ow.key("count").value(count);
+            ow.key("event").value("dropped");
+            ow.end_object();
+        }
+        oss << '\n';
+        return oss.str();
+    }
+}
+
+telemetry::telemetry(const std::string& path, size_t capacity) :
+    _path(path),
+    _fd(::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)),
+    _capacity(capacity),
+    _mx(),
+    _queue(),
+    _dropped(0),
+    _stop(false),
+    _clients(),
+    _thread()
+{
+    assert(_capacity > 0);
+    if (_fd == -1)
+        throw std::system_error(errno, std::generic_category(), "error creating telemetry socket");
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        ::close(_fd);
+        throw std::system_error(ENAMETOOLONG, std::generic_category(),
+            "telemetry socket path '" + path + "'");
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str());
+    if (::bind(_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1 ||
+        ::listen(_fd, SOMAXCONN) == -1)
+    {
+        int errnum = errno;
+        ::close(_fd);
+        throw std::system_error(errnum, std::generic_category(),
+            "error listening on telemetry socket '" + path + "'");
+    }
+    _queue.reserve(_capacity);
+    _thread = std::thread(&telemetry::run, this);
+}
+
+telemetry::~telemetry()
+{
+    _stop = true;
+    _thread.join();
+    for (const auto& c : _clients)
+        ::close(c.fd);
+    ::close(_fd);
+    ::unlink(_path.c_str());
+}
+
+void telemetry::publish(telemetry_event&& event)
+{
+    std::scoped_lock lock(_mx);
+    if (_queue.size() >= _capacity)
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    else
+        _queue.push_back(std::move(event));
+}
+
+uint64_t telemetry::dropped() const noexcept
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void telemetry::run()
+{
+    std::vector<telemetry_event> events;
+    events.reserve(_capacity);
+    std::vector<size_t> closed;
+    uint64_t reported_dropped = 0;
+    bool stop = false;
+    while (!stop)
+    {
+        // the events published before the stop are still written
+        stop = _stop;
+        std::vector<pollfd> fds;
+        fds.push_back({ _fd, POLLIN, 0 });
+        for (const auto& c : _clients)
+            fds.push_back({ c.fd, static_cast<short>(POLLIN | (c.buffer.empty() ? 0 : POLLOUT)), 0 });
+        if (!stop && ::poll(fds.data(), fds.size(), poll_timeout_ms) == -1 && errno != EINTR)
+        {
+            TEP_LOG(log::error, "telemetry: poll: %s", strerror(errno));
+            return;
+        }
+        if (fds[0].revents & POLLIN)
+            accept_clients();
+        read_clients(closed);
+
+        {
+            std::scoped_lock lock(_mx);
+            events.swap(_queue);
+        }
+        for (const auto& event : events)
+            write_line(event_json(event));
+        events.clear();
+        if (uint64_t dropped = _dropped.load(std::memory_order_relaxed); dropped != reported_dropped)
+        {
+            write_line(dropped_json(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
+        flush_clients(closed);
+    }
+}
+
+void telemetry::accept_clients()
+{
+    int fd;
+    while ((fd = ::accept4(_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        TEP_LOG(log::info, "telemetry: client connected");
+        _clients.push_back({ fd, {} });
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        TEP_LOG(log::warning, "telemetry: accept: %s", strerror(errno));
+}
+
+// clients do not send anything, reads only detect when they disconnect
+void telemetry::read_clients(std::vector<size_t>& closed)
+{
+    for (size_t ix = 0; ix < _clients.size(); ix++)
+    {
+        char buffer[256];
+        ssize_t count;
+        while ((count = ::recv(_clients[ix].fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0);
+        if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            closed.push_back(ix);
+    }
+    close_clients(closed);
+}
+
+void telemetry::write_line(const std::string& line)
+{
+    for (auto& c : _clients)
+    {
+        if (c.buffer.size() + line.size() > max_client_buffer)
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+        else
+            c.buffer += line;
+    }
+}
+
+void telemetry::flush_clients(std::vector<size_t>& closed)
+{
+    for (size_t ix = 0; ix < _clients.size(); ix++)
+    {
+        client& c = _clients[ix];
+        if (c.buffer.empty())
+            continue;
+        ssize_t sent = ::send(c.fd, c.buffer.data(), c.buffer.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent >= 0)
+            c.buffer.erase(0, sent);
+        else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            closed.push_back(ix);
+    }
+    close_clients(closed);
+}
+
+void telemetry::close_clients(std::vector<size_t>& closed)
+{
+    // indices are in increasing order
+    for (auto it = closed.rbegin(); it != closed.rend(); ++it)
+    {
+        TEP_LOG(log::info, "telemetry: client disconnected");
+        ::close(_clients[*it].fd);
+        _clients.erase(_clients.begin() + *it);
+    }
+    closed.clear();
+}
+
+section_telemetry::section_telemetry(std::shared_ptr<telemetry> tm, telemetry_section section) :
+    _telemetry(std::move(tm)),
+    _section(std::make_shared<const telemetry_section>(std::move(section)))
+{
+    assert(_telemetry && _section->rout);
+}
+
+void section_telemetry::enter(pid_t tid) const
+{
+    timed_sample ts;
+    ts.timestamp = timed_sample::clock::now();
+    _telemetry->publish({ telemetry_event::kind::enter, tid, _section, ts });
+}
+
+void section_telemetry::exit(pid_t tid) const
+{
+    timed_sample ts;
+    ts.timestamp = timed_sample::clock::now();
+    _telemetry->publish({ telemetry_event::kind::exit, tid, _section, ts });
+}
+
+void section_telemetry::sample(pid_t tid, const timed_sample& sample) const
+{
+    _telemetry->publish({ telemetry_event::kind::sample, tid, _section, sample });
+}
@@ -0,0 +1,113 @@
+// telemetry.hpp
+
+#pragma once
+
+#include "timed_sample.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace tep
+{
+    class readings_output;
+
+    // the section which telemetry events refer to
+    struct telemetry_section
+    {
+        std::optional<std::string> group;
+        std::optional<std::string> label;
+        std::shared_ptr<const readings_output> rout;
+    };
+
+    struct telemetry_event
+    {
+        enum class kind : uint8_t
+        {
+            enter,
+            exit,
+            sample,
+        };
+
+        kind type;
+        pid_t tid;
+        std::shared_ptr<const telemetry_section> section;
+        // only the timestamp is used by enter and exit events
+        timed_sample sample;
+    };
+
+    // publishes section enter and exit events and samples as they are taken
+    // to the clients connected to a Unix domain socket, one JSON object per line;
+    // events are queued in a bounded queue and written by a background thread,
+    // so that publishing never waits for the clients: events are dropped and
+    // counted when the queue or the buffer of a slow client is full
+    class telemetry
+    {
+    public:
+        static constexpr size_t default_capacity = 8192;
+        // pending output of a client, past which its events are dropped
+        static constexpr size_t max_client_buffer = 1 << 20;
+
+    private:
+        struct client
+        {
+            int fd;
+            std::string buffer;
+        };
+
+        std::string _path;
+        int _fd;
+        size_t _capacity;
+        std::mutex _mx;
+        std::vector<telemetry_event> _queue;
+        std::atomic<uint64_t> _dropped;
+        std::atomic_bool _stop;
+        std::vector<client> _clients;
+        std::thread _thread;
+
+    public:
+        // listens on the socket at <path>, replacing an existing socket file;
+        // throws std::system_error on error
+        explicit telemetry(const std::string& path, size_t capacity = default_capacity);
+        ~telemetry();
+
+        telemetry(const telemetry&) = delete;
+        telemetry& operator=(const telemetry&) = delete;
+
+        // thread-safe, does not wait for the clients
+        void publish(telemetry_event&& event);
+
+        // events dropped so far
+        uint64_t dropped() const noexcept;
+
+    private:
+        void run();
+        void accept_clients();
+        void read_clients(std::vector<size_t>& closed);
+        void write_line(const std::string& line);
+        void flush_clients(std::vector<size_t>& closed);
+        void close_clients(std::vector<size_t>& closed);
+    };
+
+    // the telemetry of a section, held by its start trap
+    class section_telemetry
+    {
+    private:
+        std::shared_ptr<telemetry> _telemetry;
+        std::shared_ptr<const telemetry_section> _section;
+
+    public:
+        section_telemetry(std::shared_ptr<telemetry> tm, telemetry_section section);
+
+        void enter(pid_t tid) const;
+        void exit(pid_t tid) const;
+        void sample(pid_t tid, const timed_sample& sample) const;
+    };
+}
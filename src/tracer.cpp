@@ -6,8 +6,11 @@
 #include "ptrace_misc.hpp"
 #include "tracer.hpp"
 #include "util.hpp"
+#include "journal.hpp"
 #include "log.hpp"
+#include "output.hpp"
 #include "registers.hpp"
+#include "telemetry.hpp"
 #include "trap.hpp"
 #include "trap_types.hpp"
 
@@ -44,6 +47,13 @@ static std::string to_string(const T& obj)
     return ss.str();
 }
 
+static compressed_expected compress(const sampler_expected& values)
+{
+    if (!values)
+        return compressed_expected(nonstd::unexpect, values.error());
+    return compressed_execution(*values);
+}
+
 // end helper functions
 
 // definition of static variables
@@ -123,7 +133,7 @@ void tracer::add_child(const registered_traps& traps, pid_t new_child)
     _children.push_back(
         std::make_unique<tracer>(traps, _tracee_tgid, new_child, _ep,
             std::launch::async, this));
-    log::logline(log::info, "[%d] new child created with tid=%d", gettid(), new_child);
+    TEP_LOG(log::info, "[%d] new child created with tid=%d", gettid(), new_child);
 }
 
 
@@ -139,7 +149,7 @@ tracer_error tracer::stop_tracees(const tracer& excl) const
         error = _parent->stop_self();
         if (error)
             return error;
-        log::logline(log::info, "[%d] stopped parent %d", tid, _parent->tracee());
+        TEP_LOG(log::info, "[%d] stopped parent %d", tid, _parent->tracee());
     }
     for (const auto& child : _children)
     {
@@ -151,7 +161,7 @@ tracer_error tracer::stop_tracees(const tracer& excl) const
         err = child->stop_self();
         if (err)
             return err;
-        log::logline(log::info, "[%d] stopped child %d", tid, child->tracee());
+        TEP_LOG(log::info, "[%d] stopped child %d", tid, child->tracee());
     }
     return tracer_error::success();
 }
@@ -161,7 +171,7 @@ tracer_error tracer::stop_self() const
     if (tgkill(_tracee_tgid, _tracee, SIGSTOP) != 0)
     {
         if (errno == ESRCH)
-            log::logline(log::warning, "[%d] tgkill: no process %d found but continuing anyway",
+            TEP_LOG(log::warning, "[%d] tgkill: no process %d found but continuing anyway",
                 gettid(), _tracee);
         else
             return get_syserror(errno, tracer_errcode::SYSTEM_ERROR, gettid(), "tgkill");
@@ -178,7 +188,7 @@ tracer_error tracer::wait_for_tracee(int& wait_status) const
     return tracer_error::success();
 }
 
-tracer_error tracer::handle_breakpoint(cpu_gp_regs& regs, const trap& t) const
+tracer_error tracer::handle_breakpoint(cpu_gp_regs& regs, long origword) const
 {
     ptrace_wrapper& pw = ptrace_wrapper::instance;
     int errnum;
@@ -190,16 +200,16 @@ tracer_error tracer::handle_breakpoint(cpu_gp_regs& regs, const trap& t) const
     long trap_word = pw.ptrace(errnum, PTRACE_PEEKDATA, _tracee, bp_addr, 0);
     if (errnum)
         return get_syserror(errnum, tracer_errcode::PTRACE_ERROR, tid, "PTRACE_PEEKDATA");
-    log::logline(log::debug, "[%d] peeked word @ 0x%" PRIxPTR " (0x%" PRIxPTR ") with value 0x%lx",
+    TEP_LOG(log::debug, "[%d] peeked word @ 0x%" PRIxPTR " (0x%" PRIxPTR ") with value 0x%lx",
         tid, bp_addr, bp_addr - _ep, trap_word);
 
     // set the registers and write the original word
     if (auto error = regs.setregs())
         return error;
-    if (pw.ptrace(errnum, PTRACE_POKEDATA, _tracee, bp_addr, t.origword()) == -1)
+    if (pw.ptrace(errnum, PTRACE_POKEDATA, _tracee, bp_addr, origword) == -1)
         return get_syserror(errnum, tracer_errcode::PTRACE_ERROR, tid, "PTRACE_POKEDATA");
-    log::logline(log::debug, "[%d] reset original word @ 0x%" PRIxPTR " (0x%" PRIxPTR "), 0x%lx -> 0x%lx",
-        tid, bp_addr, bp_addr - _ep, trap_word, t.origword());
+    TEP_LOG(log::debug, "[%d] reset original word @ 0x%" PRIxPTR " (0x%" PRIxPTR "), 0x%lx -> 0x%lx",
+        tid, bp_addr, bp_addr - _ep, trap_word, origword);
 
     // single-step and reset the trap instruction
     if (pw.ptrace(errnum, PTRACE_SINGLESTEP, _tracee, 0, 0) == -1)
@@ -211,7 +221,7 @@ tracer_error tracer::handle_breakpoint(cpu_gp_regs& regs, const trap& t) const
     // singlestep again to suppress it
     if (WIFSTOPPED(wait_status) && WSTOPSIG(wait_status) == SIGSTOP)
     {
-        log::logline(log::warning, "[%d] tracee %d stopped during single-step because of a SIGSTOP",
+        TEP_LOG(log::warning, "[%d] tracee %d stopped during single-step because of a SIGSTOP",
             tid, _tracee);
         if (pw.ptrace(errnum, PTRACE_SINGLESTEP, _tracee, 0, 0) == -1)
             return get_syserror(errnum, tracer_errcode::PTRACE_ERROR, tid, "PTRACE_SINGLESTEP");
@@ -220,25 +230,36 @@ tracer_error tracer::handle_breakpoint(cpu_gp_regs& regs, const trap& t) const
         cpu_gp_regs regs(_tracee);
         if (auto error = regs.getregs())
             return error;
-        log::logline(log::warning, "[%d] SIGSTOP signal suppressed @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
+        TEP_LOG(log::warning, "[%d] SIGSTOP signal suppressed @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
             regs.get_ip(), regs.get_ip() - _ep);
     }
 
     if (!is_breakpoint_trap(wait_status))
     {
-        log::logline(log::error, "[%d] tried to single-step but process ended"
+        TEP_LOG(log::error, "[%d] tried to single-step but process ended"
             " unexpectedly and, as such, tracing cannot continue", tid);
         return tracer_error(tracer_errcode::UNKNOWN_ERROR);
     }
 
     if (auto error = regs.getregs())
         return error;
-    log::logline(log::info, "[%d] single-stepped @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
+    TEP_LOG(log::info, "[%d] single-stepped @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
         regs.get_ip(), regs.get_ip() - _ep);
 
     return tracer_error::success();
 }
 
+tracer_error tracer::handle_loader_trap(cpu_gp_regs& regs, const loader_trap& t) const
+{
+    pid_t tid = gettid();
+    TEP_LOG(log::info, "[%d] dynamic loader changed the loaded objects", tid);
+    if (auto error = t.notify(_tracee))
+        return error;
+    if (auto error = handle_breakpoint(regs, t.origword()))
+        return error;
+    return reset_trap(t.origword(), t.addr(), t.context());
+}
+
 tracer_error tracer::trace(const registered_traps* traps)
 {
     assert(traps != nullptr);
@@ -249,7 +270,7 @@ tracer_error tracer::trace(const registered_traps* traps)
     ptrace_wrapper& pw = ptrace_wrapper::instance;
     ptrace_restarter pr(tid, _tracee);
 
-    log::logline(log::debug, "[%d] started tracer for tracee with tid %d, entrypoint @ 0x%" PRIxPTR,
+    TEP_LOG(log::debug, "[%d] started tracer for tracee with tid %d, entrypoint @ 0x%" PRIxPTR,
         tid, _tracee, entrypoint);
     while (true)
     {
@@ -258,7 +279,7 @@ tracer_error tracer::trace(const registered_traps* traps)
         if (tracer_error error = wait_for_tracee(wait_status))
             return error;
         const char* sigstr = sig_str(WSTOPSIG(wait_status));
-        log::logline(log::debug, "[%d] waited for tracee %d with signal: %s (status 0x%x)",
+        TEP_LOG(log::debug, "[%d] waited for tracee %d with signal: %s (status 0x%x)",
             tid, _tracee, sigstr ? sigstr : "<no stop signal>", wait_status);
         int errnum;
         if (is_child_event(wait_status))
@@ -276,7 +297,7 @@ tracer_error tracer::trace(const registered_traps* traps)
             unsigned long exit_status;
             if (pw.ptrace(errnum, PTRACE_GETEVENTMSG, _tracee, 0, &exit_status) == -1)
                 return get_syserror(errnum, tracer_errcode::PTRACE_ERROR, tid, "PTRACE_GETEVENTMSG");
-            log::logline(log::debug, "[%d] tracee %d PTRACE_O_TRACEEXIT status %d", tid, _tracee,
+            TEP_LOG(log::debug, "[%d] tracee %d PTRACE_O_TRACEEXIT status %d", tid, _tracee,
                 static_cast<int>(exit_status));
         }
         else if (is_breakpoint_trap(wait_status))
@@ -284,50 +305,72 @@ tracer_error tracer::trace(const registered_traps* traps)
             cpu_gp_regs regs(_tracee);
             if (auto err = regs.getregs())
                 return err;
-            log::logline(log::info, "[%d] reached breakpoint @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
+            TEP_LOG(log::info, "[%d] reached breakpoint @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
                 regs.get_ip(), regs.get_ip() - entrypoint);
 
             std::scoped_lock lock(TRAP_BARRIER);
-            log::logline(log::debug, "[%d] entered global tracer barrier", tid);
+            TEP_LOG(log::debug, "[%d] entered global tracer barrier", tid);
+
+            regs.rewind_trap();
+            if (const loader_trap* ltrap = traps->find_loader(regs.get_ip()))
+            {
+                if (auto error = handle_loader_trap(regs, *ltrap))
+                    return error;
+                TEP_LOG(log::debug, "[%d] exited global tracer barrier", tid);
+                continue;
+            }
 
             // disable tracing of children during execution of section
             auto toggler = ptrace_child_toggler::create(pw, tid, _tracee, false);
             if (!toggler)
                 return std::move(toggler.error());
-            log::logline(log::info, "[%d] child tracing disabled", tid);
-
-            regs.rewind_trap();
+            TEP_LOG(log::info, "[%d] child tracing disabled", tid);
 
+            // the inline fields of the trap are enough to step over it,
+            // the rest of the trap is only read to sample the section
             start_addr start_bp_addr = regs.get_ip();
-            const start_trap* strap = traps->find(start_bp_addr);
-            if (!strap)
+            const trap_hit* start_hit = traps->find_hit(start_bp_addr);
+            if (!start_hit)
             {
-                log::logline(log::error, "[%d] reached start trap which is not registered as "
+                TEP_LOG(log::error, "[%d] reached start trap which is not registered as "
                     "a start trap @ 0x%" PRIxPTR " (offset = 0x%" PRIxPTR ")",
                     tid, start_bp_addr.val(), start_bp_addr.val() - entrypoint);
                 return tracer_error(tracer_errcode::NO_TRAP, "No such trap registered");
             }
-            log::logline(log::info, "[%d] reached starting trap located @ %s",
+            // copied, since insertions in the loaded modules invalidate the hit
+            const long start_origword = start_hit->origword;
+            const bool function_call = start_hit->function_call;
+            const start_trap* strap = &traps->start_trap_of(*start_hit);
+            TEP_LOG(log::info, "[%d] reached starting trap located @ %s",
                 tid, to_string(strap->context()).c_str());
 
-            if (!strap->allow_concurrency())
+            if (!start_hit->allow_concurrency)
             {
-                log::logline(log::info, "[%d] concurrency not allowed; stopping tracees", tid);
+                TEP_LOG(log::info, "[%d] concurrency not allowed; stopping tracees", tid);
                 if (auto error = stop_tracees(*this))
                     return error;
             }
             else
-                log::logline(log::info, "[%d] concurrency allowed; not stopping tracees", tid);
+                TEP_LOG(log::info, "[%d] concurrency allowed; not stopping tracees", tid);
 
-            if (auto error = handle_breakpoint(regs, *strap))
+            if (auto error = handle_breakpoint(regs, start_origword))
                 return error;
             _sampler = strap->create_sampler();
+            // the section telemetry outlives the sampler, traps are only ever added
+            if (const section_telemetry* tm = strap->telemetry())
+            {
+                tm->enter(_tracee);
+                _sampler->set_listener([tm, tracee = _tracee](const timed_sample& ts)
+                    {
+                        tm->sample(tracee, ts);
+                    });
+            }
 
-            auto get_func_return_ctx = [&](const trap_context& x)
+            auto get_func_return_ctx = [&](bool function_call)
                 -> tracer_expected<std::optional<trap_context>>
             {
                 using unexpected = tracer_expected<trap_context>::unexpected_type;
-                if (!x.is_function_call())
+                if (!function_call)
                     return std::nullopt;
                 auto ret_addr = regs.get_return_address();
                 if (!ret_addr)
@@ -336,7 +379,7 @@ tracer_error tracer::trace(const registered_traps* traps)
             };
 
             long origword = 0;
-            auto func_end_ctx = get_func_return_ctx(strap->context());
+            auto func_end_ctx = get_func_return_ctx(function_call);
             if (!func_end_ctx)
                 return std::move(func_end_ctx).error();
             if (*func_end_ctx)
@@ -355,6 +398,26 @@ tracer_error tracer::trace(const registered_traps* traps)
             if (auto error = wait_for_tracee(wait_status))
                 return error;
 
+            // modules may be loaded during the section, e.g., by a call to dlopen
+            while (is_breakpoint_trap(wait_status))
+            {
+                if (auto error = regs.getregs())
+                    return error;
+                regs.rewind_trap();
+                const loader_trap* ltrap = traps->find_loader(regs.get_ip());
+                if (!ltrap)
+                    break;
+                if (auto error = handle_loader_trap(regs, *ltrap))
+                    return error;
+                if (pw.ptrace(errnum, PTRACE_CONT, _tracee, 0, 0) == -1)
+                    return get_syserror(errnum, tracer_errcode::PTRACE_ERROR, tid, "PTRACE_CONT");
+                if (auto error = wait_for_tracee(wait_status))
+                    return error;
+                // the traps inserted in the loaded modules may have relocated the start trap
+                strap = traps->find(start_bp_addr);
+                assert(strap);
+            }
+
             // reached end breakpoint
             if (is_breakpoint_trap(wait_status))
             {
@@ -362,7 +425,7 @@ tracer_error tracer::trace(const registered_traps* traps)
 
                 if (auto error = regs.getregs())
                     return error;
-                log::logline(log::info, "[%d] reached breakpoint @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
+                TEP_LOG(log::info, "[%d] reached breakpoint @ 0x%" PRIxPTR " (0x%" PRIxPTR ")", tid,
                     regs.get_ip(), regs.get_ip() - entrypoint);
 
                 const trap_context* end_ctx = nullptr;
@@ -372,7 +435,7 @@ tracer_error tracer::trace(const registered_traps* traps)
                     auto addr = func_end_ctx.value().value().addr();
                     if (regs.get_ip() != addr)
                     {
-                        log::logline(log::error,
+                        TEP_LOG(log::error,
                             "[%d] reached trap @ 0x%" PRIxPTR " (0x%" PRIxPTR
                             ") which is not %s's return @ 0x%" PRIxPTR,
                             tid,
@@ -382,7 +445,7 @@ tracer_error tracer::trace(const registered_traps* traps)
                             addr);
                         const start_trap* strap = traps->find(start_addr{ regs.get_ip() });
                         if (strap)
-                            log::logline(log::error,
+                            TEP_LOG(log::error,
                                 "[%d] reached trap of %s",
                                 tid,
                                 to_string(strap->context()).c_str());
@@ -394,7 +457,7 @@ tracer_error tracer::trace(const registered_traps* traps)
                     if (pw.ptrace(errnum, PTRACE_POKEDATA, _tracee, addr, origword) == -1)
                         return get_syserror(errnum,
                             tracer_errcode::PTRACE_ERROR, tid, "PTRACE_POKEDATA");
-                    log::logline(log::debug,
+                    TEP_LOG(log::debug,
                         "[%d] reset original word at function return @ 0x%" PRIxPTR
                         " (0x%lx -> 0x%lx)",
                         tid, addr, set_trap(origword), origword);
@@ -403,69 +466,87 @@ tracer_error tracer::trace(const registered_traps* traps)
                 else
                 {
                     end_addr end_bp_addr = regs.get_ip();
-                    const end_trap* etrap = traps->find(end_bp_addr, start_bp_addr);
-                    if (!etrap)
+                    const trap_hit* end_hit = traps->find_hit(end_bp_addr, start_bp_addr);
+                    if (!end_hit)
                     {
-                        log::logline(log::error, "[%d] reached end trap @ 0x%" PRIxPTR
+                        TEP_LOG(log::error, "[%d] reached end trap @ 0x%" PRIxPTR
                             " (offset = 0x%" PRIxPTR ") which does not exist or is not registered as "
                             "an end trap for starting trap @ 0x%" PRIxPTR " (offset = 0x%" PRIxPTR ")",
                             tid, end_bp_addr.val(), end_bp_addr.val() - entrypoint,
                             start_bp_addr.val(), start_bp_addr.val() - entrypoint);
                         return tracer_error(tracer_errcode::NO_TRAP, "No such trap registered");
                     }
-                    log::logline(log::info, "[%d] reached ending trap located @ %s",
-                        tid, to_string(etrap->context()).c_str());
-                    if (auto error = handle_breakpoint(regs, *etrap))
+                    const long end_origword = end_hit->origword;
+                    end_ctx = &traps->end_trap_of(*end_hit).context();
+                    TEP_LOG(log::info, "[%d] reached ending trap located @ %s",
+                        tid, to_string(*end_ctx).c_str());
+                    if (auto error = handle_breakpoint(regs, end_origword))
                         return error;
-                    if (auto err = reset_trap(*etrap, end_bp_addr.val()))
+                    if (auto err = reset_trap(end_origword, end_bp_addr.val(), *end_ctx))
                         return err;
-                    end_ctx = &etrap->context();
                 }
-                if (auto err = reset_trap(*strap, start_bp_addr.val()))
+                if (auto err = reset_trap(start_origword, start_bp_addr.val(), strap->context()))
                     return err;
+                if (const section_telemetry* tm = strap->telemetry())
+                    tm->exit(_tracee);
 
                 // if sampling thread generated an error, register execution as a failed one
                 // in the gathered results collection
                 if (!sampling_results)
-                    log::logline(log::error, "[%d] sampling thread exited with error", tid);
+                    TEP_LOG(log::error, "[%d] sampling thread exited with error", tid);
                 else
-                    log::logline(log::success, "[%d] sampling thread exited successfully with %zu samples",
+                    TEP_LOG(log::success, "[%d] sampling thread exited successfully with %zu samples",
                         tid, sampling_results->size());
-                _results.push_back(
-                    results_entry{
-                        strap->context(),
-                        *end_ctx,
-                        std::move(sampling_results)
-                    });
+                // fold the execution into the statistics of the section right away,
+                // so that its samples are not kept until the end of the run
+                if (sampling_results && strap->stats())
+                {
+                    strap->stats()->add(*sampling_results);
+                    TEP_LOG(log::success, "[%d] folded execution into statistics", tid);
+                    if (strap->journal())
+                        strap->journal()->snapshot(*strap->stats());
+                }
+                // nor if it is only kept in the journal
+                else if (!sampling_results || !strap->journal() ||
+                    !strap->journal()->append(strap->context(), *end_ctx, *sampling_results))
+                {
+                    _results.push_back(
+                        results_entry{
+                            strap->context(),
+                            *end_ctx,
+                            compress(sampling_results),
+                            start_bp_addr.val()
+                        });
+                }
             }
             else
             {
                 if (auto error = regs.getregs())
                     return error;
-                log::logline(log::error, "[%d] received a signal mid-section: %s @ 0x%" PRIxPTR, tid,
+                TEP_LOG(log::error, "[%d] received a signal mid-section: %s @ 0x%" PRIxPTR, tid,
                     strsignal(WSTOPSIG(wait_status)), regs.get_ip());
                 return { tracer_errcode::SIGNAL_DURING_SECTION_ERROR,
                     "Tracee received signal during section execution" };
             }
-            log::logline(log::info, "[%d] child tracing re-enabled", tid);
-            log::logline(log::debug, "[%d] exited global tracer barrier", tid);
+            TEP_LOG(log::info, "[%d] child tracing re-enabled", tid);
+            TEP_LOG(log::debug, "[%d] exited global tracer barrier", tid);
         }
         else if (WIFSTOPPED(wait_status) && WSTOPSIG(wait_status) == SIGSTOP)
         {
             // try to acquire barrier
-            log::logline(log::info, "[%d] stopped tracee with tid=%d", tid, _tracee);
+            TEP_LOG(log::info, "[%d] stopped tracee with tid=%d", tid, _tracee);
             std::scoped_lock lock(TRAP_BARRIER);
-            log::logline(log::info, "[%d] continued tracee with tid=%d", tid, _tracee);
+            TEP_LOG(log::info, "[%d] continued tracee with tid=%d", tid, _tracee);
         }
         else if (WIFEXITED(wait_status))
         {
-            log::logline(log::success, "[%d] tracee %d exited with status %d", tid, _tracee,
+            TEP_LOG(log::success, "[%d] tracee %d exited with status %d", tid, _tracee,
                 WEXITSTATUS(wait_status));
             break;
         }
         else if (WIFSIGNALED(wait_status))
         {
-            log::logline(log::success, "[%d] tracee %d signaled: %s", tid, _tracee,
+            TEP_LOG(log::success, "[%d] tracee %d signaled: %s", tid, _tracee,
                 sig_str(WTERMSIG(wait_status)));
             break;
         }
@@ -474,7 +555,7 @@ tracer_error tracer::trace(const registered_traps* traps)
             cpu_gp_regs regs(_tracee);
             if (tracer_error err = regs.getregs())
                 return err;
-            log::logline(log::debug, "[%d] tracee %d received a signal: %s @ 0x%" PRIxPTR, tid, _tracee,
+            TEP_LOG(log::debug, "[%d] tracee %d received a signal: %s @ 0x%" PRIxPTR, tid, _tracee,
                 strsignal(WSTOPSIG(wait_status)), regs.get_ip());
         }
     }
@@ -495,23 +576,23 @@ bool tep::operator!=(const tracer& lhs, const tracer& rhs)
     return lhs.tracee() != rhs.tracee();
 }
 
-tracer_error tep::tracer::reset_trap(const trap& t, uintptr_t addr) const
+tracer_error tep::tracer::reset_trap(long origword, uintptr_t addr, const trap_context& ctx) const
 {
     int errnum;
     pid_t tid = gettid();
     auto& pw = ptrace_wrapper::instance;
     if (pw.ptrace(errnum, PTRACE_POKEDATA, _tracee,
-        addr, set_trap(t.origword())) == -1)
+        addr, set_trap(origword)) == -1)
     {
         return get_syserror(errnum,
             tracer_errcode::PTRACE_ERROR, tid, "PTRACE_POKEDATA");
     }
-    log::logline(log::debug,
+    TEP_LOG(log::debug,
         "[%d] reset %s trap word @ 0x%" PRIxPTR
         " (0x%" PRIxPTR "), 0x%lx -> 0x%lx",
         tid,
-        to_string(t.context()).c_str(),
+        to_string(ctx).c_str(),
         addr, addr - _ep,
-        t.origword(), set_trap(t.origword()));
+        origword, set_trap(origword));
     return tracer_error::success();
 }
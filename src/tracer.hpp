@@ -7,6 +7,7 @@
 #include <mutex>
 #include <unordered_map>
 
+#include "compressed_execution.hpp"
 #include "reader_container.hpp"
 #include "error.hpp"
 #include "sampler.hpp"
@@ -19,17 +20,24 @@ namespace tep
 {
 
     class cpu_gp_regs;
+    class loader_trap;
     class registered_traps;
     class trap;
 
     template<typename R>
     using tracer_expected = nonstd::expected<R, tracer_error>;
 
+    // executions are compressed as soon as they are gathered,
+    // since they are kept until the end of the run
+    using compressed_expected = nonstd::expected<compressed_execution, std::error_code>;
+
     struct results_entry
     {
         trap_context start;
         trap_context end;
-        sampler_expected values;
+        compressed_expected values;
+        // runtime address of the start trap
+        uintptr_t address;
     };
 
     class tracer
@@ -81,8 +89,10 @@ namespace tep
         tracer_error stop_tracees(const tracer& excl) const;
         tracer_error stop_self() const;
         tracer_error wait_for_tracee(int& wait_status) const;
-        tracer_error reset_trap(const trap&, uintptr_t addr) const;
-        tracer_error handle_breakpoint(cpu_gp_regs& regs, const trap&) const;
+        // the context of the trap is only used for logging
+        tracer_error reset_trap(long origword, uintptr_t addr, const trap_context&) const;
+        tracer_error handle_breakpoint(cpu_gp_regs& regs, long origword) const;
+        tracer_error handle_loader_trap(cpu_gp_regs& regs, const loader_trap&) const;
         tracer_error trace(const registered_traps* traps);
     };
 
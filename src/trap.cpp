@@ -5,7 +5,9 @@
 #include <iostream>
 
 #include "trap.hpp"
+#include "error.hpp"
 #include "sampler.hpp"
+#include "trap_types.hpp"
 
 using namespace tep;
 
@@ -123,6 +125,36 @@ std::unique_ptr<sampler> start_trap::create_sampler() const
     return _creator();
 }
 
+section_stats* start_trap::stats() const noexcept
+{
+    return _stats.get();
+}
+
+void start_trap::set_stats(std::shared_ptr<section_stats> stats)
+{
+    _stats = std::move(stats);
+}
+
+const section_journal* start_trap::journal() const noexcept
+{
+    return _journal.get();
+}
+
+void start_trap::set_journal(std::shared_ptr<const section_journal> journal)
+{
+    _journal = std::move(journal);
+}
+
+const section_telemetry* start_trap::telemetry() const noexcept
+{
+    return _telemetry.get();
+}
+
+void start_trap::set_telemetry(std::shared_ptr<const section_telemetry> telemetry)
+{
+    _telemetry = std::move(telemetry);
+}
+
 end_trap::end_trap(long origword, trap_context ctx, start_addr addr) :
     trap(origword, std::move(ctx)),
     _start(addr)
@@ -139,16 +171,113 @@ void end_trap::print(std::ostream& os) const
     os << " <-> " << associated_with();
 }
 
+loader_trap::loader_trap(long origword, uintptr_t addr, callback cb) :
+    trap(origword, trap_context{ address{ addr, nullptr } }),
+    _addr(addr),
+    _callback(std::move(cb))
+{}
+
+uintptr_t loader_trap::addr() const noexcept
+{
+    return _addr;
+}
+
+tracer_error loader_trap::notify(pid_t tid) const
+{
+    return _callback(tid);
+}
+
+registered_traps::address_index::address_index() :
+    _slots(16, slot{ 0, 0, 0, trap_hit::npos, false, false }),
+    _size(0),
+    _shift(std::numeric_limits<uintptr_t>::digits - 4)
+{}
+
+size_t registered_traps::address_index::home(uintptr_t addr) const noexcept
+{
+    // Fibonacci hashing spreads nearby code addresses across the table
+    return static_cast<size_t>((addr * UINT64_C(0x9e3779b97f4a7c15)) >> _shift);
+}
+
+bool registered_traps::address_index::insert(const trap_hit& hit)
+{
+    assert(hit.idx != trap_hit::npos);
+    if (find(hit.addr))
+        return false;
+    // keep the load factor at or below 1/2 so that probe sequences stay short
+    if (2 * (_size + 1) > _slots.size())
+        grow();
+    size_t mask = _slots.size() - 1;
+    size_t pos = home(hit.addr);
+    while (_slots[pos].idx != trap_hit::npos)
+        pos = (pos + 1) & mask;
+    _slots[pos] = hit;
+    _size++;
+    return true;
+}
+
+const trap_hit* registered_traps::address_index::find(uintptr_t addr) const noexcept
+{
+    size_t mask = _slots.size() - 1;
+    for (size_t pos = home(addr); _slots[pos].idx != trap_hit::npos; pos = (pos + 1) & mask)
+        if (_slots[pos].addr == addr)
+            return &_slots[pos];
+    return nullptr;
+}
+
+void registered_traps::address_index::grow()
+{
+    std::vector<slot> old(_slots.size() * 2, slot{ 0, 0, 0, trap_hit::npos, false, false });
+    old.swap(_slots);
+    _shift--;
+    size_t mask = _slots.size() - 1;
+    for (const slot& s : old)
+    {
+        if (s.idx == trap_hit::npos)
+            continue;
+        size_t pos = home(s.addr);
+        while (_slots[pos].idx != trap_hit::npos)
+            pos = (pos + 1) & mask;
+        _slots[pos] = s;
+    }
+}
+
 std::pair<const start_trap*, bool> registered_traps::insert(start_addr a, start_trap&& st)
 {
-    auto [it, inserted] = _start_traps.insert({ a, std::move(st) });
-    return { &it->second, inserted };
+    trap_hit hit{
+        a.val(),
+        st.origword(),
+        a.val(),
+        static_cast<uint32_t>(_start_traps.size()),
+        st.allow_concurrency(),
+        st.context().is_function_call()
+    };
+    if (!_start_index.insert(hit))
+        return { find(a), false };
+    _start_traps.push_back(std::move(st));
+    return { &_start_traps.back(), true };
 }
 
 std::pair<const end_trap*, bool> registered_traps::insert(end_addr a, end_trap&& et)
 {
-    auto [it, inserted] = _end_traps.insert({ a, std::move(et) });
-    return { &it->second, inserted };
+    trap_hit hit{
+        a.val(),
+        et.origword(),
+        et.associated_with().val(),
+        static_cast<uint32_t>(_end_traps.size()),
+        false,
+        false
+    };
+    if (!_end_index.insert(hit))
+        return { &_end_traps[_end_index.find(a.val())->idx], false };
+    _end_traps.push_back(std::move(et));
+    return { &_end_traps.back(), true };
+}
+
+const loader_trap* registered_traps::insert(loader_trap&& lt)
+{
+    _loader.emplace(std::move(lt));
+    return &*_loader;
 }
 
 const start_trap* registered_traps::find(start_addr addr) const
@@ -171,24 +300,54 @@ end_trap* registered_traps::find(end_addr ea, start_addr sa)
     return find_impl(*this, ea, sa);
 }
 
+const trap_hit* registered_traps::find_hit(start_addr addr) const noexcept
+{
+    return _start_index.find(addr.val());
+}
+
+const trap_hit* registered_traps::find_hit(end_addr eaddr, start_addr saddr) const noexcept
+{
+    const trap_hit* hit = _end_index.find(eaddr.val());
+    if (!hit || hit->start != saddr.val())
+        return nullptr;
+    return hit;
+}
+
+const start_trap& registered_traps::start_trap_of(const trap_hit& hit) const noexcept
+{
+    assert(hit.idx < _start_traps.size());
+    return _start_traps[hit.idx];
+}
+
+const end_trap& registered_traps::end_trap_of(const trap_hit& hit) const noexcept
+{
+    assert(hit.idx < _end_traps.size());
+    return _end_traps[hit.idx];
+}
+
+const loader_trap* registered_traps::find_loader(uintptr_t addr) const
+{
+    if (_loader && _loader->addr() == addr)
+        return &*_loader;
+    return nullptr;
+}
+
 template<typename T>
 auto registered_traps::find_impl(T& instance, start_addr addr)
 -> decltype(instance.find(addr))
 {
-    auto it = instance._start_traps.find(addr);
-    if (it == instance._start_traps.end())
+    const trap_hit* hit = instance._start_index.find(addr.val());
+    if (!hit)
         return nullptr;
-    return &it->second;
+    return &instance._start_traps[hit->idx];
 }
 
 template<typename T>
 auto registered_traps::find_impl(T& instance, end_addr eaddr, start_addr saddr)
 -> decltype(instance.find(eaddr, saddr))
 {
-    auto it = instance._end_traps.find(eaddr);
-    if (it == instance._end_traps.end())
-        return nullptr;
-    if (it->second.associated_with() != saddr)
+    const trap_hit* hit = instance.find_hit(eaddr, saddr);
+    if (!hit)
         return nullptr;
-    return &it->second;
+    return &instance._end_traps[hit->idx];
 }
@@ -8,14 +8,22 @@
 #include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <limits>
 #include <memory>
-#include <unordered_map>
+#include <optional>
 #include <variant>
+#include <vector>
+
+#include <sys/types.h>
 
 namespace tep
 {
 
     class sampler;
+    class section_journal;
+    class section_stats;
+    class section_telemetry;
+    class tracer_error;
 
     using sampler_creator = std::function<std::unique_ptr<sampler>()>;
 
@@ -88,6 +96,12 @@ namespace tep
     private:
         bool _allow_concurrency;
         sampler_creator _creator;
+        // set if the executions are folded into statistics instead of being kept
+        std::shared_ptr<section_stats> _stats;
+        // set if the executions are appended to the journal as they finish
+        std::shared_ptr<const section_journal> _journal;
+        // set if the executions and their samples are published as they happen
+        std::shared_ptr<const section_telemetry> _telemetry;
 
     public:
         template<typename Creator>
@@ -99,11 +113,23 @@ namespace tep
             :
             trap(origword, std::move(ctx)),
             _allow_concurrency(allow_concurrency),
-            _creator(std::forward<Creator>(callable))
+            _creator(std::forward<Creator>(callable)),
+            _stats(),
+            _journal(),
+            _telemetry()
         {}
 
         bool allow_concurrency() const noexcept;
         std::unique_ptr<sampler> create_sampler() const;
+
+        section_stats* stats() const noexcept;
+        void set_stats(std::shared_ptr<section_stats>);
+
+        const section_journal* journal() const noexcept;
+        void set_journal(std::shared_ptr<const section_journal>);
+
+        const section_telemetry* telemetry() const noexcept;
+        void set_telemetry(std::shared_ptr<const section_telemetry>);
     };
 
     class end_trap : public trap
@@ -120,17 +146,84 @@ namespace tep
         void print(std::ostream&) const override;
     };
 
+    // trap at the function which the dynamic loader calls whenever it changes
+    // the list of loaded objects, used to insert traps in modules loaded at run time
+    class loader_trap : public trap
+    {
+    public:
+        using callback = std::function<tracer_error(pid_t)>;
+
+    private:
+        uintptr_t _addr;
+        callback _callback;
+
+    public:
+        loader_trap(long origword, uintptr_t addr, callback);
+
+        uintptr_t addr() const noexcept;
+
+        // invoked with the tid of the stopped thread which reached the trap
+        tracer_error notify(pid_t tid) const;
+    };
+
+    // the fields of a registered trap which are read whenever it is hit,
+    // stored inline in the slots of the table which indexes the traps
+    struct alignas(32) trap_hit
+    {
+        static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+        uintptr_t addr;
+        long origword;
+        // the address of the start trap of end traps, the trap's own address otherwise
+        uintptr_t start;
+        // index of the rest of the trap, npos if the slot is empty
+        uint32_t idx;
+        bool allow_concurrency;
+        bool function_call;
+    };
+
+    static_assert(sizeof(trap_hit) == 32, "two slots must fit in a cache line");
+
+    // traps are stored contiguously and indexed by a flat open addressing table,
+    // so that the lookup done on every breakpoint hit probes a single slot
+    // in the common case instead of chasing hash map node pointers;
+    // the slot holds everything needed to step over the trap, so the rest of the
+    // trap, i.e., its context, sampler creator and outputs, is only read to sample
     class registered_traps
     {
     private:
-        using start_traps = std::unordered_map<start_addr, start_trap, start_addr::hash>;
-        using end_traps = std::unordered_map<end_addr, end_trap, end_addr::hash>;
-        start_traps _start_traps;
-        end_traps _end_traps;
+        class address_index
+        {
+        public:
+            address_index();
+
+            // returns false if the address already exists
+            bool insert(const trap_hit&);
+            const trap_hit* find(uintptr_t addr) const noexcept;
+
+        private:
+            using slot = trap_hit;
+
+            std::vector<slot> _slots;
+            size_t _size;
+            uint32_t _shift;
+
+            size_t home(uintptr_t addr) const noexcept;
+            void grow();
+        };
+
+        std::vector<start_trap> _start_traps;
+        std::vector<end_trap> _end_traps;
+        address_index _start_index;
+        address_index _end_index;
+        std::optional<loader_trap> _loader;
 
     public:
+        // the returned pointers are invalidated by subsequent insertions
         std::pair<const start_trap*, bool> insert(start_addr, start_trap&&);
         std::pair<const end_trap*, bool> insert(end_addr, end_trap&&);
+        // there is at most one loader trap, which is replaced if it already exists
+        const loader_trap* insert(loader_trap&&);
 
         // finds the start_trap associated with start_addr
         // returns nullptr if not found
@@ -144,6 +237,20 @@ namespace tep
         const end_trap* find(end_addr, start_addr) const;
         end_trap* find(end_addr, start_addr);
 
+        // finds the inline fields of the trap at start_addr or, for end_addr, the end trap
+        // at end_addr associated with start_addr, like find does
+        // the returned pointers are invalidated by subsequent insertions
+        const trap_hit* find_hit(start_addr) const noexcept;
+        const trap_hit* find_hit(end_addr, start_addr) const noexcept;
+
+        // the trap whose inline fields were found with find_hit
+        const start_trap& start_trap_of(const trap_hit&) const noexcept;
+        const end_trap& end_trap_of(const trap_hit&) const noexcept;
+
+        // finds the loader trap if located at addr
+        // returns nullptr if not found
+        const loader_trap* find_loader(uintptr_t addr) const;
+
     private:
         template<typename T>
         static auto find_impl(T& instance, start_addr addr)
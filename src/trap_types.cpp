@@ -1,4 +1,5 @@
 #include "trap_types.hpp"
+#include "modules.hpp"
 #include "dbg/elf.hpp"
 #include "dbg/dwarf.hpp"
 #include "dbg/demangle.hpp"
@@ -142,6 +143,17 @@ namespace tep
         jfunc["instance"] = *x.inst;
         j["inlined_call"] = std::move(jfunc);
     }
+
+    template<typename T>
+    static void to_json(nlohmann::json& j, const in_module<T>& x)
+    {
+        to_json(j, static_cast<const T&>(x));
+        nlohmann::json jmod;
+        jmod["name"] = x.module->name;
+        jmod["path"] = x.module->object.path.native();
+        jmod["base"] = address_to_hex_string(x.module->object.base);
+        j["module"] = std::move(jmod);
+    }
 }
 
 namespace tep
@@ -218,31 +230,62 @@ namespace tep
 
     output_writer& operator<<(output_writer& ow, const address& x)
     {
-        ow.json = x;
+        ow.value(nlohmann::json(x));
         return ow;
     }
 
     output_writer& operator<<(output_writer& ow, const function_call& x)
     {
-        ow.json = x;
+        ow.value(nlohmann::json(x));
         return ow;
     }
 
     output_writer& operator<<(output_writer& ow, const function_return& x)
     {
-        ow.json = x;
+        ow.value(nlohmann::json(x));
         return ow;
     }
 
     output_writer& operator<<(output_writer& ow, const inline_function& x)
     {
-        ow.json = x;
+        ow.value(nlohmann::json(x));
         return ow;
     }
 
     output_writer& operator<<(output_writer& ow, const source_line& x)
     {
-        ow.json = x;
+        ow.value(nlohmann::json(x));
+        return ow;
+    }
+
+    template<typename T>
+    std::string to_string(const in_module<T>& x)
+    {
+        return cmmn::concat(x.module->name, "!",
+            to_string(static_cast<const T&>(x)));
+    }
+
+    template<typename T>
+    std::ostream& operator<<(std::ostream& os, const in_module<T>& x)
+    {
+        os << to_string(x);
+        return os;
+    }
+
+    template<typename T>
+    output_writer& operator<<(output_writer& ow, const in_module<T>& x)
+    {
+        ow.value(nlohmann::json(x));
         return ow;
     }
+
+    template std::string to_string(const in_module<address>&);
+    template std::string to_string(const in_module<function_call>&);
+    template std::string to_string(const in_module<inline_function>&);
+    template std::ostream& operator<<(std::ostream&, const in_module<address>&);
+    template std::ostream& operator<<(std::ostream&, const in_module<function_call>&);
+    template std::ostream& operator<<(std::ostream&, const in_module<inline_function>&);
+    template output_writer& operator<<(output_writer&, const in_module<address>&);
+    template output_writer& operator<<(output_writer&, const in_module<function_call>&);
+    template output_writer& operator<<(output_writer&, const in_module<inline_function>&);
 } // namespace tep
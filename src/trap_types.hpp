@@ -8,6 +8,8 @@
 
 namespace tep
 {
+    struct loaded_module;
+
     struct address
     {
         using is_trap_context = void;
@@ -40,21 +42,35 @@ namespace tep
         const dbg::source_line* line;
     };
 
+    // context located in a module instead of the executable,
+    // whose address is relative to the module's base
+    template<typename T>
+    struct in_module : T
+    {
+        const loaded_module* module;
+    };
+
     std::string to_string(const address&);
     std::string to_string(const function_call&);
     std::string to_string(const function_return&);
     std::string to_string(const inline_function&);
     std::string to_string(const source_line&);
+    template<typename T>
+    std::string to_string(const in_module<T>&);
 
     std::ostream& operator<<(std::ostream&, const address&);
     std::ostream& operator<<(std::ostream&, const function_call&);
     std::ostream& operator<<(std::ostream&, const function_return&);
     std::ostream& operator<<(std::ostream&, const inline_function&);
     std::ostream& operator<<(std::ostream&, const source_line&);
+    template<typename T>
+    std::ostream& operator<<(std::ostream&, const in_module<T>&);
 
     output_writer& operator<<(output_writer&, const address&);
     output_writer& operator<<(output_writer&, const function_call&);
     output_writer& operator<<(output_writer&, const function_return&);
     output_writer& operator<<(output_writer&, const inline_function&);
     output_writer& operator<<(output_writer&, const source_line&);
+    template<typename T>
+    output_writer& operator<<(output_writer&, const in_module<T>&);
 } // namespace tep
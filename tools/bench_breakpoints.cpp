@@ -0,0 +1,189 @@
+// bench_breakpoints.cpp
+// measures the latency of a breakpoint hit with logging off and on: a traced child executes
+// trap instructions in a loop and every hit is handled with the register reads and messages
+// of the tracer when it reaches a start trap, so that the cost of the messages is relative
+// to the cost of stopping and resuming the tracee
+
+#include "error.hpp"
+#include "log.hpp"
+#include "ptrace_wrapper.hpp"
+#include "registers.hpp"
+#include "trap_context.hpp"
+#include "trap_types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace tep;
+
+namespace
+{
+    // forked by the thread of ptrace_wrapper, which makes the requests of the tracer
+    void run_tracee(char* const argv[])
+    {
+        size_t hits = std::strtoull(argv[0], nullptr, 10);
+        if (ptrace(PTRACE_TRACEME, 0, 0, 0) == -1)
+            return;
+        raise(SIGSTOP);
+        for (size_t i = 0; i < hits; i++)
+        {
+        #if defined(__x86_64__) || defined(__i386__)
+            asm volatile("int3");
+        #elif defined(__powerpc64__)
+            asm volatile("trap");
+        #endif
+        }
+        _exit(0);
+    }
+
+    bool is_trap(int wait_status)
+    {
+        return WIFSTOPPED(wait_status) && WSTOPSIG(wait_status) == SIGTRAP;
+    }
+
+    // the latencies of every hit, in ns, from resuming the tracee until it is resumed again
+    bool trace(pid_t tracee, size_t hits, std::vector<double>& latencies)
+    {
+        pid_t tid = gettid();
+        int errnum;
+        int wait_status;
+        if (waitpid(tracee, &wait_status, 0) != tracee || !WIFSTOPPED(wait_status))
+            return false;
+        trap_context ctx{ address{ 0x401000, nullptr } };
+        latencies.reserve(hits);
+        auto start = std::chrono::steady_clock::now();
+        if (ptrace_wrapper::instance.ptrace(errnum, PTRACE_CONT, tracee, 0, 0) == -1)
+            return false;
+        while (waitpid(tracee, &wait_status, 0) == tracee && is_trap(wait_status))
+        {
+            cpu_gp_regs regs(tracee);
+            if (regs.getregs())
+                return false;
+            TEP_LOG(log::info, "[%d] reached breakpoint @ 0x%" PRIxPTR, tid, regs.get_ip());
+            TEP_LOG(log::debug, "[%d] entered global tracer barrier", tid);
+            TEP_LOG(log::info, "[%d] child tracing disabled", tid);
+            TEP_LOG(log::info, "[%d] reached starting trap located @ %s",
+                tid, to_string(ctx).c_str());
+            TEP_LOG(log::info, "[%d] concurrency allowed; not stopping tracees", tid);
+        #if defined(__powerpc64__)
+            // the instruction pointer is not advanced past the trap
+            regs.set_ip(regs.get_ip() + 4);
+            if (regs.setregs())
+                return false;
+        #endif
+            if (ptrace_wrapper::instance.ptrace(errnum, PTRACE_CONT, tracee, 0, 0) == -1)
+                return false;
+            auto now = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(now - start).count());
+            start = now;
+        }
+        return WIFEXITED(wait_status) && !WEXITSTATUS(wait_status) && latencies.size() == hits;
+    }
+
+    double percentile(std::vector<double>& values, double p)
+    {
+        size_t ix = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+        std::nth_element(values.begin(), values.begin() + ix, values.end());
+        return values[ix];
+    }
+
+    // run in a process of its own, since the logger is initialized once per process
+    int run_mode(const char* name, const std::string& log_path, char* hits_arg)
+    {
+        bool quiet = std::strcmp(name, "off") == 0;
+        log::init(quiet, quiet ? "" : log_path);
+        size_t hits = std::strtoull(hits_arg, nullptr, 10);
+        char* const tracee_args[] = { hits_arg, nullptr };
+        int errnum;
+        pid_t tracee = ptrace_wrapper::instance.fork(errnum, &run_tracee, tracee_args);
+        if (tracee == -1)
+        {
+            std::cerr << "fork: " << strerror(errnum) << "\n";
+            return 1;
+        }
+        std::vector<double> latencies;
+        if (!trace(tracee, hits, latencies))
+        {
+            std::cerr << name << ": tracing failed\n";
+            kill(tracee, SIGKILL);
+            return 1;
+        }
+        double mean = 0;
+        for (double l : latencies)
+            mean += l / latencies.size();
+        std::cout << std::left << std::setw(10) << name << std::right
+            << std::fixed << std::setprecision(0)
+            << std::setw(12) << mean
+            << std::setw(12) << percentile(latencies, 0.5)
+            << std::setw(12) << percentile(latencies, 0.99) << std::endl;
+        // the queued messages are written before exiting
+        log::flush();
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 5 && std::strcmp(argv[1], "--mode") == 0)
+        return run_mode(argv[2], argv[4], argv[3]);
+
+    size_t hits = 100000;
+    std::string log_path = "/dev/null";
+    if (argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " [hits (default: " << hits << ")] "
+            << "[log file (default: " << log_path << ")]\n";
+        return 1;
+    }
+    if (argc > 1)
+    {
+        char* end;
+        hits = std::strtoull(argv[1], &end, 10);
+        if (*end || end == argv[1] || !hits)
+        {
+            std::cerr << "invalid number of hits '" << argv[1] << "'\n";
+            return 1;
+        }
+    }
+    if (argc > 2)
+        log_path = argv[2];
+
+    std::cout << "hits: " << hits << ", log: " << log_path << "\n"
+        << std::left << std::setw(10) << "logging" << std::right
+        << std::setw(12) << "mean (ns)"
+        << std::setw(12) << "p50 (ns)"
+        << std::setw(12) << "p99 (ns)" << std::endl;
+    // quiet only enables errors, which are not written on a hit
+    std::string hits_arg = std::to_string(hits);
+    bool success = true;
+    for (const char* mode : { "off", "on" })
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cerr << "fork: " << strerror(errno) << "\n";
+            return 1;
+        }
+        if (!pid)
+        {
+            execl("/proc/self/exe", argv[0], "--mode", mode, hits_arg.c_str(),
+                log_path.c_str(), nullptr);
+            _exit(1);
+        }
+        int status;
+        success &= waitpid(pid, &status, 0) == pid && WIFEXITED(status) && !WEXITSTATUS(status);
+    }
+    return !success;
+}
@@ -0,0 +1,205 @@
+// bench_compression.cpp
+// measures the delta and varint encoding of samples, in memory and in the columns of the binary format:
+// the throughput of encoding and decoding them and their size against the raw samples
+
+#include "compressed_execution.hpp"
+#include "output/binary_writer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace tep;
+
+namespace
+{
+    // the events which are read, e.g., the package, cores and memory of two sockets
+    constexpr size_t active_cpu_events = 6;
+    constexpr size_t active_gpu_devices = 1;
+    constexpr size_t repetitions = 5;
+
+    // the samples of an execution sampled every 10 ms, whose counters increase by
+    // a few thousand units between samples, like the energy counters of a busy system
+    timed_execution make_execution(size_t count)
+    {
+        std::mt19937_64 gen(count);
+        std::uniform_int_distribution<uint64_t> jitter(0, 50000);
+        std::uniform_int_distribution<uint64_t> energy(1000, 20000);
+        std::uniform_int_distribution<uint32_t> power(50000, 250000);
+
+        timed_execution retval(count);
+        timed_sample::time_point tp = timed_sample::clock::now();
+        for (size_t i = 0; i < count; i++)
+        {
+            timed_sample& ts = retval[i];
+            if (i)
+                ts = retval[i - 1];
+            tp += std::chrono::milliseconds(10) + std::chrono::nanoseconds(jitter(gen));
+            ts.timestamp = tp;
+            auto& data = ts.sample.data;
+            for (size_t e = 0; e < active_cpu_events; e++)
+            {
+            #if defined NRG_X86_64
+                data.cpu[e] += energy(gen);
+            #elif defined NRG_PPC64
+                data.timestamps[e] += 500000 + jitter(gen);
+                data.cpu[e] = static_cast<uint16_t>(power(gen) / 1000);
+                data.accumulators[e] += energy(gen);
+            #endif
+            }
+            for (size_t d = 0; d < active_gpu_devices; d++)
+            {
+                data.gpu_power[d] = power(gen);
+                data.gpu_energy[d] += energy(gen);
+            }
+        }
+        return retval;
+    }
+
+    // the columns the binary format writes for the execution
+    std::vector<std::vector<uint64_t>> make_columns(const timed_execution& exec)
+    {
+        std::vector<std::vector<uint64_t>> retval(1 + active_cpu_events + 2 * active_gpu_devices);
+        for (const auto& ts : exec)
+        {
+            auto col = retval.begin();
+            (col++)->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                ts.timestamp.time_since_epoch()).count());
+            const auto& data = ts.sample.data;
+            for (size_t e = 0; e < active_cpu_events; e++)
+            {
+            #if defined NRG_X86_64
+                (col++)->push_back(data.cpu[e]);
+            #elif defined NRG_PPC64
+                (col++)->push_back(data.accumulators[e]);
+            #endif
+            }
+            for (size_t d = 0; d < active_gpu_devices; d++)
+            {
+                (col++)->push_back(data.gpu_power[d]);
+                (col++)->push_back(data.gpu_energy[d]);
+            }
+        }
+        return retval;
+    }
+
+    template<typename Func>
+    double best_seconds(Func&& func)
+    {
+        double retval = 0;
+        for (size_t r = 0; r < repetitions; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            double elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+            if (!r || elapsed < retval)
+                retval = elapsed;
+        }
+        return retval;
+    }
+
+    void print_row(const char* name, size_t samples, size_t raw, size_t encoded,
+        double encode, double decode)
+    {
+        std::cout << std::left << std::setw(10) << name << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(14) << static_cast<double>(encoded) / samples
+            << std::setw(10) << static_cast<double>(raw) / encoded
+            << std::setw(16) << samples / encode / 1e6
+            << std::setw(16) << samples / decode / 1e6 << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t samples = 1000000;
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [samples (default: " << samples << ")]\n";
+        return 1;
+    }
+    if (argc == 2)
+    {
+        char* end;
+        samples = std::strtoull(argv[1], &end, 10);
+        if (*end || end == argv[1] || !samples)
+        {
+            std::cerr << "invalid number of samples '" << argv[1] << "'\n";
+            return 1;
+        }
+    }
+
+    timed_execution exec = make_execution(samples);
+    std::cout << "samples: " << samples << ", raw sample: " << sizeof(timed_sample) << " bytes\n"
+        << std::left << std::setw(10) << "encoding" << std::right
+        << std::setw(14) << "bytes/sample"
+        << std::setw(10) << "ratio"
+        << std::setw(16) << "encode (M/s)"
+        << std::setw(16) << "decode (M/s)" << "\n";
+
+    // in memory, the whole sample
+    {
+        compressed_execution compressed;
+        double encode = best_seconds([&]()
+            {
+                compressed = compressed_execution(exec);
+            });
+        timed_execution decompressed;
+        double decode = best_seconds([&]()
+            {
+                decompressed = compressed.decompress();
+            });
+        if (decompressed != exec)
+        {
+            std::cerr << "decompressed execution differs from the original\n";
+            return 1;
+        }
+        print_row("memory", samples, samples * sizeof(timed_sample), compressed.bytes(),
+            encode, decode);
+    }
+
+    // on disk, only the columns of the events which are read
+    {
+        std::vector<std::vector<uint64_t>> columns = make_columns(exec);
+        std::string encoded;
+        double encode = best_seconds([&]()
+            {
+                std::ostringstream os;
+                binary_writer writer(os);
+                for (const auto& col : columns)
+                    writer.write_deltas(col);
+                encoded = os.str();
+            });
+        std::vector<std::vector<uint64_t>> decoded(columns.size());
+        double decode = best_seconds([&]()
+            {
+                const uint8_t* it = reinterpret_cast<const uint8_t*>(encoded.data());
+                const uint8_t* end = it + encoded.size();
+                for (auto& col : decoded)
+                {
+                    uint64_t size;
+                    std::memcpy(&size, it, sizeof(size));
+                    it += sizeof(size);
+                    const uint8_t* col_end = it + size;
+                    col.clear();
+                    uint64_t value = 0;
+                    while (it != col_end && varint::get_delta(it, end, value, value))
+                        col.push_back(value);
+                }
+            });
+        if (decoded != columns)
+        {
+            std::cerr << "decoded columns differ from the original\n";
+            return 1;
+        }
+        print_row("disk", samples, columns.size() * samples * sizeof(uint64_t), encoded.size(),
+            encode, decode);
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// bench_output.cpp
+// measures the time to write the results in JSON and in the binary format against the number
+// of executions; the readings are those of a synthetic reader of two sockets with three locations,
+// since the readers of the hardware cannot be created without it, so what is measured
+// is the decompression of the executions and their serialization on every core
+
+#include "output.hpp"
+#include "trap_types.hpp"
+#include "output/binary_writer.hpp"
+#include "output/output_writer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <streambuf>
+
+using namespace tep;
+
+namespace
+{
+    constexpr uint32_t sockets = 2;
+    constexpr const char* locations[] = { "dram", "package", "uncore" };
+    constexpr size_t samples_per_execution = 10;
+
+    // counts the bytes written and discards them, so that the storage is not measured
+    class null_buffer : public std::streambuf
+    {
+    private:
+        uint64_t _bytes = 0;
+
+    public:
+        uint64_t bytes() const noexcept
+        {
+            return _bytes;
+        }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            _bytes++;
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char_type*, std::streamsize count) override
+        {
+            _bytes += count;
+            return count;
+        }
+    };
+
+    // readings derived from the timestamps of the samples, in the layout
+    // of the readings of the CPU sockets
+    class synthetic_readings final : public readings_output
+    {
+    private:
+        static uint64_t value(const timed_sample& ts, uint32_t skt, size_t loc)
+        {
+            return static_cast<uint64_t>(ts.timestamp.time_since_epoch().count() / 1000) *
+                (skt + 1) + loc;
+        }
+
+    public:
+        void output(output_writer& os, const timed_execution& exec) const override
+        {
+            os.key("cpu").begin_array();
+            for (uint32_t skt = 0; skt < sockets; skt++)
+            {
+                os.begin_object();
+                for (size_t loc = 0; loc < std::size(locations); loc++)
+                {
+                    // the socket is written between the package and uncore locations
+                    if (loc == 2)
+                        os.key("socket").value(skt);
+                    os.key(locations[loc]).begin_array();
+                    for (const auto& ts : exec)
+                    {
+                        os.begin_array();
+                        os.value(value(ts, skt, loc) * 1e-6);
+                        os.end_array();
+                    }
+                    os.end_array();
+                }
+                os.end_object();
+            }
+            os.end_array();
+        }
+
+        void output(binary_writer& os, const timed_execution& exec) const override
+        {
+            os.write(binary::readings_kind::cpu);
+            os.write(static_cast<uint8_t>(0));
+            os.write(sockets);
+            std::vector<uint64_t> column(exec.size());
+            for (uint32_t skt = 0; skt < sockets; skt++)
+            {
+                os.write(skt);
+                for (size_t loc = 0; loc < std::size(locations); loc++)
+                {
+                    for (size_t ix = 0; ix < exec.size(); ix++)
+                        column[ix] = value(exec[ix], skt, loc);
+                    os.write(static_cast<uint64_t>(column.size())).write_deltas(column);
+                }
+            }
+        }
+
+        void energy(const timed_execution&, std::vector<sensor_energy>&) const override
+        {}
+    };
+
+    profiling_results make_results(size_t executions)
+    {
+        std::mt19937_64 gen(executions);
+        std::uniform_int_distribution<int64_t> jitter(0, 50000);
+
+        profiling_results retval;
+        group_output& go = retval.groups().emplace_back("group", std::nullopt);
+        section_output& so = go.push_back(section_output(
+            std::make_unique<synthetic_readings>(), "section", std::nullopt));
+        trap_context start{ address{ 0x401000, nullptr } };
+        trap_context end{ address{ 0x401100, nullptr } };
+        timed_sample::time_point tp = timed_sample::clock::now();
+        for (size_t e = 0; e < executions; e++)
+        {
+            timed_execution exec(samples_per_execution);
+            for (auto& ts : exec)
+            {
+                tp += std::chrono::milliseconds(10) + std::chrono::nanoseconds(jitter(gen));
+                ts.timestamp = tp;
+            }
+            so.push_back(position_exec{ { start, end }, compressed_execution(exec) });
+        }
+        return retval;
+    }
+
+    template<typename Func>
+    double seconds(Func&& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t max_executions = 1 << 18;
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [max executions (default: "
+            << max_executions << ")]\n";
+        return 1;
+    }
+    if (argc == 2)
+    {
+        char* end;
+        max_executions = std::strtoull(argv[1], &end, 10);
+        if (*end || end == argv[1] || !max_executions)
+        {
+            std::cerr << "invalid number of executions '" << argv[1] << "'\n";
+            return 1;
+        }
+    }
+
+    std::cout << "samples per execution: " << samples_per_execution << "\n"
+        << std::setw(12) << "executions"
+        << std::setw(12) << "json (s)"
+        << std::setw(12) << "json (MB)"
+        << std::setw(16) << "json (us/exec)"
+        << std::setw(14) << "binary (s)"
+        << std::setw(14) << "binary (MB)"
+        << std::setw(18) << "binary (us/exec)" << "\n";
+    for (size_t count = 1024; count <= max_executions; count *= 4)
+    {
+        profiling_results pr = make_results(count);
+
+        null_buffer json_buf;
+        std::ostream json_os(&json_buf);
+        double json = seconds([&]()
+            {
+                json_os << pr;
+            });
+
+        null_buffer binary_buf;
+        std::ostream binary_os(&binary_buf);
+        double binary = seconds([&]()
+            {
+                write_binary(binary_os, pr);
+            });
+
+        std::cout << std::setw(12) << count
+            << std::fixed << std::setprecision(3)
+            << std::setw(12) << json
+            << std::setw(12) << json_buf.bytes() / 1e6
+            << std::setw(16) << json / count * 1e6
+            << std::setw(14) << binary
+            << std::setw(14) << binary_buf.bytes() / 1e6
+            << std::setw(18) << binary / count * 1e6 << "\n";
+    }
+    return 0;
+}
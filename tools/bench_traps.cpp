@@ -0,0 +1,125 @@
+// bench_traps.cpp
+// measures the lookup of registered traps, done on every breakpoint hit, against the number of traps
+
+#include "sampler.hpp"
+#include "trap.hpp"
+#include "trap_types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tep;
+
+namespace
+{
+    constexpr size_t lookups = 1 << 22;
+
+    // code addresses of functions of varying sizes, like the entrypoints of an executable
+    std::vector<uintptr_t> trap_addresses(size_t count, std::mt19937_64& gen)
+    {
+        std::uniform_int_distribution<uintptr_t> size(16, 1024);
+        std::vector<uintptr_t> retval;
+        retval.reserve(count);
+        uintptr_t addr = 0x401000;
+        for (size_t i = 0; i < count; i++)
+        {
+            retval.push_back(addr);
+            addr += size(gen) & ~uintptr_t(0xf);
+        }
+        return retval;
+    }
+
+    template<typename Func>
+    double ns_per_lookup(const std::vector<uintptr_t>& order, Func&& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        uintptr_t sink = 0;
+        for (uintptr_t addr : order)
+            sink += func(addr);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        // keeps the lookups from being optimized away
+        if (sink == 1)
+            std::cerr << "";
+        return std::chrono::duration<double, std::nano>(elapsed).count() / order.size();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t max_traps = 1 << 20;
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [max traps (default: " << max_traps << ")]\n";
+        return 1;
+    }
+    if (argc == 2)
+    {
+        char* end;
+        max_traps = std::strtoull(argv[1], &end, 10);
+        if (*end || end == argv[1] || !max_traps)
+        {
+            std::cerr << "invalid number of traps '" << argv[1] << "'\n";
+            return 1;
+        }
+    }
+
+    std::cout << std::setw(10) << "traps"
+        << std::setw(16) << "hit (ns)"
+        << std::setw(16) << "trap (ns)"
+        << std::setw(16) << "miss (ns)" << "\n";
+    for (size_t count = 16; count <= max_traps; count *= 4)
+    {
+        std::mt19937_64 gen(count);
+        std::vector<uintptr_t> addrs = trap_addresses(count, gen);
+        registered_traps traps;
+        for (uintptr_t addr : addrs)
+        {
+            traps.insert(start_addr(addr), start_trap(
+                static_cast<long>(addr),
+                trap_context{ address{ addr, nullptr } },
+                addr & 0x10,
+                []()
+                {
+                    return std::unique_ptr<sampler>();
+                }));
+        }
+
+        // hits in random order, so that the lookups are not served by a warm cache line
+        std::uniform_int_distribution<size_t> pick(0, count - 1);
+        std::vector<uintptr_t> hits(lookups);
+        std::vector<uintptr_t> misses(lookups);
+        for (size_t i = 0; i < lookups; i++)
+        {
+            hits[i] = addrs[pick(gen)];
+            misses[i] = addrs[pick(gen)] + 1;
+        }
+
+        // the inline fields, which are all that is needed to step over a trap
+        double hit = ns_per_lookup(hits, [&traps](uintptr_t addr)
+            {
+                const trap_hit* h = traps.find_hit(start_addr(addr));
+                return h->origword + h->allow_concurrency;
+            });
+        // the out-of-line trap as well, which is read to sample the section
+        double trap = ns_per_lookup(hits, [&traps](uintptr_t addr)
+            {
+                const start_trap* t = traps.find(start_addr(addr));
+                return t->origword() + t->allow_concurrency();
+            });
+        double miss = ns_per_lookup(misses, [&traps](uintptr_t addr)
+            {
+                return traps.find_hit(start_addr(addr)) != nullptr;
+            });
+        std::cout << std::setw(10) << count
+            << std::fixed << std::setprecision(2)
+            << std::setw(16) << hit
+            << std::setw(16) << trap
+            << std::setw(16) << miss << "\n";
+    }
+    return 0;
+}
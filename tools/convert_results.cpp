@@ -0,0 +1,250 @@
+// convert_results.cpp
+// converts a binary results file to the JSON output of the profiler
+
+#include "output/binary_reader.hpp"
+#include "output/output_writer.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace tep;
+
+namespace
+{
+    void strings_output(output_writer& ow, const std::vector<std::string>& strs)
+    {
+        ow.begin_array();
+        for (const auto& str : strs)
+            ow.value(str);
+        ow.end_array();
+    }
+
+    void column_output(output_writer& ow, const binary_reader& reader,
+        const binary::column& column)
+    {
+        ow.begin_array();
+        for (size_t i = 0; i < column.size(); i++)
+        {
+            ow.begin_array();
+            for (size_t f = 0; f < column.fields.size(); f++)
+            {
+                uint64_t value = column.values[f][i];
+                switch (column.fields[f])
+                {
+                case binary::field::time:
+                    ow.value(reader.time(value));
+                    break;
+                case binary::field::energy:
+                    ow.value(reader.energy(value));
+                    break;
+                case binary::field::power:
+                    ow.value(reader.power(value));
+                    break;
+                }
+            }
+            ow.end_array();
+        }
+        ow.end_array();
+    }
+
+    void readings_output(output_writer& ow, const binary_reader& reader,
+        const binary::target_readings& readings)
+    {
+        switch (readings.kind)
+        {
+        case binary::readings_kind::cpu:
+            ow.key("cpu").begin_array();
+            for (const auto& socket : readings.units)
+            {
+                ow.begin_object();
+                for (size_t loc = 0; loc < binary::cpu_locations.size(); loc++)
+                {
+                    // socket is between the package and sys locations
+                    if (binary::cpu_locations[loc] == "sys")
+                        ow.key("socket").value(socket.id);
+                    ow.key(binary::cpu_locations[loc]);
+                    column_output(ow, reader, socket.columns[loc]);
+                }
+                ow.end_object();
+            }
+            ow.end_array();
+            break;
+        case binary::readings_kind::cores:
+            ow.key("cpu_cores").begin_array();
+            for (const auto& core : readings.units)
+            {
+                ow.begin_object();
+                ow.key("core").value(core.id);
+                ow.key("readings");
+                column_output(ow, reader, core.columns.front());
+                ow.end_object();
+            }
+            ow.end_array();
+            break;
+        case binary::readings_kind::gpu:
+            ow.key("gpu").begin_array();
+            for (const auto& device : readings.units)
+            {
+                ow.begin_object();
+                ow.key("board");
+                column_output(ow, reader, device.columns.front());
+                ow.key("device").value(device.id);
+                ow.end_object();
+            }
+            ow.end_array();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void reader_times_output(output_writer& ow, const binary::execution& exec)
+    {
+        ow.begin_array();
+        for (size_t ix = 0; ix < exec.sample_times.size(); ix++)
+        {
+            ow.begin_array();
+            for (const auto& times : exec.reader_times)
+                ow.value(times[ix]);
+            ow.end_array();
+        }
+        ow.end_array();
+    }
+
+    void sample_times_output(output_writer& ow, const binary::execution& exec)
+    {
+        ow.begin_array();
+        for (int64_t t : exec.sample_times)
+            ow.value(t);
+        ow.end_array();
+    }
+
+    // same document as the JSON output of the profiler, see output.cpp
+    void results_output(output_writer& ow, binary_reader& reader)
+    {
+        const binary::header& header = reader.header();
+        ow.begin_object();
+        ow.key("format").begin_object();
+        ow.key("cpu");
+        strings_output(ow, header.cpu_format);
+        ow.key("gpu");
+        strings_output(ow, header.gpu_format);
+        ow.end_object();
+
+        ow.key("groups").begin_array();
+        for (const auto& group : reader.groups())
+        {
+            ow.begin_object();
+            ow.key("extra").value(group.extra);
+            ow.key("label").value(group.label);
+            if (!group.sections.empty())
+            {
+                ow.key("sections").begin_array();
+                for (const auto& section : group.sections)
+                {
+                    ow.begin_object();
+                    ow.key("executions").begin_array();
+                    for (uint64_t offset : section.executions)
+                    {
+                        binary::execution exec = reader.read_execution(offset);
+                        ow.begin_object();
+                        for (const auto& readings : exec.readings)
+                            readings_output(ow, reader, readings);
+                        if (exec.overhead)
+                            ow.key("overhead").raw(*exec.overhead);
+                        ow.key("range").begin_object();
+                        ow.key("end").raw(exec.end);
+                        ow.key("start").raw(exec.start);
+                        ow.end_object();
+                        if (!exec.reader_times.empty())
+                        {
+                            ow.key("reader_times");
+                            reader_times_output(ow, exec);
+                        }
+                        ow.key("sample_times");
+                        sample_times_output(ow, exec);
+                        ow.end_object();
+                    }
+                    ow.end_array();
+                    ow.key("extra").value(section.extra);
+                    ow.key("label").value(section.label);
+                    if (section.overhead)
+                        ow.key("overhead").raw(*section.overhead);
+                    if (section.stats)
+                        ow.key("stats").raw(*section.stats);
+                    ow.end_object();
+                }
+                ow.end_array();
+            }
+            ow.end_object();
+        }
+        ow.end_array();
+
+        ow.key("idle").begin_array();
+        for (uint64_t offset : reader.idle())
+        {
+            if (!offset)
+            {
+                ow.null();
+                continue;
+            }
+            binary::execution exec = reader.read_execution(offset);
+            ow.begin_object();
+            for (const auto& readings : exec.readings)
+                readings_output(ow, reader, readings);
+            if (!exec.reader_times.empty())
+            {
+                ow.key("reader_times");
+                reader_times_output(ow, exec);
+            }
+            ow.key("sample_times");
+            sample_times_output(ow, exec);
+            ow.end_object();
+        }
+        ow.end_array();
+
+        ow.key("units").begin_object();
+        ow.key("energy").value(header.energy_unit);
+        ow.key("power").value(header.power_unit);
+        ow.key("time").value(header.time_unit);
+        ow.end_object();
+        ow.end_object();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <binary results> [output JSON (default: stdout)]\n";
+        return 1;
+    }
+    try
+    {
+        binary_reader reader(argv[1]);
+        std::ofstream file;
+        if (argc == 3)
+        {
+            file.open(argv[2]);
+            if (!file)
+            {
+                std::cerr << "error opening output file '" << argv[2] << "': "
+                    << strerror(errno) << "\n";
+                return 1;
+            }
+        }
+        std::ostream& os = argc == 3 ? file : std::cout;
+        {
+            output_writer ow(os);
+            results_output(ow, reader);
+        }
+        os.flush();
+        return 0;
+    }
+    catch (const binary::format_error& e)
+    {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,52 @@
+// recover_results.cpp
+// rebuilds a binary results file from the journal of a run which did not finish
+
+#include "output/binary_writer.hpp"
+#include "output/journal_reader.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace tep;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <journal> <output binary results>\n";
+        return 1;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "error opening journal '" << argv[1] << "': " << strerror(errno) << "\n";
+        return 1;
+    }
+    std::ofstream output(argv[2], std::ios::binary);
+    if (!output)
+    {
+        std::cerr << "error opening output file '" << argv[2] << "': "
+            << strerror(errno) << "\n";
+        return 1;
+    }
+    try
+    {
+        binary_writer bw(output);
+        journal::rebuilt rec = journal::rebuild(file, bw);
+        output.flush();
+        if (!output)
+        {
+            std::cerr << "error writing output file '" << argv[2] << "'\n";
+            return 1;
+        }
+        std::cerr << "recovered " << rec.executions << " executions of "
+            << rec.groups << " groups\n";
+        return 0;
+    }
+    catch (const journal::format_error& e)
+    {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,211 @@
+// sensor_daemon.cpp
+// samples the sensors at a fixed rate and publishes the samples to a shared memory segment,
+// which any number of profilers read with --sensor-segment instead of the sensors
+
+#include <nrg/nrg.hpp>
+#include <nonstd/expected.hpp>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <getopt.h>
+#include <pthread.h>
+
+namespace
+{
+    template<typename Mask>
+    std::optional<Mask> parse_mask(const char* name, const char* arg)
+    {
+        if (!std::strcmp(arg, "all"))
+            return Mask(~0x0);
+        char* end;
+        errno = 0;
+        unsigned long long value = std::strtoull(arg, &end, 16);
+        if (errno || *end || end == arg || !value)
+        {
+            std::cerr << "invalid --" << name << " '" << arg << "'\n";
+            return std::nullopt;
+        }
+        return Mask(value);
+    }
+
+    // comma-separated list of logical CPUs
+    std::optional<nrgprf::cpu_mask> parse_cpus(const char* arg)
+    {
+        nrgprf::cpu_mask cpus;
+        const char* pos = arg;
+        while (true)
+        {
+            char* end;
+            errno = 0;
+            unsigned long cpu = std::strtoul(pos, &end, 10);
+            if (errno || end == pos || cpu >= cpus.size() || (*end && *end != ','))
+            {
+                std::cerr << "invalid --cpus '" << arg << "'\n";
+                return std::nullopt;
+            }
+            cpus.set(cpu);
+            if (!*end)
+                return cpus;
+            pos = end + 1;
+        }
+    }
+
+    void print_usage(const char* name)
+    {
+        std::cout << "Usage: " << name << " [options]\n"
+            << "  --name <name>              shared memory segment (default: "
+            << nrgprf::sensor_publisher::default_name << ")\n"
+            << "  --period <us>              sampling period in microseconds (default: 1000)\n"
+            << "  --history <n>              samples kept in the segment (default: "
+            << nrgprf::sensor_publisher::default_history << ")\n"
+            << "  --cpu-sensors {MASK,all}   mask of CPU sensors to read (default: all)\n"
+            << "  --cpu-sockets {MASK,all}   mask of CPU sockets to read (default: all)\n"
+            << "  --gpu-devices {MASK,all}   mask of GPU devices to read (default: all)\n"
+            << "  --parallel                 read the CPU and GPU sensors at the same time\n"
+            << "  --cpus <cpu,...>           logical CPUs the sampling thread runs on (default: any)\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace nrgprf;
+    std::string name = sensor_publisher::default_name;
+    std::chrono::microseconds period(1000);
+    size_t history = sensor_publisher::default_history;
+    location_mask locations(~0x0);
+    socket_mask sockets(~0x0);
+    device_mask devices(~0x0);
+    bool parallel = false;
+    cpu_mask cpus;
+
+    const option long_options[] = {
+        { "name",        required_argument, nullptr, 'n' },
+        { "period",      required_argument, nullptr, 'p' },
+        { "history",     required_argument, nullptr, 'H' },
+        { "cpu-sensors", required_argument, nullptr, 'l' },
+        { "cpu-sockets", required_argument, nullptr, 's' },
+        { "gpu-devices", required_argument, nullptr, 'd' },
+        { "parallel",    no_argument,       nullptr, 'P' },
+        { "cpus",        required_argument, nullptr, 'c' },
+        { "help",        no_argument,       nullptr, 'h' },
+        { nullptr,       0,                 nullptr, 0 }
+    };
+    int c;
+    int option_index = 0;
+    while ((c = getopt_long(argc, argv, "h", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            name = optarg;
+            break;
+        case 'p':
+        case 'H':
+        {
+            char* end;
+            unsigned long long value = std::strtoull(optarg, &end, 10);
+            if (*end || end == optarg || !value)
+            {
+                std::cerr << "invalid --" << long_options[option_index].name
+                    << " '" << optarg << "'\n";
+                return 1;
+            }
+            if (c == 'p')
+                period = std::chrono::microseconds(value);
+            else
+                history = value;
+        } break;
+        case 'l':
+            if (auto mask = parse_mask<location_mask>("cpu-sensors", optarg))
+                locations = *mask;
+            else
+                return 1;
+            break;
+        case 's':
+            if (auto mask = parse_mask<socket_mask>("cpu-sockets", optarg))
+                sockets = *mask;
+            else
+                return 1;
+            break;
+        case 'd':
+            if (auto mask = parse_mask<device_mask>("gpu-devices", optarg))
+                devices = *mask;
+            else
+                return 1;
+            break;
+        case 'P':
+            parallel = true;
+            break;
+        case 'c':
+            if (auto mask = parse_cpus(optarg))
+                cpus = *mask;
+            else
+                return 1;
+            break;
+        default:
+            print_usage(argv[0]);
+            return c != 'h';
+        }
+    }
+
+    try
+    {
+        auto support = reader_gpu::support(devices);
+        if (!support)
+            throw exception(support.error());
+        // energy is preferred, like the profiler does
+        readings_type::type gpu_readings = *support & readings_type::energy ?
+            readings_type::energy : readings_type::power;
+
+        reader_rapl cpu_reader(locations, sockets, std::cerr);
+        reader_gpu gpu_reader(gpu_readings, devices, std::cerr);
+        hybrid_reader reader;
+        reader.push_back(cpu_reader);
+        reader.push_back(gpu_reader);
+        reader.parallel(parallel);
+
+        sensor_publisher publisher(name, segment_info{
+                locations,
+                sockets,
+                devices,
+                gpu_readings,
+                reader.num_events(),
+                period
+            }, history);
+
+        // the signals are blocked before the sampling thread is started, which inherits the mask,
+        // so that they are only received by the wait below
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        poll_engine engine(cpus);
+        subscription sub = engine.subscribe(reader, poll_policy::rate(period),
+            [&publisher](const result<published_sample>& s)
+            {
+                if (s)
+                    publisher.publish(s->value, s->timestamp);
+                else
+                    std::cerr << "error reading sensors: " << s.error().message() << "\n";
+            });
+        std::cerr << "publishing to '" << name << "' every " << period.count() << " us\n";
+
+        int signal;
+        sigwait(&signals, &signal);
+        sub.cancel();
+        // the segment is removed by the publisher
+    }
+    catch (const exception& e)
+    {
+        std::cerr << "NRG exception: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
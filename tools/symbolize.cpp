@@ -0,0 +1,223 @@
+// symbolize.cpp
+// resolves addresses of an ELF object to their functions, inlined-at chains and source lines,
+// either those given or a batch of random addresses in its functions, reporting the throughput
+
+#include "dbg/error.hpp"
+#include "dbg/object_info.hpp"
+#include "dbg/symbolizer.hpp"
+
+#include <nonstd/expected.hpp>
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tep;
+
+namespace
+{
+    void print_usage(const char* name)
+    {
+        std::cerr << "Usage: " << name << " [options] <object> [address ...]\n"
+            << "Resolves the addresses, read from stdin if none are given, one per line\n"
+            << "  --load-address <addr>  runtime address the object is loaded at, if PIE (default: 0)\n"
+            << "  --debug-dir <dir>      global directory of separate debug files (default: "
+            << dbg::object_info::default_debug_dir << ")\n"
+            << "  --random <n>           resolve <n> random addresses in the functions of the object\n"
+            << "                         and print the throughput instead of the results\n"
+            << "  --seed <n>             seed of the random addresses (default: 0)\n"
+            << "  --cache <n>            capacity of the cache of resolved addresses (default: "
+            << dbg::symbolizer::default_cache_capacity << ")\n"
+            << "  -h, --help             print this message and exit\n";
+    }
+
+    bool parse_address(const char* str, uintptr_t& addr)
+    {
+        char* end;
+        addr = std::strtoull(str, &end, 16);
+        return !*end && end != str;
+    }
+
+    bool parse_count(const char* name, const char* str, unsigned long long& value)
+    {
+        char* end;
+        value = std::strtoull(str, &end, 10);
+        if (*end || end == str)
+        {
+            std::cerr << "invalid --" << name << " '" << str << "'\n";
+            return false;
+        }
+        return true;
+    }
+
+    // addresses uniformly distributed over the code of the functions of the object
+    std::vector<uintptr_t> random_addresses(const dbg::object_info& info,
+        uintptr_t load_address, size_t count, unsigned long long seed)
+    {
+        std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+        std::vector<uintptr_t> ends;
+        uintptr_t total = 0;
+        for (const auto& sym : info.function_symbols())
+        {
+            if (!sym.size)
+                continue;
+            ranges.emplace_back(sym.address, sym.size);
+            ends.push_back(total += sym.size);
+        }
+        std::vector<uintptr_t> retval;
+        if (!total)
+            return retval;
+        retval.reserve(count);
+        std::mt19937_64 gen(seed);
+        std::uniform_int_distribution<uintptr_t> dist(0, total - 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            uintptr_t offset = dist(gen);
+            size_t ix = std::upper_bound(ends.begin(), ends.end(), offset) - ends.begin();
+            uintptr_t start = ix ? ends[ix - 1] : 0;
+            retval.push_back(load_address + ranges[ix].first + offset - start);
+        }
+        return retval;
+    }
+
+    double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uintptr_t load_address = 0;
+    std::string debug_dir(dbg::object_info::default_debug_dir);
+    unsigned long long random = 0;
+    unsigned long long seed = 0;
+    unsigned long long cache = dbg::symbolizer::default_cache_capacity;
+
+    const option long_options[] = {
+        { "load-address", required_argument, nullptr, 'l' },
+        { "debug-dir",    required_argument, nullptr, 'd' },
+        { "random",       required_argument, nullptr, 'r' },
+        { "seed",         required_argument, nullptr, 's' },
+        { "cache",        required_argument, nullptr, 'c' },
+        { "help",         no_argument,       nullptr, 'h' },
+        { nullptr,        0,                 nullptr, 0 }
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "h", long_options, nullptr)) != -1)
+    {
+        switch (c)
+        {
+        case 'l':
+            if (!parse_address(optarg, load_address))
+            {
+                std::cerr << "invalid --load-address '" << optarg << "'\n";
+                return 1;
+            }
+            break;
+        case 'd':
+            debug_dir = optarg;
+            break;
+        case 'r':
+            if (!parse_count("random", optarg, random) || !random)
+                return 1;
+            break;
+        case 's':
+            if (!parse_count("seed", optarg, seed))
+                return 1;
+            break;
+        case 'c':
+            if (!parse_count("cache", optarg, cache))
+                return 1;
+            break;
+        default:
+            print_usage(argv[0]);
+            return c != 'h';
+        }
+    }
+    if (optind >= argc)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        dbg::object_info info(argv[optind], debug_dir);
+        double load_time = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        dbg::symbolizer sym(info, load_address, cache);
+        double index_time = seconds_since(start);
+
+        if (random)
+        {
+            std::vector<uintptr_t> addrs = random_addresses(info, load_address, random, seed);
+            if (addrs.empty())
+            {
+                std::cerr << argv[optind] << ": no function symbols with a size\n";
+                return 1;
+            }
+            start = std::chrono::steady_clock::now();
+            auto results = sym.resolve(addrs);
+            double resolve_time = seconds_since(start);
+
+            size_t found = 0;
+            size_t lines = 0;
+            for (const auto& res : results)
+            {
+                found += res.has_value();
+                lines += res && res->line;
+            }
+            std::cout << "loaded debug info in " << load_time << " s\n"
+                << "built symbolizer in " << index_time << " s\n"
+                << "resolved " << results.size() << " addresses (" << found << " found, "
+                << lines << " with source lines) in " << resolve_time << " s: "
+                << results.size() / resolve_time << " addresses/s\n";
+            return 0;
+        }
+
+        auto resolve = [&sym](const char* str)
+        {
+            uintptr_t addr;
+            if (!parse_address(str, addr))
+            {
+                std::cerr << "invalid address '" << str << "'\n";
+                return false;
+            }
+            auto res = sym.resolve(addr);
+            if (res)
+                std::cout << *res << "\n";
+            else
+                std::cout << std::hex << addr << std::dec << " " << res.error().message() << "\n";
+            return true;
+        };
+
+        bool success = true;
+        if (optind + 1 < argc)
+        {
+            for (int i = optind + 1; i < argc; i++)
+                success &= resolve(argv[i]);
+        }
+        else
+        {
+            std::string line;
+            while (std::getline(std::cin, line))
+                if (!line.empty())
+                    success &= resolve(line.c_str());
+        }
+        return !success;
+    }
+    catch (const dbg::exception& e)
+    {
+        std::cerr << argv[optind] << ": " << e.what() << "\n";
+        return 1;
+    }
+}
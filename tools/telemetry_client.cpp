@@ -0,0 +1,51 @@
+// telemetry_client.cpp
+// prints the telemetry events published by the profiler, one JSON object per line
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <socket>\n";
+        return 1;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (std::strlen(argv[1]) >= sizeof(addr.sun_path))
+    {
+        std::cerr << "socket path '" << argv[1] << "' is too long\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, argv[1]);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        std::cerr << "socket: " << strerror(errno) << "\n";
+        return 1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1)
+    {
+        std::cerr << "error connecting to '" << argv[1] << "': " << strerror(errno) << "\n";
+        ::close(fd);
+        return 1;
+    }
+
+    // the profiler closes the connection when it exits
+    char buffer[4096];
+    ssize_t count;
+    while ((count = ::read(fd, buffer, sizeof(buffer))) > 0 || (count == -1 && errno == EINTR))
+        if (count > 0)
+            std::cout.write(buffer, count).flush();
+    if (count == -1)
+        std::cerr << "read: " << strerror(errno) << "\n";
+    ::close(fd);
+    return count == -1;
+}